@@ -159,15 +159,13 @@ void HaploPloidyCollapse::figure(HaploGenotypeSet* toCollapse, uintptr_t numPloi
 	//make a copy
 		HaploGenotypeSet* copyCol = toCollapse;
 	//turn everything in that copy to its canonical form
-		PODLessComparator<unsigned short> fixupComp;
-		PODSortOptions fixupOpts(&fixupComp);
-		PODInMemoryMergesort fixupSort(&fixupOpts);
+		PODInMemoryMergesortT<unsigned short> fixupSort;
 		unsigned short* curFixUp = &(copyCol->hotGenos[0]);
 		uintptr_t totalNumGenotypes = copyCol->hotGenos.size() / copyCol->numH;
 		for(uintptr_t i = 0; i<totalNumGenotypes; i++){
 			for(uintptr_t j = 0; j<numPloid; j++){
 				uintptr_t curPloid = thePloids[j];
-				if(curPloid > 1){ fixupSort.sort(curPloid, (char*)curFixUp); }
+				if(curPloid > 1){ fixupSort.sort(curPloid, curFixUp); }
 				curFixUp += curPloid;
 			}
 			collapseInds.push_back(i);
@@ -11,6 +11,7 @@ public:
 	~WhodunDataToTableMainLoop();
 	
 	void doSingle(uintptr_t threadInd, uintptr_t ind);
+	void doRange(uintptr_t threadInd, uintptr_t fromI, uintptr_t toI);
 	
 	/**How the data table looks.*/
 	DataTableDescription* dataLayout;
@@ -20,8 +21,18 @@ public:
 	TextTable* toSave;
 	/**The amount of bytes between rows in the table.*/
 	uintptr_t textPitch;
+	/**The offset of each column's text within a row.*/
+	std::vector<uintptr_t> textOffsets;
 	/**Invert factor values to names.*/
 	std::vector< std::map<uintptr_t,std::string> > invFacMap;
+	/**Storage for the rows of a column that need formatting.*/
+	std::vector< std::vector<uintptr_t> > saveRowInds;
+	/**Storage for integers to format.*/
+	std::vector< std::vector<int64_t> > saveInts;
+	/**Storage for reals to format.*/
+	std::vector< std::vector<double> > saveReals;
+	/**Storage for the formatted text.*/
+	std::vector< std::vector<SizePtrString> > saveCells;
 };
 
 };
@@ -121,7 +132,9 @@ void WhodunDataToTableProgram::baseRun(){
 			bigieDo.toSave = &workTab;
 			bigieDo.invFacMap.resize(numTabCols);
 			uintptr_t textStrP = 0;
+			bigieDo.textOffsets.resize(numTabCols);
 			for(uintptr_t i = 0; i<numTabCols; i++){
+				bigieDo.textOffsets[i] = textStrP;
 				switch(inStr->tabDesc.colTypes[i]){
 					case WHODUN_DATA_CAT:{
 						std::map<std::string,uintptr_t>* facCMap = &(inStr->tabDesc.factorColMap[i]);
@@ -135,10 +148,10 @@ void WhodunDataToTableProgram::baseRun(){
 						textStrP += maxSize;
 					} break;
 					case WHODUN_DATA_INT:{
-						textStrP += (8*sizeof(uintmax_t)+8);
+						textStrP += WHODUN_FORMAT_INT_MAXLEN;
 					} break;
 					case WHODUN_DATA_REAL:{
-						textStrP += (8*sizeof(uintmax_t)+8);
+						textStrP += WHODUN_FORMAT_FLOAT_MAXLEN;
 					} break;
 					case WHODUN_DATA_STR:{
 						textStrP += inStr->tabDesc.strLengths[i];
@@ -172,6 +185,10 @@ void WhodunDataToTableProgram::baseRun(){
 
 WhodunDataToTableMainLoop::WhodunDataToTableMainLoop(uintptr_t numThread) : ParallelForLoop(numThread){
 	naturalStride = 128;
+	saveRowInds.resize(numThread);
+	saveInts.resize(numThread);
+	saveReals.resize(numThread);
+	saveCells.resize(numThread);
 }
 WhodunDataToTableMainLoop::~WhodunDataToTableMainLoop(){}
 void WhodunDataToTableMainLoop::doSingle(uintptr_t threadInd, uintptr_t ind){
@@ -183,7 +200,7 @@ void WhodunDataToTableMainLoop::doSingle(uintptr_t threadInd, uintptr_t ind){
 	curOutR->numCols = numDatums;
 	curOutR->texts = curOutS;
 	for(uintptr_t i = 0; i<numDatums; i++){
-		curOutS->txt = curOutC;
+		curOutS->txt = curOutC + textOffsets[i];
 		if(curIn->isNA){
 			curOutS->len = 0;
 		}
@@ -194,28 +211,59 @@ void WhodunDataToTableMainLoop::doSingle(uintptr_t threadInd, uintptr_t ind){
 					std::map<uintptr_t,std::string>::iterator catIt = catMap->find(curIn->valC);
 					if(catIt == catMap->end()){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Unknown categoriacal index in data.", 0, 0); }
 					curOutS->len = catIt->second.size();
-					memcpy(curOutC, catIt->second.c_str(), curOutS->len);
-				} break;
-				case WHODUN_DATA_INT:{
-					curOutS->len = sprintf(curOutC, "%d", (int)(curIn->valI));
-				} break;
-				case WHODUN_DATA_REAL:{
-					curOutS->len = sprintf(curOutC, "%e", curIn->valR);
+					memcpy(curOutS->txt, catIt->second.c_str(), curOutS->len);
 				} break;
+				case WHODUN_DATA_INT:
+				case WHODUN_DATA_REAL:
+					//formatted a column at a time in doRange
+					break;
 				case WHODUN_DATA_STR:{
 					curOutS->len = dataLayout->strLengths[i];
-					memcpy(curOutC, curIn->valS, curOutS->len);
+					memcpy(curOutS->txt, curIn->valS, curOutS->len);
 				} break;
 				default:
 					throw std::runtime_error("Da fuq?");
 			};
-			curOutC += curOutS->len;
 		}
 		curIn++;
 		curOutS++;
 	}
 }
-
-
-
+void WhodunDataToTableMainLoop::doRange(uintptr_t threadInd, uintptr_t fromI, uintptr_t toI){
+	//categories and strings go a row at a time
+	ParallelForLoop::doRange(threadInd, fromI, toI);
+	//numbers go a column at a time
+	uintptr_t numDatums = dataLayout->colTypes.size();
+	std::vector<uintptr_t>* curRowInds = &(saveRowInds[threadInd]);
+	std::vector<int64_t>* curInts = &(saveInts[threadInd]);
+	std::vector<double>* curReals = &(saveReals[threadInd]);
+	std::vector<SizePtrString>* curCells = &(saveCells[threadInd]);
+	for(uintptr_t i = 0; i<numDatums; i++){
+		uintptr_t curType = dataLayout->colTypes[i];
+		if((curType != WHODUN_DATA_INT) && (curType != WHODUN_DATA_REAL)){ continue; }
+		curRowInds->clear();
+		curInts->clear();
+		curReals->clear();
+		curCells->clear();
+		for(uintptr_t j = fromI; j<toI; j++){
+			DataTableEntry* curIn = toConv->saveData[j * numDatums + i];
+			if(curIn->isNA){ continue; }
+			curRowInds->push_back(j);
+			if(curType == WHODUN_DATA_INT){ curInts->push_back(curIn->valI); }
+			else{ curReals->push_back(curIn->valR); }
+			curCells->push_back(*(toSave->saveStrs[j * numDatums + i]));
+		}
+		uintptr_t numFmt = curRowInds->size();
+		if(numFmt == 0){ continue; }
+		if(curType == WHODUN_DATA_INT){
+			formatIntBatch(numFmt, &((*curInts)[0]), &((*curCells)[0]));
+		}
+		else{
+			formatFloatBatch(numFmt, &((*curReals)[0]), &((*curCells)[0]));
+		}
+		for(uintptr_t j = 0; j<numFmt; j++){
+			*(toSave->saveStrs[(*curRowInds)[j] * numDatums + i]) = (*curCells)[j];
+		}
+	}
+}
 
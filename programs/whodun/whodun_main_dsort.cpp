@@ -0,0 +1,100 @@
+#include "whodunmain_programs.h"
+
+#include "whodun_oshook.h"
+#include "whodun_stat_query.h"
+
+using namespace whodun;
+
+WhodunDataSortProgram::WhodunDataSortProgram() : optKeys("--key"), optReverse("--rev"), optMem("--mem"), optTemp("--temp"), optTabIn(0, "--in", "The data to sort."), optTabOut(0, "--out", "The sorted data to write out."){
+	optKeys.summary = "A column to sort by, most important first.";
+	optKeys.usage = "--key name";
+	optReverse.summary = "Sort a key column largest first.";
+	optReverse.usage = "--rev name";
+	optMem.value = 512;
+	optMem.summary = "The number of megabytes of sort keys and rows to hold in memory.";
+	optMem.usage = "--mem 512";
+	optTemp.value = "whodun_sort_temp";
+	optTemp.summary = "The folder to put temporary files in.";
+	optTemp.usage = "--temp folder";
+	name = "dsort";
+	summary = "Sort the rows of a data table.";
+	version = "whodun dsort 0.0\nCopyright (C) 2022 Benjamin Crysup\nLicense LGPLv3: GNU LGPL version 3\nThis is free software: you are free to change and redistribute it.\nThere is NO WARRANTY, to the extent permitted by law.\n";
+	usage = "dsort --in IN.bdat --out OUT.bdat --key name";
+	allOptions.push_back(&optKeys);
+	allOptions.push_back(&optReverse);
+	allOptions.push_back(&optMem);
+	allOptions.push_back(&optTemp);
+	allOptions.push_back(&optTC);
+	allOptions.push_back(&optChunky);
+	allOptions.push_back(&optTabIn);
+	allOptions.push_back(&optTabOut);
+}
+WhodunDataSortProgram::~WhodunDataSortProgram(){}
+void WhodunDataSortProgram::idiotCheck(){
+	if(optMem.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need some memory to sort in.", 0, 0); }
+	if(optKeys.value.size() == 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need at least one column to sort by.", 0, 0); }
+	for(uintptr_t i = 0; i<optReverse.value.size(); i++){
+		if(std::find(optKeys.value.begin(), optKeys.value.end(), optReverse.value[i]) == optKeys.value.end()){
+			const char* packName = optReverse.value[i].c_str();
+			throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "--rev column is not a --key.", 1, &packName);
+		}
+	}
+}
+void WhodunDataSortProgram::baseRun(){
+	DataTableReader* inStr = 0;
+	DataTableWriter* stageStr = 0;
+	RandacDataTableReader* sortStr = 0;
+	DataTableWriter* outStr = 0;
+	TableExternalSort* doSort = 0;
+	std::string stageName;
+	int madeTemp = 0;
+	try{
+		uintptr_t numThr = optTC.value;
+		ThreadPool usePool(optTC.value);
+		uintptr_t chunkS = numThr * optChunky.value;
+		//anything that cannot be jumped around in gets copied
+			StandardMemorySearcher strMeth;
+			SizePtrString inName = toSizePtr(optTabIn.value.c_str());
+			int isRandac = strMeth.memendswith(inName, toSizePtr(".bdat")) || strMeth.memendswith(inName, toSizePtr(".bcdat")) || strMeth.memendswith(inName, toSizePtr(".cdat"));
+			if(!isRandac){
+				whodunStageTableName(&(optTemp.value), "whodun_sort_stage.raw.bcdat", &stageName, &madeTemp);
+				inStr = new ExtensionDataTableReader(optTabIn.value.c_str(), numThr, &usePool, useIn);
+				stageStr = new ExtensionDataTableWriter(&(inStr->tabDesc), stageName.c_str(), numThr, &usePool);
+				DataTable workTab;
+				while(1){
+					uintptr_t numGot = inStr->read(&workTab, chunkS);
+					if(numGot == 0){ break; }
+					stageStr->write(&workTab);
+				}
+				stageStr->close(); delete(stageStr); stageStr = 0;
+				inStr->close(); delete(inStr); inStr = 0;
+			}
+			sortStr = new ExtensionRandacDataTableReader(stageName.size() ? stageName.c_str() : optTabIn.value.c_str(), numThr, &usePool);
+		//figure out what to do
+			doSort = new TableExternalSort(optTemp.value.c_str(), numThr, &usePool);
+			doSort->maxLoad = ((uintptr_t)optMem.value) << 20;
+			for(uintptr_t i = 0; i<optKeys.value.size(); i++){
+				uintptr_t curC = whodunFindDataColumn(&(sortStr->tabDesc), &(optKeys.value[i]));
+				int curF = 0;
+				if(std::find(optReverse.value.begin(), optReverse.value.end(), optKeys.value[i]) != optReverse.value.end()){ curF |= WHODUN_TABLESORT_REVERSE; }
+				doSort->addKey(curC, curF, 0);
+			}
+		//sort it
+			outStr = new ExtensionDataTableWriter(&(sortStr->tabDesc), optTabOut.value.c_str(), numThr, &usePool, useOut);
+			doSort->sortData(sortStr, outStr);
+		//close it
+			delete(doSort); doSort = 0;
+			outStr->close(); delete(outStr); outStr = 0;
+			sortStr->close(); delete(sortStr); sortStr = 0;
+			whodunKillStagedTable(&stageName, &(optTemp.value), madeTemp);
+	}
+	catch(std::exception& errE){
+		if(doSort){ delete(doSort); }
+		if(inStr){ inStr->close(); delete(inStr); }
+		if(stageStr){ stageStr->close(); delete(stageStr); }
+		if(sortStr){ sortStr->close(); delete(sortStr); }
+		if(outStr){ outStr->close(); delete(outStr); }
+		whodunKillStagedTable(&stageName, &(optTemp.value), madeTemp);
+		throw;
+	}
+}
@@ -0,0 +1,115 @@
+#include "whodunmain_programs.h"
+
+#include "whodun_stat_query.h"
+
+using namespace whodun;
+
+WhodunDataGroupProgram::WhodunDataGroupProgram() : optKeys("--key"), optRows("--rows"), optCount("--count"), optSum("--sum"), optMean("--mean"), optMin("--min"), optMax("--max"), optVar("--var"), optMem("--mem"), optTemp("--temp"), optTabIn(0, "--in", "The data to summarize."), optTabOut(0, "--out", "The summaries to write out."){
+	optKeys.summary = "A column to group rows by.";
+	optKeys.usage = "--key name";
+	optRows.summary = "Count the rows in each group.";
+	optCount.summary = "Count the known values of a column in each group.";
+	optCount.usage = "--count name";
+	optSum.summary = "Sum a column in each group.";
+	optSum.usage = "--sum name";
+	optMean.summary = "Average a column in each group.";
+	optMean.usage = "--mean name";
+	optMin.summary = "Find the smallest value of a column in each group.";
+	optMin.usage = "--min name";
+	optMax.summary = "Find the largest value of a column in each group.";
+	optMax.usage = "--max name";
+	optVar.summary = "Find the variance of a column in each group.";
+	optVar.usage = "--var name";
+	optMem.value = 512;
+	optMem.summary = "The number of megabytes of groups to hold before spilling to disk.";
+	optMem.usage = "--mem 512";
+	optTemp.value = "whodun_group_temp";
+	optTemp.summary = "The folder to put temporary files in.";
+	optTemp.usage = "--temp folder";
+	name = "group";
+	summary = "Summarize the rows of a data table by group.";
+	version = "whodun group 0.0\nCopyright (C) 2022 Benjamin Crysup\nLicense LGPLv3: GNU LGPL version 3\nThis is free software: you are free to change and redistribute it.\nThere is NO WARRANTY, to the extent permitted by law.\n";
+	usage = "group --in IN.bdat --out OUT.bdat --key name --rows --mean value";
+	allOptions.push_back(&optKeys);
+	allOptions.push_back(&optRows);
+	allOptions.push_back(&optCount);
+	allOptions.push_back(&optSum);
+	allOptions.push_back(&optMean);
+	allOptions.push_back(&optMin);
+	allOptions.push_back(&optMax);
+	allOptions.push_back(&optVar);
+	allOptions.push_back(&optMem);
+	allOptions.push_back(&optTemp);
+	allOptions.push_back(&optTC);
+	allOptions.push_back(&optChunky);
+	allOptions.push_back(&optTabIn);
+	allOptions.push_back(&optTabOut);
+}
+WhodunDataGroupProgram::~WhodunDataGroupProgram(){}
+void WhodunDataGroupProgram::idiotCheck(){
+	if(optMem.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need some memory to group in.", 0, 0); }
+}
+uintptr_t whodun::whodunFindDataColumn(DataTableDescription* forData, std::string* colName){
+	for(uintptr_t i = 0; i<forData->colNames.size(); i++){
+		if(forData->colNames[i] == *colName){ return i; }
+	}
+	const char* packName = colName->c_str();
+	throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Unknown column.", 1, &packName);
+}
+void WhodunDataGroupProgram::baseRun(){
+	DataTableReader* inStr = 0;
+	DataTableWriter* outStr = 0;
+	DataTableGroupBy* doGroup = 0;
+	try{
+		//open the input
+			uintptr_t numThr = optTC.value;
+			ThreadPool usePool(optTC.value);
+			uintptr_t chunkS = numThr * optChunky.value;
+			inStr = new ExtensionDataTableReader(optTabIn.value.c_str(), numThr, &usePool, useIn);
+		//figure out what to do
+			doGroup = new DataTableGroupBy(&(inStr->tabDesc), optTemp.value.c_str(), numThr, &usePool);
+			doGroup->maxLoad = ((uintptr_t)optMem.value) << 20;
+			for(uintptr_t i = 0; i<optKeys.value.size(); i++){
+				doGroup->addKey(whodunFindDataColumn(&(inStr->tabDesc), &(optKeys.value[i])));
+			}
+			if(optRows.value){ doGroup->addAggregate(WHODUN_AGGREGATE_ROWS, 0); }
+			ArgumentOptionStringVector* aggOpts[] = {&optCount, &optSum, &optMean, &optMin, &optMax, &optVar};
+			int aggTypes[] = {WHODUN_AGGREGATE_COUNT, WHODUN_AGGREGATE_SUM, WHODUN_AGGREGATE_MEAN, WHODUN_AGGREGATE_MIN, WHODUN_AGGREGATE_MAX, WHODUN_AGGREGATE_VAR};
+			for(uintptr_t ai = 0; ai<6; ai++){
+				for(uintptr_t i = 0; i<aggOpts[ai]->value.size(); i++){
+					uintptr_t curC = whodunFindDataColumn(&(inStr->tabDesc), &(aggOpts[ai]->value[i]));
+					if(aggTypes[ai] != WHODUN_AGGREGATE_COUNT){
+						uintptr_t curT = inStr->tabDesc.colTypes[curC];
+						if((curT != WHODUN_DATA_INT) && (curT != WHODUN_DATA_REAL)){
+							const char* packName = aggOpts[ai]->value[i].c_str();
+							throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Can only do arithmetic on number columns.", 1, &packName);
+						}
+					}
+					doGroup->addAggregate(aggTypes[ai], curC);
+				}
+			}
+		//open the output
+			DataTableDescription outDesc;
+			doGroup->getResultDescription(&outDesc);
+			outStr = new ExtensionDataTableWriter(&outDesc, optTabOut.value.c_str(), numThr, &usePool, useOut);
+		//pump and dump
+			DataTable workTab;
+			while(1){
+				uintptr_t numGot = inStr->read(&workTab, chunkS);
+				if(numGot == 0){ break; }
+				doGroup->add(&workTab);
+			}
+			doGroup->finish(outStr);
+		//close it
+			delete(doGroup); doGroup = 0;
+			outStr->close(); delete(outStr); outStr = 0;
+			inStr->close(); delete(inStr); inStr = 0;
+	}
+	catch(std::exception& errE){
+		if(doGroup){ delete(doGroup); }
+		if(inStr){ inStr->close(); delete(inStr); }
+		if(outStr){ outStr->close(); delete(outStr); }
+		throw;
+	}
+}
+
@@ -0,0 +1,95 @@
+#include "whodunmain_programs.h"
+
+#include "whodun_stat_query.h"
+
+using namespace whodun;
+
+WhodunDataJoinProgram::WhodunDataJoinProgram() : optKeys("--key"), optWithKeys("--wkey"), optLeft("--left"), optMem("--mem"), optTemp("--temp"), optTabIn(0, "--in", "The rows to look up."), optTabWith(0, "--with", "The rows to look in."), optTabOut(0, "--out", "The joined rows to write out."){
+	optKeys.summary = "A column to join on.";
+	optKeys.usage = "--key name";
+	optWithKeys.summary = "The matching column in the table to look in, if named differently.";
+	optWithKeys.usage = "--wkey name";
+	optLeft.summary = "Keep rows that have no match.";
+	optMem.value = 512;
+	optMem.summary = "The number of megabytes of rows to look in to hold before spilling to disk.";
+	optMem.usage = "--mem 512";
+	optTemp.value = "whodun_join_temp";
+	optTemp.summary = "The folder to put temporary files in.";
+	optTemp.usage = "--temp folder";
+	name = "join";
+	summary = "Join the rows of a data table to matching rows of another.";
+	version = "whodun join 0.0\nCopyright (C) 2022 Benjamin Crysup\nLicense LGPLv3: GNU LGPL version 3\nThis is free software: you are free to change and redistribute it.\nThere is NO WARRANTY, to the extent permitted by law.\n";
+	usage = "join --in IN.bdat --with WITH.bdat --out OUT.bdat --key name";
+	allOptions.push_back(&optKeys);
+	allOptions.push_back(&optWithKeys);
+	allOptions.push_back(&optLeft);
+	allOptions.push_back(&optMem);
+	allOptions.push_back(&optTemp);
+	allOptions.push_back(&optTC);
+	allOptions.push_back(&optChunky);
+	allOptions.push_back(&optTabIn);
+	allOptions.push_back(&optTabWith);
+	allOptions.push_back(&optTabOut);
+}
+WhodunDataJoinProgram::~WhodunDataJoinProgram(){}
+void WhodunDataJoinProgram::idiotCheck(){
+	if(optMem.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need some memory to join in.", 0, 0); }
+	if(optKeys.value.size() == 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need at least one column to join on.", 0, 0); }
+	if(optWithKeys.value.size() && (optWithKeys.value.size() != optKeys.value.size())){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need as many --wkey as --key.", 0, 0); }
+}
+void WhodunDataJoinProgram::baseRun(){
+	DataTableReader* inStr = 0;
+	DataTableReader* withStr = 0;
+	DataTableWriter* outStr = 0;
+	DataTableHashJoin* doJoin = 0;
+	try{
+		//open the inputs
+			uintptr_t numThr = optTC.value;
+			ThreadPool usePool(optTC.value);
+			uintptr_t chunkS = numThr * optChunky.value;
+			inStr = new ExtensionDataTableReader(optTabIn.value.c_str(), numThr, &usePool, useIn);
+			withStr = new ExtensionDataTableReader(optTabWith.value.c_str(), numThr, &usePool, useIn);
+		//figure out what to do
+			doJoin = new DataTableHashJoin(&(withStr->tabDesc), &(inStr->tabDesc), optLeft.value ? WHODUN_JOIN_LEFT : WHODUN_JOIN_INNER, optTemp.value.c_str(), numThr, &usePool);
+			doJoin->maxLoad = ((uintptr_t)optMem.value) << 20;
+			for(uintptr_t i = 0; i<optKeys.value.size(); i++){
+				std::string* withName = optWithKeys.value.size() ? &(optWithKeys.value[i]) : &(optKeys.value[i]);
+				uintptr_t inC = whodunFindDataColumn(&(inStr->tabDesc), &(optKeys.value[i]));
+				uintptr_t withC = whodunFindDataColumn(&(withStr->tabDesc), withName);
+				if(inStr->tabDesc.colTypes[inC] != withStr->tabDesc.colTypes[withC]){
+					const char* packName = optKeys.value[i].c_str();
+					throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Join columns must have the same type.", 1, &packName);
+				}
+				doJoin->addKey(withC, inC);
+			}
+		//open the output
+			DataTableDescription outDesc;
+			doJoin->getResultDescription(&outDesc);
+			outStr = new ExtensionDataTableWriter(&outDesc, optTabOut.value.c_str(), numThr, &usePool, useOut);
+		//hash the one, then look up the other
+			DataTable workTab;
+			while(1){
+				uintptr_t numGot = withStr->read(&workTab, chunkS);
+				if(numGot == 0){ break; }
+				doJoin->addBuild(&workTab);
+			}
+			while(1){
+				uintptr_t numGot = inStr->read(&workTab, chunkS);
+				if(numGot == 0){ break; }
+				doJoin->addProbe(&workTab, outStr);
+			}
+			doJoin->finish(outStr);
+		//close it
+			delete(doJoin); doJoin = 0;
+			outStr->close(); delete(outStr); outStr = 0;
+			withStr->close(); delete(withStr); withStr = 0;
+			inStr->close(); delete(inStr); inStr = 0;
+	}
+	catch(std::exception& errE){
+		if(doJoin){ delete(doJoin); }
+		if(inStr){ inStr->close(); delete(inStr); }
+		if(withStr){ withStr->close(); delete(withStr); }
+		if(outStr){ outStr->close(); delete(outStr); }
+		throw;
+	}
+}
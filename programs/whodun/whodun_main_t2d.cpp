@@ -11,19 +11,26 @@ public:
 	~WhodunTableToDataMainLoop();
 	
 	void doSingle(uintptr_t threadInd, uintptr_t ind);
+	void doRange(uintptr_t threadInd, uintptr_t fromI, uintptr_t toI);
 	
 	/**How the data table looks.*/
 	DataTableDescription* dataLayout;
+	/**Fast lookup for the levels of each categorical column.*/
+	std::vector<DataTableFactorDictionary>* factorDicts;
 	/**The amount of characters between entries when saving text.*/
 	uintptr_t dataStrPitch;
 	/**The data to convert.*/
 	TextTableView* toConv;
 	/**The place to put the converted data.*/
 	DataTable* toSave;
-	/**Storage for string data.*/
-	std::vector<std::string> saveStrs;
-	/**Hunt for things.*/
-	StandardMemorySearcher helpFind;
+	/**Storage for a column of cells to parse.*/
+	std::vector< std::vector<SizePtrString> > saveCells;
+	/**Storage for parsed integers.*/
+	std::vector< std::vector<int64_t> > saveInts;
+	/**Storage for parsed reals.*/
+	std::vector< std::vector<double> > saveReals;
+	/**Storage for whether the cells were malformed.*/
+	std::vector< std::vector<char> > saveBad;
 };
 
 };
@@ -143,9 +150,17 @@ void WhodunTableToDataProgram::baseRun(){
 					dataStrP += dataLayout.strLengths[i];
 				}
 			}
+			std::vector<DataTableFactorDictionary> factorDicts(numTabCols);
+			for(uintptr_t i = 0; i<numTabCols; i++){
+				if(dataLayout.colTypes[i] == WHODUN_DATA_CAT){
+					factorDicts[i].setLevels(&(dataLayout.factorColMap[i]));
+					factorDicts[i].freeze();
+				}
+			}
 			DataTable workDat;
 			WhodunTableToDataMainLoop bigieDo(numThr);
 				bigieDo.dataLayout = &dataLayout;
+				bigieDo.factorDicts = &factorDicts;
 				bigieDo.toConv = &workTab;
 				bigieDo.toSave = &workDat;
 				bigieDo.dataStrPitch = dataStrP;
@@ -173,11 +188,13 @@ void WhodunTableToDataProgram::baseRun(){
 
 WhodunTableToDataMainLoop::WhodunTableToDataMainLoop(uintptr_t numThread) : ParallelForLoop(numThread){
 	naturalStride = 128;
-	saveStrs.resize(numThread);
+	saveCells.resize(numThread);
+	saveInts.resize(numThread);
+	saveReals.resize(numThread);
+	saveBad.resize(numThread);
 }
 WhodunTableToDataMainLoop::~WhodunTableToDataMainLoop(){}
 void WhodunTableToDataMainLoop::doSingle(uintptr_t threadInd, uintptr_t ind){
-	std::string* tmpStr = &(saveStrs[threadInd]);
 	uintptr_t numDatums = dataLayout->colTypes.size();
 	TextTableRow* curIn = toConv->saveRows[ind];
 	DataTableEntry* curOut = toSave->saveData[ind * numDatums];
@@ -187,42 +204,20 @@ void WhodunTableToDataMainLoop::doSingle(uintptr_t threadInd, uintptr_t ind){
 		SizePtrString curCell = curIn->texts[i];
 		switch(dataLayout->colTypes[i]){
 			case WHODUN_DATA_CAT:{
-				tmpStr->clear();
-				tmpStr->insert(tmpStr->end(), curCell.txt, curCell.txt + curCell.len);
-				std::map<std::string,uintptr_t>::iterator foundIt = dataLayout->factorColMap[i].find(*tmpStr);
-				if(foundIt == dataLayout->factorColMap[i].end()){
-					curOut->isNA = 1;
-					curOut->valC = 0;
-				}
-				else{
+				uintptr_t foundV;
+				if((*factorDicts)[i].find(curCell, &foundV)){
 					curOut->isNA = 0;
-					curOut->valC = foundIt->second;
-				}
-			} break;
-			case WHODUN_DATA_INT:{
-				if((curCell.len == 0) || (helpFind.memspn(curCell.txt, curCell.len, "+-0123456789", 12) != curCell.len)){
-					curOut->isNA = 1;
-					curOut->valI = 0;
+					curOut->valC = foundV;
 				}
 				else{
-					tmpStr->clear();
-					tmpStr->insert(tmpStr->end(), curCell.txt, curCell.txt + curCell.len);
-					curOut->isNA = 0;
-					curOut->valI = atol(tmpStr->c_str());
-				}
-			} break;
-			case WHODUN_DATA_REAL:{
-				if((curCell.len == 0) || (helpFind.memspn(curCell.txt, curCell.len, "+-0123456789.eE", 15) != curCell.len)){
 					curOut->isNA = 1;
-					curOut->valR = 0;
-				}
-				else{
-					tmpStr->clear();
-					tmpStr->insert(tmpStr->end(), curCell.txt, curCell.txt + curCell.len);
-					curOut->isNA = 0;
-					curOut->valR = atof(tmpStr->c_str());
+					curOut->valC = 0;
 				}
 			} break;
+			case WHODUN_DATA_INT:
+			case WHODUN_DATA_REAL:
+				//parsed a column at a time in doRange
+				break;
 			case WHODUN_DATA_STR:{
 				uintptr_t curLen = dataLayout->strLengths[i];
 				curOut->valS = curOutT;
@@ -243,7 +238,43 @@ void WhodunTableToDataMainLoop::doSingle(uintptr_t threadInd, uintptr_t ind){
 		curOut++;
 	}
 }
-
-
-
+void WhodunTableToDataMainLoop::doRange(uintptr_t threadInd, uintptr_t fromI, uintptr_t toI){
+	//categories and strings go a row at a time
+	ParallelForLoop::doRange(threadInd, fromI, toI);
+	//numbers go a column at a time
+	uintptr_t numDatums = dataLayout->colTypes.size();
+	uintptr_t numRow = toI - fromI;
+	std::vector<SizePtrString>* curCells = &(saveCells[threadInd]);
+	std::vector<int64_t>* curInts = &(saveInts[threadInd]);
+	std::vector<double>* curReals = &(saveReals[threadInd]);
+	std::vector<char>* curBad = &(saveBad[threadInd]);
+	curCells->resize(numRow);
+	curBad->resize(numRow);
+	for(uintptr_t i = 0; i<numDatums; i++){
+		uintptr_t curType = dataLayout->colTypes[i];
+		if((curType != WHODUN_DATA_INT) && (curType != WHODUN_DATA_REAL)){ continue; }
+		for(uintptr_t j = 0; j<numRow; j++){
+			(*curCells)[j] = toConv->saveRows[fromI + j]->texts[i];
+		}
+		DataTableEntry* curOut = toSave->saveData[fromI * numDatums + i];
+		if(curType == WHODUN_DATA_INT){
+			curInts->resize(numRow);
+			parseIntBatch(numRow, &((*curCells)[0]), &((*curInts)[0]), &((*curBad)[0]));
+			for(uintptr_t j = 0; j<numRow; j++){
+				curOut->isNA = (*curBad)[j];
+				curOut->valI = (*curInts)[j];
+				curOut += numDatums;
+			}
+		}
+		else{
+			curReals->resize(numRow);
+			parseFloatBatch(numRow, &((*curCells)[0]), &((*curReals)[0]), &((*curBad)[0]));
+			for(uintptr_t j = 0; j<numRow; j++){
+				curOut->isNA = (*curBad)[j];
+				curOut->valR = (*curReals)[j];
+				curOut += numDatums;
+			}
+		}
+	}
+}
 
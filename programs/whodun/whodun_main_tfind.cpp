@@ -0,0 +1,57 @@
+#include "whodunmain_programs.h"
+
+#include "whodun_oshook.h"
+#include "whodun_stat_query.h"
+
+using namespace whodun;
+
+WhodunTableFindProgram::WhodunTableFindProgram() : optFind("--find"), optTabIn(1, "--in", "The table to look in."), optIndIn("--index"), optTabOut(0, "--out", "The matching rows to write out."){
+	optFind.summary = "A key to look for.";
+	optFind.usage = "--find key";
+	optIndIn.required = 1;
+	optIndIn.summary = "The index of the table, from tindex.";
+	optIndIn.usage = "--index table.kix";
+	optIndIn.validExts.push_back(".kix");
+	name = "tfind";
+	summary = "Find rows in a block compressed text table using a key index.";
+	version = "whodun tfind 0.0\nCopyright (C) 2022 Benjamin Crysup\nLicense LGPLv3: GNU LGPL version 3\nThis is free software: you are free to change and redistribute it.\nThere is NO WARRANTY, to the extent permitted by law.\n";
+	usage = "tfind --in IN.zlib.bctab --index IN.zlib.bctab.kix --out OUT.tsv --find key";
+	allOptions.push_back(&optFind);
+	allOptions.push_back(&optTC);
+	allOptions.push_back(&optTabIn);
+	allOptions.push_back(&optIndIn);
+	allOptions.push_back(&optTabOut);
+}
+WhodunTableFindProgram::~WhodunTableFindProgram(){}
+void WhodunTableFindProgram::baseRun(){
+	RandacTextTableReader* inStr = 0;
+	RandaccInStream* indStr = 0;
+	TextTableWriter* outStr = 0;
+	try{
+		//open everything
+			uintptr_t numThr = optTC.value;
+			ThreadPool usePool(optTC.value);
+			inStr = new ExtensionRandacTextTableReader(optTabIn.value.c_str(), numThr, &usePool);
+			indStr = new FileInStream(optIndIn.value.c_str());
+			outStr = new ExtensionTextTableWriter(optTabOut.value.c_str(), numThr, &usePool, useOut);
+		//look them all up at once
+			TextTableKeyIndex useIndex(indStr, inStr);
+			std::vector<SizePtrString> allKeys;
+			for(uintptr_t i = 0; i<optFind.value.size(); i++){
+				allKeys.push_back(toSizePtr(&(optFind.value[i])));
+			}
+			TextTable foundTab;
+			useIndex.lookup(allKeys.size(), allKeys.size() ? &(allKeys[0]) : 0, &foundTab, 0);
+			outStr->write(&foundTab);
+		//close it
+			outStr->close(); delete(outStr); outStr = 0;
+			indStr->close(); delete(indStr); indStr = 0;
+			inStr->close(); delete(inStr); inStr = 0;
+	}
+	catch(std::exception& errE){
+		if(inStr){ inStr->close(); delete(inStr); }
+		if(indStr){ indStr->close(); delete(indStr); }
+		if(outStr){ outStr->close(); delete(outStr); }
+		throw;
+	}
+}
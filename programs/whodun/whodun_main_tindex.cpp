@@ -0,0 +1,66 @@
+#include "whodunmain_programs.h"
+
+#include "whodun_oshook.h"
+#include "whodun_stat_query.h"
+
+using namespace whodun;
+
+WhodunTableIndexProgram::WhodunTableIndexProgram() : optKey("--key"), optWidth("--width"), optMem("--mem"), optTemp("--temp"), optTabIn(1, "--in", "The table to index."), optIndOut("--out"){
+	optKey.value = 0;
+	optKey.summary = "The column to index (counting from zero).";
+	optKey.usage = "--key 0";
+	optWidth.value = 32;
+	optWidth.summary = "The number of leading bytes of each key to store in the index.";
+	optWidth.usage = "--width 32";
+	optMem.value = 512;
+	optMem.summary = "The number of megabytes of keys to hold in memory.";
+	optMem.usage = "--mem 512";
+	optTemp.value = "whodun_index_temp";
+	optTemp.summary = "The folder to put temporary files in.";
+	optTemp.usage = "--temp folder";
+	optIndOut.required = 1;
+	optIndOut.summary = "The index to write out.";
+	optIndOut.usage = "--out table.kix";
+	optIndOut.validExts.push_back(".kix");
+	name = "tindex";
+	summary = "Index the keys in a column of a block compressed text table.";
+	version = "whodun tindex 0.0\nCopyright (C) 2022 Benjamin Crysup\nLicense LGPLv3: GNU LGPL version 3\nThis is free software: you are free to change and redistribute it.\nThere is NO WARRANTY, to the extent permitted by law.\n";
+	usage = "tindex --in IN.zlib.bctab --out IN.zlib.bctab.kix --key 0";
+	allOptions.push_back(&optKey);
+	allOptions.push_back(&optWidth);
+	allOptions.push_back(&optMem);
+	allOptions.push_back(&optTemp);
+	allOptions.push_back(&optTC);
+	allOptions.push_back(&optTabIn);
+	allOptions.push_back(&optIndOut);
+}
+WhodunTableIndexProgram::~WhodunTableIndexProgram(){}
+void WhodunTableIndexProgram::idiotCheck(){
+	if(optKey.value < 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Column indices must be non-negative.", 0, 0); }
+	if(optWidth.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need to store at least one byte of key.", 0, 0); }
+	if(optMem.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need some memory to index in.", 0, 0); }
+}
+void WhodunTableIndexProgram::baseRun(){
+	RandacTextTableReader* inStr = 0;
+	OutStream* outStr = 0;
+	try{
+		//open everything
+			uintptr_t numThr = optTC.value;
+			ThreadPool usePool(optTC.value);
+			inStr = new ExtensionRandacTextTableReader(optTabIn.value.c_str(), numThr, &usePool);
+			outStr = new FileOutStream(0, optIndOut.value.c_str());
+		//build it
+			TextTableKeyIndexBuilder doBuild(optTemp.value.c_str(), numThr, &usePool);
+			doBuild.keyWidth = optWidth.value;
+			doBuild.maxLoad = ((uintptr_t)optMem.value) << 20;
+			doBuild.build(inStr, optKey.value, outStr);
+		//close it
+			outStr->close(); delete(outStr); outStr = 0;
+			inStr->close(); delete(inStr); inStr = 0;
+	}
+	catch(std::exception& errE){
+		if(inStr){ inStr->close(); delete(inStr); }
+		if(outStr){ outStr->close(); delete(outStr); }
+		throw;
+	}
+}
@@ -0,0 +1,135 @@
+#include "whodunmain_programs.h"
+
+#include "whodun_oshook.h"
+#include "whodun_stat_query.h"
+
+using namespace whodun;
+
+WhodunTableSortProgram::WhodunTableSortProgram() : optKeys("--key"), optNumeric("--num"), optReverse("--rev"), optWidth("--width"), optMem("--mem"), optTemp("--temp"), optTabIn(0, "--in", "The table to sort."), optTabOut(0, "--out", "The sorted table to write out."){
+	optKeys.summary = "A column to sort by (counting from zero), most important first.";
+	optKeys.usage = "--key 0";
+	optNumeric.summary = "Sort a key column by its value as a number.";
+	optNumeric.usage = "--num 0";
+	optReverse.summary = "Sort a key column largest first.";
+	optReverse.usage = "--rev 0";
+	optWidth.value = 32;
+	optWidth.summary = "The number of leading bytes of non-numeric key columns to compare.";
+	optWidth.usage = "--width 32";
+	optMem.value = 512;
+	optMem.summary = "The number of megabytes of sort keys and rows to hold in memory.";
+	optMem.usage = "--mem 512";
+	optTemp.value = "whodun_sort_temp";
+	optTemp.summary = "The folder to put temporary files in.";
+	optTemp.usage = "--temp folder";
+	name = "tsort";
+	summary = "Sort the rows of a text table.";
+	version = "whodun tsort 0.0\nCopyright (C) 2022 Benjamin Crysup\nLicense LGPLv3: GNU LGPL version 3\nThis is free software: you are free to change and redistribute it.\nThere is NO WARRANTY, to the extent permitted by law.\n";
+	usage = "tsort --in IN.zlib.bctab --out OUT.tsv --key 2 --num 2";
+	allOptions.push_back(&optKeys);
+	allOptions.push_back(&optNumeric);
+	allOptions.push_back(&optReverse);
+	allOptions.push_back(&optWidth);
+	allOptions.push_back(&optMem);
+	allOptions.push_back(&optTemp);
+	allOptions.push_back(&optTC);
+	allOptions.push_back(&optChunky);
+	allOptions.push_back(&optTabIn);
+	allOptions.push_back(&optTabOut);
+}
+WhodunTableSortProgram::~WhodunTableSortProgram(){}
+void WhodunTableSortProgram::idiotCheck(){
+	if(optMem.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need some memory to sort in.", 0, 0); }
+	if(optWidth.value <= 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need to compare at least one byte.", 0, 0); }
+	if(optKeys.value.size() == 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Need at least one column to sort by.", 0, 0); }
+	for(uintptr_t i = 0; i<optKeys.value.size(); i++){
+		if(optKeys.value[i] < 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Column indices must be non-negative.", 0, 0); }
+	}
+	for(uintptr_t i = 0; i<optNumeric.value.size(); i++){
+		if(std::find(optKeys.value.begin(), optKeys.value.end(), optNumeric.value[i]) == optKeys.value.end()){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "--num column is not a --key.", 0, 0); }
+	}
+	for(uintptr_t i = 0; i<optReverse.value.size(); i++){
+		if(std::find(optKeys.value.begin(), optKeys.value.end(), optReverse.value[i]) == optKeys.value.end()){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "--rev column is not a --key.", 0, 0); }
+	}
+}
+void whodun::whodunStageTableName(std::string* tempName, const char* fileName, std::string* toFill, int* madeTemp){
+	if(!directoryExists(tempName->c_str())){
+		if(directoryCreate(tempName->c_str())){
+			const char* packName = tempName->c_str();
+			throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Problem creating temporary folder.", 1, &packName);
+		}
+		*madeTemp = 1;
+	}
+	toFill->append(*tempName);
+	StandardMemorySearcher strMeth;
+	if(!strMeth.memendswith(toSizePtr(toFill->c_str()), toSizePtr(filePathSeparator))){
+		toFill->append(filePathSeparator);
+	}
+	toFill->append(fileName);
+}
+void whodun::whodunKillStagedTable(std::string* stageName, std::string* tempName, int madeTemp){
+	if(stageName->size()){
+		const char* allExt[] = {"", ".blk", ".ind", ".ind.blk"};
+		for(uintptr_t i = 0; i<4; i++){
+			std::string curName = *stageName; curName.append(allExt[i]);
+			if(fileExists(curName.c_str())){ fileKill(curName.c_str()); }
+		}
+	}
+	if(madeTemp){ directoryKill(tempName->c_str()); }
+}
+void WhodunTableSortProgram::baseRun(){
+	TextTableReader* inStr = 0;
+	TextTableWriter* stageStr = 0;
+	RandacTextTableReader* sortStr = 0;
+	TextTableWriter* outStr = 0;
+	TableExternalSort* doSort = 0;
+	std::string stageName;
+	int madeTemp = 0;
+	try{
+		uintptr_t numThr = optTC.value;
+		ThreadPool usePool(optTC.value);
+		uintptr_t chunkS = numThr * optChunky.value;
+		//anything that cannot be jumped around in gets copied
+			StandardMemorySearcher strMeth;
+			if(!strMeth.memendswith(toSizePtr(optTabIn.value.c_str()), toSizePtr(".bctab"))){
+				whodunStageTableName(&(optTemp.value), "whodun_sort_stage.raw.bctab", &stageName, &madeTemp);
+				inStr = new ExtensionTextTableReader(optTabIn.value.c_str(), numThr, &usePool, useIn);
+				stageStr = new ExtensionTextTableWriter(stageName.c_str(), numThr, &usePool);
+				TextTable workTab;
+				while(1){
+					uintptr_t numGot = inStr->read(&workTab, chunkS);
+					if(numGot == 0){ break; }
+					stageStr->write(&workTab);
+				}
+				stageStr->close(); delete(stageStr); stageStr = 0;
+				inStr->close(); delete(inStr); inStr = 0;
+			}
+			sortStr = new ExtensionRandacTextTableReader(stageName.size() ? stageName.c_str() : optTabIn.value.c_str(), numThr, &usePool);
+		//figure out what to do
+			doSort = new TableExternalSort(optTemp.value.c_str(), numThr, &usePool);
+			doSort->maxLoad = ((uintptr_t)optMem.value) << 20;
+			for(uintptr_t i = 0; i<optKeys.value.size(); i++){
+				intptr_t curC = optKeys.value[i];
+				int curF = 0;
+				if(std::find(optNumeric.value.begin(), optNumeric.value.end(), curC) != optNumeric.value.end()){ curF |= WHODUN_TABLESORT_NUMERIC; }
+				if(std::find(optReverse.value.begin(), optReverse.value.end(), curC) != optReverse.value.end()){ curF |= WHODUN_TABLESORT_REVERSE; }
+				doSort->addKey(curC, curF, optWidth.value);
+			}
+		//sort it
+			outStr = new ExtensionTextTableWriter(optTabOut.value.c_str(), numThr, &usePool, useOut);
+			doSort->sortText(sortStr, outStr);
+		//close it
+			delete(doSort); doSort = 0;
+			outStr->close(); delete(outStr); outStr = 0;
+			sortStr->close(); delete(sortStr); sortStr = 0;
+			whodunKillStagedTable(&stageName, &(optTemp.value), madeTemp);
+	}
+	catch(std::exception& errE){
+		if(doSort){ delete(doSort); }
+		if(inStr){ inStr->close(); delete(inStr); }
+		if(stageStr){ stageStr->close(); delete(stageStr); }
+		if(sortStr){ sortStr->close(); delete(sortStr); }
+		if(outStr){ outStr->close(); delete(outStr); }
+		whodunKillStagedTable(&stageName, &(optTemp.value), madeTemp);
+		throw;
+	}
+}
@@ -47,6 +47,12 @@ WhodunProgramSet::WhodunProgramSet(){
 	hotPrograms["d2t"] = makeNewProgram<WhodunDataToTableProgram>;
 	hotPrograms["tconv"] = makeNewProgram<WhodunTableConvertProgram>;
 	hotPrograms["t2d"] = makeNewProgram<WhodunTableToDataProgram>;
+	hotPrograms["group"] = makeNewProgram<WhodunDataGroupProgram>;
+	hotPrograms["join"] = makeNewProgram<WhodunDataJoinProgram>;
+	hotPrograms["tsort"] = makeNewProgram<WhodunTableSortProgram>;
+	hotPrograms["dsort"] = makeNewProgram<WhodunDataSortProgram>;
+	hotPrograms["tindex"] = makeNewProgram<WhodunTableIndexProgram>;
+	hotPrograms["tfind"] = makeNewProgram<WhodunTableFindProgram>;
 	//TODO
 }
 WhodunProgramSet::~WhodunProgramSet(){}
@@ -7,6 +7,31 @@
 
 namespace whodun {
 
+/**
+ * Find a column of a data table by name.
+ * @param forData The table to look in.
+ * @param colName The name of the column.
+ * @return The index of the column.
+ */
+uintptr_t whodunFindDataColumn(DataTableDescription* forData, std::string* colName);
+
+/**
+ * Make the name for a copy of a table in a temporary folder.
+ * @param tempName The temporary folder: made if it does not exist.
+ * @param fileName The name of the copy.
+ * @param toFill The place to put the full name.
+ * @param madeTemp The place to note whether the folder was made.
+ */
+void whodunStageTableName(std::string* tempName, const char* fileName, std::string* toFill, int* madeTemp);
+
+/**
+ * Remove a copy of a table from a temporary folder.
+ * @param stageName The full name of the copy, or empty if none was made.
+ * @param tempName The temporary folder.
+ * @param madeTemp Whether the folder should be removed.
+ */
+void whodunKillStagedTable(std::string* stageName, std::string* tempName, int madeTemp);
+
 /**A program to convert between types of data tables.*/
 class WhodunDataConvertProgram : public StandardProgram{
 public:
@@ -91,6 +116,185 @@ public:
 	ArgumentOptionDataTableWrite optDatOut;
 };
 
+/**Summarize the rows of a data table by group.*/
+class WhodunDataGroupProgram : public StandardProgram{
+public:
+	/**Set up*/
+	WhodunDataGroupProgram();
+	/**Tear down*/
+	~WhodunDataGroupProgram();
+	void idiotCheck();
+	void baseRun();
+	
+	/**The columns to group by.*/
+	ArgumentOptionStringVector optKeys;
+	/**Whether to count the rows in each group.*/
+	ArgumentOptionFlag optRows;
+	/**The columns to count known values of.*/
+	ArgumentOptionStringVector optCount;
+	/**The columns to sum.*/
+	ArgumentOptionStringVector optSum;
+	/**The columns to average.*/
+	ArgumentOptionStringVector optMean;
+	/**The columns to find the minimum of.*/
+	ArgumentOptionStringVector optMin;
+	/**The columns to find the maximum of.*/
+	ArgumentOptionStringVector optMax;
+	/**The columns to find the variance of.*/
+	ArgumentOptionStringVector optVar;
+	/**The number of megabytes of groups to hold in memory.*/
+	ArgumentOptionInteger optMem;
+	/**The folder for temporary files.*/
+	ArgumentOptionFolderWrite optTemp;
+	/**The number of threads to spin up.*/
+	ArgumentOptionThreadcount optTC;
+	/**How many to do in one go, per thread.*/
+	ArgumentOptionThreadgrain optChunky;
+	/**The table to summarize.*/
+	ArgumentOptionDataTableRead optTabIn;
+	/**The table to write to.*/
+	ArgumentOptionDataTableWrite optTabOut;
+};
+
+/**Join the rows of a data table to matching rows of another.*/
+class WhodunDataJoinProgram : public StandardProgram{
+public:
+	/**Set up*/
+	WhodunDataJoinProgram();
+	/**Tear down*/
+	~WhodunDataJoinProgram();
+	void idiotCheck();
+	void baseRun();
+	
+	/**The columns to join on.*/
+	ArgumentOptionStringVector optKeys;
+	/**The names of the join columns in the table to look in, if different.*/
+	ArgumentOptionStringVector optWithKeys;
+	/**Whether to keep rows without a match.*/
+	ArgumentOptionFlag optLeft;
+	/**The number of megabytes of rows to hold in memory.*/
+	ArgumentOptionInteger optMem;
+	/**The folder for temporary files.*/
+	ArgumentOptionFolderWrite optTemp;
+	/**The number of threads to spin up.*/
+	ArgumentOptionThreadcount optTC;
+	/**How many to do in one go, per thread.*/
+	ArgumentOptionThreadgrain optChunky;
+	/**The table to look up.*/
+	ArgumentOptionDataTableRead optTabIn;
+	/**The table to look in.*/
+	ArgumentOptionDataTableRead optTabWith;
+	/**The table to write to.*/
+	ArgumentOptionDataTableWrite optTabOut;
+};
+
+/**Sort the rows of a text table.*/
+class WhodunTableSortProgram : public StandardProgram{
+public:
+	/**Set up*/
+	WhodunTableSortProgram();
+	/**Tear down*/
+	~WhodunTableSortProgram();
+	void idiotCheck();
+	void baseRun();
+	
+	/**The columns to sort by.*/
+	ArgumentOptionIntegerVector optKeys;
+	/**The columns to sort as numbers.*/
+	ArgumentOptionIntegerVector optNumeric;
+	/**The columns to sort largest first.*/
+	ArgumentOptionIntegerVector optReverse;
+	/**The number of bytes of text to compare.*/
+	ArgumentOptionInteger optWidth;
+	/**The number of megabytes to hold in memory.*/
+	ArgumentOptionInteger optMem;
+	/**The folder for temporary files.*/
+	ArgumentOptionFolderWrite optTemp;
+	/**The number of threads to spin up.*/
+	ArgumentOptionThreadcount optTC;
+	/**How many to do in one go, per thread.*/
+	ArgumentOptionThreadgrain optChunky;
+	/**The table to sort.*/
+	ArgumentOptionTextTableRead optTabIn;
+	/**The table to write to.*/
+	ArgumentOptionTextTableWrite optTabOut;
+};
+
+/**Sort the rows of a data table.*/
+class WhodunDataSortProgram : public StandardProgram{
+public:
+	/**Set up*/
+	WhodunDataSortProgram();
+	/**Tear down*/
+	~WhodunDataSortProgram();
+	void idiotCheck();
+	void baseRun();
+	
+	/**The columns to sort by.*/
+	ArgumentOptionStringVector optKeys;
+	/**The columns to sort largest first.*/
+	ArgumentOptionStringVector optReverse;
+	/**The number of megabytes to hold in memory.*/
+	ArgumentOptionInteger optMem;
+	/**The folder for temporary files.*/
+	ArgumentOptionFolderWrite optTemp;
+	/**The number of threads to spin up.*/
+	ArgumentOptionThreadcount optTC;
+	/**How many to do in one go, per thread.*/
+	ArgumentOptionThreadgrain optChunky;
+	/**The table to sort.*/
+	ArgumentOptionDataTableRead optTabIn;
+	/**The table to write to.*/
+	ArgumentOptionDataTableWrite optTabOut;
+};
+
+/**Index the keys in a column of a text table.*/
+class WhodunTableIndexProgram : public StandardProgram{
+public:
+	/**Set up*/
+	WhodunTableIndexProgram();
+	/**Tear down*/
+	~WhodunTableIndexProgram();
+	void idiotCheck();
+	void baseRun();
+	
+	/**The column to index.*/
+	ArgumentOptionInteger optKey;
+	/**The number of bytes of key to store.*/
+	ArgumentOptionInteger optWidth;
+	/**The number of megabytes to hold in memory.*/
+	ArgumentOptionInteger optMem;
+	/**The folder for temporary files.*/
+	ArgumentOptionFolderWrite optTemp;
+	/**The number of threads to spin up.*/
+	ArgumentOptionThreadcount optTC;
+	/**The table to index.*/
+	ArgumentOptionTextTableRandac optTabIn;
+	/**The index to write.*/
+	ArgumentOptionFileWrite optIndOut;
+};
+
+/**Find rows in a text table by key.*/
+class WhodunTableFindProgram : public StandardProgram{
+public:
+	/**Set up*/
+	WhodunTableFindProgram();
+	/**Tear down*/
+	~WhodunTableFindProgram();
+	void baseRun();
+	
+	/**The keys to look for.*/
+	ArgumentOptionStringVector optFind;
+	/**The number of threads to spin up.*/
+	ArgumentOptionThreadcount optTC;
+	/**The table to look in.*/
+	ArgumentOptionTextTableRandac optTabIn;
+	/**The index of the table.*/
+	ArgumentOptionFileRead optIndIn;
+	/**The table to write to.*/
+	ArgumentOptionTextTableWrite optTabOut;
+};
+
 //TODO
 
 };
@@ -18,6 +18,8 @@ public:
 class DeflateCompressionMethod : public CompressionMethod{
 public:
 	void compressData(SizePtrString theData);
+	/**The compression level to use.*/
+	int compLevel;
 };
 
 /**Perform deflate decompression.*/
@@ -118,8 +120,16 @@ DecompressionMethod* RawCompressionFactory::makeUnzip(){
 	return new RawDecompressionMethod();
 }
 
+DeflateCompressionFactory::DeflateCompressionFactory(){
+	compLevel = Z_DEFAULT_COMPRESSION;
+}
+DeflateCompressionFactory::DeflateCompressionFactory(int useLevel){
+	compLevel = useLevel;
+}
 CompressionMethod* DeflateCompressionFactory::makeZip(){
-	return new DeflateCompressionMethod();
+	DeflateCompressionMethod* toRet = new DeflateCompressionMethod();
+	toRet->compLevel = compLevel;
+	return toRet;
 }
 DecompressionMethod* DeflateCompressionFactory::makeUnzip(){
 	return new DeflateDecompressionMethod();
@@ -158,10 +168,16 @@ void RawDecompressionMethod::expandData(SizePtrString theComp){
 }
 
 void DeflateCompressionMethod::compressData(SizePtrString theData){
+	uintptr_t needSize = compressBound(theData.len);
+	if(needSize > allocSize){
+		free(compData.txt);
+		allocSize = needSize;
+		compData.txt = (char*)malloc(allocSize);
+	}
 	unsigned long bufEndSStore = allocSize;
 	int compRes = 0;
-	while((compRes = compress(((unsigned char*)(compData.txt)), &bufEndSStore, ((const unsigned char*)(theData.txt)), theData.len)) != Z_OK){
-		if((compRes == Z_MEM_ERROR) || (compRes == Z_DATA_ERROR)){
+	while((compRes = compress2(((unsigned char*)(compData.txt)), &bufEndSStore, ((const unsigned char*)(theData.txt)), theData.len, compLevel)) != Z_OK){
+		if((compRes == Z_MEM_ERROR) || (compRes == Z_DATA_ERROR) || (compRes == Z_STREAM_ERROR)){
 			throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Error compressing deflate data.", 0, 0);
 		}
 		allocSize = allocSize << 1;
@@ -767,10 +783,8 @@ uintptr_t BlockCompInStream::read(char* toR, uintptr_t numR){
 			ByteUnpacker doUPack(annotBuff);
 			uintmax_t precomLowA = doUPack.unpackBE64();
 			uintmax_t compLowA = doUPack.unpackBE64();
-			uintmax_t precomHighA = doUPack.unpackBE64();
-			uintmax_t compHighA = doUPack.unpackBE64();
-			uintptr_t pcLen = precomHighA - precomLowA;
-			uintptr_t comLen = compHighA - compLowA;
+			uintptr_t pcLen = doUPack.unpackBE64();
+			uintptr_t comLen = doUPack.unpackBE64();
 			uintptr_t skipFirst = totalReads - precomLowA;
 			uintptr_t curLeft = leftR - totalPostLoad;
 			mainF->seek(compLowA);
@@ -801,12 +815,9 @@ uintptr_t BlockCompInStream::read(char* toR, uintptr_t numR){
 				char annotBuff[WHODUN_BLOCKCOMP_ANNOT_ENTLEN];
 				annotF->forceRead(annotBuff, WHODUN_BLOCKCOMP_ANNOT_ENTLEN);
 				ByteUnpacker doUPack(annotBuff);
-				uintmax_t precomLowA = doUPack.unpackBE64();
-				uintmax_t compLowA = doUPack.unpackBE64();
-				uintmax_t precomHighA = doUPack.unpackBE64();
-				uintmax_t compHighA = doUPack.unpackBE64();
-				uintptr_t pcLen = precomHighA - precomLowA;
-				uintptr_t comLen = compHighA - compLowA;
+				doUPack.skip(16);
+				uintptr_t pcLen = doUPack.unpackBE64();
+				uintptr_t comLen = doUPack.unpackBE64();
 				uintptr_t curLeft = leftR - totalPostLoad;
 				curGrab->theComp.txt = chunkMarshal + numLoadBytes;
 				curGrab->theComp.len = comLen;
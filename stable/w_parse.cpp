@@ -1,6 +1,7 @@
 #include "whodun_parse.h"
 
 #include <string.h>
+#include <algorithm>
 
 namespace whodun {
 
@@ -15,6 +16,8 @@ public:
 	
 	/**The character to split on.*/
 	char splitOn;
+	/**The characters to split on, if more than one.*/
+	ByteSetSearcher* splitSet;
 	/**The string to hunt in.*/
 	SizePtrString toHunt;
 	/**The offset to add to any split indices.*/
@@ -43,7 +46,61 @@ public:
 	/**The place to put the tokens.*/
 	Token* toFill;
 	/**Save the base thing.*/
-	MultithreadedCharacterSplitTokenizer* saveBase;
+	CharacterSplitTokenizer* saveBase;
+};
+
+/**Hunt split points, keeping escapes in mind and noting the quote state each was found in.*/
+class MultithreadedEscapedSplitHunter : public MultithreadedCharacterSplitHunter{
+public:
+	/**Basic setup*/
+	MultithreadedEscapedSplitHunter();
+	/**Tear down*/
+	~MultithreadedEscapedSplitHunter();
+	void doTask();
+	
+	/**The tokenizer this is for.*/
+	EscapedCharacterSplitTokenizer* saveBase;
+	/**The full text being tokenized (to look for escapes before this piece).*/
+	SizePtrString fullText;
+	/**The splits that are real if this piece actually starts inside quotes.*/
+	std::vector<uintptr_t> altIndices;
+	/**Whether this piece has an odd number of (unescaped) quotes.*/
+	int flipsQuote;
+};
+
+/**
+ * Find the delimiters in some text, skipping escaped ones and sorting them by quote state.
+ * @param forSplit The tokenizer with the characters to look for.
+ * @param toHunt The text to look through.
+ * @param firstLiteral Whether the first character of the text is escaped.
+ * @param splitOffset The offset to add to any split indices.
+ * @param outSplits The place to put delimiters outside quotes (assuming the text starts outside quotes).
+ * @param inSplits The place to put delimiters inside quotes (assuming the text starts outside quotes).
+ * @return Whether the text has an odd number of (unescaped) quotes.
+ */
+int escapedSplitHunt(EscapedCharacterSplitTokenizer* forSplit, SizePtrString toHunt, int firstLiteral, uintptr_t splitOffset, std::vector<uintptr_t>* outSplits, std::vector<uintptr_t>* inSplits);
+
+/**Cut a chunk of text into tokens, starting from a guess.*/
+class MultithreadedRegexTokenizerTask : public JoinableThreadTask{
+public:
+	/**Basic setup*/
+	MultithreadedRegexTokenizerTask();
+	/**Tear down*/
+	~MultithreadedRegexTokenizerTask();
+	void doTask();
+	
+	/**The regex set to use.*/
+	RegexSet* useRgx;
+	/**The full text being tokenized.*/
+	SizePtrString fullText;
+	/**The index to start cutting at.*/
+	uintptr_t startInd;
+	/**The index to stop starting tokens at.*/
+	uintptr_t endInd;
+	/**The tokens found.*/
+	StructVector<Token> foundToks;
+	/**For each place cutting failed (text that is not a token), the number of tokens found before it.*/
+	std::vector<uintptr_t> badBefore;
 };
 
 };
@@ -57,6 +114,14 @@ CharacterSplitTokenizer::CharacterSplitTokenizer(char onChar){
 	typeDelim = 0;
 	typeText = 1;
 	splitOn = onChar;
+	splitMulti = 0;
+}
+CharacterSplitTokenizer::CharacterSplitTokenizer(const char* onChars, uintptr_t numChars){
+	typeDelim = 0;
+	typeText = 1;
+	splitOn = numChars ? onChars[0] : 0;
+	splitMulti = numChars > 1;
+	splitSet.setBytes(onChars, numChars);
 }
 CharacterSplitTokenizer::~CharacterSplitTokenizer(){
 }
@@ -65,6 +130,35 @@ uintptr_t CharacterSplitTokenizer::numTokenTypes(){
 }
 SizePtrString CharacterSplitTokenizer::tokenize(SizePtrString toCut, StructVector<Token>* fillTokens){
 	Token curPush;
+	if(splitMulti){
+		//walk the masks of split positions
+		uintptr_t prevStart = 0;
+		uintptr_t curBase = 0;
+		while(curBase < toCut.len){
+			uintptr_t curNum = std::min((uintptr_t)64, toCut.len - curBase);
+			uint64_t curMask = splitSet.mask64(toCut.txt + curBase, curNum);
+			while(curMask){
+				uintptr_t curSplitInd = curBase + __builtin_ctzll(curMask);
+				curPush.text.txt = toCut.txt + prevStart;
+					curPush.text.len = curSplitInd - prevStart;
+					curPush.numTypes = 1;
+					curPush.types = &typeText;
+					fillTokens->push_back(&curPush);
+				curPush.text.txt = toCut.txt + curSplitInd;
+					curPush.text.len = 1;
+					curPush.numTypes = 1;
+					curPush.types = &typeDelim;
+					fillTokens->push_back(&curPush);
+				prevStart = curSplitInd + 1;
+				curMask = curMask & (curMask - 1);
+			}
+			curBase += curNum;
+		}
+		SizePtrString remText;
+			remText.txt = toCut.txt + prevStart;
+			remText.len = toCut.len - prevStart;
+		return remText;
+	}
 	SizePtrString nextCut = toCut;
 	char* findIt = (char*)doMem.memchr(nextCut.txt, splitOn, nextCut.len);
 	while(findIt){
@@ -87,11 +181,19 @@ SizePtrString CharacterSplitTokenizer::tokenize(SizePtrString toCut, StructVecto
 
 MultithreadedCharacterSplitTokenizer::MultithreadedCharacterSplitTokenizer(char onChar, uintptr_t numThread, ThreadPool* mainPool) : CharacterSplitTokenizer(onChar){
 	usePool = mainPool;
+	makeTasks(numThread);
+}
+MultithreadedCharacterSplitTokenizer::MultithreadedCharacterSplitTokenizer(const char* onChars, uintptr_t numChars, uintptr_t numThread, ThreadPool* mainPool) : CharacterSplitTokenizer(onChars, numChars){
+	usePool = mainPool;
+	makeTasks(numThread);
+}
+void MultithreadedCharacterSplitTokenizer::makeTasks(uintptr_t numThread){
 	std::vector<MultithreadedCharacterSplitHunter*>* huntTasks = new std::vector<MultithreadedCharacterSplitHunter*>();
 	std::vector<MultithreadedCharacterSplitPatcher*>* patchTasks = new std::vector<MultithreadedCharacterSplitPatcher*>();
 	for(uintptr_t i = 0; i<numThread; i++){
 		MultithreadedCharacterSplitHunter* curHunt = new MultithreadedCharacterSplitHunter();
-			curHunt->splitOn = onChar;
+			curHunt->splitOn = splitOn;
+			curHunt->splitSet = splitMulti ? &splitSet : 0;
 			huntTasks->push_back(curHunt);
 		MultithreadedCharacterSplitPatcher* curPatch = new MultithreadedCharacterSplitPatcher();
 			curPatch->doSplits = curHunt;
@@ -162,10 +264,25 @@ SizePtrString MultithreadedCharacterSplitTokenizer::tokenize(SizePtrString toCut
 		return remText;
 }
 
-MultithreadedCharacterSplitHunter::MultithreadedCharacterSplitHunter(){}
+MultithreadedCharacterSplitHunter::MultithreadedCharacterSplitHunter(){
+	splitSet = 0;
+}
 MultithreadedCharacterSplitHunter::~MultithreadedCharacterSplitHunter(){}
 void MultithreadedCharacterSplitHunter::doTask(){
 	splitIndices.clear();
+	if(splitSet){
+		uintptr_t curBase = 0;
+		while(curBase < toHunt.len){
+			uintptr_t curNum = std::min((uintptr_t)64, toHunt.len - curBase);
+			uint64_t curMask = splitSet->mask64(toHunt.txt + curBase, curNum);
+			while(curMask){
+				splitIndices.push_back(splitOffset + curBase + __builtin_ctzll(curMask));
+				curMask = curMask & (curMask - 1);
+			}
+			curBase += curNum;
+		}
+		return;
+	}
 	SizePtrString remHunt = toHunt;
 	char* findIt = (char*)doMem.memchr(remHunt.txt, splitOn, remHunt.len);
 	while(findIt){
@@ -200,6 +317,175 @@ void MultithreadedCharacterSplitPatcher::doTask(){
 	}
 }
 
+EscapedCharacterSplitTokenizer::EscapedCharacterSplitTokenizer(char onChar, int escChar, int quotChar) : CharacterSplitTokenizer(onChar){
+	escapeChar = escChar;
+	quoteChar = quotChar;
+	char allSpec[3];
+	uintptr_t numSpec = 0;
+	allSpec[numSpec++] = onChar;
+	if(escChar >= 0){ allSpec[numSpec++] = escChar; }
+	if(quotChar >= 0){ allSpec[numSpec++] = quotChar; }
+	specialSet.setBytes(allSpec, numSpec);
+}
+EscapedCharacterSplitTokenizer::~EscapedCharacterSplitTokenizer(){}
+SizePtrString EscapedCharacterSplitTokenizer::tokenize(SizePtrString toCut, StructVector<Token>* fillTokens){
+	std::vector<uintptr_t> foundSplits;
+	escapedSplitHunt(this, toCut, 0, 0, &foundSplits, 0);
+	Token curPush;
+	uintptr_t prevStart = 0;
+	for(uintptr_t i = 0; i<foundSplits.size(); i++){
+		uintptr_t curSplitInd = foundSplits[i];
+		curPush.text.txt = toCut.txt + prevStart;
+			curPush.text.len = curSplitInd - prevStart;
+			curPush.numTypes = 1;
+			curPush.types = &typeText;
+			fillTokens->push_back(&curPush);
+		curPush.text.txt = toCut.txt + curSplitInd;
+			curPush.text.len = 1;
+			curPush.numTypes = 1;
+			curPush.types = &typeDelim;
+			fillTokens->push_back(&curPush);
+		prevStart = curSplitInd + 1;
+	}
+	SizePtrString remText;
+		remText.txt = toCut.txt + prevStart;
+		remText.len = toCut.len - prevStart;
+	return remText;
+}
+
+MultithreadedEscapedCharacterSplitTokenizer::MultithreadedEscapedCharacterSplitTokenizer(char onChar, int escChar, int quotChar, uintptr_t numThread, ThreadPool* mainPool) : EscapedCharacterSplitTokenizer(onChar, escChar, quotChar){
+	usePool = mainPool;
+	std::vector<MultithreadedEscapedSplitHunter*>* huntTasks = new std::vector<MultithreadedEscapedSplitHunter*>();
+	std::vector<MultithreadedCharacterSplitPatcher*>* patchTasks = new std::vector<MultithreadedCharacterSplitPatcher*>();
+	for(uintptr_t i = 0; i<numThread; i++){
+		MultithreadedEscapedSplitHunter* curHunt = new MultithreadedEscapedSplitHunter();
+			curHunt->saveBase = this;
+			huntTasks->push_back(curHunt);
+		MultithreadedCharacterSplitPatcher* curPatch = new MultithreadedCharacterSplitPatcher();
+			curPatch->doSplits = curHunt;
+			curPatch->saveBase = this;
+			patchTasks->push_back(curPatch);
+	}
+	useForUA = huntTasks;
+	useForUB = patchTasks;
+}
+MultithreadedEscapedCharacterSplitTokenizer::~MultithreadedEscapedCharacterSplitTokenizer(){
+	std::vector<MultithreadedEscapedSplitHunter*>* huntTasks = (std::vector<MultithreadedEscapedSplitHunter*>*)useForUA;
+	std::vector<MultithreadedCharacterSplitPatcher*>* patchTasks = (std::vector<MultithreadedCharacterSplitPatcher*>*)useForUB;
+	for(uintptr_t i = 0; i<huntTasks->size(); i++){
+		delete((*huntTasks)[i]);
+		delete((*patchTasks)[i]);
+	}
+	delete(huntTasks);
+	delete(patchTasks);
+}
+SizePtrString MultithreadedEscapedCharacterSplitTokenizer::tokenize(SizePtrString toCut, StructVector<Token>* fillTokens){
+	//hunt assuming each piece starts outside quotes (escapes are settled locally)
+		std::vector<MultithreadedEscapedSplitHunter*>* huntTasks = (std::vector<MultithreadedEscapedSplitHunter*>*)useForUA;
+		uintptr_t numThread = huntTasks->size();
+		uintptr_t numPT = toCut.len / numThread;
+		uintptr_t numET = toCut.len % numThread;
+		uintptr_t curInd = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			uintptr_t curNum = numPT + (i < numET);
+			MultithreadedEscapedSplitHunter* curHunt = ((*huntTasks)[i]);
+			curHunt->fullText = toCut;
+			curHunt->toHunt.txt = toCut.txt + curInd;
+			curHunt->toHunt.len = curNum;
+			curHunt->splitOffset = curInd;
+			curInd += curNum;
+		}
+		usePool->addTasks(numThread, (JoinableThreadTask**)(&((*huntTasks)[0])));
+		joinTasks(numThread, (JoinableThreadTask**)(&((*huntTasks)[0])));
+	//fix up the quote state of each piece, and count the splits
+		int inQuote = 0;
+		uintptr_t numSplit = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			MultithreadedEscapedSplitHunter* curHunt = ((*huntTasks)[i]);
+			if(inQuote){ std::swap(curHunt->splitIndices, curHunt->altIndices); }
+			inQuote = inQuote ^ curHunt->flipsQuote;
+			numSplit += curHunt->splitIndices.size();
+		}
+		if(numSplit == 0){ return toCut; }
+	//patch up the tokens
+		std::vector<MultithreadedCharacterSplitPatcher*>* patchTasks = (std::vector<MultithreadedCharacterSplitPatcher*>*)useForUB;
+		uintptr_t origSize = fillTokens->size();
+		fillTokens->resize(origSize + 2*numSplit);
+		Token* curPushTok = (*fillTokens)[origSize];
+		uintptr_t curBaseIndex = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			MultithreadedEscapedSplitHunter* curHunt = ((*huntTasks)[i]);
+			MultithreadedCharacterSplitPatcher* curPatch = ((*patchTasks)[i]);
+			curPatch->fullText = toCut;
+			curPatch->priorBase = curBaseIndex;
+			curPatch->toFill = curPushTok;
+			uintptr_t curNumSplit = curHunt->splitIndices.size();
+			if(curNumSplit){
+				curPushTok += (2*curNumSplit);
+				curBaseIndex = curHunt->splitIndices[curNumSplit-1] + 1;
+			}
+		}
+		usePool->addTasks(numThread, (JoinableThreadTask**)(&((*patchTasks)[0])));
+		joinTasks(numThread, (JoinableThreadTask**)(&((*patchTasks)[0])));
+	//note what wasn't cut
+		SizePtrString remText;
+			remText.txt = toCut.txt + curBaseIndex;
+			remText.len = toCut.len - curBaseIndex;
+		return remText;
+}
+
+MultithreadedEscapedSplitHunter::MultithreadedEscapedSplitHunter(){}
+MultithreadedEscapedSplitHunter::~MultithreadedEscapedSplitHunter(){}
+void MultithreadedEscapedSplitHunter::doTask(){
+	splitIndices.clear();
+	altIndices.clear();
+	//an odd run of escapes right before this piece escapes its first character
+		int firstLiteral = 0;
+		if(saveBase->escapeChar >= 0){
+			char escC = saveBase->escapeChar;
+			uintptr_t numEsc = 0;
+			while((numEsc < splitOffset) && (fullText.txt[splitOffset - (numEsc + 1)] == escC)){ numEsc++; }
+			firstLiteral = numEsc & 1;
+		}
+	flipsQuote = escapedSplitHunt(saveBase, toHunt, firstLiteral, splitOffset, &splitIndices, &altIndices);
+}
+
+int whodun::escapedSplitHunt(EscapedCharacterSplitTokenizer* forSplit, SizePtrString toHunt, int firstLiteral, uintptr_t splitOffset, std::vector<uintptr_t>* outSplits, std::vector<uintptr_t>* inSplits){
+	//masks come back as delimiter, then escape and quote if present
+	uintptr_t escSlot = (forSplit->escapeChar >= 0) ? 1 : 0;
+	uintptr_t quoteSlot = (forSplit->quoteChar >= 0) ? (1 + escSlot) : 0;
+	uint64_t allMasks[WHODUN_BYTECLASS_MAX];
+	uint64_t prevEscaped = firstLiteral ? 1 : 0;
+	uint64_t prevQuoted = 0;
+	uintptr_t curBase = 0;
+	while(curBase < toHunt.len){
+		uintptr_t curNum = std::min((uintptr_t)64, toHunt.len - curBase);
+		forSplit->specialSet.mask64(toHunt.txt + curBase, curNum, allMasks);
+		uint64_t splitMask = allMasks[0];
+		uint64_t quotedMask = 0;
+		if(escSlot){
+			uint64_t escapedMask = maskEscaped64(allMasks[escSlot], &prevEscaped);
+			splitMask = splitMask & ~escapedMask;
+			if(quoteSlot){ allMasks[quoteSlot] = allMasks[quoteSlot] & ~escapedMask; }
+		}
+		if(quoteSlot){ quotedMask = maskQuoted64(allMasks[quoteSlot], &prevQuoted); }
+		uint64_t curMask = splitMask & ~quotedMask;
+		while(curMask){
+			outSplits->push_back(splitOffset + curBase + __builtin_ctzll(curMask));
+			curMask = curMask & (curMask - 1);
+		}
+		if(inSplits){
+			curMask = splitMask & quotedMask;
+			while(curMask){
+				inSplits->push_back(splitOffset + curBase + __builtin_ctzll(curMask));
+				curMask = curMask & (curMask - 1);
+			}
+		}
+		curBase += curNum;
+	}
+	return prevQuoted & 1;
+}
+
 RegexTokenizer::RegexTokenizer(RegexSet* useRegex){
 	useRgx = useRegex;
 }
@@ -213,7 +499,7 @@ SizePtrString RegexTokenizer::tokenize(SizePtrString toCut, StructVector<Token>*
 	while(nextCut.len){
 		//TODO fix this to cut on certainty only
 		intptr_t longMat = useRgx->longMatchLength(nextCut, &(curPush.numTypes), &(curPush.types));
-		if(longMat < 0){ break; }
+		if(longMat <= 0){ break; }
 		curPush.text.txt = nextCut.txt;
 		curPush.text.len = longMat;
 		fillTokens->push_back(&curPush);
@@ -223,5 +509,223 @@ SizePtrString RegexTokenizer::tokenize(SizePtrString toCut, StructVector<Token>*
 	return nextCut;
 }
 
+RegexStreamTokenizer::RegexStreamTokenizer(RegexSet* useRegex) : RegexTokenizer(useRegex){
+	readSize = WHODUN_STREAMTOKEN_CHUNK;
+	reset();
+}
+RegexStreamTokenizer::RegexStreamTokenizer(RegexSet* useRegex, uintptr_t chunkSize) : RegexTokenizer(useRegex){
+	readSize = chunkSize;
+	reset();
+}
+RegexStreamTokenizer::~RegexStreamTokenizer(){}
+SizePtrString RegexStreamTokenizer::tokenize(SizePtrString toCut, StructVector<Token>* fillTokens){
+	reset();
+	feed(toCut, fillTokens);
+	return finish(fillTokens);
+}
+void RegexStreamTokenizer::reset(){
+	hitBad = 0;
+	totalFed = 0;
+	tokStart = 0;
+	pendText.clear();
+	leftText.len = 0;
+	leftText.txt = 0;
+	useRgx->startMatch(&curProg);
+}
+int RegexStreamTokenizer::feed(SizePtrString toCut, StructVector<Token>* fillTokens){
+	cutPiece(toCut, fillTokens, 0);
+	return !hitBad;
+}
+int RegexStreamTokenizer::feed(InStream* fromStr, StructVector<Token>* fillTokens){
+	readText.resize(readSize);
+	SizePtrString toCut;
+		toCut.txt = &(readText[0]);
+		toCut.len = fromStr->read(toCut.txt, readSize);
+	if(toCut.len == 0){
+		finish(fillTokens);
+		return 0;
+	}
+	cutPiece(toCut, fillTokens, 0);
+	return !hitBad;
+}
+SizePtrString RegexStreamTokenizer::finish(StructVector<Token>* fillTokens){
+	SizePtrString noText = {0, 0};
+	cutPiece(noText, fillTokens, 1);
+	return leftText;
+}
+void RegexStreamTokenizer::cutPiece(SizePtrString toCut, StructVector<Token>* fillTokens, int atEnd){
+	if(hitBad){ return; }
+	uintmax_t pendStart = tokStart;
+	uintmax_t pieceStart = totalFed;
+	uintmax_t pieceEnd = pieceStart + toCut.len;
+	joinText.clear();
+	Token curPush;
+	//cut what can be cut
+		uintmax_t scanAt = tokStart + curProg.numSeen;
+		while(true){
+			//feed the next bit to the match (pending text can show up again after a token ends inside it)
+			if(!curProg.isDead){
+				SizePtrString nextLook;
+				if(scanAt < pieceStart){
+					nextLook.txt = &(pendText[scanAt - pendStart]);
+					nextLook.len = pieceStart - scanAt;
+				}
+				else{
+					nextLook.txt = toCut.txt + (scanAt - pieceStart);
+					nextLook.len = pieceEnd - scanAt;
+				}
+				if(nextLook.len){
+					scanAt += useRgx->continueMatch(&curProg, nextLook);
+					continue;
+				}
+				if(!atEnd){ break; }
+				if(scanAt == tokStart){ break; }
+			}
+			//the current token is done
+			if(curProg.winLen <= 0){
+				hitBad = 1;
+				break;
+			}
+			uintmax_t tokEnd = tokStart + curProg.winLen;
+			curPush.text.len = curProg.winLen;
+			curPush.numTypes = curProg.winTC;
+			curPush.types = curProg.winTypes;
+			if(tokStart >= pieceStart){
+				curPush.text.txt = toCut.txt + (tokStart - pieceStart);
+			}
+			else if(tokEnd <= pieceStart){
+				curPush.text.txt = &(pendText[tokStart - pendStart]);
+			}
+			else{
+				joinText.insert(joinText.end(), pendText.begin() + (tokStart - pendStart), pendText.end());
+				joinText.insert(joinText.end(), toCut.txt, toCut.txt + (tokEnd - pieceStart));
+				curPush.text.txt = &(joinText[0]);
+			}
+			fillTokens->push_back(&curPush);
+			tokStart = tokEnd;
+			scanAt = tokStart;
+			useRgx->startMatch(&curProg);
+		}
+	//save anything not finished (if nothing finished, nothing points into pendText)
+		if(tokStart == pendStart){
+			pendText.insert(pendText.end(), toCut.txt, toCut.txt + toCut.len);
+		}
+		else if(tokStart < pieceStart){
+			nextPend.clear();
+			nextPend.insert(nextPend.end(), pendText.begin() + (tokStart - pendStart), pendText.end());
+			nextPend.insert(nextPend.end(), toCut.txt, toCut.txt + toCut.len);
+			pendText.swap(nextPend);
+		}
+		else{
+			nextPend.clear();
+			nextPend.insert(nextPend.end(), toCut.txt + (tokStart - pieceStart), toCut.txt + toCut.len);
+			pendText.swap(nextPend);
+		}
+		totalFed = pieceEnd;
+		leftText.len = pendText.size();
+		leftText.txt = pendText.size() ? &(pendText[0]) : (char*)0;
+}
 
+MultithreadedRegexTokenizer::MultithreadedRegexTokenizer(RegexSet* useRegex, uintptr_t numThread, ThreadPool* mainPool) : RegexTokenizer(useRegex){
+	usePool = mainPool;
+	numResync = 0;
+	std::vector<MultithreadedRegexTokenizerTask*>* cutTasks = new std::vector<MultithreadedRegexTokenizerTask*>();
+	for(uintptr_t i = 0; i<numThread; i++){
+		MultithreadedRegexTokenizerTask* curCut = new MultithreadedRegexTokenizerTask();
+		curCut->useRgx = useRegex;
+		cutTasks->push_back(curCut);
+	}
+	useForUA = cutTasks;
+}
+MultithreadedRegexTokenizer::~MultithreadedRegexTokenizer(){
+	std::vector<MultithreadedRegexTokenizerTask*>* cutTasks = (std::vector<MultithreadedRegexTokenizerTask*>*)useForUA;
+	for(uintptr_t i = 0; i<cutTasks->size(); i++){
+		delete((*cutTasks)[i]);
+	}
+	delete(cutTasks);
+}
+SizePtrString MultithreadedRegexTokenizer::tokenize(SizePtrString toCut, StructVector<Token>* fillTokens){
+	std::vector<MultithreadedRegexTokenizerTask*>* cutTasks = (std::vector<MultithreadedRegexTokenizerTask*>*)useForUA;
+	uintptr_t numThread = cutTasks->size();
+	if(useRgx->lazyRegs || (numThread < 2) || (toCut.len < numThread)){
+		return RegexTokenizer::tokenize(toCut, fillTokens);
+	}
+	//cut each chunk from its start
+		uintptr_t numPT = toCut.len / numThread;
+		uintptr_t numET = toCut.len % numThread;
+		uintptr_t curInd = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			uintptr_t curNum = numPT + (i < numET);
+			MultithreadedRegexTokenizerTask* curCut = ((*cutTasks)[i]);
+			curCut->fullText = toCut;
+			curCut->startInd = curInd;
+			curCut->endInd = curInd + curNum;
+			curInd += curNum;
+		}
+		usePool->addTasks(numThread, (JoinableThreadTask**)(&((*cutTasks)[0])));
+		joinTasks(numThread, (JoinableThreadTask**)(&((*cutTasks)[0])));
+	//stitch: once the real cut lands on a token start from a chunk, the rest of that chunk is right
+		Token curPush;
+		uintptr_t curPos = 0;
+		int hitBad = 0;
+		for(uintptr_t i = 0; (i<numThread) && !hitBad; i++){
+			MultithreadedRegexTokenizerTask* curCut = ((*cutTasks)[i]);
+			if(curPos >= curCut->endInd){ continue; }
+			StructVector<Token>* curToks = &(curCut->foundToks);
+			uintptr_t numToks = curToks->size();
+			uintptr_t curTokI = 0;
+			while(true){
+				while((curTokI < numToks) && ((uintptr_t)(curToks->at(curTokI)->text.txt - toCut.txt) < curPos)){ curTokI++; }
+				if((curTokI < numToks) && ((uintptr_t)(curToks->at(curTokI)->text.txt - toCut.txt) == curPos)){ break; }
+				if(curPos >= curCut->endInd){ break; }
+				//not in sync: cut one here
+				SizePtrString nextCut = {toCut.len - curPos, toCut.txt + curPos};
+				intptr_t longMat = useRgx->longMatchLength(nextCut, &(curPush.numTypes), &(curPush.types));
+				if(longMat <= 0){ hitBad = 1; break; }
+				curPush.text.txt = nextCut.txt;
+				curPush.text.len = longMat;
+				fillTokens->push_back(&curPush);
+				curPos += longMat;
+				numResync += longMat;
+			}
+			if(hitBad || (curPos >= curCut->endInd)){ continue; }
+			//in sync: take the rest, up to any place the cutting failed (it will fail here too)
+			uintptr_t endTokI = numToks;
+			for(uintptr_t j = 0; j<curCut->badBefore.size(); j++){
+				if(curCut->badBefore[j] > curTokI){ endTokI = curCut->badBefore[j]; hitBad = 1; break; }
+			}
+			uintptr_t numTake = endTokI - curTokI;
+			uintptr_t origSize = fillTokens->size();
+			fillTokens->resize(origSize + numTake);
+			memcpy(fillTokens->at(origSize), curToks->at(curTokI), numTake*sizeof(Token));
+			Token* lastTok = curToks->at(endTokI - 1);
+			curPos = (lastTok->text.txt - toCut.txt) + lastTok->text.len;
+		}
+	SizePtrString remText;
+		remText.txt = toCut.txt + curPos;
+		remText.len = toCut.len - curPos;
+	return remText;
+}
 
+MultithreadedRegexTokenizerTask::MultithreadedRegexTokenizerTask(){}
+MultithreadedRegexTokenizerTask::~MultithreadedRegexTokenizerTask(){}
+void MultithreadedRegexTokenizerTask::doTask(){
+	foundToks.clear();
+	badBefore.clear();
+	Token curPush;
+	uintptr_t curPos = startInd;
+	while(curPos < endInd){
+		SizePtrString nextCut = {fullText.len - curPos, fullText.txt + curPos};
+		intptr_t longMat = useRgx->longMatchLength(nextCut, &(curPush.numTypes), &(curPush.types));
+		if(longMat <= 0){
+			//the guess might have started in the middle of something: note it and try the next byte
+			badBefore.push_back(foundToks.size());
+			curPos++;
+			continue;
+		}
+		curPush.text.txt = nextCut.txt;
+		curPush.text.len = longMat;
+		foundToks.push_back(&curPush);
+		curPos += longMat;
+	}
+}
@@ -34,6 +34,28 @@ public:
  */
 bool operator <(const DFASetTraversal& itemA, const DFASetTraversal& itemB);
 
+/**
+ * Split up byte classes so that bytes that go to different places end up in different classes.
+ * @param classMap The current class of each byte: updated in place.
+ * @param byteVals Where each byte goes.
+ * @return The number of classes after splitting.
+ */
+uintptr_t regexRefineByteClasses(unsigned char* classMap, const uintptr_t* byteVals);
+
+/**
+ * Get a representative byte for each byte class.
+ * @param classMap The class of each byte.
+ * @param classRep The place to put the first byte in each class.
+ */
+void regexByteClassReps(const unsigned char* classMap, unsigned char* classRep);
+
+/**
+ * Set up prefilter information for something that matches one exact string.
+ * @param toFill The place to put the information.
+ * @param theText The text.
+ */
+void regexPrefilterExact(RegexPrefilter* toFill, const std::string& theText);
+
 }
 
 using namespace whodun;
@@ -50,6 +72,29 @@ bool whodun::operator < (const NondeterministicFiniteAutomataTraversal& itemA, c
 	return false;
 }
 
+uintptr_t whodun::regexRefineByteClasses(unsigned char* classMap, const uintptr_t* byteVals){
+	std::map< std::pair<uintptr_t,uintptr_t>, uintptr_t > newClass;
+	for(uintptr_t i = 0; i<256; i++){
+		std::pair<uintptr_t,uintptr_t> curK(classMap[i], byteVals[i]);
+		std::map< std::pair<uintptr_t,uintptr_t>, uintptr_t >::iterator ncIt = newClass.find(curK);
+		if(ncIt == newClass.end()){
+			uintptr_t newInd = newClass.size();
+			newClass[curK] = newInd;
+			classMap[i] = newInd;
+		}
+		else{
+			classMap[i] = ncIt->second;
+		}
+	}
+	return newClass.size();
+}
+
+void whodun::regexByteClassReps(const unsigned char* classMap, unsigned char* classRep){
+	for(int i = 255; i>=0; i--){
+		classRep[classMap[i]] = i;
+	}
+}
+
 NondeterministicFiniteAutomataState::NondeterministicFiniteAutomataState(){}
 NondeterministicFiniteAutomataState::~NondeterministicFiniteAutomataState(){}
 
@@ -114,10 +159,23 @@ void NondeterministicFiniteAutomataTraversal::expandEpsilon(){
 	}
 }
 
-DeterministicFiniteAutomata::DeterministicFiniteAutomata(){}
+DeterministicFiniteAutomata::DeterministicFiniteAutomata(){
+	numClasses = 0;
+}
 DeterministicFiniteAutomata::DeterministicFiniteAutomata(NondeterministicFiniteAutomata* toCrank){
+	numClasses = 0;
 	NondeterministicFiniteAutomataTraversal nextState;
 	NondeterministicFiniteAutomataTraversal storeState;
+	//bytes that every nfa state treats the same only need to be walked once
+		unsigned char nfaClass[256];
+		memset(nfaClass, 0, 256);
+		uintptr_t numNFAClass = 1;
+		for(uintptr_t i = 0; (i<toCrank->states.size()) && (numNFAClass < 256); i++){
+			numNFAClass = regexRefineByteClasses(nfaClass, toCrank->states[i].charTransitions);
+		}
+		unsigned char nfaClassRep[256];
+		regexByteClassReps(nfaClass, nfaClassRep);
+		uintptr_t nfaClassJump[256];
 	//set up the state map
 		std::map<NondeterministicFiniteAutomataTraversal,uintptr_t> stateMap;
 		std::vector<NondeterministicFiniteAutomataTraversal> openStates;
@@ -136,8 +194,8 @@ DeterministicFiniteAutomata::DeterministicFiniteAutomata(NondeterministicFiniteA
 		storeState = openStates[openStates.size() - 1];
 		openStates.pop_back();
 		uintptr_t updStateIndex = stateMap[storeState];
-		for(uintptr_t i = 0; i<256; i++){
-			nextState.consume(i, &storeState);
+		for(uintptr_t i = 0; i<numNFAClass; i++){
+			nextState.consume(nfaClassRep[i], &storeState);
 			std::map<NondeterministicFiniteAutomataTraversal,uintptr_t>::iterator smIt;
 			smIt = stateMap.find(nextState);
 			if(smIt == stateMap.end()){
@@ -149,15 +207,387 @@ DeterministicFiniteAutomata::DeterministicFiniteAutomata(NondeterministicFiniteA
 				states.push_back(blankState);
 				smIt = stateMap.find(nextState);
 			}
-			states[updStateIndex].charTransitions[i] = smIt->second;
+			nfaClassJump[i] = smIt->second;
+		}
+		for(uintptr_t i = 0; i<256; i++){
+			states[updStateIndex].charTransitions[i] = nfaClassJump[nfaClass[i]];
 		}
 	}
 }
 DeterministicFiniteAutomata::~DeterministicFiniteAutomata(){}
+void DeterministicFiniteAutomata::minimize(){
+	uintptr_t numS = states.size();
+	if(numS < 2){ return; }
+	//only need to look at one byte from each class
+		unsigned char byteClass[256];
+		memset(byteClass, 0, 256);
+		uintptr_t numBC = 1;
+		for(uintptr_t i = 0; (i<numS) && (numBC < 256); i++){
+			numBC = regexRefineByteClasses(byteClass, states[i].charTransitions);
+		}
+		unsigned char classRep[256];
+		regexByteClassReps(byteClass, classRep);
+	//build the reverse jumps: for each class, for each target, the sources
+		std::vector<uintptr_t> revStart(numBC*(numS+1), 0);
+		std::vector<uintptr_t> revSource(numBC*numS);
+		for(uintptr_t c = 0; c<numBC; c++){
+			uintptr_t* curStart = &(revStart[c*(numS+1)]);
+			uintptr_t* curSource = &(revSource[c*numS]);
+			for(uintptr_t s = 0; s<numS; s++){ curStart[states[s].charTransitions[classRep[c]] + 1]++; }
+			for(uintptr_t s = 0; s<numS; s++){ curStart[s+1] += curStart[s]; }
+			for(uintptr_t s = 0; s<numS; s++){
+				uintptr_t tgtS = states[s].charTransitions[classRep[c]];
+				curSource[curStart[tgtS]] = s;
+				curStart[tgtS]++;
+			}
+			for(uintptr_t s = numS; s>0; s--){ curStart[s] = curStart[s-1]; }
+			curStart[0] = 0;
+		}
+	//initial partition: by status
+		std::vector< std::pair<uintptr_t,uintptr_t> > statSort(numS);
+		for(uintptr_t s = 0; s<numS; s++){ statSort[s].first = states[s].stateStatus; statSort[s].second = s; }
+		std::sort(statSort.begin(), statSort.end());
+		std::vector<uintptr_t> elems(numS);
+		std::vector<uintptr_t> elemLoc(numS);
+		std::vector<uintptr_t> blockOf(numS);
+		std::vector<uintptr_t> blockStart;
+		std::vector<uintptr_t> blockEnd;
+		for(uintptr_t i = 0; i<numS; i++){
+			if((i == 0) || (statSort[i].first != statSort[i-1].first)){
+				if(i){ blockEnd.push_back(i); }
+				blockStart.push_back(i);
+			}
+			elems[i] = statSort[i].second;
+			elemLoc[elems[i]] = i;
+			blockOf[elems[i]] = blockStart.size() - 1;
+		}
+		blockEnd.push_back(numS);
+	//split until nothing changes
+		std::vector<uintptr_t> markCount(blockStart.size(), 0);
+		std::vector<char> inWork(blockStart.size(), 1);
+		std::vector<uintptr_t> workList;
+		for(uintptr_t i = 0; i<blockStart.size(); i++){ workList.push_back(i); }
+		std::vector<uintptr_t> splitSet;
+		std::vector<uintptr_t> touched;
+		while(workList.size()){
+			uintptr_t curB = workList[workList.size()-1];
+			workList.pop_back();
+			inWork[curB] = 0;
+			splitSet.clear();
+			splitSet.insert(splitSet.end(), elems.begin() + blockStart[curB], elems.begin() + blockEnd[curB]);
+			for(uintptr_t c = 0; c<numBC; c++){
+				uintptr_t* curStart = &(revStart[c*(numS+1)]);
+				uintptr_t* curSource = &(revSource[c*numS]);
+				//mark everything that jumps into the splitter (move to the front of its block)
+				touched.clear();
+				for(uintptr_t i = 0; i<splitSet.size(); i++){
+					uintptr_t tgtS = splitSet[i];
+					for(uintptr_t j = curStart[tgtS]; j<curStart[tgtS+1]; j++){
+						uintptr_t srcS = curSource[j];
+						uintptr_t srcB = blockOf[srcS];
+						if(markCount[srcB] == 0){ touched.push_back(srcB); }
+						uintptr_t swapLoc = blockStart[srcB] + markCount[srcB];
+						uintptr_t swapS = elems[swapLoc];
+						uintptr_t srcLoc = elemLoc[srcS];
+						elems[swapLoc] = srcS; elemLoc[srcS] = swapLoc;
+						elems[srcLoc] = swapS; elemLoc[swapS] = srcLoc;
+						markCount[srcB]++;
+					}
+				}
+				//split any partially marked blocks
+				for(uintptr_t i = 0; i<touched.size(); i++){
+					uintptr_t splB = touched[i];
+					uintptr_t numMark = markCount[splB];
+					markCount[splB] = 0;
+					uintptr_t numRest = (blockEnd[splB] - blockStart[splB]) - numMark;
+					if(numRest == 0){ continue; }
+					uintptr_t newB = blockStart.size();
+					blockStart.push_back(blockStart[splB]);
+					blockEnd.push_back(blockStart[splB] + numMark);
+					blockStart[splB] += numMark;
+					markCount.push_back(0);
+					inWork.push_back(0);
+					for(uintptr_t j = blockStart[newB]; j<blockEnd[newB]; j++){ blockOf[elems[j]] = newB; }
+					uintptr_t addB = (inWork[splB] || (numMark <= numRest)) ? newB : splB;
+					inWork[addB] = 1;
+					workList.push_back(addB);
+				}
+			}
+		}
+	//renumber, keeping the start at zero
+		uintptr_t numB = blockStart.size();
+		if(numB == numS){ return; }
+		std::vector<uintptr_t> blockNewInd(numB, numB);
+		std::vector<DeterministicFiniteAutomataState> newStates(numB);
+		uintptr_t nextInd = 0;
+		for(uintptr_t s = 0; s<numS; s++){
+			uintptr_t curB = blockOf[s];
+			if(blockNewInd[curB] != numB){ continue; }
+			blockNewInd[curB] = nextInd;
+			newStates[nextInd] = states[s];
+			nextInd++;
+		}
+		for(uintptr_t s = 0; s<numB; s++){
+			DeterministicFiniteAutomataState* curS = &(newStates[s]);
+			for(uintptr_t i = 0; i<256; i++){
+				curS->charTransitions[i] = blockNewInd[blockOf[curS->charTransitions[i]]];
+			}
+		}
+		states.swap(newStates);
+}
+void DeterministicFiniteAutomata::compress(){
+	uintptr_t numS = states.size();
+	memset(charClass, 0, 256);
+	numClasses = 1;
+	for(uintptr_t i = 0; (i<numS) && (numClasses < 256); i++){
+		numClasses = regexRefineByteClasses(charClass, states[i].charTransitions);
+	}
+	unsigned char classRep[256];
+	regexByteClassReps(charClass, classRep);
+	uintptr_t rowSize = numClasses + 1;
+	classTable.resize(numS * rowSize);
+	for(uintptr_t s = 0; s<numS; s++){
+		uintptr_t* curRow = &(classTable[s * rowSize]);
+		curRow[0] = states[s].stateStatus;
+		for(uintptr_t c = 0; c<numClasses; c++){
+			curRow[c+1] = rowSize * states[s].charTransitions[classRep[c]];
+		}
+	}
+}
+
+LazyDeterministicFiniteAutomata::LazyDeterministicFiniteAutomata(uintptr_t numNFA, NondeterministicFiniteAutomata** toCrank, uintptr_t maxBytes){
+	maxCache = maxBytes;
+	usedCache = 0;
+	numStep = 0;
+	numMiss = 0;
+	numFlush = 0;
+	numBuilt = 0;
+	curMark = 0;
+	//pack the nfas together
+		for(uintptr_t i = 0; i<numNFA; i++){
+			uintptr_t state0 = nfaStates.size();
+			NondeterministicFiniteAutomata* curNFA = toCrank[i];
+			nfaStates.insert(nfaStates.end(), curNFA->states.begin(), curNFA->states.end());
+			nfaOwner.insert(nfaOwner.end(), curNFA->states.size(), i);
+			for(uintptr_t j = state0; j<nfaStates.size(); j++){
+				NondeterministicFiniteAutomataState* curS = &(nfaStates[j]);
+				for(uintptr_t k = 0; k<256; k++){ curS->charTransitions[k] += state0; }
+				for(uintptr_t k = 0; k<curS->epsilonTransitions.size(); k++){ curS->epsilonTransitions[k] += state0; }
+			}
+		}
+		nfaMark.resize(nfaStates.size(), 0);
+	//note states that only reject and never leave: they add nothing to a state set
+		nfaDead.resize(nfaStates.size());
+		for(uintptr_t i = 0; i<nfaStates.size(); i++){
+			NondeterministicFiniteAutomataState* curS = &(nfaStates[i]);
+			int isDead = ((curS->stateStatus & (WHODUN_NFA_STATE_ACCEPT | WHODUN_NFA_STATE_REJECT)) == WHODUN_NFA_STATE_REJECT) && (curS->epsilonTransitions.size() == 0);
+			for(uintptr_t k = 0; isDead && (k<256); k++){ isDead = (curS->charTransitions[k] == i); }
+			nfaDead[i] = isDead;
+		}
+	//figure out the byte classes
+		memset(charClass, 0, 256);
+		numClasses = 1;
+		for(uintptr_t i = 0; (i<nfaStates.size()) && (numClasses < 256); i++){
+			numClasses = regexRefineByteClasses(charClass, nfaStates[i].charTransitions);
+		}
+		regexByteClassReps(charClass, classRep);
+	//the empty accept list
+		uintptr_t* emptyAcc = new uintptr_t[1];
+		emptyAcc[0] = 0;
+		acceptLists.push_back(emptyAcc);
+		acceptMap[workAccept] = 0;
+	//find the start
+		curMark++;
+		for(uintptr_t i = 0; i<nfaStates.size(); i++){
+			if(nfaStates[i].stateStatus & WHODUN_NFA_STATE_START){ addClosure(i, &startStates); }
+		}
+		std::sort(startStates.begin(), startStates.end());
+		startRow = findRow(&startStates);
+}
+LazyDeterministicFiniteAutomata::~LazyDeterministicFiniteAutomata(){
+	for(uintptr_t i = 0; i<acceptLists.size(); i++){ delete[] acceptLists[i]; }
+}
+intptr_t LazyDeterministicFiniteAutomata::longMatchLength(SizePtrString toLook, uintptr_t* storeTC, uintptr_t** storeTypes){
+	intptr_t winM = -1;
+	uintptr_t curRow = startRow;
+	uintptr_t curStatus = classTable[curRow];
+	if(curStatus & WHODUN_NFA_STATE_ACCEPT){
+		uintptr_t* curAcc = acceptLists[classTable[curRow+1]];
+		*storeTC = curAcc[0];
+		*storeTypes = curAcc + 1;
+		winM = 0;
+	}
+	if(curStatus & WHODUN_NFA_STATE_REJECT){
+		*storeTC = 0;
+		return winM;
+	}
+	
+	uintptr_t i = 0;
+	while(i < toLook.len){
+		uintptr_t curC = charClass[0x00FF & toLook.txt[i]];
+		uintptr_t nextRow = classTable[curRow + 2 + curC];
+		if(nextRow == WHODUN_LAZYDFA_UNKNOWN){ nextRow = buildNext(curRow, curC); }
+		curRow = nextRow;
+		curStatus = classTable[curRow];
+		i++;
+		if(curStatus & WHODUN_NFA_STATE_ACCEPT){
+			uintptr_t* curAcc = acceptLists[classTable[curRow+1]];
+			*storeTC = curAcc[0];
+			*storeTypes = curAcc + 1;
+			winM = i;
+		}
+		if(curStatus & WHODUN_NFA_STATE_REJECT){
+			break;
+		}
+	}
+	numStep += i;
+	
+	return winM;
+}
+intptr_t LazyDeterministicFiniteAutomata::firstMatchLength(SizePtrString toLook){
+	uintptr_t curRow = startRow;
+	uintptr_t curStatus = classTable[curRow];
+	if(curStatus & WHODUN_NFA_STATE_ACCEPT){ return 0; }
+	if(curStatus & WHODUN_NFA_STATE_REJECT){ return -1; }
+	
+	intptr_t winM = -1;
+	uintptr_t i = 0;
+	while(i < toLook.len){
+		uintptr_t curC = charClass[0x00FF & toLook.txt[i]];
+		uintptr_t nextRow = classTable[curRow + 2 + curC];
+		if(nextRow == WHODUN_LAZYDFA_UNKNOWN){ nextRow = buildNext(curRow, curC); }
+		curRow = nextRow;
+		curStatus = classTable[curRow];
+		i++;
+		if(curStatus & WHODUN_NFA_STATE_ACCEPT){ winM = i; break; }
+		if(curStatus & WHODUN_NFA_STATE_REJECT){ break; }
+	}
+	numStep += i;
+	
+	return winM;
+}
+uintptr_t LazyDeterministicFiniteAutomata::buildNext(uintptr_t fromRow, uintptr_t onClass){
+	numMiss++;
+	//figure out the states
+		uintptr_t rowSize = numClasses + 2;
+		std::vector<uintptr_t>* fromStates = &(rowStates[fromRow / rowSize]);
+		uintptr_t onByte = classRep[onClass];
+		workStates.clear();
+		curMark++;
+		for(uintptr_t i = 0; i<fromStates->size(); i++){
+			addClosure(nfaStates[(*fromStates)[i]].charTransitions[onByte], &workStates);
+		}
+		std::sort(workStates.begin(), workStates.end());
+	//make room, if it is new and there is none
+		if(rowMap.find(workStates) == rowMap.end()){
+			uintptr_t newCost = rowSize*sizeof(uintptr_t) + 2*workStates.size()*sizeof(uintptr_t) + 64;
+			if((usedCache + newCost) > maxCache){
+				std::vector<uintptr_t> saveFrom = *fromStates;
+				flush();
+				fromRow = findRow(&saveFrom);
+			}
+		}
+	//and link
+		uintptr_t toRet = findRow(&workStates);
+		classTable[fromRow + 2 + onClass] = toRet;
+		return toRet;
+}
+void LazyDeterministicFiniteAutomata::flush(){
+	numFlush++;
+	classTable.clear();
+	rowStates.clear();
+	rowMap.clear();
+	usedCache = 0;
+	startRow = findRow(&startStates);
+}
+void LazyDeterministicFiniteAutomata::addClosure(uintptr_t toAdd, std::vector<uintptr_t>* toFill){
+	if(nfaMark[toAdd] == curMark){ return; }
+	nfaMark[toAdd] = curMark;
+	openStack.clear();
+	openStack.push_back(toAdd);
+	while(openStack.size()){
+		uintptr_t curS = openStack[openStack.size()-1];
+		openStack.pop_back();
+		if(nfaDead[curS]){ continue; }
+		toFill->push_back(curS);
+		std::vector<uintptr_t>* curEps = &(nfaStates[curS].epsilonTransitions);
+		for(uintptr_t i = 0; i<curEps->size(); i++){
+			uintptr_t nextS = (*curEps)[i];
+			if(nfaMark[nextS] == curMark){ continue; }
+			nfaMark[nextS] = curMark;
+			openStack.push_back(nextS);
+		}
+	}
+}
+uintptr_t LazyDeterministicFiniteAutomata::findRow(std::vector<uintptr_t>* forStates){
+	std::map< std::vector<uintptr_t>, uintptr_t >::iterator rowIt = rowMap.find(*forStates);
+	if(rowIt != rowMap.end()){ return rowIt->second; }
+	numBuilt++;
+	uintptr_t rowSize = numClasses + 2;
+	uintptr_t newRow = classTable.size();
+	classTable.resize(newRow + rowSize, WHODUN_LAZYDFA_UNKNOWN);
+	//figure out the status (nfa states are sorted, so owners are too)
+		uintptr_t numReject = 0;
+		workAccept.clear();
+		for(uintptr_t i = 0; i<forStates->size(); i++){
+			uintptr_t curS = (*forStates)[i];
+			uintptr_t curStat = nfaStates[curS].stateStatus;
+			if(curStat & WHODUN_NFA_STATE_ACCEPT){
+				uintptr_t curOwn = nfaOwner[curS];
+				if((workAccept.size() == 0) || (workAccept[workAccept.size()-1] != curOwn)){ workAccept.push_back(curOwn); }
+			}
+			if(curStat & WHODUN_NFA_STATE_REJECT){ numReject++; }
+		}
+		if(workAccept.size()){ classTable[newRow] = WHODUN_NFA_STATE_ACCEPT; }
+		else if(numReject == forStates->size()){ classTable[newRow] = WHODUN_NFA_STATE_REJECT; }
+		else{ classTable[newRow] = 0; }
+	//and the accept list
+		std::map< std::vector<uintptr_t>, uintptr_t >::iterator accIt = acceptMap.find(workAccept);
+		if(accIt == acceptMap.end()){
+			uintptr_t* newAcc = new uintptr_t[workAccept.size() + 1];
+			newAcc[0] = workAccept.size();
+			for(uintptr_t i = 0; i<workAccept.size(); i++){ newAcc[i+1] = workAccept[i]; }
+			classTable[newRow+1] = acceptLists.size();
+			acceptMap[workAccept] = acceptLists.size();
+			acceptLists.push_back(newAcc);
+		}
+		else{
+			classTable[newRow+1] = accIt->second;
+		}
+	//remember
+		rowStates.push_back(*forStates);
+		rowMap[*forStates] = newRow;
+		usedCache += rowSize*sizeof(uintptr_t) + 2*forStates->size()*sizeof(uintptr_t) + 64;
+	return newRow;
+}
+
+void whodun::regexPrefilterExact(RegexPrefilter* toFill, const std::string& theText){
+	toFill->canEmpty = (theText.size() == 0);
+	memset(toFill->firstBytes, 0, 256);
+	if(theText.size()){ toFill->firstBytes[0x00FF & theText[0]] = 1; }
+	toFill->isExact = 1;
+	toFill->exactText = theText;
+	toFill->prefixText = theText;
+	toFill->requireText = theText;
+}
 
+RegexPrefilter::RegexPrefilter(){
+	canEmpty = 1;
+	memset(firstBytes, 1, 256);
+	isExact = 0;
+}
+RegexPrefilter::~RegexPrefilter(){}
 
 RegexSpecification::RegexSpecification(){}
 RegexSpecification::~RegexSpecification(){}
+void RegexSpecification::prefilter(RegexPrefilter* toFill){
+	toFill->canEmpty = 1;
+	memset(toFill->firstBytes, 1, 256);
+	toFill->isExact = 0;
+	toFill->exactText.clear();
+	toFill->prefixText.clear();
+	toFill->requireText.clear();
+}
 
 RegexEpsilon::RegexEpsilon(){}
 uintptr_t RegexEpsilon::neededStates(){
@@ -174,6 +604,9 @@ void RegexEpsilon::packStates(NondeterministicFiniteAutomata* toPack, uintptr_t
 		fstate->charTransitions[i] = state1;
 	}
 }
+void RegexEpsilon::prefilter(RegexPrefilter* toFill){
+	regexPrefilterExact(toFill, std::string());
+}
 
 RegexLiteral::RegexLiteral(SizePtrString theSeq){
 	toMatch = theSeq;
@@ -211,6 +644,9 @@ void RegexLiteral::packStates(NondeterministicFiniteAutomata* toPack, uintptr_t
 		fstate->charTransitions[i] = stateF;
 	}
 }
+void RegexLiteral::prefilter(RegexPrefilter* toFill){
+	regexPrefilterExact(toFill, std::string(toMatch.txt, toMatch.len));
+}
 
 RegexCharset::RegexCharset(SizePtrString theSeq){
 	toMatch = theSeq;
@@ -244,6 +680,24 @@ void RegexCharset::packStates(NondeterministicFiniteAutomata* toPack, uintptr_t
 		fstate->charTransitions[i] = stateF;
 	}
 }
+void RegexCharset::prefilter(RegexPrefilter* toFill){
+	memset(toFill->firstBytes, 0, 256);
+	uintptr_t numDiff = 0;
+	for(uintptr_t i = 0; i<toMatch.len; i++){
+		char* curF = toFill->firstBytes + (0x00FF & toMatch.txt[i]);
+		numDiff += !*curF;
+		*curF = 1;
+	}
+	if(numDiff == 1){
+		regexPrefilterExact(toFill, std::string(toMatch.txt, 1));
+		return;
+	}
+	toFill->canEmpty = 0;
+	toFill->isExact = 0;
+	toFill->exactText.clear();
+	toFill->prefixText.clear();
+	toFill->requireText.clear();
+}
 	
 RegexConcatenate::RegexConcatenate(){}
 uintptr_t RegexConcatenate::neededStates(){
@@ -292,6 +746,48 @@ void RegexConcatenate::packStates(NondeterministicFiniteAutomata* toPack, uintpt
 	}
 }
 
+void RegexConcatenate::prefilter(RegexPrefilter* toFill){
+	if(toConcat.size() == 0){
+		RegexEpsilon subBuild;
+		subBuild.prefilter(toFill);
+		return;
+	}
+	regexPrefilterExact(toFill, std::string());
+	RegexPrefilter subInfo;
+	int prefixOpen = 1;
+	std::string curRun;
+	std::string bestReq;
+	for(uintptr_t i = 0; i<toConcat.size(); i++){
+		toConcat[i]->prefilter(&subInfo);
+		//anything that can start a piece after empty pieces can start
+		if(toFill->canEmpty){
+			for(uintptr_t j = 0; j<256; j++){ toFill->firstBytes[j] = toFill->firstBytes[j] || subInfo.firstBytes[j]; }
+		}
+		toFill->canEmpty = toFill->canEmpty && subInfo.canEmpty;
+		//the prefix runs until the first piece that is not exact
+		if(prefixOpen){
+			toFill->prefixText.append(subInfo.prefixText);
+			prefixOpen = subInfo.isExact;
+		}
+		//required text: runs of exact pieces (and the start of the piece after), or anything a piece requires
+		if(subInfo.isExact){
+			toFill->exactText.append(subInfo.exactText);
+			curRun.append(subInfo.exactText);
+		}
+		else{
+			toFill->isExact = 0;
+			curRun.append(subInfo.prefixText);
+			if(curRun.size() > bestReq.size()){ bestReq = curRun; }
+			if(subInfo.requireText.size() > bestReq.size()){ bestReq = subInfo.requireText; }
+			curRun.clear();
+		}
+	}
+	if(curRun.size() > bestReq.size()){ bestReq = curRun; }
+	if(toFill->prefixText.size() > bestReq.size()){ bestReq = toFill->prefixText; }
+	if(!toFill->isExact){ toFill->exactText.clear(); }
+	toFill->requireText = bestReq;
+}
+
 RegexAlternate::RegexAlternate(){}
 uintptr_t RegexAlternate::neededStates(){
 	if(toConcat.size() == 0){ return 2; }
@@ -340,6 +836,29 @@ void RegexAlternate::packStates(NondeterministicFiniteAutomata* toPack, uintptr_
 	}
 }
 
+void RegexAlternate::prefilter(RegexPrefilter* toFill){
+	if(toConcat.size() == 0){
+		RegexEpsilon subBuild;
+		subBuild.prefilter(toFill);
+		return;
+	}
+	RegexPrefilter subInfo;
+	toConcat[0]->prefilter(toFill);
+	for(uintptr_t i = 1; i<toConcat.size(); i++){
+		toConcat[i]->prefilter(&subInfo);
+		toFill->canEmpty = toFill->canEmpty || subInfo.canEmpty;
+		for(uintptr_t j = 0; j<256; j++){ toFill->firstBytes[j] = toFill->firstBytes[j] || subInfo.firstBytes[j]; }
+		toFill->isExact = toFill->isExact && subInfo.isExact && (toFill->exactText == subInfo.exactText);
+		uintptr_t numSame = 0;
+		uintptr_t maxSame = std::min(toFill->prefixText.size(), subInfo.prefixText.size());
+		while((numSame < maxSame) && (toFill->prefixText[numSame] == subInfo.prefixText[numSame])){ numSame++; }
+		toFill->prefixText.resize(numSame);
+		if(toFill->requireText != subInfo.requireText){ toFill->requireText.clear(); }
+	}
+	if(!toFill->isExact){ toFill->exactText.clear(); }
+	if(toFill->prefixText.size() > toFill->requireText.size()){ toFill->requireText = toFill->prefixText; }
+}
+
 RegexStar::RegexStar(RegexSpecification* toRepeat){
 	toRep = toRepeat;
 }
@@ -376,22 +895,54 @@ void RegexStar::packStates(NondeterministicFiniteAutomata* toPack, uintptr_t sta
 	}
 }
 
+void RegexStar::prefilter(RegexPrefilter* toFill){
+	toRep->prefilter(toFill);
+	toFill->canEmpty = 1;
+	toFill->isExact = toFill->isExact && (toFill->exactText.size() == 0);
+	toFill->exactText.clear();
+	toFill->prefixText.clear();
+	toFill->requireText.clear();
+}
+
 Regex::Regex(RegexSpecification* toFind){
 	NondeterministicFiniteAutomata compNFA(toFind->neededStates());
 	toFind->packStates(&compNFA, 0);
 	compRegex = new DeterministicFiniteAutomata(&compNFA);
+	compRegex->minimize();
+	compRegex->compress();
+	baseNFA = 0;
+	lazyRegex = 0;
+	setupPrefilter(toFind);
+}
+Regex::Regex(RegexSpecification* toFind, uintptr_t lazyCache){
+	baseNFA = new NondeterministicFiniteAutomata(toFind->neededStates());
+	toFind->packStates(baseNFA, 0);
+	compRegex = 0;
+	lazyRegex = new LazyDeterministicFiniteAutomata(1, &baseNFA, lazyCache);
+	setupPrefilter(toFind);
+}
+Regex::~Regex(){
+	if(compRegex){ delete(compRegex); }
+	if(baseNFA){ delete(baseNFA); }
+	if(lazyRegex){ delete(lazyRegex); }
 }
-Regex::~Regex(){ delete(compRegex); }
 intptr_t Regex::longMatchLength(SizePtrString toLook){
+	if(lazyRegex){
+		uintptr_t numAcc;
+		uintptr_t* accList;
+		return lazyRegex->longMatchLength(toLook, &numAcc, &accList);
+	}
+	const uintptr_t* classTab = &(compRegex->classTable[0]);
+	const unsigned char* charClass = compRegex->charClass;
 	intptr_t winM = -1;
-	uintptr_t curState = 0;
-	uintptr_t curSStat = compRegex->states[curState].stateStatus;
+	uintptr_t curRow = 0;
+	uintptr_t curSStat = classTab[curRow];
 	if(curSStat & WHODUN_NFA_STATE_ACCEPT){ winM = 0; }
 	if(curSStat & WHODUN_NFA_STATE_REJECT){ return winM; }
 	
 	for(uintptr_t i = 0; i<toLook.len; i++){
-		curState = compRegex->states[curState].charTransitions[0x00FF & toLook.txt[i]];
-		curSStat = compRegex->states[curState].stateStatus;
+		curRow = classTab[curRow + 1 + charClass[0x00FF & toLook.txt[i]]];
+		curSStat = classTab[curRow];
 		if(curSStat & WHODUN_NFA_STATE_ACCEPT){ winM = i+1; }
 		if(curSStat & WHODUN_NFA_STATE_REJECT){ return winM; }
 	}
@@ -399,14 +950,17 @@ intptr_t Regex::longMatchLength(SizePtrString toLook){
 	return winM;
 }
 intptr_t Regex::firstMatchLength(SizePtrString toLook){
-	uintptr_t curState = 0;
-	uintptr_t curSStat = compRegex->states[curState].stateStatus;
+	if(lazyRegex){ return lazyRegex->firstMatchLength(toLook); }
+	const uintptr_t* classTab = &(compRegex->classTable[0]);
+	const unsigned char* charClass = compRegex->charClass;
+	uintptr_t curRow = 0;
+	uintptr_t curSStat = classTab[curRow];
 	if(curSStat & WHODUN_NFA_STATE_ACCEPT){ return 0; }
 	if(curSStat & WHODUN_NFA_STATE_REJECT){ return -1; }
 	
 	for(uintptr_t i = 0; i<toLook.len; i++){
-		curState = compRegex->states[curState].charTransitions[0x00FF & toLook.txt[i]];
-		curSStat = compRegex->states[curState].stateStatus;
+		curRow = classTab[curRow + 1 + charClass[0x00FF & toLook.txt[i]]];
+		curSStat = classTab[curRow];
 		if(curSStat & WHODUN_NFA_STATE_ACCEPT){ return i+1; }
 		if(curSStat & WHODUN_NFA_STATE_REJECT){ return -1; }
 	}
@@ -415,7 +969,8 @@ intptr_t Regex::firstMatchLength(SizePtrString toLook){
 }
 int Regex::findLong(SizePtrString toLook, uintptr_t* repS, uintptr_t* repE){
 	intptr_t longFind = -1;
-	for(uintptr_t i = 0; i<=toLook.len; i++){
+	uintptr_t reqAt = WHODUN_REGEX_NOTFOUND;
+	for(uintptr_t i = 0; nextCandidate(toLook, &i, &reqAt); i++){
 		SizePtrString curLook = {toLook.len - i, toLook.txt + i};
 		intptr_t curFind = longMatchLength(curLook);
 		if(curFind > longFind){
@@ -427,7 +982,8 @@ int Regex::findLong(SizePtrString toLook, uintptr_t* repS, uintptr_t* repE){
 	return longFind >= 0;
 }
 int Regex::findFirst(SizePtrString toLook, uintptr_t* repS, uintptr_t* repE){
-	for(uintptr_t i = 0; i<=toLook.len; i++){
+	uintptr_t reqAt = WHODUN_REGEX_NOTFOUND;
+	for(uintptr_t i = 0; nextCandidate(toLook, &i, &reqAt); i++){
 		SizePtrString curLook = {toLook.len - i, toLook.txt + i};
 		intptr_t curFind = firstMatchLength(curLook);
 		if(curFind > -1){
@@ -442,6 +998,48 @@ int Regex::matches(SizePtrString toLook){
 	intptr_t matL = longMatchLength(toLook);
 	return (matL == (intptr_t)(toLook.len));
 }
+void Regex::setupPrefilter(RegexSpecification* toFind){
+	toFind->prefilter(&preInfo);
+	char allFirst[256];
+	numFirst = 0;
+	for(uintptr_t i = 0; i<256; i++){
+		if(preInfo.firstBytes[i]){ allFirst[numFirst] = i; numFirst++; }
+	}
+	firstSet.setBytes(allFirst, numFirst);
+}
+int Regex::nextCandidate(SizePtrString toLook, uintptr_t* fromI, uintptr_t* reqAt){
+	uintptr_t curI = *fromI;
+	if(curI > toLook.len){ return 0; }
+	if(preInfo.canEmpty){ return 1; }
+	//jump to something that could start a match
+		uintptr_t numLeft = toLook.len - curI;
+		const char* curLook = toLook.txt + curI;
+		if(preInfo.prefixText.size() > 1){
+			char* preF = doMem.memmem(curLook, numLeft, preInfo.prefixText.c_str(), preInfo.prefixText.size());
+			if(preF == 0){ return 0; }
+			curI = preF - toLook.txt;
+		}
+		else if(preInfo.prefixText.size() == 1){
+			char* preF = (char*)doMem.memchr(curLook, 0x00FF & preInfo.prefixText[0], numLeft);
+			if(preF == 0){ return 0; }
+			curI = preF - toLook.txt;
+		}
+		else if(numFirst < 256){
+			uintptr_t firstI = firstSet.findFirst(curLook, numLeft);
+			if(firstI == numLeft){ return 0; }
+			curI += firstI;
+		}
+		else if(curI == toLook.len){ return 0; }
+	//and make sure the required text is still there
+		uintptr_t reqLen = preInfo.requireText.size();
+		if(reqLen && (preInfo.requireText != preInfo.prefixText) && ((*reqAt == WHODUN_REGEX_NOTFOUND) || (*reqAt < curI))){
+			char* reqF = doMem.memmem(toLook.txt + curI, toLook.len - curI, preInfo.requireText.c_str(), reqLen);
+			if(reqF == 0){ return 0; }
+			*reqAt = reqF - toLook.txt;
+		}
+	*fromI = curI;
+	return 1;
+}
 
 DFASetTraversal::DFASetTraversal(){}
 DFASetTraversal::~DFASetTraversal(){}
@@ -461,16 +1059,48 @@ bool whodun::operator <(const DFASetTraversal& itemA, const DFASetTraversal& ite
 	return false;
 }
 
-RegexSet::RegexSet(){}
-RegexSet::~RegexSet(){}
+RegexSet::RegexSet(){
+	lazyRegs = 0;
+}
+RegexSet::~RegexSet(){
+	if(lazyRegs){ delete(lazyRegs); }
+}
 void RegexSet::compile(){
 	uintptr_t numRegex = theReg.size();
+	compiledRegs.states.clear();
+	compiledStatus.clear();
+	if(lazyRegs){ delete(lazyRegs); lazyRegs = 0; }
+	//lazy regexes need a full dfa for this
+		std::vector<DeterministicFiniteAutomata*> useDFA(numRegex);
+		for(uintptr_t i = 0; i<numRegex; i++){
+			useDFA[i] = theReg[i]->compRegex;
+			if(useDFA[i] == 0){
+				useDFA[i] = new DeterministicFiniteAutomata(theReg[i]->baseNFA);
+				useDFA[i]->minimize();
+				useDFA[i]->compress();
+			}
+		}
 	std::map<DFASetTraversal,uintptr_t> seenStates;
 	std::vector<DFASetTraversal> openStates;
+	std::map<std::vector<uintptr_t>,uintptr_t> seenStatus;
+	std::vector<uintptr_t> curStatus;
+	//only need to walk one byte from each class (common to all the regexes)
+		unsigned char setClass[256];
+		memset(setClass, 0, 256);
+		uintptr_t numSetClass = 1;
+		uintptr_t regClass[256];
+		for(uintptr_t i = 0; (i<numRegex) && (numSetClass < 256); i++){
+			for(uintptr_t c = 0; c<256; c++){ regClass[c] = useDFA[i]->charClass[c]; }
+			numSetClass = regexRefineByteClasses(setClass, regClass);
+		}
+		unsigned char setClassRep[256];
+		regexByteClassReps(setClass, setClassRep);
+		uintptr_t setClassJump[256];
 	//add the starting state to the open set
 		DFASetTraversal curState;
 			curState.curStates.resize(numRegex);
 			seenStates[curState] = 0;
+			openStates.push_back(curState);
 			compiledRegs.states.resize(1);
 	//walk through jumps until nothing open
 		DFASetTraversal nextState;
@@ -481,30 +1111,40 @@ void RegexSet::compile(){
 				openStates.pop_back();
 				uintptr_t dfaIndex = seenStates[curState];
 			//figure out its status, including hot states
-				uintptr_t winStatIndex = compiledStatus.size();
-				compiledRegs.states[dfaIndex].stateStatus = winStatIndex;
-				compiledStatus.push_back(0);
-				compiledStatus.push_back(0);
+				curStatus.clear();
+				curStatus.push_back(0);
+				curStatus.push_back(0);
 				uintptr_t numAccept = 0;
 				uintptr_t numReject = 0;
 				uintptr_t numPass = 0;
 				for(uintptr_t i = 0; i<numRegex; i++){
-					uintptr_t curSStatus = theReg[i]->compRegex->states[curState.curStates[i]].stateStatus;
-					if(curSStatus & WHODUN_NFA_STATE_ACCEPT){ numAccept++; compiledStatus.push_back(i); }
+					uintptr_t curSStatus = useDFA[i]->states[curState.curStates[i]].stateStatus;
+					if(curSStatus & WHODUN_NFA_STATE_ACCEPT){ numAccept++; curStatus.push_back(i); }
 					if(curSStatus & WHODUN_NFA_STATE_REJECT){ numReject++; }
 					if((curSStatus & (WHODUN_NFA_STATE_ACCEPT | WHODUN_NFA_STATE_REJECT)) == 0){ numPass++; }
 				}
 				if(numAccept){
-					compiledStatus[winStatIndex] = WHODUN_NFA_STATE_ACCEPT;
-					compiledStatus[winStatIndex + 1] = numAccept;
+					curStatus[0] = WHODUN_NFA_STATE_ACCEPT;
+					curStatus[1] = numAccept;
 				}
 				else if(numReject && (numPass == 0)){
-					compiledStatus[winStatIndex] = WHODUN_NFA_STATE_REJECT;
+					curStatus[0] = WHODUN_NFA_STATE_REJECT;
+				}
+			//states with the same status share (so minimization can merge them)
+				std::map<std::vector<uintptr_t>,uintptr_t>::iterator statIt = seenStatus.find(curStatus);
+				if(statIt == seenStatus.end()){
+					seenStatus[curStatus] = compiledStatus.size();
+					compiledRegs.states[dfaIndex].stateStatus = compiledStatus.size();
+					compiledStatus.insert(compiledStatus.end(), curStatus.begin(), curStatus.end());
+				}
+				else{
+					compiledRegs.states[dfaIndex].stateStatus = statIt->second;
 				}
 			//figure out where it goes
-				for(uintptr_t c = 0; c<256; c++){
+				for(uintptr_t c = 0; c<numSetClass; c++){
+					uintptr_t repC = setClassRep[c];
 					for(uintptr_t i = 0; i<numRegex; i++){
-						nextState.curStates[i] = theReg[i]->compRegex->states[curState.curStates[i]].charTransitions[c];
+						nextState.curStates[i] = useDFA[i]->states[curState.curStates[i]].charTransitions[repC];
 					}
 					std::map<DFASetTraversal,uintptr_t>::iterator hasSeen = seenStates.find(nextState);
 					if(hasSeen == seenStates.end()){
@@ -512,43 +1152,130 @@ void RegexSet::compile(){
 						seenStates[nextState] = newStateInd;
 						openStates.push_back(nextState);
 						compiledRegs.states.resize(newStateInd+1);
-						compiledRegs.states[dfaIndex].charTransitions[c] = newStateInd;
+						setClassJump[c] = newStateInd;
 					}
 					else{
-						compiledRegs.states[dfaIndex].charTransitions[c] = hasSeen->second;
+						setClassJump[c] = hasSeen->second;
 					}
 				}
+				for(uintptr_t c = 0; c<256; c++){
+					compiledRegs.states[dfaIndex].charTransitions[c] = setClassJump[setClass[c]];
+				}
+		}
+	//shrink it down
+		compiledRegs.minimize();
+		compiledRegs.compress();
+		for(uintptr_t i = 0; i<numRegex; i++){
+			if(useDFA[i] != theReg[i]->compRegex){ delete(useDFA[i]); }
 		}
 }
-intptr_t RegexSet::longMatchLength(SizePtrString toLook, uintptr_t* storeTC, uintptr_t** storeTypes){
-	intptr_t winM = -1;
-	uintptr_t curState = 0;
-	uintptr_t curStatusIndex = compiledRegs.states[curState].stateStatus;
-	uintptr_t curStatus = compiledStatus[curStatusIndex];
-	if(curStatus & WHODUN_NFA_STATE_ACCEPT){
-		*storeTC = compiledStatus[curStatusIndex+1];
-		*storeTypes = &(compiledStatus[0]) + curStatusIndex+2;
-		winM = 0;
+void RegexSet::compileLazy(uintptr_t lazyCache){
+	uintptr_t numRegex = theReg.size();
+	compiledRegs.states.clear();
+	compiledRegs.classTable.clear();
+	compiledStatus.clear();
+	if(lazyRegs){ delete(lazyRegs); lazyRegs = 0; }
+	//get nfas for everything (a dfa is already an nfa)
+		std::vector<NondeterministicFiniteAutomata*> useNFA(numRegex);
+		for(uintptr_t i = 0; i<numRegex; i++){
+			useNFA[i] = theReg[i]->baseNFA;
+			if(useNFA[i]){ continue; }
+			DeterministicFiniteAutomata* curDFA = theReg[i]->compRegex;
+			useNFA[i] = new NondeterministicFiniteAutomata(curDFA->states.size());
+			for(uintptr_t j = 0; j<curDFA->states.size(); j++){
+				NondeterministicFiniteAutomataState* curS = &(useNFA[i]->states[j]);
+				curS->stateStatus = curDFA->states[j].stateStatus | (j ? 0 : WHODUN_NFA_STATE_START);
+				memcpy(curS->charTransitions, curDFA->states[j].charTransitions, 256*sizeof(uintptr_t));
+			}
+		}
+	lazyRegs = new LazyDeterministicFiniteAutomata(numRegex, numRegex ? &(useNFA[0]) : (NondeterministicFiniteAutomata**)0, lazyCache);
+	for(uintptr_t i = 0; i<numRegex; i++){
+		if(useNFA[i] != theReg[i]->baseNFA){ delete(useNFA[i]); }
 	}
-	if(curStatus & WHODUN_NFA_STATE_REJECT){
-		*storeTC = 0;
-		return winM;
+}
+intptr_t RegexSet::longMatchLength(SizePtrString toLook, uintptr_t* storeTC, uintptr_t** storeTypes){
+	if(lazyRegs){ return lazyRegs->longMatchLength(toLook, storeTC, storeTypes); }
+	RegexSetMatchProgress curProg;
+	startMatch(&curProg);
+	continueMatch(&curProg, toLook);
+	*storeTC = curProg.winTC;
+	*storeTypes = curProg.winTypes;
+	return curProg.winLen;
+}
+void RegexSet::startMatch(RegexSetMatchProgress* toFill){
+	toFill->numSeen = 0;
+	toFill->winLen = -1;
+	toFill->winTC = 0;
+	toFill->winTypes = 0;
+	uintptr_t curStatus;
+	uintptr_t* curAcc;
+	if(lazyRegs){
+		toFill->curState = lazyRegs->startRow;
+		curStatus = lazyRegs->classTable[toFill->curState];
+		curAcc = lazyRegs->acceptLists[lazyRegs->classTable[toFill->curState+1]];
 	}
-	
-	for(uintptr_t i = 0; i<toLook.len; i++){
-		curState = compiledRegs.states[curState].charTransitions[0x00FF & toLook.txt[i]];
-		curStatusIndex = compiledRegs.states[curState].stateStatus;
+	else{
+		toFill->curState = 0;
+		uintptr_t curStatusIndex = compiledRegs.classTable[0];
 		curStatus = compiledStatus[curStatusIndex];
-		if(curStatus & WHODUN_NFA_STATE_ACCEPT){
-			*storeTC = compiledStatus[curStatusIndex+1];
-			*storeTypes = &(compiledStatus[0]) + curStatusIndex+2;
-			winM = i+1;
+		curAcc = &(compiledStatus[curStatusIndex+1]);
+	}
+	if(curStatus & WHODUN_NFA_STATE_ACCEPT){
+		toFill->winLen = 0;
+		toFill->winTC = curAcc[0];
+		toFill->winTypes = curAcc + 1;
+	}
+	toFill->isDead = (curStatus & WHODUN_NFA_STATE_REJECT) != 0;
+}
+uintptr_t RegexSet::continueMatch(RegexSetMatchProgress* toUpd, SizePtrString toLook){
+	if(toUpd->isDead){ return 0; }
+	uintptr_t curRow = toUpd->curState;
+	uintptr_t numSeen = toUpd->numSeen;
+	uintptr_t i = 0;
+	if(lazyRegs){
+		LazyDeterministicFiniteAutomata* lazyR = lazyRegs;
+		while(i < toLook.len){
+			uintptr_t curC = lazyR->charClass[0x00FF & toLook.txt[i]];
+			uintptr_t nextRow = lazyR->classTable[curRow + 2 + curC];
+			if(nextRow == WHODUN_LAZYDFA_UNKNOWN){ nextRow = lazyR->buildNext(curRow, curC); }
+			curRow = nextRow;
+			uintptr_t curStatus = lazyR->classTable[curRow];
+			i++;
+			if(curStatus & WHODUN_NFA_STATE_ACCEPT){
+				uintptr_t* curAcc = lazyR->acceptLists[lazyR->classTable[curRow+1]];
+				toUpd->winLen = numSeen + i;
+				toUpd->winTC = curAcc[0];
+				toUpd->winTypes = curAcc + 1;
+			}
+			if(curStatus & WHODUN_NFA_STATE_REJECT){
+				toUpd->isDead = 1;
+				break;
+			}
 		}
-		if(curStatus & WHODUN_NFA_STATE_REJECT){
-			return winM;
+		lazyR->numStep += i;
+	}
+	else{
+		const uintptr_t* classTab = &(compiledRegs.classTable[0]);
+		const unsigned char* charClass = compiledRegs.charClass;
+		uintptr_t* allStatus = &(compiledStatus[0]);
+		while(i < toLook.len){
+			curRow = classTab[curRow + 1 + charClass[0x00FF & toLook.txt[i]]];
+			uintptr_t curStatusIndex = classTab[curRow];
+			uintptr_t curStatus = allStatus[curStatusIndex];
+			i++;
+			if(curStatus & WHODUN_NFA_STATE_ACCEPT){
+				toUpd->winLen = numSeen + i;
+				toUpd->winTC = allStatus[curStatusIndex+1];
+				toUpd->winTypes = allStatus + curStatusIndex + 2;
+			}
+			if(curStatus & WHODUN_NFA_STATE_REJECT){
+				toUpd->isDead = 1;
+				break;
+			}
 		}
 	}
-	
-	return winM;
+	toUpd->curState = curRow;
+	toUpd->numSeen = numSeen + i;
+	return i;
 }
 
@@ -5,6 +5,15 @@ namespace whodun{
 /**Go between between function pointer based and classes.*/
 bool whodun_comparatorSortFunc(void* useUni, void* itemA, void* itemB);
 
+/**
+ * Get a floating point key part as an unsigned number with the same order.
+ * @param keyBytes The bytes of the key.
+ * @param keySize The number of bytes in the key (at most 8).
+ * @param isBig Whether the bytes are stored most significant first.
+ * @return The ordered bits: negative zero is folded into zero, and every NaN into one value after infinity.
+ */
+uint64_t whodun_sortFloatKeyBits(const char* keyBytes, uintptr_t keySize, int isBig);
+
 /**Merge.*/
 class PODMergeQuantTask : public JoinableThreadTask{
 public:
@@ -77,6 +86,164 @@ public:
 	PODSortOptions opts;
 };
 
+/**Count or scatter a single byte of a key for radix sorting.*/
+class PODRadixSortTask : public JoinableThreadTask{
+public:
+	/**
+	 * Basic setup
+	 * @param theOpts Sorting options.
+	 */
+	PODRadixSortTask(PODSortOptions* theOpts);
+	/**Tear down*/
+	~PODRadixSortTask();
+	void doTask();
+	
+	/**
+	 * Get the (flipped) byte for an item.
+	 * @param curItem The item in question.
+	 * @return The byte to bucket on.
+	 */
+	inline unsigned char getRadix(char* curItem){
+		unsigned char curV = curItem[byteOff];
+		if(isFloat){
+			//only negative zero and NaN need the whole key, and the sign byte rules out most others
+			unsigned char signV = curItem[signOff];
+			if(slowFloat || (signV == 0x80) || ((signV & 0x7F) == 0x7F)){ return getFloatRadix(curItem); }
+			if(signV & 0x80){ return ~curV; }
+		}
+		return curV ^ flipMask;
+	}
+	/**
+	 * Get the byte for a floating point item, looking at the whole key.
+	 * @param curItem The item in question.
+	 * @return The byte to bucket on.
+	 */
+	unsigned char getFloatRadix(char* curItem);
+	
+	/**The first item this is responsible for.*/
+	uintptr_t fromI;
+	/**The item after the last item this is responsible for.*/
+	uintptr_t toI;
+	/**The array the data start in.*/
+	char* dataSrc;
+	/**The array the data go to.*/
+	char* dataDst;
+	/**The offset of the byte to look at.*/
+	uintptr_t byteOff;
+	/**The offset of the byte with the sign bit.*/
+	uintptr_t signOff;
+	/**Whether the key is floating point.*/
+	int isFloat;
+	/**Whether every floating point key needs to be looked at whole (i.e. not a float or double).*/
+	int slowFloat;
+	/**The offset of the key part.*/
+	uintptr_t partOff;
+	/**The number of bytes in the key part.*/
+	uintptr_t partSize;
+	/**Whether the key part is stored most significant first.*/
+	int partBig;
+	/**Which byte of the key part to look at, least significant first.*/
+	uintptr_t byteRank;
+	/**Bits to flip in the byte before bucketing.*/
+	unsigned char flipMask;
+	/**The number of items in each bucket, for this thread.*/
+	uintptr_t byteCounts[256];
+	/**The place the next item of each bucket goes, for this thread.*/
+	uintptr_t byteOffsets[256];
+	/**The phase: 1 for counting, 2 for scattering, 3 for copying back.*/
+	int phase;
+	/**Sorting options.*/
+	PODSortOptions opts;
+};
+
+/**Cut and merge a range of the output of a multiway merge.*/
+class PODMultiwayMergeTask : public JoinableThreadTask{
+public:
+	/**
+	 * Basic setup
+	 * @param theOpts Sorting options.
+	 */
+	PODMultiwayMergeTask(PODSortOptions* theOpts);
+	/**Tear down*/
+	~PODMultiwayMergeTask();
+	void doTask();
+	/**Find the cuts at the start of this range.*/
+	void findCuts();
+	/**Merge the range.*/
+	void mergeRange();
+	/**
+	 * Figure whether the head of one piece should come before the head of another.
+	 * @param srcA The first piece.
+	 * @param srcB The second piece.
+	 * @return Whether srcA wins: empty pieces lose, ties go to the earlier piece.
+	 */
+	bool beats(uintptr_t srcA, uintptr_t srcB);
+	/**
+	 * Replay the matches on the path from a piece to the root.
+	 * @param srcInd The piece whose head changed.
+	 */
+	void replay(uintptr_t srcInd);
+	
+	/**The index of the output range this works on.*/
+	uintptr_t rangeInd;
+	/**The number of output ranges.*/
+	uintptr_t numRange;
+	/**The number of pieces.*/
+	uintptr_t numPiece;
+	/**The total number of entries.*/
+	uintptr_t numEntries;
+	/**The start of the sorted pieces.*/
+	char* mergeFrom;
+	/**The place to merge to.*/
+	char* mergeTo;
+	/**The sizes of the pieces.*/
+	uintptr_t* pieceSizes;
+	/**The cut table: numPiece entries for each range boundary.*/
+	uintptr_t* allCuts;
+	/**The splitter at the start of this range.*/
+	char* splitter;
+	/**The phase: 1 for finding cuts, 2 for merging.*/
+	int phase;
+	/**The current head of each piece.*/
+	std::vector<char*> pieceHeads;
+	/**The end of each piece.*/
+	std::vector<char*> pieceEnds;
+	/**The end of the items equal to the splitter in each piece.*/
+	std::vector<uintptr_t> equalEnds;
+	/**The loser tree.*/
+	std::vector<uintptr_t> tree;
+	/**Sorting options.*/
+	PODSortOptions opts;
+};
+
+/**Build prefixes and gather items for indirect sorting.*/
+class PODIndirectSortTask : public JoinableThreadTask{
+public:
+	/**
+	 * Basic setup
+	 * @param theOpts Sorting options.
+	 */
+	PODIndirectSortTask(PODSortOptions* theOpts);
+	/**Tear down*/
+	~PODIndirectSortTask();
+	void doTask();
+	
+	/**The first item this is responsible for.*/
+	uintptr_t fromI;
+	/**The item after the last item this is responsible for.*/
+	uintptr_t toI;
+	/**The original items.*/
+	char* dataSrc;
+	/**The place to gather items to.*/
+	char* dataDst;
+	/**The prefixes.*/
+	PODSortPrefixEntry* prefixes;
+	/**The phase: 1 for building prefixes, 2 for gathering, 3 for copying back.*/
+	int phase;
+	/**Sorting options.*/
+	PODSortOptions opts;
+};
+
 /**
  * Create a new temporary name.
  * @param inFolder The folder it's in.
@@ -129,6 +296,65 @@ public:
 	int haveHitEnd;
 };
 
+/**Sort and spill a run in the background.*/
+class PODExternalSpillTask : public JoinableThreadTask{
+public:
+	/**
+	 * Basic setup
+	 * @param forSort The sort this spills for.
+	 */
+	PODExternalSpillTask(PODExternalMergeSort* forSort);
+	/**Tear down*/
+	~PODExternalSpillTask();
+	void doTask();
+	
+	/**The sort this spills for.*/
+	PODExternalMergeSort* mainSort;
+	/**The number of entries to spill.*/
+	uintptr_t numEntries;
+	/**The entries to spill.*/
+	char* entryStore;
+	/**Whether the entries need sorting first.*/
+	int needSort;
+};
+
+/**A tournament between sorted files, storing the loser at each node.*/
+class PODExternalLoserTree{
+public:
+	/**
+	 * Set up the tournament.
+	 * @param theOpts Sorting options.
+	 * @param theSources The files to merge.
+	 */
+	PODExternalLoserTree(PODSortOptions* theOpts, std::vector<PODExternalFileSource*>* theSources);
+	/**Clean up.*/
+	~PODExternalLoserTree();
+	
+	/**
+	 * Figure whether the head of one file should come before the head of another.
+	 * @param srcA The first file.
+	 * @param srcB The second file.
+	 * @return Whether srcA wins: empty files lose, ties go to the earlier file.
+	 */
+	bool beats(uintptr_t srcA, uintptr_t srcB);
+	/**
+	 * Replay the matches on the path from a file to the root.
+	 * @param srcInd The file whose head changed.
+	 */
+	void replay(uintptr_t srcInd);
+	
+	/**The winner (at zero), followed by the losers at each internal node.*/
+	std::vector<uintptr_t> tree;
+	/**Whether key prefixes are available.*/
+	int usePrefix;
+	/**The key prefix of the head of each file.*/
+	std::vector<uint64_t> headPrefix;
+	/**The files being merged.*/
+	std::vector<PODExternalFileSource*>* sources;
+	/**Sorting options.*/
+	PODSortOptions opts;
+};
+
 };
 
 using namespace whodun;
@@ -138,20 +364,106 @@ PODComparator::~PODComparator(){}
 bool whodun::whodun_comparatorSortFunc(void* useUni, void* itemA, void* itemB){
 	return ((PODComparator*)(useUni))->compare(itemA, itemB);
 }
+
+uint64_t whodun::whodun_sortFloatKeyBits(const char* keyBytes, uintptr_t keySize, int isBig){
+	uint64_t allBits = 0;
+	if((keySize == 8) && (isBig == WHODUN_SORTKEY_NATIVE)){
+		memcpy(&allBits, keyBytes, 8);
+	}
+	else if((keySize == 4) && (isBig == WHODUN_SORTKEY_NATIVE)){
+		uint32_t nativeBits;
+		memcpy(&nativeBits, keyBytes, 4);
+		allBits = nativeBits;
+	}
+	else{
+		for(uintptr_t bi = 0; bi<keySize; bi++){
+			allBits = (allBits << 8) | (unsigned char)(keyBytes[isBig ? bi : (keySize - (bi + 1))]);
+		}
+	}
+	uintptr_t numBits = 8*keySize;
+	uint64_t signBit = ((uint64_t)1) << (numBits - 1);
+	uint64_t magMask = signBit - 1;
+	//fold negative zero and the NaNs
+		uintptr_t expBits = (keySize == 8) ? 11 : ((keySize == 4) ? 8 : ((keySize == 2) ? 5 : 0));
+		if((allBits & magMask) == 0){ allBits = 0; }
+		else if(expBits){
+			uint64_t fracMask = magMask >> expBits;
+			uint64_t expMask = magMask & ~fracMask;
+			if(((allBits & expMask) == expMask) && (allBits & fracMask)){
+				allBits = expMask | ((fracMask + 1) >> 1);
+			}
+		}
+	//flip so it sorts as unsigned
+		if(allBits & signBit){ return ~allBits & (signBit | magMask); }
+		return allBits | signBit;
+}
 PODSortOptions::PODSortOptions(){
 	compMeth = 0;
 	useUni = 0;
 	itemSize = 0;
+	prefixMeth = 0;
+	useIndirect = 0;
 }
 PODSortOptions::PODSortOptions(uintptr_t itemS, void* useU, bool(*compM)(void*,void*,void*)){
 	compMeth = compM;
 	useUni = useU;
 	itemSize = itemS;
+	prefixMeth = 0;
+	useIndirect = 0;
 }
 PODSortOptions::PODSortOptions(PODComparator* useComp){
 	compMeth = whodun_comparatorSortFunc;
 	useUni = useComp;
 	itemSize = useComp->itemSize();
+	prefixMeth = 0;
+	useIndirect = 0;
+}
+void PODSortOptions::addKeyPart(uintptr_t offset, uintptr_t size, int flags){
+	PODSortKeyPart curPart = {offset, size, flags};
+	keyParts.push_back(curPart);
+}
+uint64_t PODSortOptions::getPrefix(void* item){
+	if(prefixMeth){ return prefixMeth(useUni, item); }
+	//normalize the key bytes, most significant first
+	char* itemC = (char*)item;
+	uint64_t toRet = 0;
+	int numLeft = 8;
+	for(uintptr_t pi = 0; (pi < keyParts.size()) && numLeft; pi++){
+		PODSortKeyPart* curPart = &(keyParts[pi]);
+		int isBig = curPart->flags & WHODUN_SORTKEY_BIGENDIAN;
+		if(curPart->flags & WHODUN_SORTKEY_FLOAT){
+			uint64_t floatBits = whodun_sortFloatKeyBits(itemC + curPart->offset, curPart->size, isBig);
+			for(uintptr_t bi = 0; (bi < curPart->size) && numLeft; bi++){
+				toRet = (toRet << 8) | (0x00FF & (floatBits >> (8*(curPart->size - (bi + 1)))));
+				numLeft--;
+			}
+			continue;
+		}
+		int flipSign = curPart->flags & WHODUN_SORTKEY_SIGNED;
+		for(uintptr_t bi = 0; (bi < curPart->size) && numLeft; bi++){
+			unsigned char curV = itemC[curPart->offset + (isBig ? bi : (curPart->size - (bi + 1)))];
+			if(flipSign && (bi == 0)){ curV = curV ^ 0x80; }
+			toRet = (toRet << 8) | curV;
+			numLeft--;
+		}
+	}
+	return toRet << (8*numLeft);
+}
+int PODSortOptions::hasPrefix(){
+	return (prefixMeth != 0) || (keyParts.size() != 0);
+}
+
+PODSortPrefixLess::PODSortPrefixLess(PODSortOptions* theOpts, char** theBase){
+	opts = theOpts;
+	baseData = theBase;
+}
+bool PODSortPrefixLess::operator()(const PODSortPrefixEntry& itemA, const PODSortPrefixEntry& itemB) const{
+	if(itemA.prefix != itemB.prefix){ return itemA.prefix < itemB.prefix; }
+	char* itemAP = *baseData + itemA.index * opts->itemSize;
+	char* itemBP = *baseData + itemB.index * opts->itemSize;
+	if(opts->compMeth(opts->useUni, itemAP, itemBP)){ return true; }
+	if(opts->compMeth(opts->useUni, itemBP, itemAP)){ return false; }
+	return itemA.index < itemB.index;
 }
 
 PODSortedDataChunk::PODSortedDataChunk(PODSortOptions* theOpts, char* dataStart, uintptr_t numData){
@@ -260,10 +572,10 @@ void PODMergeQuantTask::doTask(){
 		uintptr_t quantALow = chunkyPairedQuantile(quantileStart);
 		uintptr_t quantAHigh = chunkyPairedQuantile(quantileEnd);
 	//turn into arrays
-		char* curTgt = dataE + quantileStart;
-		char* curElemA = dataA + quantALow;
+		char* curTgt = dataE + quantileStart*itemSize;
+		char* curElemA = dataA + quantALow*itemSize;
 		uintptr_t numElemA = quantAHigh - quantALow;
-		char* curElemB = dataB + (quantileStart - quantALow);
+		char* curElemB = dataB + (quantileStart - quantALow)*itemSize;
 		uintptr_t numElemB = (quantileEnd - quantileStart) - numElemA;
 	//merge
 		while(numElemA && numElemB){
@@ -324,7 +636,8 @@ int whodun::whodun_inMemoryMergesortSmall(uintptr_t numEnts, char* inMem, PODSor
 			uintptr_t numLeftA = nxtBase - curBase;
 			uintptr_t numLeftB = finBase - nxtBase;
 			while(numLeftA && numLeftB){
-				if(opts->compMeth(opts->useUni, curFromA, curFromB)){
+				//in case of tie, A should go first (to keep it stable)
+				if(!(opts->compMeth(opts->useUni, curFromB, curFromA))){
 					memcpy(curTo, curFromA, itemSize);
 					curTo += itemSize;
 					curFromA += itemSize;
@@ -367,6 +680,175 @@ void PODSortChunkTask::doTask(){
 	}
 }
 
+PODRadixSortTask::PODRadixSortTask(PODSortOptions* theOpts){
+	opts = *theOpts;
+}
+PODRadixSortTask::~PODRadixSortTask(){}
+void PODRadixSortTask::doTask(){
+	uintptr_t itemSize = opts.itemSize;
+	char* curItem = dataSrc + fromI*itemSize;
+	switch(phase){
+		case 1:
+			memset(byteCounts, 0, 256*sizeof(uintptr_t));
+			for(uintptr_t i = fromI; i<toI; i++){
+				byteCounts[getRadix(curItem)]++;
+				curItem += itemSize;
+			}
+			break;
+		case 2:
+			for(uintptr_t i = fromI; i<toI; i++){
+				uintptr_t* curTgt = byteOffsets + getRadix(curItem);
+				memcpy(dataDst + itemSize*(*curTgt), curItem, itemSize);
+				(*curTgt)++;
+				curItem += itemSize;
+			}
+			break;
+		case 3:
+			memcpy(dataDst + fromI*itemSize, curItem, (toI - fromI)*itemSize);
+			break;
+		default:
+			throw std::runtime_error("Da fuq?");
+	}
+}
+
+unsigned char PODRadixSortTask::getFloatRadix(char* curItem){
+	return (unsigned char)(whodun_sortFloatKeyBits(curItem + partOff, partSize, partBig) >> (8*byteRank));
+}
+
+PODIndirectSortTask::PODIndirectSortTask(PODSortOptions* theOpts){
+	opts = *theOpts;
+}
+PODIndirectSortTask::~PODIndirectSortTask(){}
+void PODIndirectSortTask::doTask(){
+	uintptr_t itemSize = opts.itemSize;
+	switch(phase){
+		case 1:{
+			char* curItem = dataSrc + fromI*itemSize;
+			for(uintptr_t i = fromI; i<toI; i++){
+				prefixes[i].prefix = opts.getPrefix(curItem);
+				prefixes[i].index = i;
+				curItem += itemSize;
+			}
+		} break;
+		case 2:{
+			char* curTgt = dataDst + fromI*itemSize;
+			for(uintptr_t i = fromI; i<toI; i++){
+				memcpy(curTgt, dataSrc + prefixes[i].index*itemSize, itemSize);
+				curTgt += itemSize;
+			}
+		} break;
+		case 3:
+			memcpy(dataDst + fromI*itemSize, dataSrc + fromI*itemSize, (toI - fromI)*itemSize);
+			break;
+		default:
+			throw std::runtime_error("Da fuq?");
+	}
+}
+
+PODMultiwayMergeTask::PODMultiwayMergeTask(PODSortOptions* theOpts){
+	opts = *theOpts;
+}
+PODMultiwayMergeTask::~PODMultiwayMergeTask(){}
+void PODMultiwayMergeTask::doTask(){
+	switch(phase){
+		case 1: findCuts(); break;
+		case 2: mergeRange(); break;
+		default:
+			throw std::runtime_error("Da fuq?");
+	}
+}
+void PODMultiwayMergeTask::findCuts(){
+	uintptr_t itemSize = opts.itemSize;
+	uintptr_t* lowCuts = allCuts + rangeInd*numPiece;
+	//everything before the splitter goes in earlier ranges
+		uintptr_t totLow = 0;
+		uintptr_t totHigh = 0;
+		char* curPiece = mergeFrom;
+		equalEnds.resize(numPiece);
+		for(uintptr_t i = 0; i<numPiece; i++){
+			PODSortedDataChunk curChunk(&opts, curPiece, pieceSizes[i]);
+			lowCuts[i] = curChunk.lowerBound(splitter);
+			equalEnds[i] = curChunk.upperBound(splitter);
+			totLow += lowCuts[i];
+			totHigh += equalEnds[i];
+			curPiece += pieceSizes[i]*itemSize;
+		}
+	//split runs of items equal to the splitter (in piece order) to even out the ranges
+		uintptr_t wantTot = (rangeInd * numEntries) / numRange;
+		wantTot = std::min(std::max(wantTot, totLow), totHigh);
+		uintptr_t needMore = wantTot - totLow;
+		for(uintptr_t i = 0; (i<numPiece) && needMore; i++){
+			uintptr_t curTake = std::min(needMore, equalEnds[i] - lowCuts[i]);
+			lowCuts[i] += curTake;
+			needMore -= curTake;
+		}
+}
+void PODMultiwayMergeTask::mergeRange(){
+	uintptr_t itemSize = opts.itemSize;
+	uintptr_t* lowCuts = allCuts + rangeInd*numPiece;
+	uintptr_t* highCuts = lowCuts + numPiece;
+	//set up the pieces
+		pieceHeads.resize(numPiece);
+		pieceEnds.resize(numPiece);
+		uintptr_t outOffset = 0;
+		char* curPiece = mergeFrom;
+		for(uintptr_t i = 0; i<numPiece; i++){
+			pieceHeads[i] = curPiece + lowCuts[i]*itemSize;
+			pieceEnds[i] = curPiece + highCuts[i]*itemSize;
+			outOffset += lowCuts[i];
+			curPiece += pieceSizes[i]*itemSize;
+		}
+	//build the tree
+		tree.clear();
+		tree.resize(numPiece, numPiece);
+		uintptr_t i = numPiece;
+		while(i){
+			i--;
+			replay(i);
+		}
+	//and merge
+		char* curTgt = mergeTo + outOffset*itemSize;
+		while(1){
+			uintptr_t winInd = tree[0];
+			char* winHead = pieceHeads[winInd];
+			if(winHead == pieceEnds[winInd]){ break; }
+			memcpy(curTgt, winHead, itemSize);
+			curTgt += itemSize;
+			pieceHeads[winInd] = winHead + itemSize;
+			replay(winInd);
+		}
+}
+bool PODMultiwayMergeTask::beats(uintptr_t srcA, uintptr_t srcB){
+	if(pieceHeads[srcA] == pieceEnds[srcA]){ return false; }
+	if(pieceHeads[srcB] == pieceEnds[srcB]){ return true; }
+	if(opts.compMeth(opts.useUni, pieceHeads[srcA], pieceHeads[srcB])){ return true; }
+	if(opts.compMeth(opts.useUni, pieceHeads[srcB], pieceHeads[srcA])){ return false; }
+	return srcA < srcB;
+}
+void PODMultiwayMergeTask::replay(uintptr_t srcInd){
+	uintptr_t numSrc = tree.size();
+	uintptr_t curWin = srcInd;
+	uintptr_t curNode = (srcInd + numSrc) >> 1;
+	while(curNode){
+		uintptr_t curLose = tree[curNode];
+		if(curLose == numSrc){
+			tree[curNode] = curWin;
+			return;
+		}
+		if(beats(curLose, curWin)){
+			tree[curNode] = curWin;
+			curWin = curLose;
+		}
+		curNode = curNode >> 1;
+	}
+	tree[0] = curWin;
+}
+
+/**The minimum number of things to bother with radix sorting.*/
+#define WHODUN_SORT_RADIX_MINIMUM 1024
+/**The minimum item size to sort prefixes instead of items.*/
+#define WHODUN_SORT_INDIRECT_MINSIZE 64
+
 PODInMemoryMergesort::PODInMemoryMergesort(PODSortOptions* theOpts){
 	opts = *theOpts;
 	allocSize = 1024;
@@ -381,6 +863,14 @@ PODInMemoryMergesort::PODInMemoryMergesort(PODSortOptions* theOpts){
 			passUnis.push_back(curSTask);
 		PODSortedDataMerger* curMerge = new PODSortedDataMerger(theOpts);
 			mergeMeths.push_back(curMerge);
+		radixUnis.push_back(new PODRadixSortTask(theOpts));
+		indirectUnis.push_back(new PODIndirectSortTask(theOpts));
+	}
+	useMultiway = 0;
+	indirectBase = 0;
+	prefixSort = 0;
+	if(opts.hasPrefix() && (opts.prefixMeth || opts.useIndirect)){
+		prefixSort = new PODInMemoryMergesortT<PODSortPrefixEntry,PODSortPrefixLess>(PODSortPrefixLess(&opts, &indirectBase));
 	}
 }
 PODInMemoryMergesort::PODInMemoryMergesort(PODSortOptions* theOpts, uintptr_t numThr, ThreadPool* mainPool){
@@ -395,6 +885,9 @@ PODInMemoryMergesort::PODInMemoryMergesort(PODSortOptions* theOpts, uintptr_t nu
 			wantInTemp = !wantInTemp;
 			tmpNumThr = (tmpNumThr >> 1) + (tmpNumThr & 0x01);
 		}
+	//past two threads, merge everything in one go
+		useMultiway = (numThr > 2);
+		if(useMultiway){ wantInTemp = 1; }
 	//make the thread stuff
 	for(uintptr_t i = 0; i<numThr; i++){
 		PODSortChunkTask* curSTask = new PODSortChunkTask(theOpts);
@@ -402,13 +895,27 @@ PODInMemoryMergesort::PODInMemoryMergesort(PODSortOptions* theOpts, uintptr_t nu
 			passUnis.push_back(curSTask);
 		PODSortedDataMerger* curMerge = new PODSortedDataMerger(theOpts, numThr, mainPool);
 			mergeMeths.push_back(curMerge);
+		radixUnis.push_back(new PODRadixSortTask(theOpts));
+		indirectUnis.push_back(new PODIndirectSortTask(theOpts));
+		multiUnis.push_back(new PODMultiwayMergeTask(theOpts));
+	}
+	indirectBase = 0;
+	prefixSort = 0;
+	if(opts.hasPrefix() && (opts.prefixMeth || opts.useIndirect)){
+		prefixSort = new PODInMemoryMergesortT<PODSortPrefixEntry,PODSortPrefixLess>(numThr, mainPool, PODSortPrefixLess(&opts, &indirectBase));
 	}
 }
 PODInMemoryMergesort::~PODInMemoryMergesort(){
 	for(uintptr_t i = 0; i<passUnis.size(); i++){
 		delete(passUnis[i]);
 		delete(mergeMeths[i]);
+		delete(radixUnis[i]);
+		delete(indirectUnis[i]);
+	}
+	for(uintptr_t i = 0; i<multiUnis.size(); i++){
+		delete(multiUnis[i]);
 	}
+	if(prefixSort){ delete(prefixSort); }
 	free(allocTmp);
 }
 void PODInMemoryMergesort::sort(uintptr_t numEntries, char* entryStore){
@@ -419,6 +926,16 @@ void PODInMemoryMergesort::sort(uintptr_t numEntries, char* entryStore){
 			allocSize = numEntries;
 			allocTmp = (char*)malloc(allocSize * itemSize);
 		}
+	//big items can sort by prefix, if asked
+		if(prefixSort && (itemSize >= WHODUN_SORT_INDIRECT_MINSIZE) && (numEntries >= WHODUN_SORT_RADIX_MINIMUM)){
+			indirectSort(numEntries, entryStore);
+			return;
+		}
+	//use the key, if there is one
+		if(opts.keyParts.size() && (numEntries >= WHODUN_SORT_RADIX_MINIMUM)){
+			radixSort(numEntries, entryStore);
+			return;
+		}
 	//do the initial sort
 		uintptr_t numThread = passUnis.size();
 		uintptr_t numPT = numEntries / numThread;
@@ -444,6 +961,10 @@ void PODInMemoryMergesort::sort(uintptr_t numEntries, char* entryStore){
 	//do the merges
 		char* curMergeFrom = wantInTemp ? allocTmp : entryStore;
 		char* curMergeTo = wantInTemp ? entryStore : allocTmp;
+		if(useMultiway){
+			multiwayMerge(curMergeFrom, curMergeTo);
+			return;
+		}
 		while(threadPieceSizes.size() > 1){
 			//start the merges
 				uintptr_t curI0 = 0;
@@ -477,6 +998,214 @@ void PODInMemoryMergesort::sort(uintptr_t numEntries, char* entryStore){
 		}
 }
 
+void PODInMemoryMergesort::radixSort(uintptr_t numEntries, char* entryStore){
+	//test storage allocation
+		if(numEntries > allocSize){
+			if(allocTmp){ free(allocTmp); }
+			allocSize = numEntries;
+			allocTmp = (char*)malloc(allocSize * opts.itemSize);
+		}
+	//split up the items
+		uintptr_t numThread = radixUnis.size();
+		uintptr_t numPT = numEntries / numThread;
+		uintptr_t numET = numEntries % numThread;
+		uintptr_t curI0 = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			PODRadixSortTask* curTask = (PODRadixSortTask*)(radixUnis[i]);
+			curTask->fromI = curI0;
+			curI0 += (numPT + (i < numET));
+			curTask->toI = curI0;
+		}
+	//least significant byte first
+		char* curSrc = entryStore;
+		char* curDst = allocTmp;
+		uintptr_t pi = opts.keyParts.size();
+		while(pi){
+			pi--;
+			PODSortKeyPart* curPart = &(opts.keyParts[pi]);
+			int isBig = curPart->flags & WHODUN_SORTKEY_BIGENDIAN;
+			uintptr_t signOff = curPart->offset + (isBig ? 0 : (curPart->size - 1));
+			for(uintptr_t bi = 0; bi<curPart->size; bi++){
+				uintptr_t byteOff = curPart->offset + (isBig ? (curPart->size - (bi + 1)) : bi);
+				int isSign = (bi == (curPart->size - 1)) && (curPart->flags & (WHODUN_SORTKEY_SIGNED | WHODUN_SORTKEY_FLOAT));
+				//count
+				for(uintptr_t i = 0; i<numThread; i++){
+					PODRadixSortTask* curTask = (PODRadixSortTask*)(radixUnis[i]);
+					curTask->dataSrc = curSrc;
+					curTask->dataDst = curDst;
+					curTask->byteOff = byteOff;
+					curTask->signOff = signOff;
+					curTask->isFloat = curPart->flags & WHODUN_SORTKEY_FLOAT;
+					curTask->slowFloat = (curPart->size != 8) && (curPart->size != 4);
+					curTask->partOff = curPart->offset;
+					curTask->partSize = curPart->size;
+					curTask->partBig = isBig;
+					curTask->byteRank = bi;
+					curTask->flipMask = isSign ? 0x80 : 0x00;
+					curTask->phase = 1;
+				}
+				if(usePool){
+					usePool->addTasks(numThread, (JoinableThreadTask**)(&(radixUnis[0])));
+					joinTasks(numThread, (JoinableThreadTask**)(&(radixUnis[0])));
+				}
+				else{
+					radixUnis[0]->doTask();
+				}
+				//figure out where things go (skip if everything has the same byte)
+				uintptr_t curOff = 0;
+				int allSame = 0;
+				for(uintptr_t v = 0; v<256; v++){
+					uintptr_t curTot = 0;
+					for(uintptr_t i = 0; i<numThread; i++){
+						PODRadixSortTask* curTask = (PODRadixSortTask*)(radixUnis[i]);
+						curTask->byteOffsets[v] = curOff + curTot;
+						curTot += curTask->byteCounts[v];
+					}
+					if(curTot == numEntries){ allSame = 1; break; }
+					curOff += curTot;
+				}
+				if(allSame){ continue; }
+				//scatter
+				for(uintptr_t i = 0; i<numThread; i++){
+					((PODRadixSortTask*)(radixUnis[i]))->phase = 2;
+				}
+				if(usePool){
+					usePool->addTasks(numThread, (JoinableThreadTask**)(&(radixUnis[0])));
+					joinTasks(numThread, (JoinableThreadTask**)(&(radixUnis[0])));
+				}
+				else{
+					radixUnis[0]->doTask();
+				}
+				char* tmpSwap = curSrc;
+				curSrc = curDst;
+				curDst = tmpSwap;
+			}
+		}
+	//copy back if it wound up in the wrong place
+		if(curSrc != entryStore){
+			for(uintptr_t i = 0; i<numThread; i++){
+				PODRadixSortTask* curTask = (PODRadixSortTask*)(radixUnis[i]);
+				curTask->dataSrc = curSrc;
+				curTask->dataDst = entryStore;
+				curTask->phase = 3;
+			}
+			if(usePool){
+				usePool->addTasks(numThread, (JoinableThreadTask**)(&(radixUnis[0])));
+				joinTasks(numThread, (JoinableThreadTask**)(&(radixUnis[0])));
+			}
+			else{
+				radixUnis[0]->doTask();
+			}
+		}
+}
+
+void PODInMemoryMergesort::multiwayMerge(char* mergeFrom, char* mergeTo){
+	uintptr_t itemSize = opts.itemSize;
+	uintptr_t numPiece = threadPieceSizes.size();
+	uintptr_t numThread = multiUnis.size();
+	uintptr_t numEntries = 0;
+	for(uintptr_t i = 0; i<numPiece; i++){ numEntries += threadPieceSizes[i]; }
+	//take regular samples from each piece, and sort them
+		uintptr_t numSample = 0;
+		multiSamples.resize(2*numPiece*numThread*itemSize);
+		char* curPiece = mergeFrom;
+		for(uintptr_t i = 0; i<numPiece; i++){
+			uintptr_t curSize = threadPieceSizes[i];
+			if(curSize){
+				for(uintptr_t j = 0; j<numThread; j++){
+					memcpy(&(multiSamples[numSample*itemSize]), curPiece + ((j*curSize)/numThread)*itemSize, itemSize);
+					numSample++;
+				}
+			}
+			curPiece += curSize*itemSize;
+		}
+		char* sampStart = &(multiSamples[0]);
+		if(whodun_inMemoryMergesortSmall(numSample, sampStart, &opts, sampStart + numSample*itemSize)){
+			sampStart = sampStart + numSample*itemSize;
+		}
+	//pick splitters
+		multiSplitters.resize(numThread*itemSize);
+		for(uintptr_t j = 1; j<numThread; j++){
+			memcpy(&(multiSplitters[j*itemSize]), sampStart + ((j*numSample)/numThread)*itemSize, itemSize);
+		}
+	//set up the cut table
+		multiCuts.resize((numThread+1)*numPiece);
+		for(uintptr_t i = 0; i<numPiece; i++){
+			multiCuts[i] = 0;
+			multiCuts[numThread*numPiece + i] = threadPieceSizes[i];
+		}
+	//find the cuts, then merge
+		for(int phase = 1; phase <= 2; phase++){
+			for(uintptr_t j = 0; j<numThread; j++){
+				PODMultiwayMergeTask* curTask = (PODMultiwayMergeTask*)(multiUnis[j]);
+				curTask->rangeInd = j;
+				curTask->numPiece = numPiece;
+				curTask->numEntries = numEntries;
+				curTask->mergeFrom = mergeFrom;
+				curTask->mergeTo = mergeTo;
+				curTask->pieceSizes = &(threadPieceSizes[0]);
+				curTask->allCuts = &(multiCuts[0]);
+				curTask->splitter = &(multiSplitters[j*itemSize]);
+				curTask->numRange = numThread;
+				curTask->phase = phase;
+			}
+			if(phase == 1){
+				//the first range starts at zero
+				usePool->addTasks(numThread-1, (JoinableThreadTask**)(&(multiUnis[1])));
+				joinTasks(numThread-1, (JoinableThreadTask**)(&(multiUnis[1])));
+			}
+			else{
+				usePool->addTasks(numThread, (JoinableThreadTask**)(&(multiUnis[0])));
+				joinTasks(numThread, (JoinableThreadTask**)(&(multiUnis[0])));
+			}
+		}
+}
+
+void PODInMemoryMergesort::indirectSort(uintptr_t numEntries, char* entryStore){
+	if(prefixSort == 0){ throw std::runtime_error("Indirect sorting needs a key prefix."); }
+	//test storage allocation
+		if(numEntries > allocSize){
+			if(allocTmp){ free(allocTmp); }
+			allocSize = numEntries;
+			allocTmp = (char*)malloc(allocSize * opts.itemSize);
+		}
+		if(prefixStore.size() < numEntries){ prefixStore.resize(numEntries); }
+		if(numEntries == 0){ return; }
+	//split up the items
+		uintptr_t numThread = indirectUnis.size();
+		uintptr_t numPT = numEntries / numThread;
+		uintptr_t numET = numEntries % numThread;
+		uintptr_t curI0 = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			PODIndirectSortTask* curTask = (PODIndirectSortTask*)(indirectUnis[i]);
+			curTask->fromI = curI0;
+			curI0 += (numPT + (i < numET));
+			curTask->toI = curI0;
+			curTask->prefixes = &(prefixStore[0]);
+		}
+	//get the prefixes, sort them, gather, and copy back
+		indirectBase = entryStore;
+		for(int phase = 1; phase <= 3; phase++){
+			if(phase == 2){
+				prefixSort->sort(numEntries, &(prefixStore[0]));
+			}
+			for(uintptr_t i = 0; i<numThread; i++){
+				PODIndirectSortTask* curTask = (PODIndirectSortTask*)(indirectUnis[i]);
+				curTask->dataSrc = (phase == 3) ? allocTmp : entryStore;
+				curTask->dataDst = (phase == 3) ? entryStore : allocTmp;
+				curTask->phase = phase;
+			}
+			if(usePool){
+				usePool->addTasks(numThread, (JoinableThreadTask**)(&(indirectUnis[0])));
+				joinTasks(numThread, (JoinableThreadTask**)(&(indirectUnis[0])));
+			}
+			else{
+				indirectUnis[0]->doTask();
+			}
+		}
+		indirectBase = 0;
+}
+
 void whodun::whodun_externalSortNewTempName(const char* inFolder, std::string* toFill, uintptr_t numTemps){
 	char asciiBuff[8*sizeof(uintmax_t)+8];
 	toFill->append(inFolder);
@@ -491,7 +1220,23 @@ void whodun::whodun_externalSortNewTempName(const char* inFolder, std::string* t
 
 #define TEMPORARY_BLOCK_SIZE 0x0100000
 
+PODExternalSpillTask::PODExternalSpillTask(PODExternalMergeSort* forSort){
+	mainSort = forSort;
+}
+PODExternalSpillTask::~PODExternalSpillTask(){}
+void PODExternalSpillTask::doTask(){
+	if(needSort){ mainSort->runSort->sort(numEntries, entryStore); }
+	mainSort->spillRun(numEntries, entryStore);
+}
+
 PODExternalMergeSort::PODExternalMergeSort(const char* workDirName, PODSortOptions* theOpts){
+	spillComp = &defaultSpillComp;
+	runBuffers[0] = 0; runBuffers[1] = 0;
+	runBufferSize[0] = 0; runBufferSize[1] = 0;
+	runFillIndex = 0;
+	runSort = new PODInMemoryMergesort(theOpts);
+	spillTask = new PODExternalSpillTask(this);
+	spillThread = 0;
 	statusDump = 0;
 	maxLoad = 0x040000;
 	maxMergeFiles = 256;
@@ -508,6 +1253,13 @@ PODExternalMergeSort::PODExternalMergeSort(const char* workDirName, PODSortOptio
 	}
 }
 PODExternalMergeSort::PODExternalMergeSort(const char* workDirName, PODSortOptions* theOpts, uintptr_t numThr, ThreadPool* mainPool){
+	spillComp = &defaultSpillComp;
+	runBuffers[0] = 0; runBuffers[1] = 0;
+	runBufferSize[0] = 0; runBufferSize[1] = 0;
+	runFillIndex = 0;
+	runSort = new PODInMemoryMergesort(theOpts, numThr, mainPool);
+	spillTask = new PODExternalSpillTask(this);
+	spillThread = 0;
 	statusDump = 0;
 	maxLoad = 0x040000;
 	maxMergeFiles = 256;
@@ -524,6 +1276,11 @@ PODExternalMergeSort::PODExternalMergeSort(const char* workDirName, PODSortOptio
 	}
 }
 PODExternalMergeSort::~PODExternalMergeSort(){
+	try{ waitSpill(); }catch(std::exception& errE){}
+	delete(spillTask);
+	delete(runSort);
+	if(runBuffers[0]){ free(runBuffers[0]); }
+	if(runBuffers[1]){ free(runBuffers[1]); }
 	for(uintptr_t i = 0; i<allTempBase.size(); i++){
 		fileKill(allTempBase[i].c_str());
 		fileKill(allTempBlock[i].c_str());
@@ -531,7 +1288,43 @@ PODExternalMergeSort::~PODExternalMergeSort(){
 	if(madeTemp){ directoryKill(tempName.c_str()); }
 }
 void PODExternalMergeSort::addData(uintptr_t numEntries, char* entryStore){
-	DeflateCompressionFactory compMeth;
+	char* fillBuf = getFillBuffer(numEntries);
+	memcpy(fillBuf, entryStore, numEntries * opts.itemSize);
+	addFillBuffer(numEntries, 0);
+}
+void PODExternalMergeSort::addUnsortedData(uintptr_t numEntries, char* entryStore){
+	char* fillBuf = getFillBuffer(numEntries);
+	memcpy(fillBuf, entryStore, numEntries * opts.itemSize);
+	addFillBuffer(numEntries, 1);
+}
+char* PODExternalMergeSort::getFillBuffer(uintptr_t numEntries){
+	if(numEntries > runBufferSize[runFillIndex]){
+		if(runBuffers[runFillIndex]){ free(runBuffers[runFillIndex]); }
+		runBufferSize[runFillIndex] = numEntries;
+		runBuffers[runFillIndex] = (char*)malloc(numEntries * opts.itemSize);
+	}
+	return runBuffers[runFillIndex];
+}
+void PODExternalMergeSort::addFillBuffer(uintptr_t numEntries, int needSort){
+	waitSpill();
+	if(numEntries == 0){ return; }
+	PODExternalSpillTask* curTask = (PODExternalSpillTask*)spillTask;
+	curTask->numEntries = numEntries;
+	curTask->entryStore = runBuffers[runFillIndex];
+	curTask->needSort = needSort;
+	curTask->reset();
+	spillThread = new OSThread(curTask);
+	runFillIndex = 1 - runFillIndex;
+}
+void PODExternalMergeSort::waitSpill(){
+	if(spillThread == 0){ return; }
+	spillThread->join();
+	delete(spillThread);
+	spillThread = 0;
+	spillTask->join();
+}
+void PODExternalMergeSort::spillRun(uintptr_t numEntries, char* entryStore){
+	CompressionFactory& compMeth = *spillComp;
 	//make the name of the thing
 		std::string baseN;
 			whodun_externalSortNewTempName(tempName.c_str(), &baseN, numTemps);
@@ -557,7 +1350,8 @@ void PODExternalMergeSort::addData(uintptr_t numEntries, char* entryStore){
 		}
 }
 void PODExternalMergeSort::mergeData(OutStream* toDump){
-	DeflateCompressionFactory compMeth;
+	waitSpill();
+	CompressionFactory& compMeth = *spillComp;
 	//if no files, stop
 		if(allTempBase.size() == 0){ return; }
 	//if only one file, just dump it
@@ -592,13 +1386,17 @@ void PODExternalMergeSort::mergeData(OutStream* toDump){
 			free(tmpStore);
 			return;
 		}
-	//figure out how many entries to load in a single file
-		uintptr_t stageSize = maxLoad / 3;
-		uintptr_t sinLoadBytes = stageSize / maxMergeFiles;
-		uintptr_t sinLoadEnts = sinLoadBytes / opts.itemSize;
-			sinLoadEnts = std::max(sinLoadEnts, minMergeEnts);
-	//keep spitting while there are a large number of files
-		while(allTempBase.size() > maxMergeFiles){
+	//figure out the fan in from the memory budget (each open file and the output get a buffer)
+		uintptr_t maxFanIn = maxLoad / (minMergeEnts * opts.itemSize);
+			maxFanIn = (maxFanIn > 1) ? (maxFanIn - 1) : 0;
+			maxFanIn = std::min(maxFanIn, maxMergeFiles);
+			maxFanIn = std::max(maxFanIn, (uintptr_t)2);
+	//keep spitting while there are a large number of files (only merge enough to make the last merge fit)
+		//merge neighboring runs and put the result in their place, so ties keep their order
+		uintptr_t curPos = 0;
+		while(allTempBase.size() > maxFanIn){
+			uintptr_t numMerge = std::min(maxFanIn, allTempBase.size() - maxFanIn + 1);
+			if((curPos + numMerge) > allTempBase.size()){ curPos = 0; }
 			std::string baseN;
 				whodun_externalSortNewTempName(tempName.c_str(), &baseN, numTemps);
 				numTemps++;
@@ -608,8 +1406,8 @@ void PODExternalMergeSort::mergeData(OutStream* toDump){
 				//update status
 					if(statusDump){
 						const char* baseNAC[2];
-							baseNAC[0] = allTempBase[0].c_str();
-							baseNAC[1] = allTempBase[maxMergeFiles-1].c_str();
+							baseNAC[0] = allTempBase[curPos].c_str();
+							baseNAC[1] = allTempBase[curPos+numMerge-1].c_str();
 						statusDump->spitError(WHODUN_ERROR_LEVEL_DEBUG, WHODUN_ERROR_SDESC_UPDATE, __FILE__, __LINE__, "OOM SORT MERGE", 2, baseNAC);
 					}
 				//open the file
@@ -620,7 +1418,7 @@ void PODExternalMergeSort::mergeData(OutStream* toDump){
 						endDump = new BlockCompOutStream(0, TEMPORARY_BLOCK_SIZE, baseN.c_str(), blockN.c_str(), &compMeth);
 					}
 				//merge
-					mergeSingle(maxMergeFiles, sinLoadEnts, endDump);
+					mergeSingle(curPos, numMerge, maxLoad / ((numMerge + 1) * opts.itemSize), endDump);
 					endDump->close();
 					delete(endDump);
 			}
@@ -629,188 +1427,125 @@ void PODExternalMergeSort::mergeData(OutStream* toDump){
 				fileKill(baseN.c_str()); fileKill(blockN.c_str());
 				throw;
 			}
-			allTempBase.push_back(baseN);
-			allTempBlock.push_back(blockN);
+			allTempBase.insert(allTempBase.begin() + curPos, baseN);
+			allTempBlock.insert(allTempBlock.begin() + curPos, blockN);
+			curPos++;
 		}
 	//do the final merge
 		if(statusDump){
 			statusDump->spitError(WHODUN_ERROR_LEVEL_DEBUG, WHODUN_ERROR_SDESC_UPDATE, __FILE__, __LINE__, "OOM SORT SPIT", 0, 0);
 		}
-		mergeSingle(allTempBase.size(), sinLoadEnts, toDump);
+		uintptr_t numMerge = allTempBase.size();
+		mergeSingle(0, numMerge, maxLoad / ((numMerge + 1) * opts.itemSize), toDump);
 }
-void PODExternalMergeSort::mergeSingle(uintptr_t numFileOpen, uintptr_t loadEnts, OutStream* toDump){
+void PODExternalMergeSort::mergeSingle(uintptr_t fromFile, uintptr_t numFileOpen, uintptr_t loadEnts, OutStream* toDump){
 	uintptr_t i;
-	DeflateCompressionFactory compMeth;
+	CompressionFactory& compMeth = *spillComp;
 	uintptr_t itemSize = opts.itemSize;
-	char* mergeArenaA = 0;
-	char* mergeArenaB = 0;
+	loadEnts = std::max(loadEnts, minMergeEnts);
+	char* outArena = 0;
 	std::vector<PODExternalFileSource*> openFiles;
-	std::vector<PODSortedDataMerger*> mergeMeths;
-	std::vector<uintptr_t> mergeCount(numFileOpen);
-	std::vector<uintptr_t> mergeLens;
 	try{
 		//open the files
 			for(i = 0; i<numFileOpen; i++){
 				if(usePool){
-					InStream* curRFile = new BlockCompInStream(allTempBase[i].c_str(), allTempBlock[i].c_str(), &compMeth, numThread, usePool);
+					InStream* curRFile = new BlockCompInStream(allTempBase[fromFile+i].c_str(), allTempBlock[fromFile+i].c_str(), &compMeth, numThread, usePool);
 					openFiles.push_back(new PODExternalFileSource(loadEnts, &opts, curRFile, numThread, usePool));
 				}
 				else{
-					InStream* curRFile = new BlockCompInStream(allTempBase[i].c_str(), allTempBlock[i].c_str(), &compMeth);
+					InStream* curRFile = new BlockCompInStream(allTempBase[fromFile+i].c_str(), allTempBlock[fromFile+i].c_str(), &compMeth);
 					openFiles.push_back(new PODExternalFileSource(loadEnts, &opts, curRFile));
 				}
-			}
-		//allocate ram and mergers
-			mergeArenaA = (char*)malloc(loadEnts*numFileOpen*itemSize);
-			mergeArenaB = (char*)malloc(loadEnts*numFileOpen*itemSize);
-			for(i = 0; i<numFileOpen; i++){
-				if(usePool){
-					mergeMeths.push_back(new PODSortedDataMerger(&opts, numThread, usePool));
-				}
-				else{
-					mergeMeths.push_back(new PODSortedDataMerger(&opts));
-				}
-			}
-		
-		doAnotherLoad:
-		//let the things load
-		{
-			int anyHasSomething = 0;
-			for(i = 0; i<openFiles.size(); i++){
 				openFiles[i]->load();
-				anyHasSomething = anyHasSomething || openFiles[i]->loadSize;
 			}
-			if(!anyHasSomething){ goto allGone; }
-		}
-		
-		doAnotherMerge:
-		//figure out what to merge
-		{
-			//find the smallest thing at the end of all the files with more stuff (smallest largest)
-				char* smallestEnt = 0;
-				for(i = 0; i<openFiles.size(); i++){
-					PODExternalFileSource* curF = openFiles[i];
-					if(curF->haveHitEnd){ continue; }
-					if(curF->loadSize){
-						char* curExEnt = curF->loadArena + (curF->loadOffset + curF->loadSize - 1)*itemSize;
-						if((smallestEnt == 0) || opts.compMeth(opts.useUni, curExEnt, smallestEnt)){
-							smallestEnt = curExEnt;
-						}
-					}
-				}
-			//figure out how many from each file to merge
-				uintptr_t numWithAnyMerge = 0;
-				uintptr_t mergeIndex = 0;
-				for(i = 0; i<openFiles.size(); i++){
-					PODExternalFileSource* curF = openFiles[i];
-					PODSortedDataChunk curFD(&opts, curF->loadArena + itemSize*curF->loadOffset, curF->loadSize);
-					if(smallestEnt){
-						curFD.size = curFD.upperBound(smallestEnt);
-					}
-					if(curFD.size){
-						numWithAnyMerge++;
-						mergeIndex = i;
-					}
-					mergeCount[i] = curFD.size;
-				}
-			//if only one, just dump it and retry
-				if(numWithAnyMerge == 1){
-					PODExternalFileSource* curF = openFiles[mergeIndex];
-					toDump->write(curF->loadArena + itemSize*curF->loadOffset, itemSize*curF->loadSize);
-					curF->loadOffset += curF->loadSize;
-					curF->loadSize = 0;
-					curF->load();
-					goto doAnotherMerge;
-				}
-			//run the initial merge
-				mergeLens.clear();
-				char* curMergeTgt = mergeArenaA;
-				uintptr_t curI0 = 0;
-				uintptr_t curMI = 0;
-				i = 0;
-				while(i < openFiles.size()){
-					char* curElemE = curMergeTgt + curI0*itemSize;
-					//get the first thing
-						PODExternalFileSource* curF = openFiles[i];
-						uintptr_t curNumA = mergeCount[i];
-						char* curElemA = curF->loadArena + itemSize*curF->loadOffset;
-						curI0 += curNumA;
-						curF->loadOffset += curNumA;
-						curF->loadSize -= curNumA;
-						i++;
-					//get the second thing
-						uintptr_t curNumB = 0;
-						char* curElemB = 0;
-						if(i < openFiles.size()){
-							curF = openFiles[i];
-							curNumB = mergeCount[i];
-							curElemB = curF->loadArena + itemSize*curF->loadOffset;
-							curF->loadOffset += curNumB;
-							curF->loadSize -= curNumB;
-						}
-						curI0 += curNumB;
-						i++;
-					//start the merge
-						PODSortedDataMerger* curMergeT = mergeMeths[curMI];
-						curMergeT->startMerge(curNumA, curElemA, curNumB, curElemB, curElemE);
-						mergeLens.push_back(curNumA + curNumB);
-						curMI++;
-				}
-				for(i = 0; i<curMI; i++){
-					mergeMeths[i]->joinMerge();
-				}
-			//do the other merges
-				char* curMergeSrc = curMergeTgt;
-				curMergeTgt = mergeArenaB;
-				while(mergeLens.size() > 1){
-					//start the merges
-						uintptr_t startNumP = mergeLens.size();
-						curI0 = 0;
-						curMI = 0;
-						i = 0;
-						while(i < startNumP){
-							char* curElemE = curMergeTgt + curI0*itemSize;
-							uintptr_t curNumA = mergeLens[i];
-							char* curElemA = curMergeSrc + curI0*itemSize;
-							curI0 += curNumA;
-							i++;
-							char* curElemB = curMergeSrc + curI0*itemSize;
-							uintptr_t curNumB = (i < startNumP) ? mergeLens[i] : 0;
-							curI0 += curNumB;
-							i++;
-							PODSortedDataMerger* curMergeT = mergeMeths[curMI];
-							curMergeT->startMerge(curNumA, curElemA, curNumB, curElemB, curElemE);
-							mergeLens.push_back(curNumA + curNumB);
-							curMI++;
-						}
-					//wait for them to finish
-						for(i = 0; i<curMI; i++){
-							mergeMeths[i]->joinMerge();
-						}
-					//prepare for the next round
-						char* tmpMerge = curMergeSrc;
-						curMergeSrc = curMergeTgt;
-						curMergeTgt = tmpMerge;
-						mergeLens.erase(mergeLens.begin(), mergeLens.begin() + startNumP);
+		//set up the tournament
+			outArena = (char*)malloc(loadEnts * itemSize);
+			uintptr_t outSize = 0;
+			PODExternalLoserTree mergeTree(&opts, &openFiles);
+		//run it
+			while(1){
+				uintptr_t winInd = mergeTree.tree[0];
+				PODExternalFileSource* curF = openFiles[winInd];
+				if(curF->loadSize == 0){ break; }
+				memcpy(outArena + outSize*itemSize, curF->loadArena + curF->loadOffset*itemSize, itemSize);
+				outSize++;
+				if(outSize == loadEnts){
+					toDump->write(outArena, outSize*itemSize);
+					outSize = 0;
 				}
-			//dump and go again
-				toDump->write(curMergeSrc, itemSize*mergeLens[0]);
-			goto doAnotherLoad;
-		}
-		
-		allGone:
+				curF->loadOffset++;
+				curF->loadSize--;
+				if(curF->loadSize == 0){ curF->load(); }
+				mergeTree.replay(winInd);
+			}
+			if(outSize){ toDump->write(outArena, outSize*itemSize); }
 		//clean up
 			deleteAll(&openFiles); openFiles.clear();
-			deleteAll(&mergeMeths); mergeMeths.clear();
-			free(mergeArenaB); mergeArenaB = 0;
-			free(mergeArenaA); mergeArenaA = 0;
+			free(outArena); outArena = 0;
+		//remove the merged files
+			for(i = 0; i<numFileOpen; i++){
+				fileKill(allTempBase[fromFile+i].c_str());
+				fileKill(allTempBlock[fromFile+i].c_str());
+			}
+			allTempBase.erase(allTempBase.begin() + fromFile, allTempBase.begin() + fromFile + numFileOpen);
+			allTempBlock.erase(allTempBlock.begin() + fromFile, allTempBlock.begin() + fromFile + numFileOpen);
 	}
 	catch(std::exception& errE){
-		if(mergeArenaA){ free(mergeArenaA); }
-		if(mergeArenaB){ free(mergeArenaB); }
+		if(outArena){ free(outArena); }
 		deleteAll(&openFiles);
-		deleteAll(&mergeMeths);
+		throw;
+	}
+}
+
+PODExternalLoserTree::PODExternalLoserTree(PODSortOptions* theOpts, std::vector<PODExternalFileSource*>* theSources){
+	opts = *theOpts;
+	sources = theSources;
+	uintptr_t numSrc = sources->size();
+	usePrefix = opts.hasPrefix();
+	headPrefix.resize(numSrc);
+	tree.resize(numSrc);
+	for(uintptr_t i = 0; i<numSrc; i++){ tree[i] = numSrc; }
+	uintptr_t i = numSrc;
+	while(i){
+		i--;
+		replay(i);
+	}
+}
+PODExternalLoserTree::~PODExternalLoserTree(){}
+bool PODExternalLoserTree::beats(uintptr_t srcA, uintptr_t srcB){
+	PODExternalFileSource* fileA = (*sources)[srcA];
+	PODExternalFileSource* fileB = (*sources)[srcB];
+	if(fileA->loadSize == 0){ return false; }
+	if(fileB->loadSize == 0){ return true; }
+	if(usePrefix && (headPrefix[srcA] != headPrefix[srcB])){ return headPrefix[srcA] < headPrefix[srcB]; }
+	char* itemA = fileA->loadArena + fileA->loadOffset*opts.itemSize;
+	char* itemB = fileB->loadArena + fileB->loadOffset*opts.itemSize;
+	if(opts.compMeth(opts.useUni, itemA, itemB)){ return true; }
+	if(opts.compMeth(opts.useUni, itemB, itemA)){ return false; }
+	return srcA < srcB;
+}
+void PODExternalLoserTree::replay(uintptr_t srcInd){
+	uintptr_t numSrc = tree.size();
+	if(usePrefix){
+		PODExternalFileSource* curF = (*sources)[srcInd];
+		if(curF->loadSize){ headPrefix[srcInd] = opts.getPrefix(curF->loadArena + curF->loadOffset*opts.itemSize); }
+	}
+	uintptr_t curWin = srcInd;
+	uintptr_t curNode = (srcInd + numSrc) >> 1;
+	while(curNode){
+		uintptr_t curLose = tree[curNode];
+		if(curLose == numSrc){
+			//still building
+			tree[curNode] = curWin;
+			return;
+		}
+		if(beats(curLose, curWin)){
+			tree[curNode] = curWin;
+			curWin = curLose;
+		}
+		curNode = curNode >> 1;
 	}
+	tree[0] = curWin;
 }
 
 PODExternalFileSource::PODExternalFileSource(uintptr_t maxLoad, PODSortOptions* theOpts, InStream* fromFile){
@@ -842,7 +1577,7 @@ PODExternalFileSource::~PODExternalFileSource(){
 void PODExternalFileSource::load(){
 	uintptr_t itemSize = opts.itemSize;
 	if(haveHitEnd){ return; }
-	if(loadOffset > (arenaSize / 2)){
+	if((loadSize == 0) || (loadOffset > (arenaSize / 2))){
 		doMemOps->memcpy(loadArena, loadArena + loadOffset*itemSize, loadSize*itemSize);
 		loadOffset = 0;
 		uintptr_t numEntToLoad = arenaSize - loadSize;
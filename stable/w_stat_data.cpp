@@ -1,5 +1,8 @@
 #include "whodun_stat_data.h"
 
+#include <string.h>
+#include <algorithm>
+
 #include "whodun_compress.h"
 
 namespace whodun {
@@ -23,6 +26,76 @@ public:
 	char* myParse;
 };
 
+/**Decompress column chunks of a columnar table.*/
+class ColumnarTableReadTask : public JoinableThreadTask{
+public:
+	/**setup an empty*/
+	ColumnarTableReadTask();
+	/**Clean up.*/
+	~ColumnarTableReadTask();
+	void doTask();
+	
+	/**The decompression for each chunk this needs to handle.*/
+	std::vector<DecompressionMethod*> doUnzip;
+	/**The compressed data for each chunk.*/
+	std::vector<SizePtrString> doComp;
+	/**The expected size of each chunk.*/
+	std::vector<uintptr_t> doExpect;
+};
+
+/**Compress column chunks of a columnar table.*/
+class ColumnarTableWriteTask : public JoinableThreadTask{
+public:
+	/**setup an empty*/
+	ColumnarTableWriteTask();
+	/**Clean up.*/
+	~ColumnarTableWriteTask();
+	void doTask();
+	
+	/**The number of rows in the group.*/
+	uintptr_t numRow;
+	/**The number of rows the packing space was laid out for.*/
+	uintptr_t maxRow;
+	/**The compression for each chunk this needs to handle.*/
+	std::vector<CompressionMethod*> doZip;
+	/**The packed data for each chunk.*/
+	std::vector<char*> doPack;
+	/**The size of the values in each chunk.*/
+	std::vector<uintptr_t> doWidth;
+};
+
+/**
+ * Get the number of bytes a value in a column takes up in a binary file (not counting the missing flag).
+ * @param tabDesc The description of the table.
+ * @param colInd The column in question.
+ * @return The number of bytes.
+ */
+uintptr_t dataTableValueBytes(DataTableDescription* tabDesc, uintptr_t colInd);
+
+/**
+ * Write the description of a table to a binary file.
+ * @param tabDesc The description to write.
+ * @param toStr The place to write it.
+ * @return The number of bytes written.
+ */
+uintmax_t dataTableWriteDescription(DataTableDescription* tabDesc, OutStream* toStr);
+
+/**
+ * Read the description of a table from a binary file.
+ * @param tabDesc The place to put the description.
+ * @param fromStr The place to read it from.
+ */
+void dataTableReadDescription(DataTableDescription* tabDesc, InStream* fromStr);
+
+/**
+ * Pick the slot for a level in a frozen factor dictionary.
+ * @param hashV The hash of the level's name.
+ * @param seed The seed for the level's bucket.
+ * @param slotMask The number of slots, minus one.
+ * @return The slot.
+ */
+uintptr_t dataFactorSeedSlot(uint64_t hashV, uintptr_t seed, uintptr_t slotMask);
+
 /**Pack read data.*/
 class BinaryTableWriteTask : public JoinableThreadTask{
 public:
@@ -49,9 +122,417 @@ using namespace whodun;
 DataTableDescription::DataTableDescription(){}
 DataTableDescription::~DataTableDescription(){}
 
+/**The number of seeds to try for a bucket before giving the frozen dictionary more slots.*/
+#define FACTOR_FREEZE_MAX_SEED 0x01000
+/**The number of slots for each bucket of a frozen dictionary.*/
+#define FACTOR_FREEZE_BUCKET_SLOTS 4
+/**The most slots (per level) a frozen dictionary may use before giving up and probing.*/
+#define FACTOR_FREEZE_MAX_SPREAD 64
+
+uintptr_t whodun::dataFactorSeedSlot(uint64_t hashV, uintptr_t seed, uintptr_t slotMask){
+	uint64_t mixH = hashV + seed * 0x9E3779B97F4A7C15ULL;
+	mixH = (mixH ^ (mixH >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	mixH = (mixH ^ (mixH >> 27)) * 0x94D049BB133111EBULL;
+	mixH ^= (mixH >> 31);
+	return mixH & slotMask;
+}
+
+DataTableFactorDictionary::DataTableFactorDictionary(){
+	numLevels = 0;
+	isFrozen = 0;
+	nameOffsets.resize(1);
+	*(nameOffsets[0]) = 0;
+	rehashProbe(16);
+}
+DataTableFactorDictionary::~DataTableFactorDictionary(){}
+uint64_t DataTableFactorDictionary::hashName(SizePtrString levName){
+	uint64_t curH = 0x9E3779B97F4A7C15ULL ^ levName.len;
+	uintptr_t i = 0;
+	for(; (i+8)<=levName.len; i+=8){
+		uint64_t curW;
+		memcpy(&curW, levName.txt + i, 8);
+		curH = (curH ^ curW) * 0xFF51AFD7ED558CCDULL;
+		curH ^= (curH >> 32);
+	}
+	if(i < levName.len){
+		uint64_t curW = 0;
+		memcpy(&curW, levName.txt + i, levName.len - i);
+		curH = (curH ^ curW) * 0xFF51AFD7ED558CCDULL;
+		curH ^= (curH >> 32);
+	}
+	curH ^= (curH >> 33);
+	curH *= 0xC4CEB9FE1A85EC53ULL;
+	curH ^= (curH >> 33);
+	return curH;
+}
+int DataTableFactorDictionary::add(SizePtrString levName, uintptr_t levVal){
+	uint64_t hashV = hashName(levName);
+	uintptr_t oldVal;
+	if(find(levName, hashV, &oldVal)){ return 0; }
+	//save the level
+		uintptr_t textEnd = *(nameOffsets[numLevels]);
+		nameText.resize(textEnd + levName.len);
+		if(levName.len){ memcpy(nameText[textEnd], levName.txt, levName.len); }
+		nameOffsets.resize(numLevels + 2);
+		*(nameOffsets[numLevels+1]) = textEnd + levName.len;
+		nameHashes.resize(numLevels + 1);
+		*(nameHashes[numLevels]) = hashV;
+		levelValues.resize(numLevels + 1);
+		*(levelValues[numLevels]) = levVal;
+		numLevels++;
+	//rebuild if too full (or frozen)
+		uintptr_t numSlots = slotLevel.size();
+		if(isFrozen || (2*numLevels > numSlots)){
+			while(2*numLevels > numSlots){ numSlots = 2*numSlots; }
+			rehashProbe(numSlots);
+			return 1;
+		}
+	//otherwise, just drop it in
+		uintptr_t slotMask = numSlots - 1;
+		uintptr_t curS = hashV & slotMask;
+		while(*(slotLevel[curS])){ curS = (curS + 1) & slotMask; }
+		*(slotHash[curS]) = hashV;
+		*(slotLevel[curS]) = numLevels;
+	return 1;
+}
+void DataTableFactorDictionary::setLevels(std::map<std::string,uintptr_t>* fromMap){
+	clear();
+	for(std::map<std::string,uintptr_t>::iterator curIt = fromMap->begin(); curIt != fromMap->end(); curIt++){
+		SizePtrString curName;
+			curName.len = curIt->first.size();
+			curName.txt = (char*)(curIt->first.c_str());
+		add(curName, curIt->second);
+	}
+}
+int DataTableFactorDictionary::find(SizePtrString levName, uintptr_t* toFill){
+	return find(levName, hashName(levName), toFill);
+}
+int DataTableFactorDictionary::find(SizePtrString levName, uint64_t hashV, uintptr_t* toFill){
+	uintptr_t slotMask = slotLevel.size() - 1;
+	uint64_t* allHash = slotHash[0];
+	uintptr_t* allLevel = slotLevel[0];
+	uintptr_t* allOffs = nameOffsets[0];
+	char* allText = nameText[0];
+	if(isFrozen){
+		//one place to look
+		intptr_t curP = *(bucketPlace[hashV & (bucketPlace.size() - 1)]);
+		if(curP == 0){ return 0; }
+		uintptr_t curS = (curP < 0) ? (uintptr_t)(-(curP + 1)) : dataFactorSeedSlot(hashV, curP, slotMask);
+		uintptr_t curL = allLevel[curS];
+		if((curL == 0) || (allHash[curS] != hashV)){ return 0; }
+		curL--;
+		uintptr_t curLen = allOffs[curL+1] - allOffs[curL];
+		if(curLen != levName.len){ return 0; }
+		if(curLen && memcmp(allText + allOffs[curL], levName.txt, curLen)){ return 0; }
+		*toFill = *(levelValues[curL]);
+		return 1;
+	}
+	//probe until an empty slot
+	uintptr_t curS = hashV & slotMask;
+	while(allLevel[curS]){
+		if(allHash[curS] == hashV){
+			uintptr_t curL = allLevel[curS] - 1;
+			uintptr_t curLen = allOffs[curL+1] - allOffs[curL];
+			if((curLen == levName.len) && ((curLen == 0) || (memcmp(allText + allOffs[curL], levName.txt, curLen) == 0))){
+				*toFill = *(levelValues[curL]);
+				return 1;
+			}
+		}
+		curS = (curS + 1) & slotMask;
+	}
+	return 0;
+}
+void DataTableFactorDictionary::freeze(){
+	if(isFrozen){ return; }
+	uintptr_t numSlots = 16;
+	while(numSlots < numLevels){ numSlots = 2*numSlots; }
+	uintptr_t maxSlots = FACTOR_FREEZE_MAX_SPREAD * numSlots;
+	while(numSlots <= maxSlots){
+		if(tryFreeze(numSlots)){ return; }
+		numSlots = 2*numSlots;
+	}
+	//only happens if two names share a hash: leave it probing
+	numSlots = 16;
+	while(2*numLevels > numSlots){ numSlots = 2*numSlots; }
+	rehashProbe(numSlots);
+}
+void DataTableFactorDictionary::clear(){
+	numLevels = 0;
+	nameText.clear();
+	nameOffsets.resize(1);
+	nameHashes.clear();
+	levelValues.clear();
+	rehashProbe(16);
+}
+void DataTableFactorDictionary::rehashProbe(uintptr_t numSlots){
+	isFrozen = 0;
+	bucketPlace.clear();
+	slotHash.resize(numSlots);
+	slotLevel.resize(numSlots);
+	memset(slotLevel[0], 0, numSlots*sizeof(uintptr_t));
+	uintptr_t slotMask = numSlots - 1;
+	for(uintptr_t i = 0; i<numLevels; i++){
+		uint64_t curH = *(nameHashes[i]);
+		uintptr_t curS = curH & slotMask;
+		while(*(slotLevel[curS])){ curS = (curS + 1) & slotMask; }
+		*(slotHash[curS]) = curH;
+		*(slotLevel[curS]) = i + 1;
+	}
+}
+int DataTableFactorDictionary::tryFreeze(uintptr_t numSlots){
+	uintptr_t slotMask = numSlots - 1;
+	uintptr_t numBuckets = numSlots / FACTOR_FREEZE_BUCKET_SLOTS;
+	uintptr_t bucketMask = numBuckets - 1;
+	uint64_t* allHash = nameHashes[0];
+	//sort the levels by bucket
+		StructVector<uintptr_t> bucketStart(numBuckets + 1);
+		memset(bucketStart[0], 0, (numBuckets + 1)*sizeof(uintptr_t));
+		uintptr_t* allStart = bucketStart[0];
+		for(uintptr_t i = 0; i<numLevels; i++){ allStart[(allHash[i] & bucketMask) + 1]++; }
+		uintptr_t maxSize = 0;
+		for(uintptr_t i = 0; i<numBuckets; i++){
+			maxSize = std::max(maxSize, allStart[i+1]);
+			allStart[i+1] += allStart[i];
+		}
+		StructVector<uintptr_t> bucketFill(numBuckets);
+		memcpy(bucketFill[0], allStart, numBuckets*sizeof(uintptr_t));
+		StructVector<uintptr_t> bucketLevels(numLevels + 1);
+		uintptr_t* allLevs = bucketLevels[0];
+		for(uintptr_t i = 0; i<numLevels; i++){
+			uintptr_t* curFill = bucketFill[allHash[i] & bucketMask];
+			allLevs[*curFill] = i;
+			(*curFill)++;
+		}
+	//set up empty slots
+		slotHash.resize(numSlots);
+		slotLevel.resize(numSlots);
+		memset(slotLevel[0], 0, numSlots*sizeof(uintptr_t));
+		bucketPlace.resize(numBuckets);
+		memset(bucketPlace[0], 0, numBuckets*sizeof(intptr_t));
+		uint64_t* allSHash = slotHash[0];
+		uintptr_t* allSLevel = slotLevel[0];
+		intptr_t* allPlace = bucketPlace[0];
+	//find seeds for the crowded buckets, biggest first
+		for(uintptr_t curSize = maxSize; curSize > 1; curSize--){
+			for(uintptr_t b = 0; b<numBuckets; b++){
+				uintptr_t bucketS = allStart[b];
+				if((allStart[b+1] - bucketS) != curSize){ continue; }
+				uintptr_t seed;
+				for(seed = 1; seed <= FACTOR_FREEZE_MAX_SEED; seed++){
+					uintptr_t j;
+					for(j = 0; j<curSize; j++){
+						uintptr_t curL = allLevs[bucketS + j];
+						uintptr_t curS = dataFactorSeedSlot(allHash[curL], seed, slotMask);
+						if(allSLevel[curS]){ break; }
+						allSHash[curS] = allHash[curL];
+						allSLevel[curS] = curL + 1;
+					}
+					if(j == curSize){ break; }
+					for(uintptr_t k = 0; k<j; k++){
+						allSLevel[dataFactorSeedSlot(allHash[allLevs[bucketS + k]], seed, slotMask)] = 0;
+					}
+				}
+				if(seed > FACTOR_FREEZE_MAX_SEED){ return 0; }
+				allPlace[b] = seed;
+			}
+		}
+	//lonely levels go in whatever is left
+		uintptr_t freeS = 0;
+		for(uintptr_t b = 0; b<numBuckets; b++){
+			uintptr_t bucketS = allStart[b];
+			if((allStart[b+1] - bucketS) != 1){ continue; }
+			while(allSLevel[freeS]){ freeS++; }
+			uintptr_t curL = allLevs[bucketS];
+			allSHash[freeS] = allHash[curL];
+			allSLevel[freeS] = curL + 1;
+			allPlace[b] = -((intptr_t)freeS + 1);
+		}
+	isFrozen = 1;
+	return 1;
+}
+
 DataTable::DataTable(){}
 DataTable::~DataTable(){}
 
+DataTableColumn::DataTableColumn(){
+	colType = 0;
+	strLength = 0;
+}
+DataTableColumn::~DataTableColumn(){}
+
+DataTableColumns::DataTableColumns(){
+	numRows = 0;
+}
+DataTableColumns::~DataTableColumns(){
+	for(uintptr_t i = 0; i<cols.size(); i++){
+		delete(cols[i]);
+	}
+}
+void DataTableColumns::setColumns(DataTableDescription* forData){
+	uintptr_t numCol = forData->colTypes.size();
+	while(cols.size() > numCol){
+		delete(cols[cols.size()-1]);
+		cols.pop_back();
+	}
+	while(cols.size() < numCol){
+		cols.push_back(new DataTableColumn());
+	}
+	for(uintptr_t ci = 0; ci<numCol; ci++){
+		DataTableColumn* curC = cols[ci];
+		curC->colType = forData->colTypes[ci];
+		curC->strLength = forData->strLengths[ci];
+		curC->strText.clear();
+	}
+	resize(0);
+	for(uintptr_t ci = 0; ci<numCol; ci++){
+		DataTableColumn* curC = cols[ci];
+		if(curC->colType == WHODUN_DATA_STR){ *(curC->strOffs[0]) = 0; }
+	}
+}
+void DataTableColumns::resize(uintptr_t newRows){
+	numRows = newRows;
+	uintptr_t numWord = (newRows + 63) / 64;
+	for(uintptr_t ci = 0; ci<cols.size(); ci++){
+		DataTableColumn* curC = cols[ci];
+		curC->valid.resize(numWord);
+		switch(curC->colType){
+			case WHODUN_DATA_CAT:
+				curC->valC.resize(newRows);
+				break;
+			case WHODUN_DATA_INT:
+				curC->valI.resize(newRows);
+				break;
+			case WHODUN_DATA_REAL:
+				curC->valR.resize(newRows);
+				break;
+			case WHODUN_DATA_STR:
+				curC->strOffs.resize(newRows + 1);
+				break;
+			default:
+				throw std::runtime_error("Da fuq?");
+		};
+	}
+}
+void DataTableColumns::fromRows(DataTable* fromRows){
+	uintptr_t numCol = cols.size();
+	uintptr_t newRows = numCol ? (fromRows->saveData.size() / numCol) : 0;
+	resize(newRows);
+	for(uintptr_t ci = 0; ci<numCol; ci++){
+		DataTableColumn* curC = cols[ci];
+		DataTableEntry* curFrom = fromRows->saveData[ci];
+		uint64_t* curValid = curC->valid[0];
+		memset(curValid, 0, sizeof(uint64_t)*curC->valid.size());
+		switch(curC->colType){
+			case WHODUN_DATA_CAT:{
+				uint64_t* curTo = curC->valC[0];
+				for(uintptr_t ri = 0; ri<newRows; ri++){
+					curValid[ri >> 6] |= ((uint64_t)(curFrom->isNA == 0)) << (ri & 63);
+					curTo[ri] = curFrom->valC;
+					curFrom += numCol;
+				}
+			} break;
+			case WHODUN_DATA_INT:{
+				int64_t* curTo = curC->valI[0];
+				for(uintptr_t ri = 0; ri<newRows; ri++){
+					curValid[ri >> 6] |= ((uint64_t)(curFrom->isNA == 0)) << (ri & 63);
+					curTo[ri] = curFrom->valI;
+					curFrom += numCol;
+				}
+			} break;
+			case WHODUN_DATA_REAL:{
+				double* curTo = curC->valR[0];
+				for(uintptr_t ri = 0; ri<newRows; ri++){
+					curValid[ri >> 6] |= ((uint64_t)(curFrom->isNA == 0)) << (ri & 63);
+					curTo[ri] = curFrom->valR;
+					curFrom += numCol;
+				}
+			} break;
+			case WHODUN_DATA_STR:{
+				uintptr_t strLen = curC->strLength;
+				curC->strText.resize(newRows * strLen);
+				char* curText = curC->strText[0];
+				uintptr_t* curOffs = curC->strOffs[0];
+				curOffs[0] = 0;
+				for(uintptr_t ri = 0; ri<newRows; ri++){
+					uintptr_t curLen = 0;
+					if(!(curFrom->isNA)){
+						curValid[ri >> 6] |= ((uint64_t)1) << (ri & 63);
+						curLen = strLen;
+						while(curLen && (curFrom->valS[curLen-1] == 0)){ curLen--; }
+						memcpy(curText + curOffs[ri], curFrom->valS, curLen);
+					}
+					curOffs[ri+1] = curOffs[ri] + curLen;
+					curFrom += numCol;
+				}
+				curC->strText.resize(curOffs[newRows]);
+			} break;
+			default:
+				throw std::runtime_error("Da fuq?");
+		};
+	}
+}
+void DataTableColumns::toRows(DataTable* toRows){
+	uintptr_t numCol = cols.size();
+	//make some space
+		uintptr_t strRowBytes = 0;
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			if(cols[ci]->colType == WHODUN_DATA_STR){ strRowBytes += cols[ci]->strLength; }
+		}
+		toRows->saveData.clear();
+		toRows->saveData.resize(numRows * numCol);
+		toRows->saveText.clear();
+		toRows->saveText.resize(numRows * strRowBytes);
+	//fill it in
+		char* nextStr = toRows->saveText[0];
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			DataTableColumn* curC = cols[ci];
+			DataTableEntry* curTo = toRows->saveData[ci];
+			uint64_t* curValid = curC->valid[0];
+			switch(curC->colType){
+				case WHODUN_DATA_CAT:{
+					uint64_t* curFrom = curC->valC[0];
+					for(uintptr_t ri = 0; ri<numRows; ri++){
+						curTo->isNA = ((curValid[ri >> 6] >> (ri & 63)) & 1) ? 0 : 1;
+						curTo->valC = curFrom[ri];
+						curTo += numCol;
+					}
+				} break;
+				case WHODUN_DATA_INT:{
+					int64_t* curFrom = curC->valI[0];
+					for(uintptr_t ri = 0; ri<numRows; ri++){
+						curTo->isNA = ((curValid[ri >> 6] >> (ri & 63)) & 1) ? 0 : 1;
+						curTo->valI = curFrom[ri];
+						curTo += numCol;
+					}
+				} break;
+				case WHODUN_DATA_REAL:{
+					double* curFrom = curC->valR[0];
+					for(uintptr_t ri = 0; ri<numRows; ri++){
+						curTo->isNA = ((curValid[ri >> 6] >> (ri & 63)) & 1) ? 0 : 1;
+						curTo->valR = curFrom[ri];
+						curTo += numCol;
+					}
+				} break;
+				case WHODUN_DATA_STR:{
+					uintptr_t strLen = curC->strLength;
+					char* curText = curC->strText[0];
+					uintptr_t* curOffs = curC->strOffs[0];
+					for(uintptr_t ri = 0; ri<numRows; ri++){
+						uintptr_t curLen = curOffs[ri+1] - curOffs[ri];
+						curTo->isNA = ((curValid[ri >> 6] >> (ri & 63)) & 1) ? 0 : 1;
+						curTo->valS = nextStr;
+						memcpy(nextStr, curText + curOffs[ri], curLen);
+						memset(nextStr + curLen, 0, strLen - curLen);
+						nextStr += strLen;
+						curTo += numCol;
+					}
+				} break;
+				default:
+					throw std::runtime_error("Da fuq?");
+			};
+		}
+}
+
 DataTableReader::DataTableReader(){
 	isClosed = 0;
 }
@@ -61,6 +542,12 @@ DataTableReader::~DataTableReader(){
 void DataTableReader::getDescription(DataTableDescription* toFill){
 	*toFill = tabDesc;
 }
+uintptr_t DataTableReader::readColumns(DataTableColumns* toStore, uintptr_t numRows){
+	uintptr_t numGot = read(&convRows, numRows);
+	toStore->setColumns(&tabDesc);
+	if(numGot){ toStore->fromRows(&convRows); }
+	return numGot;
+}
 
 void RandacDataTableReader::readRange(DataTable* toStore, uintmax_t fromIndex, uintmax_t toIndex){
 	uintmax_t numR = toIndex - fromIndex;
@@ -75,6 +562,140 @@ DataTableWriter::DataTableWriter(DataTableDescription* forData){
 DataTableWriter::~DataTableWriter(){
 	if(!isClosed){ std::cerr << "Need to close a stream before destruction." << std::endl; std::terminate(); }
 }
+void DataTableWriter::writeColumns(DataTableColumns* toStore){
+	toStore->toRows(&convRows);
+	write(&convRows);
+}
+
+uintptr_t whodun::dataTableValueBytes(DataTableDescription* tabDesc, uintptr_t colInd){
+	switch(tabDesc->colTypes[colInd]){
+		case WHODUN_DATA_CAT:
+			return 8;
+		case WHODUN_DATA_INT:
+			return 8;
+		case WHODUN_DATA_REAL:
+			return 8;
+		case WHODUN_DATA_STR:
+			return tabDesc->strLengths[colInd];
+		default:
+			throw std::runtime_error("Da fuq?");
+	};
+}
+
+uintmax_t whodun::dataTableWriteDescription(DataTableDescription* tabDesc, OutStream* toStr){
+	uintmax_t numWrite = 0;
+	char stageB[8];
+	//number of columns
+		uintptr_t numCol = tabDesc->colTypes.size();
+		BytePacker packNCol(stageB);
+		packNCol.packBE64(numCol);
+		toStr->write(stageB, 8);
+		numWrite += 8;
+	//column types
+		for(uintptr_t i = 0; i<numCol; i++){
+			int curType = tabDesc->colTypes[i];
+			toStr->write(curType);
+		}
+		numWrite += numCol;
+	//names
+		for(uintptr_t i = 0; i<numCol; i++){
+			uintptr_t curNLen = tabDesc->colNames[i].size();
+			BytePacker packSLen(stageB);
+			packSLen.packBE64(curNLen);
+			toStr->write(stageB, 8);
+			toStr->write(tabDesc->colNames[i].c_str(), curNLen);
+			numWrite += (8 + curNLen);
+		}
+	//categorical names
+		for(uintptr_t i = 0; i<numCol; i++){
+			if(tabDesc->colTypes[i] != WHODUN_DATA_CAT){ continue; }
+			std::map<std::string,uintptr_t>* curFacs = &(tabDesc->factorColMap[i]);
+			uintptr_t curNFac = curFacs->size();
+			BytePacker packNFac(stageB);
+			packNFac.packBE64(curNFac);
+			toStr->write(stageB, 8);
+			numWrite += 8;
+			std::map<std::string,uintptr_t>::iterator facIt;
+			for(facIt = curFacs->begin(); facIt != curFacs->end(); facIt++){
+				uintptr_t curNLen = facIt->first.size();
+				BytePacker packSLen(stageB);
+				packSLen.packBE64(curNLen);
+				toStr->write(stageB, 8);
+				toStr->write(facIt->first.c_str(), curNLen);
+				BytePacker packFVal(stageB);
+				packFVal.packBE64(facIt->second);
+				toStr->write(stageB, 8);
+				numWrite += (16 + curNLen);
+			}
+		}
+	//string lengths
+		for(uintptr_t i = 0; i<numCol; i++){
+			if(tabDesc->colTypes[i] != WHODUN_DATA_STR){ continue; }
+			BytePacker packSLen(stageB);
+			packSLen.packBE64(tabDesc->strLengths[i]);
+			toStr->write(stageB, 8);
+			numWrite += 8;
+		}
+	return numWrite;
+}
+
+void whodun::dataTableReadDescription(DataTableDescription* tabDesc, InStream* fromStr){
+	char stageB[8];
+	StructVector<char> altV; //friggin string
+	//number of columns
+		fromStr->forceRead(stageB, 8);
+		ByteUnpacker getNCol(stageB);
+		uintptr_t numCol = getNCol.unpackBE64();
+		tabDesc->colTypes.resize(numCol);
+		tabDesc->colNames.resize(numCol);
+		tabDesc->factorColMap.resize(numCol);
+		tabDesc->strLengths.resize(numCol);
+	//column types
+		for(uintptr_t i = 0; i<numCol; i++){
+			int curType = fromStr->read();
+			if(curType < 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Header data truncated.", 0, 0); }
+			if((curType == 0) || (curType > 4)){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Unknown data type encountered.", 0, 0); }
+			tabDesc->colTypes[i] = curType;
+		}
+	//names
+		for(uintptr_t i = 0; i<numCol; i++){
+			fromStr->forceRead(stageB, 8);
+			ByteUnpacker getSLen(stageB);
+			uintptr_t curNLen = getSLen.unpackBE64();
+			altV.clear(); altV.resize(curNLen);
+			fromStr->forceRead(altV[0], curNLen);
+			std::string* curFillN = &(tabDesc->colNames[i]);
+			curFillN->insert(curFillN->end(), altV[0], altV[curNLen]);
+		}
+	//categorical names
+		for(uintptr_t i = 0; i<numCol; i++){
+			if(tabDesc->colTypes[i] != WHODUN_DATA_CAT){ continue; }
+			std::map<std::string,uintptr_t>* curFacs = &(tabDesc->factorColMap[i]);
+			fromStr->forceRead(stageB, 8);
+			ByteUnpacker getNFac(stageB);
+			uintptr_t curNFac = getNFac.unpackBE64();
+			for(uintptr_t j = 0; j<curNFac; j++){
+				fromStr->forceRead(stageB, 8);
+				ByteUnpacker getSLen(stageB);
+				uintptr_t curNLen = getSLen.unpackBE64();
+				altV.clear(); altV.resize(curNLen);
+				fromStr->forceRead(altV[0], curNLen);
+				fromStr->forceRead(stageB, 8);
+				ByteUnpacker getFVal(stageB);
+				uintptr_t curFVal = getFVal.unpackBE64();
+				std::string curFacN(altV[0], altV[curNLen]);
+				(*curFacs)[curFacN] = curFVal;
+			}
+		}
+	//string lengths
+		for(uintptr_t i = 0; i<numCol; i++){
+			if(tabDesc->colTypes[i] != WHODUN_DATA_STR){ continue; }
+			fromStr->forceRead(stageB, 8);
+			ByteUnpacker getSLen(stageB);
+			uintptr_t curSLen = getSLen.unpackBE64();
+			tabDesc->strLengths[i] = curSLen;
+		}
+}
 
 BinaryDataTableReader::BinaryDataTableReader(InStream* dataFile){
 	tsvStr = dataFile;
@@ -143,81 +764,11 @@ void BinaryDataTableReader::close(){
 }
 void BinaryDataTableReader::readHeader(){
 	try{
-		char stageB[8];
-		StructVector<char> altV; //friggin string
-		//number of columns
-			tsvStr->forceRead(stageB, 8);
-			ByteUnpacker getNCol(stageB);
-			uintptr_t numCol = getNCol.unpackBE64();
-			tabDesc.colTypes.resize(numCol);
-			tabDesc.colNames.resize(numCol);
-			tabDesc.factorColMap.resize(numCol);
-			tabDesc.strLengths.resize(numCol);
-		//column types
-			for(uintptr_t i = 0; i<numCol; i++){
-				int curType = tsvStr->read();
-				if(curType < 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Header data truncated.", 0, 0); }
-				if((curType == 0) || (curType > 4)){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Unknown data type encountered.", 0, 0); }
-				tabDesc.colTypes[i] = curType;
-			}
-		//names
-			for(uintptr_t i = 0; i<numCol; i++){
-				tsvStr->forceRead(stageB, 8);
-				ByteUnpacker getSLen(stageB);
-				uintptr_t curNLen = getSLen.unpackBE64();
-				altV.clear(); altV.resize(curNLen);
-				tsvStr->forceRead(altV[0], curNLen);
-				std::string* curFillN = &(tabDesc.colNames[i]);
-				curFillN->insert(curFillN->end(), altV[0], altV[curNLen]);
-			}
-		//categorical names
-			for(uintptr_t i = 0; i<numCol; i++){
-				if(tabDesc.colTypes[i] != WHODUN_DATA_CAT){ continue; }
-				std::map<std::string,uintptr_t>* curFacs = &(tabDesc.factorColMap[i]);
-				tsvStr->forceRead(stageB, 8);
-				ByteUnpacker getNFac(stageB);
-				uintptr_t curNFac = getNFac.unpackBE64();
-				for(uintptr_t j = 0; j<curNFac; j++){
-					tsvStr->forceRead(stageB, 8);
-					ByteUnpacker getSLen(stageB);
-					uintptr_t curNLen = getSLen.unpackBE64();
-					altV.clear(); altV.resize(curNLen);
-					tsvStr->forceRead(altV[0], curNLen);
-					tsvStr->forceRead(stageB, 8);
-					ByteUnpacker getFVal(stageB);
-					uintptr_t curFVal = getFVal.unpackBE64();
-					std::string curFacN(altV[0], altV[curNLen]);
-					(*curFacs)[curFacN] = curFVal;
-				}
-			}
-		//string lengths
-			for(uintptr_t i = 0; i<numCol; i++){
-				if(tabDesc.colTypes[i] != WHODUN_DATA_STR){ continue; }
-				tsvStr->forceRead(stageB, 8);
-				ByteUnpacker getSLen(stageB);
-				uintptr_t curSLen = getSLen.unpackBE64();
-				tabDesc.strLengths[i] = curSLen;
-			}
-		//get the offset of the actual data, the size of each row and the number of rows
-			rowBytes = 0;
-			for(uintptr_t i = 0; i<tabDesc.colTypes.size(); i++){
-				switch(tabDesc.colTypes[i]){
-				case WHODUN_DATA_CAT:{
-					rowBytes += 9;
-				} break;
-				case WHODUN_DATA_INT:{
-					rowBytes += 9;
-				} break;
-				case WHODUN_DATA_REAL:{
-					rowBytes += 9;
-				} break;
-				case WHODUN_DATA_STR:{
-					rowBytes += (1 + tabDesc.strLengths[i]);
-				} break;
-				default:
-					throw std::runtime_error("Da fuq?");
-				};
-			}
+		dataTableReadDescription(&tabDesc, tsvStr);
+		rowBytes = 0;
+		for(uintptr_t i = 0; i<tabDesc.colTypes.size(); i++){
+			rowBytes += (1 + dataTableValueBytes(&tabDesc, i));
+		}
 	}
 	catch(std::exception& errE){
 		isClosed = 1;
@@ -262,6 +813,7 @@ BinaryRandacDataTableReader::BinaryRandacDataTableReader(RandaccInStream* dataFi
 	try{
 		tsvStr = dataFile;
 		realRead = new BinaryDataTableReader(dataFile);
+		tabDesc = realRead->tabDesc;
 		baseLoc = tsvStr->tell();
 		needSeek = 0;
 		focusInd = 0;
@@ -283,6 +835,7 @@ BinaryRandacDataTableReader::BinaryRandacDataTableReader(RandaccInStream* dataFi
 	try{
 		tsvStr = dataFile;
 		realRead = new BinaryDataTableReader(dataFile, numThread, mainPool);
+		tabDesc = realRead->tabDesc;
 		baseLoc = tsvStr->tell();
 		needSeek = 0;
 		focusInd = 0;
@@ -395,73 +948,11 @@ void BinaryDataTableWriter::close(){
 }
 void BinaryDataTableWriter::writeHeader(){
 	try{
-		char stageB[8];
-		StructVector<char> altV; //friggin string
-		//number of columns
-			uintptr_t numCol = tabDesc.colTypes.size();
-			BytePacker packNCol(stageB);
-			packNCol.packBE64(numCol);
-			tsvStr->write(stageB, 8);
-		//column types
-			for(uintptr_t i = 0; i<numCol; i++){
-				int curType = tabDesc.colTypes[i];
-				tsvStr->write(curType);
-			}
-		//names
-			for(uintptr_t i = 0; i<numCol; i++){
-				uintptr_t curNLen = tabDesc.colNames[i].size();
-				BytePacker packSLen(stageB);
-				packSLen.packBE64(curNLen);
-				tsvStr->write(stageB, 8);
-				tsvStr->write(tabDesc.colNames[i].c_str(), curNLen);
-			}
-		//categorical names
-			for(uintptr_t i = 0; i<numCol; i++){
-				if(tabDesc.colTypes[i] != WHODUN_DATA_CAT){ continue; }
-				std::map<std::string,uintptr_t>* curFacs = &(tabDesc.factorColMap[i]);
-				uintptr_t curNFac = curFacs->size();
-				BytePacker packNFac(stageB);
-				packNFac.packBE64(curNFac);
-				tsvStr->write(stageB, 8);
-				std::map<std::string,uintptr_t>::iterator facIt;
-				for(facIt = curFacs->begin(); facIt != curFacs->end(); facIt++){
-					uintptr_t curNLen = facIt->first.size();
-					BytePacker packSLen(stageB);
-					packSLen.packBE64(curNLen);
-					tsvStr->write(stageB, 8);
-					tsvStr->write(facIt->first.c_str(), curNLen);
-					BytePacker packFVal(stageB);
-					packFVal.packBE64(facIt->second);
-					tsvStr->write(stageB, 8);
-				}
-			}
-		//string lengths
-			for(uintptr_t i = 0; i<numCol; i++){
-				if(tabDesc.colTypes[i] != WHODUN_DATA_STR){ continue; }
-				BytePacker packSLen(stageB);
-				packSLen.packBE64(tabDesc.strLengths[i]);
-				tsvStr->write(stageB, 8);
-			}
-		//get the size of each row
-			rowBytes = 0;
-			for(uintptr_t i = 0; i<tabDesc.colTypes.size(); i++){
-				switch(tabDesc.colTypes[i]){
-				case WHODUN_DATA_CAT:{
-					rowBytes += 9;
-				} break;
-				case WHODUN_DATA_INT:{
-					rowBytes += 9;
-				} break;
-				case WHODUN_DATA_REAL:{
-					rowBytes += 9;
-				} break;
-				case WHODUN_DATA_STR:{
-					rowBytes += (1 + tabDesc.strLengths[i]);
-				} break;
-				default:
-					throw std::runtime_error("Da fuq?");
-				};
-			}
+		dataTableWriteDescription(&tabDesc, tsvStr);
+		rowBytes = 0;
+		for(uintptr_t i = 0; i<tabDesc.colTypes.size(); i++){
+			rowBytes += (1 + dataTableValueBytes(&tabDesc, i));
+		}
 	}
 	catch(std::exception& errE){
 		isClosed = 1;
@@ -502,6 +993,528 @@ void BinaryTableWriteTask::doTask(){
 	}
 }
 
+/**Marks that no group is loaded.*/
+#define COLUMNAR_NO_GROUP (~(uintptr_t)0)
+
+ColumnarDataTableReader::ColumnarDataTableReader(RandaccInStream* dataFile, CompressionFactory* compMeth){
+	tsvStr = dataFile;
+	usePool = 0;
+	loadedGroup = COLUMNAR_NO_GROUP;
+	focusInd = 0;
+	readHeader(compMeth);
+	passUnis.push_back(new ColumnarTableReadTask());
+}
+ColumnarDataTableReader::ColumnarDataTableReader(RandaccInStream* dataFile, CompressionFactory* compMeth, uintptr_t numThread, ThreadPool* mainPool){
+	tsvStr = dataFile;
+	usePool = mainPool;
+	loadedGroup = COLUMNAR_NO_GROUP;
+	focusInd = 0;
+	readHeader(compMeth);
+	for(uintptr_t i = 0; i<numThread; i++){
+		passUnis.push_back(new ColumnarTableReadTask());
+	}
+}
+ColumnarDataTableReader::~ColumnarDataTableReader(){
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		delete(passUnis[i]);
+	}
+	for(uintptr_t i = 0; i<colUnzip.size(); i++){
+		delete(colUnzip[i]);
+	}
+}
+uintptr_t ColumnarDataTableReader::read(DataTable* toStore, uintptr_t numRows){
+	if(numRows == 0){ return 0; }
+	//figure out how many to load
+		uintmax_t totalNInd = groupStarts[groupStarts.size()-1];
+		if(focusInd >= totalNInd){ return 0; }
+		uintmax_t endIndex = focusInd + numRows;
+			endIndex = std::min(endIndex, totalNInd);
+		uintptr_t numRealRead = endIndex - focusInd;
+	//make some space
+		uintptr_t numSel = useCols.size();
+		uintptr_t strRowBytes = 0;
+		for(uintptr_t si = 0; si<numSel; si++){
+			if(tabDesc.colTypes[si] == WHODUN_DATA_STR){ strRowBytes += tabDesc.strLengths[si]; }
+		}
+		toStore->saveData.clear();
+		toStore->saveData.resize(numRealRead * numSel);
+		toStore->saveText.clear();
+		toStore->saveText.resize(numRealRead * strRowBytes);
+	//unpack a group at a time
+		uintptr_t numDone = 0;
+		char* nextStr = toStore->saveText[0];
+		while(numDone < numRealRead){
+			uintptr_t curGroup = (std::upper_bound(groupStarts.begin(), groupStarts.end(), focusInd) - groupStarts.begin()) - 1;
+			if(curGroup != loadedGroup){ loadGroup(curGroup); }
+			uintptr_t groupRows = groupStarts[curGroup+1] - groupStarts[curGroup];
+			uintptr_t fromRow = focusInd - groupStarts[curGroup];
+			uintptr_t numCopy = std::min(groupRows - fromRow, numRealRead - numDone);
+			DataTableEntry* baseFill = toStore->saveData[numDone * numSel];
+			for(uintptr_t si = 0; si<numSel; si++){
+				uintptr_t ci = useCols[si];
+				uintptr_t valWidth = dataTableValueBytes(&fullDesc, ci);
+				char* curNA = colUnzip[ci]->theData.txt + fromRow;
+				ByteUnpacker curData(colUnzip[ci]->theData.txt + groupRows + fromRow*valWidth);
+				DataTableEntry* curFill = baseFill + si;
+				switch(fullDesc.colTypes[ci]){
+					case WHODUN_DATA_CAT:
+						for(uintptr_t ri = 0; ri<numCopy; ri++){
+							curFill->isNA = curNA[ri] ? 1 : 0;
+							curFill->valC = curData.unpackBE64();
+							curFill += numSel;
+						}
+						break;
+					case WHODUN_DATA_INT:
+						for(uintptr_t ri = 0; ri<numCopy; ri++){
+							curFill->isNA = curNA[ri] ? 1 : 0;
+							curFill->valI = curData.unpackBE64();
+							curFill += numSel;
+						}
+						break;
+					case WHODUN_DATA_REAL:
+						for(uintptr_t ri = 0; ri<numCopy; ri++){
+							curFill->isNA = curNA[ri] ? 1 : 0;
+							curFill->valR = curData.unpackBEDbl();
+							curFill += numSel;
+						}
+						break;
+					case WHODUN_DATA_STR:
+						for(uintptr_t ri = 0; ri<numCopy; ri++){
+							curFill->isNA = curNA[ri] ? 1 : 0;
+							memcpy(nextStr, curData.target, valWidth);
+							curFill->valS = nextStr;
+							nextStr += valWidth;
+							curData.skip(valWidth);
+							curFill += numSel;
+						}
+						break;
+					default:
+						throw std::runtime_error("Da fuq?");
+				};
+			}
+			numDone += numCopy;
+			focusInd += numCopy;
+		}
+	return numRealRead;
+}
+uintptr_t ColumnarDataTableReader::readColumns(DataTableColumns* toStore, uintptr_t numRows){
+	toStore->setColumns(&tabDesc);
+	if(numRows == 0){ return 0; }
+	//figure out how many to load
+		uintmax_t totalNInd = groupStarts[groupStarts.size()-1];
+		if(focusInd >= totalNInd){ return 0; }
+		uintmax_t endIndex = focusInd + numRows;
+			endIndex = std::min(endIndex, totalNInd);
+		uintptr_t numRealRead = endIndex - focusInd;
+	//make some space
+		uintptr_t numSel = useCols.size();
+		toStore->resize(numRealRead);
+		for(uintptr_t si = 0; si<numSel; si++){
+			DataTableColumn* curC = toStore->cols[si];
+			memset(curC->valid[0], 0, sizeof(uint64_t)*curC->valid.size());
+			if(curC->colType == WHODUN_DATA_STR){ curC->strText.resize(numRealRead * curC->strLength); }
+		}
+	//unpack a group at a time
+		uintptr_t numDone = 0;
+		while(numDone < numRealRead){
+			uintptr_t curGroup = (std::upper_bound(groupStarts.begin(), groupStarts.end(), focusInd) - groupStarts.begin()) - 1;
+			if(curGroup != loadedGroup){ loadGroup(curGroup); }
+			uintptr_t groupRows = groupStarts[curGroup+1] - groupStarts[curGroup];
+			uintptr_t fromRow = focusInd - groupStarts[curGroup];
+			uintptr_t numCopy = std::min(groupRows - fromRow, numRealRead - numDone);
+			for(uintptr_t si = 0; si<numSel; si++){
+				uintptr_t ci = useCols[si];
+				uintptr_t valWidth = dataTableValueBytes(&fullDesc, ci);
+				char* curNA = colUnzip[ci]->theData.txt + fromRow;
+				ByteUnpacker curData(colUnzip[ci]->theData.txt + groupRows + fromRow*valWidth);
+				DataTableColumn* curC = toStore->cols[si];
+				uint64_t* curValid = curC->valid[0];
+				for(uintptr_t ri = 0; ri<numCopy; ri++){
+					uintptr_t ti = numDone + ri;
+					curValid[ti >> 6] |= ((uint64_t)(curNA[ri] == 0)) << (ti & 63);
+				}
+				switch(fullDesc.colTypes[ci]){
+					case WHODUN_DATA_CAT:{
+						uint64_t* curTo = curC->valC[numDone];
+						for(uintptr_t ri = 0; ri<numCopy; ri++){ curTo[ri] = curData.unpackBE64(); }
+					} break;
+					case WHODUN_DATA_INT:{
+						int64_t* curTo = curC->valI[numDone];
+						for(uintptr_t ri = 0; ri<numCopy; ri++){ curTo[ri] = curData.unpackBE64(); }
+					} break;
+					case WHODUN_DATA_REAL:{
+						double* curTo = curC->valR[numDone];
+						for(uintptr_t ri = 0; ri<numCopy; ri++){ curTo[ri] = curData.unpackBEDbl(); }
+					} break;
+					case WHODUN_DATA_STR:{
+						char* curText = curC->strText[0];
+						uintptr_t* curOffs = curC->strOffs[0];
+						for(uintptr_t ri = 0; ri<numCopy; ri++){
+							uintptr_t ti = numDone + ri;
+							uintptr_t curLen = 0;
+							if(!curNA[ri]){
+								curLen = valWidth;
+								while(curLen && (curData.target[curLen-1] == 0)){ curLen--; }
+								memcpy(curText + curOffs[ti], curData.target, curLen);
+							}
+							curOffs[ti+1] = curOffs[ti] + curLen;
+							curData.skip(valWidth);
+						}
+					} break;
+					default:
+						throw std::runtime_error("Da fuq?");
+				};
+			}
+			numDone += numCopy;
+			focusInd += numCopy;
+		}
+	//drop the extra string space
+		for(uintptr_t si = 0; si<numSel; si++){
+			DataTableColumn* curC = toStore->cols[si];
+			if(curC->colType == WHODUN_DATA_STR){ curC->strText.resize(*(curC->strOffs[numRealRead])); }
+		}
+	return numRealRead;
+}
+void ColumnarDataTableReader::close(){
+	isClosed = 1;
+}
+uintmax_t ColumnarDataTableReader::size(){
+	return groupStarts[groupStarts.size()-1];
+}
+void ColumnarDataTableReader::seek(uintmax_t index){
+	focusInd = index;
+}
+void ColumnarDataTableReader::selectColumns(uintptr_t numSel, const uintptr_t* selCols){
+	uintptr_t numCol = fullDesc.colTypes.size();
+	for(uintptr_t i = 0; i<numSel; i++){
+		if(selCols[i] >= numCol){ throw std::runtime_error("Selected column not in table."); }
+	}
+	useCols.clear();
+	tabDesc.colTypes.clear();
+	tabDesc.colNames.clear();
+	tabDesc.factorColMap.clear();
+	tabDesc.strLengths.clear();
+	for(uintptr_t i = 0; i<numSel; i++){
+		uintptr_t ci = selCols[i];
+		useCols.push_back(ci);
+		tabDesc.colTypes.push_back(fullDesc.colTypes[ci]);
+		tabDesc.colNames.push_back(fullDesc.colNames[ci]);
+		tabDesc.factorColMap.push_back(fullDesc.factorColMap[ci]);
+		tabDesc.strLengths.push_back(fullDesc.strLengths[ci]);
+	}
+	loadedGroup = COLUMNAR_NO_GROUP;
+}
+void ColumnarDataTableReader::readHeader(CompressionFactory* compMeth){
+	try{
+		char stageB[8];
+		//read the description
+			dataTableReadDescription(&fullDesc, tsvStr);
+			uintptr_t numCol = fullDesc.colTypes.size();
+			uintmax_t dataStart = tsvStr->tell();
+			uintmax_t fileSize = tsvStr->size();
+		//find the footer
+			if((fileSize - dataStart) < 16){
+				throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Columnar table missing footer.", 0, 0);
+			}
+			tsvStr->seek(fileSize - 8);
+			tsvStr->forceRead(stageB, 8);
+			ByteUnpacker getFAddr(stageB);
+			uintmax_t footAddr = getFAddr.unpackBE64();
+			if((footAddr < dataStart) || (footAddr > (fileSize - 16))){
+				throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Columnar table footer location invalid.", 0, 0);
+			}
+		//load the footer
+			uintptr_t footLen = (fileSize - 8) - footAddr;
+			compLoad.clear();
+			compLoad.resize(footLen);
+			tsvStr->seek(footAddr);
+			tsvStr->forceRead(compLoad[0], footLen);
+			ByteUnpacker getFoot(compLoad[0]);
+			uintmax_t numGroup = getFoot.unpackBE64();
+			uintmax_t groupEntLen = 8 + 16*numCol;
+			if(((footLen - 8) % groupEntLen) || (((footLen - 8) / groupEntLen) != numGroup)){
+				throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Columnar table footer malformed.", 0, 0);
+			}
+			groupStarts.push_back(0);
+			for(uintmax_t gi = 0; gi<numGroup; gi++){
+				uintmax_t groupRows = getFoot.unpackBE64();
+				groupStarts.push_back(groupStarts[gi] + groupRows);
+				for(uintptr_t ci = 0; ci<numCol; ci++){
+					uintmax_t chunkAddr = getFoot.unpackBE64();
+					uintmax_t chunkLen = getFoot.unpackBE64();
+					if((chunkAddr < dataStart) || (chunkAddr > footAddr) || (chunkLen > (footAddr - chunkAddr))){
+						throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Columnar table chunk out of bounds.", 0, 0);
+					}
+					chunkLocs.push_back(chunkAddr);
+					chunkLocs.push_back(chunkLen);
+				}
+			}
+		//set up to read everything
+			for(uintptr_t ci = 0; ci<numCol; ci++){
+				colUnzip.push_back(compMeth->makeUnzip());
+			}
+			tabDesc = fullDesc;
+			for(uintptr_t ci = 0; ci<numCol; ci++){
+				useCols.push_back(ci);
+			}
+	}
+	catch(std::exception& errE){
+		for(uintptr_t i = 0; i<colUnzip.size(); i++){
+			delete(colUnzip[i]);
+		}
+		colUnzip.clear();
+		isClosed = 1;
+		throw;
+	}
+}
+void ColumnarDataTableReader::loadGroup(uintptr_t groupInd){
+	loadedGroup = COLUMNAR_NO_GROUP;
+	uintptr_t numCol = fullDesc.colTypes.size();
+	uintptr_t groupRows = groupStarts[groupInd+1] - groupStarts[groupInd];
+	uintmax_t* groupLocs = &(chunkLocs[2*numCol*groupInd]);
+	//figure out which chunks are needed
+		std::vector<uintptr_t> needCols;
+		std::vector<char> colSeen(numCol, 0);
+		uintptr_t totalComp = 0;
+		for(uintptr_t si = 0; si<useCols.size(); si++){
+			uintptr_t ci = useCols[si];
+			if(colSeen[ci]){ continue; }
+			colSeen[ci] = 1;
+			needCols.push_back(ci);
+			totalComp += groupLocs[2*ci+1];
+		}
+	//read in the compressed chunks (only seek when they are not adjacent)
+		compLoad.clear();
+		compLoad.resize(totalComp);
+		std::vector<SizePtrString> needComp;
+		char* nextLoad = compLoad[0];
+		uintmax_t curAddr = tsvStr->tell();
+		for(uintptr_t i = 0; i<needCols.size(); i++){
+			uintptr_t ci = needCols[i];
+			uintmax_t chunkAddr = groupLocs[2*ci];
+			uintptr_t chunkLen = groupLocs[2*ci+1];
+			if(chunkAddr != curAddr){ tsvStr->seek(chunkAddr); }
+			tsvStr->forceRead(nextLoad, chunkLen);
+			curAddr = chunkAddr + chunkLen;
+			SizePtrString curComp = {chunkLen, nextLoad};
+			needComp.push_back(curComp);
+			nextLoad += chunkLen;
+		}
+	//decompress
+		uintptr_t numThread = passUnis.size();
+		for(uintptr_t i = 0; i<numThread; i++){
+			ColumnarTableReadTask* curT = (ColumnarTableReadTask*)(passUnis[i]);
+			curT->doUnzip.clear();
+			curT->doComp.clear();
+			curT->doExpect.clear();
+		}
+		for(uintptr_t i = 0; i<needCols.size(); i++){
+			uintptr_t ci = needCols[i];
+			ColumnarTableReadTask* curT = (ColumnarTableReadTask*)(passUnis[i % numThread]);
+			curT->doUnzip.push_back(colUnzip[ci]);
+			curT->doComp.push_back(needComp[i]);
+			curT->doExpect.push_back(groupRows * (1 + dataTableValueBytes(&fullDesc, ci)));
+		}
+		if(usePool){
+			usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
+			joinTasks(numThread, &(passUnis[0]));
+		}
+		else{
+			passUnis[0]->doTask();
+		}
+	loadedGroup = groupInd;
+}
+
+ColumnarTableReadTask::ColumnarTableReadTask(){}
+ColumnarTableReadTask::~ColumnarTableReadTask(){}
+void ColumnarTableReadTask::doTask(){
+	for(uintptr_t i = 0; i<doUnzip.size(); i++){
+		doUnzip[i]->expandData(doComp[i]);
+		if(doUnzip[i]->theData.len != doExpect[i]){
+			throw WhodunError(WHODUN_ERROR_LEVEL_ERROR, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Column chunk does not decompress to expected size.", 0, 0);
+		}
+	}
+}
+
+ColumnarDataTableWriter::ColumnarDataTableWriter(DataTableDescription* forData, OutStream* dataFile, CompressionFactory* compMeth) : DataTableWriter(forData){
+	tsvStr = dataFile;
+	usePool = 0;
+	prepareGroups(compMeth, 0);
+	passUnis.push_back(new ColumnarTableWriteTask());
+}
+ColumnarDataTableWriter::ColumnarDataTableWriter(DataTableDescription* forData, OutStream* dataFile, CompressionFactory* compMeth, uintptr_t groupRows, uintptr_t numThread, ThreadPool* mainPool) : DataTableWriter(forData){
+	tsvStr = dataFile;
+	usePool = mainPool;
+	prepareGroups(compMeth, groupRows);
+	for(uintptr_t i = 0; i<numThread; i++){
+		passUnis.push_back(new ColumnarTableWriteTask());
+	}
+}
+ColumnarDataTableWriter::~ColumnarDataTableWriter(){
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		delete(passUnis[i]);
+	}
+	for(uintptr_t i = 0; i<colPack.size(); i++){
+		free(colPack[i]);
+		delete(colZip[i]);
+	}
+}
+void ColumnarDataTableWriter::write(DataTable* toStore){
+	uintptr_t numCol = tabDesc.colTypes.size();
+	uintptr_t numRows = toStore->saveData.size() / numCol;
+	uintptr_t numDone = 0;
+	while(numDone < numRows){
+		uintptr_t numAdd = std::min(maxGroupRows - numPending, numRows - numDone);
+		DataTableEntry* baseFrom = toStore->saveData[numDone * numCol];
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			uintptr_t valWidth = dataTableValueBytes(&tabDesc, ci);
+			char* curNA = colPack[ci] + numPending;
+			BytePacker curPD(colPack[ci] + maxGroupRows + numPending*valWidth);
+			DataTableEntry* curFrom = baseFrom + ci;
+			switch(tabDesc.colTypes[ci]){
+				case WHODUN_DATA_CAT:
+					for(uintptr_t ri = 0; ri<numAdd; ri++){
+						curNA[ri] = curFrom->isNA ? 1 : 0;
+						curPD.packBE64(curFrom->valC);
+						curFrom += numCol;
+					}
+					break;
+				case WHODUN_DATA_INT:
+					for(uintptr_t ri = 0; ri<numAdd; ri++){
+						curNA[ri] = curFrom->isNA ? 1 : 0;
+						curPD.packBE64(curFrom->valI);
+						curFrom += numCol;
+					}
+					break;
+				case WHODUN_DATA_REAL:
+					for(uintptr_t ri = 0; ri<numAdd; ri++){
+						curNA[ri] = curFrom->isNA ? 1 : 0;
+						curPD.packBEDbl(curFrom->valR);
+						curFrom += numCol;
+					}
+					break;
+				case WHODUN_DATA_STR:
+					for(uintptr_t ri = 0; ri<numAdd; ri++){
+						curNA[ri] = curFrom->isNA ? 1 : 0;
+						memcpy(curPD.target, curFrom->valS, valWidth);
+						curPD.skip(valWidth);
+						curFrom += numCol;
+					}
+					break;
+				default:
+					throw std::runtime_error("Da fuq?");
+			};
+		}
+		numPending += numAdd;
+		numDone += numAdd;
+		if(numPending == maxGroupRows){ dumpGroup(); }
+	}
+}
+void ColumnarDataTableWriter::close(){
+	isClosed = 1;
+	dumpGroup();
+	//pack up the footer
+		uintptr_t numCol = tabDesc.colTypes.size();
+		uintptr_t numGroup = groupRowCounts.size();
+		StructVector<char> footText;
+		footText.resize(8 + numGroup*(8 + 16*numCol) + 8);
+		BytePacker curPD(footText[0]);
+		curPD.packBE64(numGroup);
+		for(uintptr_t gi = 0; gi<numGroup; gi++){
+			curPD.packBE64(groupRowCounts[gi]);
+			for(uintptr_t ci = 0; ci<numCol; ci++){
+				curPD.packBE64(chunkLocs[2*(gi*numCol + ci)]);
+				curPD.packBE64(chunkLocs[2*(gi*numCol + ci) + 1]);
+			}
+		}
+		curPD.packBE64(totalWrite);
+	//and write
+		tsvStr->write(footText[0], footText.size());
+		totalWrite += footText.size();
+}
+void ColumnarDataTableWriter::prepareGroups(CompressionFactory* compMeth, uintptr_t groupRows){
+	try{
+		uintptr_t numCol = tabDesc.colTypes.size();
+		uintptr_t rowBytes = 0;
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			rowBytes += (1 + dataTableValueBytes(&tabDesc, ci));
+		}
+		maxGroupRows = groupRows;
+		if(maxGroupRows == 0){
+			maxGroupRows = WHODUN_COLUMNAR_GROUP_BYTES / std::max(rowBytes, (uintptr_t)1);
+			maxGroupRows = std::max(maxGroupRows, (uintptr_t)1);
+		}
+		numPending = 0;
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			colPack.push_back((char*)malloc(maxGroupRows * (1 + dataTableValueBytes(&tabDesc, ci))));
+			colZip.push_back(compMeth->makeZip());
+		}
+		totalWrite = dataTableWriteDescription(&tabDesc, tsvStr);
+	}
+	catch(std::exception& errE){
+		for(uintptr_t i = 0; i<colPack.size(); i++){
+			free(colPack[i]);
+			delete(colZip[i]);
+		}
+		colPack.clear();
+		colZip.clear();
+		isClosed = 1;
+		throw;
+	}
+}
+void ColumnarDataTableWriter::dumpGroup(){
+	if(numPending == 0){ return; }
+	uintptr_t numCol = tabDesc.colTypes.size();
+	//compress
+		uintptr_t numThread = passUnis.size();
+		for(uintptr_t i = 0; i<numThread; i++){
+			ColumnarTableWriteTask* curT = (ColumnarTableWriteTask*)(passUnis[i]);
+			curT->numRow = numPending;
+			curT->maxRow = maxGroupRows;
+			curT->doZip.clear();
+			curT->doPack.clear();
+			curT->doWidth.clear();
+		}
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			ColumnarTableWriteTask* curT = (ColumnarTableWriteTask*)(passUnis[ci % numThread]);
+			curT->doZip.push_back(colZip[ci]);
+			curT->doPack.push_back(colPack[ci]);
+			curT->doWidth.push_back(dataTableValueBytes(&tabDesc, ci));
+		}
+		if(usePool){
+			usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
+			joinTasks(numThread, &(passUnis[0]));
+		}
+		else{
+			passUnis[0]->doTask();
+		}
+	//write out
+		for(uintptr_t ci = 0; ci<numCol; ci++){
+			SizePtrString curComp = colZip[ci]->compData;
+			chunkLocs.push_back(totalWrite);
+			chunkLocs.push_back(curComp.len);
+			tsvStr->write(curComp.txt, curComp.len);
+			totalWrite += curComp.len;
+		}
+		groupRowCounts.push_back(numPending);
+		numPending = 0;
+}
+
+ColumnarTableWriteTask::ColumnarTableWriteTask(){}
+ColumnarTableWriteTask::~ColumnarTableWriteTask(){}
+void ColumnarTableWriteTask::doTask(){
+	for(uintptr_t i = 0; i<doZip.size(); i++){
+		char* curPack = doPack[i];
+		uintptr_t valWidth = doWidth[i];
+		//short groups leave a gap between the flags and the values
+		if(numRow != maxRow){
+			memmove(curPack + numRow, curPack + maxRow, numRow * valWidth);
+		}
+		SizePtrString curData = {numRow * (1 + valWidth), curPack};
+		doZip[i]->compressData(curData);
+	}
+}
+
 ExtensionDataTableReader::ExtensionDataTableReader(const char* fileName, InStream* useStdin){
 	openUp(fileName, 1, 0, useStdin);
 	tabDesc = wrapStr->tabDesc;
@@ -564,6 +1577,25 @@ void ExtensionDataTableReader::openUp(const char* fileName, uintptr_t numThread,
 				return;
 			}
 		}
+		//anything columnar
+		{
+			int isCdat = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".cdat"));
+			int isRaw = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".raw.cdat"));
+			int isDeflate = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".zlib.cdat"));
+			if(isCdat){
+				if(isRaw){ compMeth = new RawCompressionFactory(); }
+				else if(isDeflate){ compMeth = new DeflateCompressionFactory(); }
+				else{
+					const char* packExt[] = {fileName};
+					throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Unknown compression method for columnar data.", 1, packExt);
+				}
+				RandaccInStream* dataS = new FileInStream(fileName);
+				baseStrs.push_back(dataS);
+				wrapStr = mainPool ? new ColumnarDataTableReader(dataS, compMeth, numThread, mainPool) : new ColumnarDataTableReader(dataS, compMeth);
+				delete(compMeth);
+				return;
+			}
+		}
 		//complain on anything weird
 		{
 			const char* packExt[] = {fileName};
@@ -593,6 +1625,9 @@ ExtensionDataTableReader::~ExtensionDataTableReader(){
 uintptr_t ExtensionDataTableReader::read(DataTable* toStore, uintptr_t numRows){
 	return wrapStr->read(toStore, numRows);
 }
+uintptr_t ExtensionDataTableReader::readColumns(DataTableColumns* toStore, uintptr_t numRows){
+	return wrapStr->readColumns(toStore, numRows);
+}
 void ExtensionDataTableReader::close(){
 	isClosed = 1;
 	wrapStr->close();
@@ -622,6 +1657,9 @@ ExtensionRandacDataTableReader::~ExtensionRandacDataTableReader(){
 uintptr_t ExtensionRandacDataTableReader::read(DataTable* toStore, uintptr_t numRows){
 	return wrapStr->read(toStore, numRows);
 }
+uintptr_t ExtensionRandacDataTableReader::readColumns(DataTableColumns* toStore, uintptr_t numRows){
+	return wrapStr->readColumns(toStore, numRows);
+}
 void ExtensionRandacDataTableReader::close(){
 	isClosed = 1;
 	wrapStr->close();
@@ -673,6 +1711,25 @@ void ExtensionRandacDataTableReader::openUp(const char* fileName, uintptr_t numT
 				return;
 			}
 		}
+		//anything columnar
+		{
+			int isCdat = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".cdat"));
+			int isRaw = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".raw.cdat"));
+			int isDeflate = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".zlib.cdat"));
+			if(isCdat){
+				if(isRaw){ compMeth = new RawCompressionFactory(); }
+				else if(isDeflate){ compMeth = new DeflateCompressionFactory(); }
+				else{
+					const char* packExt[] = {fileName};
+					throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Unknown compression method for columnar data.", 1, packExt);
+				}
+				RandaccInStream* dataS = new FileInStream(fileName);
+				baseStrs.push_back(dataS);
+				wrapStr = mainPool ? new ColumnarDataTableReader(dataS, compMeth, numThread, mainPool) : new ColumnarDataTableReader(dataS, compMeth);
+				delete(compMeth);
+				return;
+			}
+		}
 		//complain on anything weird
 		{
 			const char* packExt[] = {fileName};
@@ -711,6 +1768,9 @@ ExtensionDataTableWriter::~ExtensionDataTableWriter(){
 void ExtensionDataTableWriter::write(DataTable* toStore){
 	wrapStr->write(toStore);
 }
+void ExtensionDataTableWriter::writeColumns(DataTableColumns* toStore){
+	wrapStr->writeColumns(toStore);
+}
 void ExtensionDataTableWriter::close(){
 	isClosed = 1;
 	wrapStr->close();
@@ -774,6 +1834,25 @@ void ExtensionDataTableWriter::openUp(const char* fileName, uintptr_t numThread,
 				return;
 			}
 		}
+		//anything columnar
+		{
+			int isCdat = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".cdat"));
+			int isRaw = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".raw.cdat"));
+			int isDeflate = strMeth.memendswith(toSizePtr(fileName), toSizePtr(".zlib.cdat"));
+			if(isCdat){
+				if(isRaw){ compMeth = new RawCompressionFactory(); }
+				else if(isDeflate){ compMeth = new DeflateCompressionFactory(); }
+				else{
+					const char* packExt[] = {fileName};
+					throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_BADCLIARG, __FILE__, __LINE__, "Unknown compression method for columnar data.", 1, packExt);
+				}
+				OutStream* dataS = new FileOutStream(0, fileName);
+				baseStrs.push_back(dataS);
+				wrapStr = mainPool ? new ColumnarDataTableWriter(&tabDesc, dataS, compMeth, 0, numThread, mainPool) : new ColumnarDataTableWriter(&tabDesc, dataS, compMeth);
+				delete(compMeth);
+				return;
+			}
+		}
 		//complain on anything weird
 		{
 			const char* packExt[] = {fileName};
@@ -804,6 +1883,8 @@ ArgumentOptionDataTableRead::ArgumentOptionDataTableRead(int needed, const char*
 	validExts.push_back(".raw.bcdat");
 	//validExts.push_back(".gzip.bcdat");
 	validExts.push_back(".zlib.bcdat");
+	validExts.push_back(".raw.cdat");
+	validExts.push_back(".zlib.cdat");
 }
 ArgumentOptionDataTableRead::~ArgumentOptionDataTableRead(){}
 
@@ -816,6 +1897,8 @@ ArgumentOptionDataTableRandac::ArgumentOptionDataTableRandac(int needed, const c
 	validExts.push_back(".raw.bcdat");
 	//validExts.push_back(".gzip.bcdat");
 	validExts.push_back(".zlib.bcdat");
+	validExts.push_back(".raw.cdat");
+	validExts.push_back(".zlib.cdat");
 }
 ArgumentOptionDataTableRandac::~ArgumentOptionDataTableRandac(){}
 
@@ -830,6 +1913,8 @@ ArgumentOptionDataTableWrite::ArgumentOptionDataTableWrite(int needed, const cha
 	validExts.push_back(".raw.bcdat");
 	//validExts.push_back(".gzip.bcdat");
 	validExts.push_back(".zlib.bcdat");
+	validExts.push_back(".raw.cdat");
+	validExts.push_back(".zlib.cdat");
 }
 ArgumentOptionDataTableWrite::~ArgumentOptionDataTableWrite(){}
 
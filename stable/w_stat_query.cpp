@@ -0,0 +1,2270 @@
+#include "whodun_stat_query.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "whodun_oshook.h"
+#include "whodun_string.h"
+
+namespace whodun{
+
+/**Do the grouping work.*/
+class DataTableGroupTask : public JoinableThreadTask{
+public:
+	/**
+	 * Set up.
+	 * @param forGroup The grouping this is for.
+	 */
+	DataTableGroupTask(DataTableGroupBy* forGroup);
+	/**Clean up.*/
+	~DataTableGroupTask();
+	void doTask();
+
+	/**The grouping this is for.*/
+	DataTableGroupBy* myGroup;
+	/**The phase to run.*/
+	uintptr_t phase;
+	/**The first thing to work on.*/
+	uintptr_t fromI;
+	/**The thing to stop at.*/
+	uintptr_t toI;
+	/**The groups this has seen.*/
+	DataTableGroupHash localTab;
+	/**Storage for a key.*/
+	StructVector<char> keyStore;
+
+	//phase 1 - add rows
+	/**The rows to add.*/
+	DataTable* addTab;
+
+	//phase 2 - add spilled records
+	/**The records to add.*/
+	char* addRecords;
+
+	//phase 3 - sort groups by partition
+	/**The level of partitioning.*/
+	uintptr_t spillLevel;
+	/**The groups, arranged by partition.*/
+	StructVector<char> spillData;
+	/**The number of groups in each partition.*/
+	StructVector<uintptr_t> spillCounts;
+
+	//phase 4 - merge the groups from all tasks
+	/**The index of this task.*/
+	uintptr_t taskInd;
+	/**The merged groups.*/
+	DataTableGroupHash finalTab;
+};
+
+/**
+ * Hash a key.
+ * @param keyData The key.
+ * @param keyBytes The number of bytes in the key (a multiple of 8).
+ * @return The hash.
+ */
+uint64_t dataGroupHashKey(const char* keyData, uintptr_t keyBytes);
+
+/**
+ * Figure out which task merges a group.
+ * @param hashV The hash of the group's key.
+ * @param numThread The number of tasks.
+ * @return The task to merge it.
+ */
+uintptr_t dataGroupMergeTask(uint64_t hashV, uintptr_t numThread);
+
+/**
+ * Fold the running statistics of one group into another.
+ * @param forGroup The grouping this is for.
+ * @param toRecord The record to add to.
+ * @param fromRecord The record to add.
+ */
+void dataGroupMergeRecord(DataTableGroupBy* forGroup, char* toRecord, const char* fromRecord);
+
+/**
+ * Make the name for a new temporary file.
+ * @param inFolder The folder the file goes in.
+ * @param filePrefix The start of the file name.
+ * @param toFill The place to put the name.
+ * @param numTemps The number of temporary files made so far.
+ */
+void dataGroupNewTempName(const char* inFolder, const char* filePrefix, std::string* toFill, uintptr_t numTemps);
+
+/**
+ * Open the partition files of a spill, if not already open.
+ * @param spillTo The spill.
+ * @param tempName The folder for the files.
+ * @param madeTemp The place to note whether the folder was made.
+ * @param numTemps The number of temporary files made so far: updated.
+ * @param filePrefix The start of the file names.
+ * @param compMeth The compression to use.
+ * @param numThread The number of threads to use.
+ * @param usePool The threads to use, if any.
+ */
+void dataGroupOpenSpill(DataTableGroupSpill* spillTo, std::string* tempName, int* madeTemp, uintptr_t* numTemps, const char* filePrefix, CompressionFactory* compMeth, uintptr_t numThread, ThreadPool* usePool);
+
+/**
+ * Open a spilled partition for reading.
+ * @param spillFrom The spill.
+ * @param fileInd The partition to open.
+ * @param compMeth The compression to use.
+ * @param numThread The number of threads to use.
+ * @param usePool The threads to use, if any.
+ * @return The opened stream.
+ */
+BlockCompInStream* dataGroupReadSpill(DataTableGroupSpill* spillFrom, uintptr_t fileInd, CompressionFactory* compMeth, uintptr_t numThread, ThreadPool* usePool);
+
+/**
+ * Remove the files of a spilled partition.
+ * @param spillFrom The spill.
+ * @param fileInd The partition to remove.
+ */
+void dataGroupKillSpill(DataTableGroupSpill* spillFrom, uintptr_t fileInd);
+
+/**Do the joining work.*/
+class DataTableJoinTask : public JoinableThreadTask{
+public:
+	/**
+	 * Set up.
+	 * @param forJoin The join this is for.
+	 */
+	DataTableJoinTask(DataTableHashJoin* forJoin);
+	/**Clean up.*/
+	~DataTableJoinTask();
+	void doTask();
+	/**
+	 * Add a result row.
+	 * @param probeRec The probe record.
+	 * @param buildRec The matching build record, or null if none.
+	 */
+	void addResult(const char* probeRec, const char* buildRec);
+
+	/**The join this is for.*/
+	DataTableHashJoin* myJoin;
+	/**The phase to run.*/
+	uintptr_t phase;
+	/**The first thing to work on.*/
+	uintptr_t fromI;
+	/**The thing to stop at.*/
+	uintptr_t toI;
+	/**The index of this task.*/
+	uintptr_t taskInd;
+
+	//phase 1 - pack rows into records
+	/**The rows to pack.*/
+	DataTable* packTab;
+	/**Whether the rows are from the probe table.*/
+	int packProbe;
+	/**The packed records.*/
+	StructVector<char> packData;
+	/**The number of packed records.*/
+	uintptr_t packCount;
+
+	//phase 2 - sort records by partition
+	/**The records to work on (phases 2 and 4).*/
+	char* srcData;
+	/**The number of bytes in each record.*/
+	uintptr_t srcRecBytes;
+	/**The level of partitioning.*/
+	uintptr_t spillLevel;
+	/**The records, arranged by partition.*/
+	StructVector<char> spillData;
+	/**The number of records in each partition.*/
+	StructVector<uintptr_t> spillCounts;
+
+	//phase 3 - hash the build records
+	/**The build records this task owns.*/
+	DataTableJoinHash joinTab;
+
+	//phase 4 - look up probe records
+	/**The results.*/
+	DataTable outTab;
+};
+
+/**
+ * Unpack a column from a record.
+ * @param colType The type of the column.
+ * @param packData The packed column: a flag for unknown, then the value.
+ * @param toFill The entry to fill: strings point into the record.
+ */
+void dataJoinUnpackColumn(uintptr_t colType, const char* packData, DataTableEntry* toFill);
+
+/**Make the sort entries for some rows.*/
+class TableSortTask : public JoinableThreadTask{
+public:
+	/**
+	 * Set up.
+	 * @param forSort The sort this is for.
+	 */
+	TableSortTask(TableExternalSort* forSort);
+	/**Clean up.*/
+	~TableSortTask();
+	void doTask();
+
+	/**The sort this is for.*/
+	TableExternalSort* mySort;
+	/**The first row to work on.*/
+	uintptr_t fromI;
+	/**The row to stop at.*/
+	uintptr_t toI;
+	/**The index of the first loaded row in the table.*/
+	uintmax_t baseRow;
+	/**The place to put the entry for the first row.*/
+	char* fillTo;
+};
+
+/**Collect sorted entries and write out their rows.*/
+class TableSortGatherStream : public OutStream{
+public:
+	/**
+	 * Set up.
+	 * @param forSort The sort this is for.
+	 */
+	TableSortGatherStream(TableExternalSort* forSort);
+	/**Clean up.*/
+	~TableSortGatherStream();
+	void write(int toW);
+	void write(const char* toW, uintptr_t numW);
+	void close();
+
+	/**The sort this is for.*/
+	TableExternalSort* mySort;
+	/**The entries waiting to be gathered.*/
+	StructVector<char> entryStore;
+	/**The number of waiting bytes.*/
+	uintptr_t numBytes;
+};
+
+/**Write out a key index, noting the first key of each block.*/
+class TextTableKeyIndexDumpStream : public OutStream{
+public:
+	/**
+	 * Set up.
+	 * @param baseStr The place to write the index.
+	 * @param keyWidth The number of bytes of key in each entry.
+	 * @param blockEntries The number of entries in each block.
+	 */
+	TextTableKeyIndexDumpStream(OutStream* baseStr, uintptr_t keyWidth, uintptr_t blockEntries);
+	/**Clean up.*/
+	~TextTableKeyIndexDumpStream();
+	void write(int toW);
+	void write(const char* toW, uintptr_t numW);
+	void close();
+
+	/**The place to write the index.*/
+	OutStream* baseStr;
+	/**The number of bytes of key in each entry.*/
+	uintptr_t keyWidth;
+	/**The number of bytes in each entry.*/
+	uintptr_t entryBytes;
+	/**The number of entries in each block.*/
+	uintptr_t blockEntries;
+	/**The number of bytes written so far.*/
+	uintmax_t numBytes;
+	/**The first key of each block.*/
+	StructVector<char> topKeys;
+};
+
+/**
+ * Compare sort entries.
+ * @param unif The number of bytes in an entry.
+ * @param itemA The first entry.
+ * @param itemB The second entry.
+ * @return Whether itemA comes first.
+ */
+bool tableSortCompare(void* unif, void* itemA, void* itemB);
+
+/**
+ * Store a real so its bytes sort in order.
+ * @param value The value: not a NaN.
+ * @param toFill The place to put the eight bytes.
+ */
+void tableSortPackReal(double value, char* toFill);
+
+};
+
+using namespace whodun;
+
+/**The number of bits of the hash each level of spilling partitions on.*/
+#define GROUPBY_SPILL_BITS 4
+/**The number of partitions each level of spilling makes.*/
+#define GROUPBY_SPILL_PARTS (1 << GROUPBY_SPILL_BITS)
+/**The deepest level to partition to: after this, the budget is ignored.*/
+#define GROUPBY_SPILL_MAXLEVEL 8
+/**The size of blocks in temporary files.*/
+#define GROUPBY_TEMP_BLOCK_SIZE 0x010000
+/**The number of spilled records to load at a time.*/
+#define GROUPBY_LOAD_RECORDS 0x010000
+/**The number of groups to write at a time.*/
+#define GROUPBY_DUMP_GROUPS 0x01000
+/**The offset to the key in a group record.*/
+#define GROUPBY_REC_KEY 8
+/**The build level used for probe categories the build table does not have.*/
+#define HASHJOIN_MISSING_LEVEL 0xFFFFFFFFFFFFFFFFULL
+/**The number of rows to read at a time while making sort entries.*/
+#define TABLESORT_READ_ROWS 0x04000
+/**Wanted rows this close together are read in one go.*/
+#define TABLESORT_GATHER_GAP 256
+/**The number of bytes in the header of a key index.*/
+#define KEYINDEX_HEAD_BYTES 32
+/**The most rows to read in one go when fetching rows for a key index.*/
+#define KEYINDEX_MAX_SPAN 0x04000
+
+uint64_t whodun::dataGroupHashKey(const char* keyData, uintptr_t keyBytes){
+	uint64_t curH = 0x9E3779B97F4A7C15ULL ^ keyBytes;
+	for(uintptr_t i = 0; i<keyBytes; i+=8){
+		uint64_t curW;
+		memcpy(&curW, keyData + i, 8);
+		curH = (curH ^ curW) * 0xFF51AFD7ED558CCDULL;
+		curH ^= (curH >> 32);
+	}
+	curH ^= (curH >> 33);
+	curH *= 0xC4CEB9FE1A85EC53ULL;
+	curH ^= (curH >> 33);
+	return curH;
+}
+
+uintptr_t whodun::dataGroupMergeTask(uint64_t hashV, uintptr_t numThread){
+	//the table uses the low bits and spills use the high bits, so scramble before picking
+	uint64_t mixH = (hashV ^ (hashV >> 29)) * 0xBF58476D1CE4E5B9ULL;
+	return (mixH >> 40) % numThread;
+}
+
+void whodun::dataGroupMergeRecord(DataTableGroupBy* forGroup, char* toRecord, const char* fromRecord){
+	uintptr_t statOff = GROUPBY_REC_KEY + forGroup->keyBytes;
+	uint64_t toRows; memcpy(&toRows, toRecord + statOff, 8);
+	uint64_t fromRows; memcpy(&fromRows, fromRecord + statOff, 8);
+	toRows += fromRows;
+	memcpy(toRecord + statOff, &toRows, 8);
+	DataTableAggregateAccum* toAcc = (DataTableAggregateAccum*)(toRecord + statOff + 8);
+	const DataTableAggregateAccum* fromAcc = (const DataTableAggregateAccum*)(fromRecord + statOff + 8);
+	for(uintptr_t i = 0; i<forGroup->accumCols.size(); i++){
+		const DataTableAggregateAccum* curF = fromAcc + i;
+		DataTableAggregateAccum* curT = toAcc + i;
+		if(curF->numKnown == 0){ continue; }
+		if(curT->numKnown == 0){
+			*curT = *curF;
+			continue;
+		}
+		//combine the variance pieces
+			double numA = curT->numKnown;
+			double numB = curF->numKnown;
+			double numTot = numA + numB;
+			double delta = curF->mean - curT->mean;
+			curT->mean += delta * (numB / numTot);
+			curT->sumSqDev += curF->sumSqDev + delta*delta*(numA*numB/numTot);
+			curT->numKnown += curF->numKnown;
+		//and the rest
+			switch(forGroup->tabDesc.colTypes[forGroup->accumCols[i]]){
+				case WHODUN_DATA_INT:
+					curT->sumI = (int64_t)((uint64_t)(curT->sumI) + (uint64_t)(curF->sumI));
+					curT->minI = std::min(curT->minI, curF->minI);
+					curT->maxI = std::max(curT->maxI, curF->maxI);
+					break;
+				case WHODUN_DATA_REAL:
+					curT->sumR += curF->sumR;
+					curT->minR = std::min(curT->minR, curF->minR);
+					curT->maxR = std::max(curT->maxR, curF->maxR);
+					break;
+				default:
+					break;
+			}
+	}
+}
+
+void whodun::dataGroupNewTempName(const char* inFolder, const char* filePrefix, std::string* toFill, uintptr_t numTemps){
+	char asciiBuff[8*sizeof(uintmax_t)+8];
+	toFill->append(inFolder);
+	StandardMemorySearcher strLook;
+	if(!strLook.memendswith(toSizePtr(toFill->c_str()), toSizePtr(filePathSeparator))){
+		toFill->append(filePathSeparator);
+	}
+	toFill->append(filePrefix);
+	sprintf(asciiBuff, "%ju", (uintmax_t)numTemps);
+	toFill->append(asciiBuff);
+}
+
+void whodun::dataGroupOpenSpill(DataTableGroupSpill* spillTo, std::string* tempName, int* madeTemp, uintptr_t* numTemps, const char* filePrefix, CompressionFactory* compMeth, uintptr_t numThread, ThreadPool* usePool){
+	if(spillTo->baseNames.size()){ return; }
+	if(!directoryExists(tempName->c_str())){
+		if(directoryCreate(tempName->c_str())){ throw std::runtime_error("Problem creating " + *tempName); }
+		*madeTemp = 1;
+	}
+	for(uintptr_t i = 0; i<GROUPBY_SPILL_PARTS; i++){
+		std::string baseN;
+			dataGroupNewTempName(tempName->c_str(), filePrefix, &baseN, *numTemps);
+			*numTemps = *numTemps + 1;
+		std::string blockN = baseN; blockN.append(".blk");
+		spillTo->baseNames.push_back(baseN);
+		spillTo->blockNames.push_back(blockN);
+		spillTo->numRecords.push_back(0);
+		spillTo->outStrs.push_back(0);
+		if(usePool){
+			spillTo->outStrs[i] = new BlockCompOutStream(0, GROUPBY_TEMP_BLOCK_SIZE, baseN.c_str(), blockN.c_str(), compMeth, numThread, usePool);
+		}
+		else{
+			spillTo->outStrs[i] = new BlockCompOutStream(0, GROUPBY_TEMP_BLOCK_SIZE, baseN.c_str(), blockN.c_str(), compMeth);
+		}
+	}
+}
+
+BlockCompInStream* whodun::dataGroupReadSpill(DataTableGroupSpill* spillFrom, uintptr_t fileInd, CompressionFactory* compMeth, uintptr_t numThread, ThreadPool* usePool){
+	if(usePool){
+		return new BlockCompInStream(spillFrom->baseNames[fileInd].c_str(), spillFrom->blockNames[fileInd].c_str(), compMeth, numThread, usePool);
+	}
+	return new BlockCompInStream(spillFrom->baseNames[fileInd].c_str(), spillFrom->blockNames[fileInd].c_str(), compMeth);
+}
+
+void whodun::dataGroupKillSpill(DataTableGroupSpill* spillFrom, uintptr_t fileInd){
+	if(spillFrom->baseNames[fileInd].size()){
+		fileKill(spillFrom->baseNames[fileInd].c_str());
+		spillFrom->baseNames[fileInd].clear();
+	}
+	if(spillFrom->blockNames[fileInd].size()){
+		fileKill(spillFrom->blockNames[fileInd].c_str());
+		spillFrom->blockNames[fileInd].clear();
+	}
+}
+
+void whodun::dataJoinUnpackColumn(uintptr_t colType, const char* packData, DataTableEntry* toFill){
+	toFill->isNA = packData[0];
+	switch(colType){
+		case WHODUN_DATA_CAT: memcpy(&(toFill->valC), packData + 1, 8); break;
+		case WHODUN_DATA_INT: memcpy(&(toFill->valI), packData + 1, 8); break;
+		case WHODUN_DATA_REAL: memcpy(&(toFill->valR), packData + 1, 8); break;
+		case WHODUN_DATA_STR: toFill->valS = (char*)(packData + 1); break;
+		default:
+			throw std::runtime_error("Unknown column type.");
+	}
+}
+
+bool whodun::tableSortCompare(void* unif, void* itemA, void* itemB){
+	return memcmp(itemA, itemB, *(uintptr_t*)unif) < 0;
+}
+
+void whodun::tableSortPackReal(double value, char* toFill){
+	if(value == 0.0){ value = 0.0; }
+	uint64_t allBits;
+	memcpy(&allBits, &value, 8);
+	allBits = (allBits >> 63) ? ~allBits : (allBits | 0x8000000000000000ULL);
+	BytePacker packV(toFill);
+	packV.packBE64(allBits);
+}
+
+DataTableGroupHash::DataTableGroupHash(uintptr_t keyBytes, uintptr_t numAccum){
+	this->keyBytes = keyBytes;
+	this->numAccum = numAccum;
+	recordBytes = GROUPBY_REC_KEY + keyBytes + 8 + numAccum*sizeof(DataTableAggregateAccum);
+	numGroups = 0;
+	slotHash.resize(64);
+	slotGroup.resize(64);
+	memset(slotGroup[0], 0, 64*sizeof(uintptr_t));
+}
+DataTableGroupHash::~DataTableGroupHash(){}
+char* DataTableGroupHash::findOrAdd(uint64_t hashV, const char* keyData, int* wasNew){
+	//make room, if needed
+	uintptr_t numSlots = slotGroup.size();
+	if(2*(numGroups + 1) > numSlots){
+		uintptr_t newSlots = 2*numSlots;
+		StructVector<uint64_t> newHash(newSlots);
+		StructVector<uintptr_t> newGroup(newSlots);
+		memset(newGroup[0], 0, newSlots*sizeof(uintptr_t));
+		uintptr_t newMask = newSlots - 1;
+		for(uintptr_t i = 0; i<numSlots; i++){
+			uintptr_t curG = *(slotGroup[i]);
+			if(curG == 0){ continue; }
+			uint64_t curH = *(slotHash[i]);
+			uintptr_t curS = curH & newMask;
+			while(*(newGroup[curS])){ curS = (curS + 1) & newMask; }
+			*(newHash[curS]) = curH;
+			*(newGroup[curS]) = curG;
+		}
+		slotHash = newHash;
+		slotGroup = newGroup;
+		numSlots = newSlots;
+	}
+	//look for it
+	uintptr_t slotMask = numSlots - 1;
+	uintptr_t curS = hashV & slotMask;
+	uint64_t* allHash = slotHash[0];
+	uintptr_t* allGroup = slotGroup[0];
+	while(allGroup[curS]){
+		if(allHash[curS] == hashV){
+			char* curRec = groupData[(allGroup[curS]-1)*recordBytes];
+			if(memcmp(curRec + GROUPBY_REC_KEY, keyData, keyBytes) == 0){
+				*wasNew = 0;
+				return curRec;
+			}
+		}
+		curS = (curS + 1) & slotMask;
+	}
+	//add it
+	groupData.resize((numGroups+1)*recordBytes);
+	char* newRec = groupData[numGroups*recordBytes];
+	memcpy(newRec, &hashV, 8);
+	memcpy(newRec + GROUPBY_REC_KEY, keyData, keyBytes);
+	numGroups++;
+	allHash[curS] = hashV;
+	allGroup[curS] = numGroups;
+	*wasNew = 1;
+	return newRec;
+}
+void DataTableGroupHash::clear(){
+	numGroups = 0;
+	groupData.clear();
+	memset(slotGroup[0], 0, slotGroup.size()*sizeof(uintptr_t));
+}
+char* DataTableGroupHash::getRecord(uintptr_t groupInd){
+	return groupData[groupInd*recordBytes];
+}
+
+DataTableGroupSpill::DataTableGroupSpill(){}
+DataTableGroupSpill::~DataTableGroupSpill(){
+	close();
+	for(uintptr_t i = 0; i<baseNames.size(); i++){
+		if(baseNames[i].size()){ fileKill(baseNames[i].c_str()); }
+		if(blockNames[i].size()){ fileKill(blockNames[i].c_str()); }
+	}
+}
+void DataTableGroupSpill::close(){
+	for(uintptr_t i = 0; i<outStrs.size(); i++){
+		if(outStrs[i]){
+			outStrs[i]->close();
+			delete(outStrs[i]);
+			outStrs[i] = 0;
+		}
+	}
+}
+
+DataTableGroupBy::DataTableGroupBy(DataTableDescription* forData, const char* workDirName){
+	maxLoad = 0x20000000;
+	spillComp = &defaultSpillComp;
+	defaultSpillComp.compLevel = Z_BEST_SPEED;
+	tabDesc = *forData;
+	keyBytes = 0;
+	tempName = workDirName;
+	madeTemp = 0;
+	numTemps = 0;
+	numThread = 1;
+	usePool = 0;
+	topSpill = 0;
+}
+DataTableGroupBy::DataTableGroupBy(DataTableDescription* forData, const char* workDirName, uintptr_t numThread, ThreadPool* mainPool){
+	maxLoad = 0x20000000;
+	spillComp = &defaultSpillComp;
+	defaultSpillComp.compLevel = Z_BEST_SPEED;
+	tabDesc = *forData;
+	keyBytes = 0;
+	tempName = workDirName;
+	madeTemp = 0;
+	numTemps = 0;
+	this->numThread = numThread;
+	usePool = mainPool;
+	topSpill = 0;
+}
+DataTableGroupBy::~DataTableGroupBy(){
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		delete(passUnis[i]);
+	}
+	if(topSpill){ delete(topSpill); }
+	if(madeTemp){ directoryKill(tempName.c_str()); }
+}
+void DataTableGroupBy::addKey(uintptr_t column){
+	if(passUnis.size()){ throw std::runtime_error("Keys must be set before adding data."); }
+	if(column >= tabDesc.colTypes.size()){ throw std::runtime_error("Key column out of range."); }
+	keyCols.push_back(column);
+}
+void DataTableGroupBy::addAggregate(int aggType, uintptr_t column){
+	if(passUnis.size()){ throw std::runtime_error("Summaries must be set before adding data."); }
+	if(aggType == WHODUN_AGGREGATE_ROWS){
+		aggTypes.push_back(aggType);
+		aggCols.push_back(0);
+		aggAccums.push_back(0);
+		return;
+	}
+	if(column >= tabDesc.colTypes.size()){ throw std::runtime_error("Summary column out of range."); }
+	uintptr_t colType = tabDesc.colTypes[column];
+	switch(aggType){
+		case WHODUN_AGGREGATE_COUNT:
+			break;
+		case WHODUN_AGGREGATE_SUM:
+		case WHODUN_AGGREGATE_MEAN:
+		case WHODUN_AGGREGATE_MIN:
+		case WHODUN_AGGREGATE_MAX:
+		case WHODUN_AGGREGATE_VAR:
+			if((colType != WHODUN_DATA_INT) && (colType != WHODUN_DATA_REAL)){ throw std::runtime_error("Can only do arithmetic on number columns."); }
+			break;
+		default:
+			throw std::runtime_error("Unknown summary.");
+	}
+	uintptr_t accInd = std::find(accumCols.begin(), accumCols.end(), column) - accumCols.begin();
+	if(accInd == accumCols.size()){ accumCols.push_back(column); }
+	aggTypes.push_back(aggType);
+	aggCols.push_back(column);
+	aggAccums.push_back(accInd);
+}
+void DataTableGroupBy::getResultDescription(DataTableDescription* toFill){
+	toFill->colTypes.clear();
+	toFill->colNames.clear();
+	toFill->factorColMap.clear();
+	toFill->strLengths.clear();
+	for(uintptr_t i = 0; i<keyCols.size(); i++){
+		uintptr_t curC = keyCols[i];
+		toFill->colTypes.push_back(tabDesc.colTypes[curC]);
+		toFill->colNames.push_back(tabDesc.colNames[curC]);
+		toFill->factorColMap.push_back(tabDesc.factorColMap[curC]);
+		toFill->strLengths.push_back(tabDesc.strLengths[curC]);
+	}
+	for(uintptr_t i = 0; i<aggTypes.size(); i++){
+		uintptr_t curC = aggCols[i];
+		uintptr_t colType = tabDesc.colTypes[curC];
+		std::string curName;
+		uintptr_t curType = WHODUN_DATA_REAL;
+		switch(aggTypes[i]){
+			case WHODUN_AGGREGATE_ROWS: curName = "rows"; curType = WHODUN_DATA_INT; break;
+			case WHODUN_AGGREGATE_COUNT: curName = "count_"; curType = WHODUN_DATA_INT; break;
+			case WHODUN_AGGREGATE_SUM: curName = "sum_"; curType = colType; break;
+			case WHODUN_AGGREGATE_MEAN: curName = "mean_"; break;
+			case WHODUN_AGGREGATE_MIN: curName = "min_"; curType = colType; break;
+			case WHODUN_AGGREGATE_MAX: curName = "max_"; curType = colType; break;
+			case WHODUN_AGGREGATE_VAR: curName = "var_"; break;
+		}
+		if(aggTypes[i] != WHODUN_AGGREGATE_ROWS){ curName.append(tabDesc.colNames[curC]); }
+		toFill->colTypes.push_back(curType);
+		toFill->colNames.push_back(curName);
+		toFill->factorColMap.push_back(std::map<std::string,uintptr_t>());
+		toFill->strLengths.push_back(0);
+	}
+}
+void DataTableGroupBy::add(DataTable* toAdd){
+	prepare();
+	uintptr_t numCols = tabDesc.colTypes.size();
+	if(numCols == 0){ return; }
+	uintptr_t numRows = toAdd->saveData.size() / numCols;
+	if(numRows == 0){ return; }
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		((DataTableGroupTask*)(passUnis[i]))->addTab = toAdd;
+	}
+	runTasks(1, numRows);
+	if(overBudget()){
+		if(topSpill == 0){ topSpill = new DataTableGroupSpill(); }
+		spillGroups(topSpill, 0);
+	}
+}
+void DataTableGroupBy::finish(DataTableWriter* toDump){
+	prepare();
+	if(topSpill == 0){
+		dumpGroups(toDump);
+		return;
+	}
+	spillGroups(topSpill, 0);
+	topSpill->close();
+	for(uintptr_t i = 0; i<topSpill->baseNames.size(); i++){
+		groupSpilled(i, topSpill, 0, toDump);
+	}
+	delete(topSpill);
+	topSpill = 0;
+}
+void DataTableGroupBy::prepare(){
+	if(passUnis.size()){ return; }
+	//lay out the key: a known flag then the value for each column, padded out to whole words
+		keyBytes = 0;
+		for(uintptr_t i = 0; i<keyCols.size(); i++){
+			keyOffsets.push_back(keyBytes);
+			uintptr_t curC = keyCols[i];
+			keyBytes += 1;
+			keyBytes += (tabDesc.colTypes[curC] == WHODUN_DATA_STR) ? tabDesc.strLengths[curC] : 8;
+		}
+		keyBytes = 8*((keyBytes + 7) / 8);
+	//make the tasks
+		for(uintptr_t i = 0; i<numThread; i++){
+			DataTableGroupTask* curT = new DataTableGroupTask(this);
+			curT->taskInd = i;
+			passUnis.push_back(curT);
+		}
+}
+int DataTableGroupBy::overBudget(){
+	uintptr_t totalBytes = 0;
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		DataTableGroupHash* curTab = &(((DataTableGroupTask*)(passUnis[i]))->localTab);
+		//the slots are at least half full
+		totalBytes += curTab->numGroups * (curTab->recordBytes + 2*(sizeof(uint64_t) + sizeof(uintptr_t)));
+	}
+	return totalBytes > maxLoad;
+}
+void DataTableGroupBy::spillGroups(DataTableGroupSpill* spillTo, uintptr_t level){
+	dataGroupOpenSpill(spillTo, &tempName, &madeTemp, &numTemps, "group_temp", spillComp, numThread, usePool);
+	//sort everything by partition
+		for(uintptr_t i = 0; i<passUnis.size(); i++){
+			((DataTableGroupTask*)(passUnis[i]))->spillLevel = level;
+		}
+		runTasks(3, passUnis.size());
+	//and write
+		for(uintptr_t i = 0; i<passUnis.size(); i++){
+			DataTableGroupTask* curT = (DataTableGroupTask*)(passUnis[i]);
+			uintptr_t recBytes = curT->localTab.recordBytes;
+			uintptr_t curOff = 0;
+			for(uintptr_t j = 0; j<GROUPBY_SPILL_PARTS; j++){
+				uintptr_t curCount = *(curT->spillCounts[j]);
+				if(curCount){
+					spillTo->outStrs[j]->write(curT->spillData[curOff*recBytes], curCount*recBytes);
+				}
+				spillTo->numRecords[j] += curCount;
+				curOff += curCount;
+			}
+			curT->localTab.clear();
+		}
+}
+void DataTableGroupBy::dumpGroups(DataTableWriter* toDump){
+	//merge the groups from all the tasks
+		std::vector<DataTableGroupHash*> allTabs;
+		if(passUnis.size() == 1){
+			allTabs.push_back(&(((DataTableGroupTask*)(passUnis[0]))->localTab));
+		}
+		else{
+			runTasks(4, passUnis.size());
+			for(uintptr_t i = 0; i<passUnis.size(); i++){
+				DataTableGroupTask* curT = (DataTableGroupTask*)(passUnis[i]);
+				curT->localTab.clear();
+				allTabs.push_back(&(curT->finalTab));
+			}
+		}
+	//write them out
+		uintptr_t numKey = keyCols.size();
+		uintptr_t numOut = numKey + aggTypes.size();
+		uintptr_t statOff = GROUPBY_REC_KEY + keyBytes;
+		for(uintptr_t ti = 0; ti<allTabs.size(); ti++){
+			DataTableGroupHash* curTab = allTabs[ti];
+			uintptr_t gi = 0;
+			while(gi < curTab->numGroups){
+				uintptr_t numDump = std::min((uintptr_t)GROUPBY_DUMP_GROUPS, curTab->numGroups - gi);
+				outTab.saveData.resize(numDump * numOut);
+				outTab.saveText.clear();
+				DataTableEntry* curFill = outTab.saveData[0];
+				for(uintptr_t i = 0; i<numDump; i++){
+					char* curRec = curTab->getRecord(gi + i);
+					//the keys (strings point right into the record)
+					for(uintptr_t k = 0; k<numKey; k++){
+						char* curKey = curRec + GROUPBY_REC_KEY + keyOffsets[k];
+						curFill->isNA = curKey[0];
+						switch(tabDesc.colTypes[keyCols[k]]){
+							case WHODUN_DATA_CAT: memcpy(&(curFill->valC), curKey + 1, 8); break;
+							case WHODUN_DATA_INT: memcpy(&(curFill->valI), curKey + 1, 8); break;
+							case WHODUN_DATA_REAL: memcpy(&(curFill->valR), curKey + 1, 8); break;
+							case WHODUN_DATA_STR: curFill->valS = curKey + 1; break;
+							default:
+								throw std::runtime_error("Unknown column type.");
+						}
+						curFill++;
+					}
+					//the summaries
+					uint64_t numRows; memcpy(&numRows, curRec + statOff, 8);
+					DataTableAggregateAccum* allAcc = (DataTableAggregateAccum*)(curRec + statOff + 8);
+					for(uintptr_t k = 0; k<aggTypes.size(); k++){
+						DataTableAggregateAccum* curAcc = allAcc + aggAccums[k];
+						int isInt = tabDesc.colTypes[aggCols[k]] == WHODUN_DATA_INT;
+						curFill->isNA = 0;
+						switch(aggTypes[k]){
+							case WHODUN_AGGREGATE_ROWS:
+								curFill->valI = numRows;
+								break;
+							case WHODUN_AGGREGATE_COUNT:
+								curFill->valI = curAcc->numKnown;
+								break;
+							case WHODUN_AGGREGATE_SUM:
+								curFill->isNA = curAcc->numKnown == 0;
+								if(isInt){ curFill->valI = curAcc->sumI; } else{ curFill->valR = curAcc->sumR; }
+								break;
+							case WHODUN_AGGREGATE_MEAN:
+								curFill->isNA = curAcc->numKnown == 0;
+								curFill->valR = curAcc->mean;
+								break;
+							case WHODUN_AGGREGATE_MIN:
+								curFill->isNA = curAcc->numKnown == 0;
+								if(isInt){ curFill->valI = curAcc->minI; } else{ curFill->valR = curAcc->minR; }
+								break;
+							case WHODUN_AGGREGATE_MAX:
+								curFill->isNA = curAcc->numKnown == 0;
+								if(isInt){ curFill->valI = curAcc->maxI; } else{ curFill->valR = curAcc->maxR; }
+								break;
+							case WHODUN_AGGREGATE_VAR:
+								curFill->isNA = curAcc->numKnown < 2;
+								curFill->valR = curFill->isNA ? 0.0 : (curAcc->sumSqDev / (curAcc->numKnown - 1));
+								break;
+						}
+						curFill++;
+					}
+				}
+				toDump->write(&outTab);
+				gi += numDump;
+			}
+			curTab->clear();
+		}
+}
+void DataTableGroupBy::groupSpilled(uintptr_t fileInd, DataTableGroupSpill* spillFrom, uintptr_t level, DataTableWriter* toDump){
+	uintmax_t numLeft = spillFrom->numRecords[fileInd];
+	if(numLeft == 0){ return; }
+	uintptr_t recBytes = ((DataTableGroupTask*)(passUnis[0]))->localTab.recordBytes;
+	DataTableGroupSpill* subSpill = 0;
+	try{
+		//load it up
+			BlockCompInStream* readStr = dataGroupReadSpill(spillFrom, fileInd, spillComp, numThread, usePool);
+			try{
+				while(numLeft){
+					uintptr_t numLoad = std::min((uintmax_t)GROUPBY_LOAD_RECORDS, numLeft);
+					loadRecords.resize(numLoad * recBytes);
+					readStr->forceRead(loadRecords[0], numLoad * recBytes);
+					for(uintptr_t i = 0; i<passUnis.size(); i++){
+						((DataTableGroupTask*)(passUnis[i]))->addRecords = loadRecords[0];
+					}
+					runTasks(2, numLoad);
+					numLeft -= numLoad;
+					if((level < GROUPBY_SPILL_MAXLEVEL) && overBudget()){
+						if(subSpill == 0){ subSpill = new DataTableGroupSpill(); }
+						spillGroups(subSpill, level + 1);
+					}
+				}
+			}
+			catch(std::exception& errE){
+				readStr->close(); delete(readStr);
+				throw;
+			}
+			readStr->close(); delete(readStr);
+			dataGroupKillSpill(spillFrom, fileInd);
+		//either dump or go down a level
+			if(subSpill){
+				spillGroups(subSpill, level + 1);
+				subSpill->close();
+				for(uintptr_t i = 0; i<subSpill->baseNames.size(); i++){
+					groupSpilled(i, subSpill, level + 1, toDump);
+				}
+				delete(subSpill);
+			}
+			else{
+				dumpGroups(toDump);
+			}
+	}
+	catch(std::exception& errE){
+		if(subSpill){ delete(subSpill); }
+		throw;
+	}
+}
+void DataTableGroupBy::runTasks(uintptr_t phase, uintptr_t numItems){
+	uintptr_t numPT = numItems / numThread;
+	uintptr_t numET = numItems % numThread;
+	uintptr_t curI = 0;
+	for(uintptr_t i = 0; i<numThread; i++){
+		DataTableGroupTask* curT = (DataTableGroupTask*)(passUnis[i]);
+		curT->phase = phase;
+		curT->fromI = curI;
+		curI += (numPT + (i<numET));
+		curT->toI = curI;
+	}
+	if(usePool){
+		usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
+		joinTasks(numThread, &(passUnis[0]));
+	}
+	else{
+		for(uintptr_t i = 0; i<numThread; i++){
+			passUnis[i]->doTask();
+		}
+	}
+}
+
+DataTableGroupTask::DataTableGroupTask(DataTableGroupBy* forGroup) : localTab(forGroup->keyBytes, forGroup->accumCols.size()), finalTab(forGroup->keyBytes, forGroup->accumCols.size()){
+	myGroup = forGroup;
+	keyStore.resize(forGroup->keyBytes);
+	spillCounts.resize(GROUPBY_SPILL_PARTS);
+}
+DataTableGroupTask::~DataTableGroupTask(){}
+void DataTableGroupTask::doTask(){
+	DataTableGroupBy* forG = myGroup;
+	uintptr_t keyBytes = forG->keyBytes;
+	uintptr_t statOff = GROUPBY_REC_KEY + keyBytes;
+	uintptr_t numAcc = forG->accumCols.size();
+	if(phase == 1){
+		uintptr_t numCols = forG->tabDesc.colTypes.size();
+		uintptr_t numKey = forG->keyCols.size();
+		char* curKey = keyStore[0];
+		for(uintptr_t ri = fromI; ri<toI; ri++){
+			DataTableEntry* curRow = addTab->saveData[ri*numCols];
+			//build the key
+				if(keyBytes){ memset(curKey, 0, keyBytes); }
+				for(uintptr_t k = 0; k<numKey; k++){
+					uintptr_t curC = forG->keyCols[k];
+					DataTableEntry* curE = curRow + curC;
+					char* curKP = curKey + forG->keyOffsets[k];
+					if(curE->isNA){
+						curKP[0] = 1;
+						continue;
+					}
+					switch(forG->tabDesc.colTypes[curC]){
+						case WHODUN_DATA_CAT: memcpy(curKP + 1, &(curE->valC), 8); break;
+						case WHODUN_DATA_INT: memcpy(curKP + 1, &(curE->valI), 8); break;
+						case WHODUN_DATA_REAL:{
+							double curV = curE->valR;
+							if(curV == 0.0){ curV = 0.0; }
+							if(curV != curV){ curV = NAN; }
+							memcpy(curKP + 1, &curV, 8);
+						} break;
+						case WHODUN_DATA_STR:{
+							uintptr_t maxLen = forG->tabDesc.strLengths[curC];
+							const char* endS = (const char*)memchr(curE->valS, 0, maxLen);
+							memcpy(curKP + 1, curE->valS, endS ? (endS - curE->valS) : maxLen);
+						} break;
+						default:
+							throw std::runtime_error("Unknown column type.");
+					}
+				}
+			//find the group
+				int wasNew;
+				char* curRec = localTab.findOrAdd(dataGroupHashKey(curKey, keyBytes), curKey, &wasNew);
+				if(wasNew){ memset(curRec + statOff, 0, 8 + numAcc*sizeof(DataTableAggregateAccum)); }
+			//and add to it
+				uint64_t numRows; memcpy(&numRows, curRec + statOff, 8);
+				numRows++;
+				memcpy(curRec + statOff, &numRows, 8);
+				DataTableAggregateAccum* curAcc = (DataTableAggregateAccum*)(curRec + statOff + 8);
+				for(uintptr_t k = 0; k<numAcc; k++){
+					uintptr_t curC = forG->accumCols[k];
+					DataTableEntry* curE = curRow + curC;
+					if(curE->isNA){ continue; }
+					double curV;
+					switch(forG->tabDesc.colTypes[curC]){
+						case WHODUN_DATA_INT:
+							if(curAcc[k].numKnown == 0){ curAcc[k].minI = curE->valI; curAcc[k].maxI = curE->valI; }
+							curAcc[k].sumI = (int64_t)((uint64_t)(curAcc[k].sumI) + (uint64_t)(curE->valI));
+							curAcc[k].minI = std::min(curAcc[k].minI, curE->valI);
+							curAcc[k].maxI = std::max(curAcc[k].maxI, curE->valI);
+							curV = curE->valI;
+							break;
+						case WHODUN_DATA_REAL:
+							if(curAcc[k].numKnown == 0){ curAcc[k].minR = curE->valR; curAcc[k].maxR = curE->valR; }
+							curAcc[k].sumR += curE->valR;
+							curAcc[k].minR = std::min(curAcc[k].minR, curE->valR);
+							curAcc[k].maxR = std::max(curAcc[k].maxR, curE->valR);
+							curV = curE->valR;
+							break;
+						default:
+							curAcc[k].numKnown++;
+							continue;
+					}
+					curAcc[k].numKnown++;
+					double delta = curV - curAcc[k].mean;
+					curAcc[k].mean += delta / curAcc[k].numKnown;
+					curAcc[k].sumSqDev += delta * (curV - curAcc[k].mean);
+				}
+		}
+	}
+	else if(phase == 2){
+		uintptr_t recBytes = localTab.recordBytes;
+		for(uintptr_t ri = fromI; ri<toI; ri++){
+			char* fromRec = addRecords + ri*recBytes;
+			uint64_t curH; memcpy(&curH, fromRec, 8);
+			int wasNew;
+			char* curRec = localTab.findOrAdd(curH, fromRec + GROUPBY_REC_KEY, &wasNew);
+			if(wasNew){ memcpy(curRec + statOff, fromRec + statOff, recBytes - statOff); }
+			else{ dataGroupMergeRecord(forG, curRec, fromRec); }
+		}
+	}
+	else if(phase == 3){
+		uintptr_t recBytes = localTab.recordBytes;
+		uintptr_t numG = localTab.numGroups;
+		uintptr_t partShift = 64 - GROUPBY_SPILL_BITS*(spillLevel + 1);
+		uintptr_t* partCount = spillCounts[0];
+		//count
+			memset(partCount, 0, GROUPBY_SPILL_PARTS*sizeof(uintptr_t));
+			for(uintptr_t i = 0; i<numG; i++){
+				uint64_t curH; memcpy(&curH, localTab.getRecord(i), 8);
+				partCount[(curH >> partShift) & (GROUPBY_SPILL_PARTS-1)]++;
+			}
+		//and place
+			uintptr_t partNext[GROUPBY_SPILL_PARTS];
+			uintptr_t curTot = 0;
+			for(uintptr_t i = 0; i<GROUPBY_SPILL_PARTS; i++){
+				partNext[i] = curTot;
+				curTot += partCount[i];
+			}
+			spillData.resize(numG * recBytes);
+			for(uintptr_t i = 0; i<numG; i++){
+				char* curRec = localTab.getRecord(i);
+				uint64_t curH; memcpy(&curH, curRec, 8);
+				uintptr_t curP = (curH >> partShift) & (GROUPBY_SPILL_PARTS-1);
+				memcpy(spillData[partNext[curP]*recBytes], curRec, recBytes);
+				partNext[curP]++;
+			}
+	}
+	else{
+		uintptr_t numThread = forG->passUnis.size();
+		uintptr_t recBytes = finalTab.recordBytes;
+		finalTab.clear();
+		for(uintptr_t ti = 0; ti<numThread; ti++){
+			DataTableGroupHash* fromTab = &(((DataTableGroupTask*)(forG->passUnis[ti]))->localTab);
+			for(uintptr_t i = 0; i<fromTab->numGroups; i++){
+				char* fromRec = fromTab->getRecord(i);
+				uint64_t curH; memcpy(&curH, fromRec, 8);
+				if(dataGroupMergeTask(curH, numThread) != taskInd){ continue; }
+				int wasNew;
+				char* curRec = finalTab.findOrAdd(curH, fromRec + GROUPBY_REC_KEY, &wasNew);
+				if(wasNew){ memcpy(curRec + statOff, fromRec + statOff, recBytes - statOff); }
+				else{ dataGroupMergeRecord(forG, curRec, fromRec); }
+			}
+		}
+	}
+}
+
+
+DataTableJoinHash::DataTableJoinHash(uintptr_t keyBytes){
+	this->keyBytes = keyBytes;
+	numKeys = 0;
+	numEntries = 0;
+	slotHash.resize(64);
+	slotEntry.resize(64);
+	memset(slotEntry[0], 0, 64*sizeof(uintptr_t));
+}
+DataTableJoinHash::~DataTableJoinHash(){}
+void DataTableJoinHash::add(uint64_t hashV, char* record){
+	//make room, if needed
+	uintptr_t numSlots = slotEntry.size();
+	if(2*(numKeys + 1) > numSlots){
+		uintptr_t newSlots = 2*numSlots;
+		StructVector<uint64_t> newHash(newSlots);
+		StructVector<uintptr_t> newEntry(newSlots);
+		memset(newEntry[0], 0, newSlots*sizeof(uintptr_t));
+		uintptr_t newMask = newSlots - 1;
+		for(uintptr_t i = 0; i<numSlots; i++){
+			uintptr_t curE = *(slotEntry[i]);
+			if(curE == 0){ continue; }
+			uint64_t curH = *(slotHash[i]);
+			uintptr_t curS = curH & newMask;
+			while(*(newEntry[curS])){ curS = (curS + 1) & newMask; }
+			*(newHash[curS]) = curH;
+			*(newEntry[curS]) = curE;
+		}
+		slotHash = newHash;
+		slotEntry = newEntry;
+		numSlots = newSlots;
+	}
+	//make the entry
+	entryRecs.resize(numEntries + 1);
+	entryNext.resize(numEntries + 1);
+	*(entryRecs[numEntries]) = record;
+	numEntries++;
+	//look for the key
+	uintptr_t slotMask = numSlots - 1;
+	uintptr_t curS = hashV & slotMask;
+	uint64_t* allHash = slotHash[0];
+	uintptr_t* allEntry = slotEntry[0];
+	while(allEntry[curS]){
+		if(allHash[curS] == hashV){
+			char* curRec = *(entryRecs[allEntry[curS]-1]);
+			if(memcmp(curRec + GROUPBY_REC_KEY, record + GROUPBY_REC_KEY, keyBytes) == 0){
+				*(entryNext[numEntries-1]) = allEntry[curS];
+				allEntry[curS] = numEntries;
+				return;
+			}
+		}
+		curS = (curS + 1) & slotMask;
+	}
+	//new key
+	*(entryNext[numEntries-1]) = 0;
+	allHash[curS] = hashV;
+	allEntry[curS] = numEntries;
+	numKeys++;
+}
+uintptr_t DataTableJoinHash::find(uint64_t hashV, const char* keyData){
+	uintptr_t slotMask = slotEntry.size() - 1;
+	uintptr_t curS = hashV & slotMask;
+	uint64_t* allHash = slotHash[0];
+	uintptr_t* allEntry = slotEntry[0];
+	while(allEntry[curS]){
+		if(allHash[curS] == hashV){
+			char* curRec = *(entryRecs[allEntry[curS]-1]);
+			if(memcmp(curRec + GROUPBY_REC_KEY, keyData, keyBytes) == 0){
+				return allEntry[curS];
+			}
+		}
+		curS = (curS + 1) & slotMask;
+	}
+	return 0;
+}
+uintptr_t DataTableJoinHash::next(uintptr_t entryInd){
+	return *(entryNext[entryInd-1]);
+}
+char* DataTableJoinHash::getRecord(uintptr_t entryInd){
+	return *(entryRecs[entryInd-1]);
+}
+void DataTableJoinHash::clear(){
+	numKeys = 0;
+	numEntries = 0;
+	entryRecs.clear();
+	entryNext.clear();
+	memset(slotEntry[0], 0, slotEntry.size()*sizeof(uintptr_t));
+}
+
+DataTableHashJoin::DataTableHashJoin(DataTableDescription* buildData, DataTableDescription* probeData, int joinType, const char* workDirName){
+	maxLoad = 0x20000000;
+	spillComp = &defaultSpillComp;
+	defaultSpillComp.compLevel = Z_BEST_SPEED;
+	this->joinType = joinType;
+	buildDesc = *buildData;
+	probeDesc = *probeData;
+	keyBytes = 0;
+	buildRecBytes = 0;
+	probeRecBytes = 0;
+	tempName = workDirName;
+	madeTemp = 0;
+	numTemps = 0;
+	numThread = 1;
+	usePool = 0;
+	buildDone = 0;
+	numBuild = 0;
+	topBuildSpill = 0;
+	topProbeSpill = 0;
+}
+DataTableHashJoin::DataTableHashJoin(DataTableDescription* buildData, DataTableDescription* probeData, int joinType, const char* workDirName, uintptr_t numThread, ThreadPool* mainPool){
+	maxLoad = 0x20000000;
+	spillComp = &defaultSpillComp;
+	defaultSpillComp.compLevel = Z_BEST_SPEED;
+	this->joinType = joinType;
+	buildDesc = *buildData;
+	probeDesc = *probeData;
+	keyBytes = 0;
+	buildRecBytes = 0;
+	probeRecBytes = 0;
+	tempName = workDirName;
+	madeTemp = 0;
+	numTemps = 0;
+	this->numThread = numThread;
+	usePool = mainPool;
+	buildDone = 0;
+	numBuild = 0;
+	topBuildSpill = 0;
+	topProbeSpill = 0;
+}
+DataTableHashJoin::~DataTableHashJoin(){
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		delete(passUnis[i]);
+	}
+	if(topBuildSpill){ delete(topBuildSpill); }
+	if(topProbeSpill){ delete(topProbeSpill); }
+	if(madeTemp){ directoryKill(tempName.c_str()); }
+}
+void DataTableHashJoin::addKey(uintptr_t buildCol, uintptr_t probeCol){
+	if(passUnis.size()){ throw std::runtime_error("Keys must be set before adding data."); }
+	if(buildCol >= buildDesc.colTypes.size()){ throw std::runtime_error("Build key column out of range."); }
+	if(probeCol >= probeDesc.colTypes.size()){ throw std::runtime_error("Probe key column out of range."); }
+	uintptr_t colType = buildDesc.colTypes[buildCol];
+	if(colType != probeDesc.colTypes[probeCol]){ throw std::runtime_error("Key columns must have the same type."); }
+	//categories are matched by name
+	std::vector<uint64_t> catMap;
+	if(colType == WHODUN_DATA_CAT){
+		std::map<std::string,uintptr_t>* buildMap = &(buildDesc.factorColMap[buildCol]);
+		std::map<std::string,uintptr_t>* probeMap = &(probeDesc.factorColMap[probeCol]);
+		if(*buildMap != *probeMap){
+			catMap.resize(probeMap->size(), HASHJOIN_MISSING_LEVEL);
+			for(std::map<std::string,uintptr_t>::iterator curIt = probeMap->begin(); curIt != probeMap->end(); curIt++){
+				std::map<std::string,uintptr_t>::iterator buildIt = buildMap->find(curIt->first);
+				if(curIt->second >= catMap.size()){ catMap.resize(curIt->second + 1, HASHJOIN_MISSING_LEVEL); }
+				if(buildIt != buildMap->end()){ catMap[curIt->second] = buildIt->second; }
+			}
+		}
+	}
+	buildKeys.push_back(buildCol);
+	probeKeys.push_back(probeCol);
+	probeCatMaps.push_back(catMap);
+}
+void DataTableHashJoin::getResultDescription(DataTableDescription* toFill){
+	toFill->colTypes = probeDesc.colTypes;
+	toFill->colNames = probeDesc.colNames;
+	toFill->factorColMap = probeDesc.factorColMap;
+	toFill->strLengths = probeDesc.strLengths;
+	for(uintptr_t i = 0; i<buildDesc.colTypes.size(); i++){
+		if(std::find(buildKeys.begin(), buildKeys.end(), i) != buildKeys.end()){ continue; }
+		toFill->colTypes.push_back(buildDesc.colTypes[i]);
+		toFill->colNames.push_back(buildDesc.colNames[i]);
+		toFill->factorColMap.push_back(buildDesc.factorColMap[i]);
+		toFill->strLengths.push_back(buildDesc.strLengths[i]);
+	}
+}
+void DataTableHashJoin::addBuild(DataTable* toAdd){
+	prepare();
+	if(buildDone){ throw std::runtime_error("Build rows must be added before probing."); }
+	uintptr_t numAdd = packRows(toAdd, 0);
+	if(numAdd == 0){ return; }
+	if(topBuildSpill){
+		spillRecords(stageData[0], numAdd, buildRecBytes, topBuildSpill, 0);
+		return;
+	}
+	buildData.resize((numBuild + numAdd)*buildRecBytes);
+	memcpy(buildData[numBuild*buildRecBytes], stageData[0], numAdd*buildRecBytes);
+	numBuild += numAdd;
+	if(overBudget()){
+		topBuildSpill = new DataTableGroupSpill();
+		spillRecords(buildData[0], numBuild, buildRecBytes, topBuildSpill, 0);
+		buildData.clear();
+		numBuild = 0;
+	}
+}
+void DataTableHashJoin::addProbe(DataTable* toAdd, DataTableWriter* toDump){
+	finishBuild();
+	uintptr_t numAdd = packRows(toAdd, 1);
+	if(numAdd == 0){ return; }
+	if(topBuildSpill){
+		if(topProbeSpill == 0){ topProbeSpill = new DataTableGroupSpill(); }
+		spillRecords(stageData[0], numAdd, probeRecBytes, topProbeSpill, 0);
+		return;
+	}
+	probeRecords(stageData[0], numAdd, toDump);
+}
+void DataTableHashJoin::finish(DataTableWriter* toDump){
+	finishBuild();
+	if(topProbeSpill){
+		topProbeSpill->close();
+		for(uintptr_t i = 0; i<topProbeSpill->baseNames.size(); i++){
+			joinSpilled(i, topBuildSpill, topProbeSpill, 0, toDump);
+		}
+	}
+	if(topBuildSpill){ delete(topBuildSpill); topBuildSpill = 0; }
+	if(topProbeSpill){ delete(topProbeSpill); topProbeSpill = 0; }
+}
+void DataTableHashJoin::prepare(){
+	if(passUnis.size()){ return; }
+	//lay out the key: a known flag then the value for each column, padded out to whole words
+		keyBytes = 0;
+		for(uintptr_t i = 0; i<buildKeys.size(); i++){
+			uintptr_t curW = 8;
+			if(buildDesc.colTypes[buildKeys[i]] == WHODUN_DATA_STR){
+				curW = std::max(buildDesc.strLengths[buildKeys[i]], probeDesc.strLengths[probeKeys[i]]);
+			}
+			keyOffsets.push_back(keyBytes);
+			keyWidths.push_back(curW);
+			keyBytes += (1 + curW);
+		}
+		keyBytes = 8*((keyBytes + 7) / 8);
+	//lay out the records: hash, key, then the columns to copy out
+		buildRecBytes = GROUPBY_REC_KEY + keyBytes;
+		for(uintptr_t i = 0; i<buildDesc.colTypes.size(); i++){
+			if(std::find(buildKeys.begin(), buildKeys.end(), i) != buildKeys.end()){ continue; }
+			buildOutCols.push_back(i);
+			buildOffsets.push_back(buildRecBytes);
+			buildRecBytes += 1 + ((buildDesc.colTypes[i] == WHODUN_DATA_STR) ? buildDesc.strLengths[i] : 8);
+		}
+		buildRecBytes = 8*((buildRecBytes + 7) / 8);
+		probeRecBytes = GROUPBY_REC_KEY + keyBytes;
+		for(uintptr_t i = 0; i<probeDesc.colTypes.size(); i++){
+			probeOffsets.push_back(probeRecBytes);
+			probeRecBytes += 1 + ((probeDesc.colTypes[i] == WHODUN_DATA_STR) ? probeDesc.strLengths[i] : 8);
+		}
+		probeRecBytes = 8*((probeRecBytes + 7) / 8);
+	//unmatched rows need something to point at
+		uintptr_t maxStr = 1;
+		for(uintptr_t i = 0; i<buildDesc.strLengths.size(); i++){ maxStr = std::max(maxStr, buildDesc.strLengths[i]); }
+		blankText.resize(maxStr);
+		memset(blankText[0], 0, maxStr);
+	//make the tasks
+		for(uintptr_t i = 0; i<numThread; i++){
+			DataTableJoinTask* curT = new DataTableJoinTask(this);
+			curT->taskInd = i;
+			passUnis.push_back(curT);
+		}
+}
+int DataTableHashJoin::overBudget(){
+	//the slots are at least half full
+	uintptr_t perRec = buildRecBytes + sizeof(char*) + sizeof(uintptr_t) + 2*(sizeof(uint64_t) + sizeof(uintptr_t));
+	return (numBuild * perRec) > maxLoad;
+}
+uintptr_t DataTableHashJoin::packRows(DataTable* toPack, int isProbe){
+	prepare();
+	uintptr_t numCols = isProbe ? probeDesc.colTypes.size() : buildDesc.colTypes.size();
+	if(numCols == 0){ return 0; }
+	uintptr_t numRows = toPack->saveData.size() / numCols;
+	if(numRows == 0){ return 0; }
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+		curT->packTab = toPack;
+		curT->packProbe = isProbe;
+	}
+	runTasks(1, numRows);
+	uintptr_t recBytes = isProbe ? probeRecBytes : buildRecBytes;
+	uintptr_t numPack = 0;
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		numPack += ((DataTableJoinTask*)(passUnis[i]))->packCount;
+	}
+	stageData.resize(numPack * recBytes);
+	uintptr_t curOff = 0;
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+		if(curT->packCount == 0){ continue; }
+		memcpy(stageData[curOff], curT->packData[0], curT->packCount * recBytes);
+		curOff += curT->packCount * recBytes;
+	}
+	return numPack;
+}
+void DataTableHashJoin::spillRecords(char* records, uintptr_t numRecords, uintptr_t recBytes, DataTableGroupSpill* spillTo, uintptr_t level){
+	dataGroupOpenSpill(spillTo, &tempName, &madeTemp, &numTemps, "join_temp", spillComp, numThread, usePool);
+	//sort everything by partition
+		for(uintptr_t i = 0; i<passUnis.size(); i++){
+			DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+			curT->srcData = records;
+			curT->srcRecBytes = recBytes;
+			curT->spillLevel = level;
+		}
+		runTasks(2, numRecords);
+	//and write
+		for(uintptr_t i = 0; i<passUnis.size(); i++){
+			DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+			uintptr_t curOff = 0;
+			for(uintptr_t j = 0; j<GROUPBY_SPILL_PARTS; j++){
+				uintptr_t curCount = *(curT->spillCounts[j]);
+				if(curCount){
+					spillTo->outStrs[j]->write(curT->spillData[curOff*recBytes], curCount*recBytes);
+				}
+				spillTo->numRecords[j] += curCount;
+				curOff += curCount;
+			}
+		}
+}
+void DataTableHashJoin::hashBuild(){
+	runTasks(3, numThread);
+}
+void DataTableHashJoin::probeRecords(char* records, uintptr_t numRecords, DataTableWriter* toDump){
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+		curT->srcData = records;
+		curT->srcRecBytes = probeRecBytes;
+	}
+	runTasks(4, numRecords);
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+		if(curT->outTab.saveData.size()){ toDump->write(&(curT->outTab)); }
+	}
+}
+void DataTableHashJoin::finishBuild(){
+	prepare();
+	if(buildDone){ return; }
+	buildDone = 1;
+	if(topBuildSpill){
+		topBuildSpill->close();
+	}
+	else{
+		hashBuild();
+	}
+}
+void DataTableHashJoin::joinSpilled(uintptr_t fileInd, DataTableGroupSpill* buildFrom, DataTableGroupSpill* probeFrom, uintptr_t level, DataTableWriter* toDump){
+	uintmax_t numProbeLeft = probeFrom->numRecords[fileInd];
+	uintmax_t numBuildLeft = buildFrom->numRecords[fileInd];
+	if((numProbeLeft == 0) || ((numBuildLeft == 0) && (joinType == WHODUN_JOIN_INNER))){
+		dataGroupKillSpill(buildFrom, fileInd);
+		dataGroupKillSpill(probeFrom, fileInd);
+		return;
+	}
+	DataTableGroupSpill* subBuild = 0;
+	DataTableGroupSpill* subProbe = 0;
+	BlockCompInStream* readStr = 0;
+	try{
+		//load up the build side, spilling further if too big
+			buildData.clear();
+			numBuild = 0;
+			readStr = dataGroupReadSpill(buildFrom, fileInd, spillComp, numThread, usePool);
+			while(numBuildLeft){
+				uintptr_t numLoad = std::min((uintmax_t)GROUPBY_LOAD_RECORDS, numBuildLeft);
+				if(subBuild){
+					stageData.resize(numLoad * buildRecBytes);
+					readStr->forceRead(stageData[0], numLoad * buildRecBytes);
+					spillRecords(stageData[0], numLoad, buildRecBytes, subBuild, level + 1);
+				}
+				else{
+					buildData.resize((numBuild + numLoad) * buildRecBytes);
+					readStr->forceRead(buildData[numBuild * buildRecBytes], numLoad * buildRecBytes);
+					numBuild += numLoad;
+					if((level < GROUPBY_SPILL_MAXLEVEL) && overBudget()){
+						subBuild = new DataTableGroupSpill();
+						spillRecords(buildData[0], numBuild, buildRecBytes, subBuild, level + 1);
+						buildData.clear();
+						numBuild = 0;
+					}
+				}
+				numBuildLeft -= numLoad;
+			}
+			readStr->close(); delete(readStr); readStr = 0;
+			dataGroupKillSpill(buildFrom, fileInd);
+		//either split the probe side up too, or run it
+			if(subBuild){
+				subBuild->close();
+				subProbe = new DataTableGroupSpill();
+				readStr = dataGroupReadSpill(probeFrom, fileInd, spillComp, numThread, usePool);
+				while(numProbeLeft){
+					uintptr_t numLoad = std::min((uintmax_t)GROUPBY_LOAD_RECORDS, numProbeLeft);
+					stageData.resize(numLoad * probeRecBytes);
+					readStr->forceRead(stageData[0], numLoad * probeRecBytes);
+					spillRecords(stageData[0], numLoad, probeRecBytes, subProbe, level + 1);
+					numProbeLeft -= numLoad;
+				}
+				readStr->close(); delete(readStr); readStr = 0;
+				dataGroupKillSpill(probeFrom, fileInd);
+				subProbe->close();
+				for(uintptr_t i = 0; i<subProbe->baseNames.size(); i++){
+					joinSpilled(i, subBuild, subProbe, level + 1, toDump);
+				}
+				delete(subBuild); subBuild = 0;
+				delete(subProbe); subProbe = 0;
+			}
+			else{
+				hashBuild();
+				readStr = dataGroupReadSpill(probeFrom, fileInd, spillComp, numThread, usePool);
+				while(numProbeLeft){
+					uintptr_t numLoad = std::min((uintmax_t)GROUPBY_LOAD_RECORDS, numProbeLeft);
+					stageData.resize(numLoad * probeRecBytes);
+					readStr->forceRead(stageData[0], numLoad * probeRecBytes);
+					probeRecords(stageData[0], numLoad, toDump);
+					numProbeLeft -= numLoad;
+				}
+				readStr->close(); delete(readStr); readStr = 0;
+				dataGroupKillSpill(probeFrom, fileInd);
+				buildData.clear();
+				numBuild = 0;
+			}
+	}
+	catch(std::exception& errE){
+		if(readStr){ readStr->close(); delete(readStr); }
+		if(subBuild){ delete(subBuild); }
+		if(subProbe){ delete(subProbe); }
+		throw;
+	}
+}
+void DataTableHashJoin::runTasks(uintptr_t phase, uintptr_t numItems){
+	uintptr_t numPT = numItems / numThread;
+	uintptr_t numET = numItems % numThread;
+	uintptr_t curI = 0;
+	for(uintptr_t i = 0; i<numThread; i++){
+		DataTableJoinTask* curT = (DataTableJoinTask*)(passUnis[i]);
+		curT->phase = phase;
+		curT->fromI = curI;
+		curI += (numPT + (i<numET));
+		curT->toI = curI;
+	}
+	if(usePool){
+		usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
+		joinTasks(numThread, &(passUnis[0]));
+	}
+	else{
+		for(uintptr_t i = 0; i<numThread; i++){
+			passUnis[i]->doTask();
+		}
+	}
+}
+
+DataTableJoinTask::DataTableJoinTask(DataTableHashJoin* forJoin) : joinTab(forJoin->keyBytes){
+	myJoin = forJoin;
+	spillCounts.resize(GROUPBY_SPILL_PARTS);
+}
+DataTableJoinTask::~DataTableJoinTask(){}
+void DataTableJoinTask::doTask(){
+	DataTableHashJoin* forJ = myJoin;
+	uintptr_t keyBytes = forJ->keyBytes;
+	if(phase == 1){
+		DataTableDescription* useDesc = packProbe ? &(forJ->probeDesc) : &(forJ->buildDesc);
+		std::vector<uintptr_t>* useKeys = packProbe ? &(forJ->probeKeys) : &(forJ->buildKeys);
+		std::vector<uintptr_t>* useOffsets = packProbe ? &(forJ->probeOffsets) : &(forJ->buildOffsets);
+		uintptr_t recBytes = packProbe ? forJ->probeRecBytes : forJ->buildRecBytes;
+		uintptr_t numCols = useDesc->colTypes.size();
+		uintptr_t numKey = useKeys->size();
+		uintptr_t numPay = useOffsets->size();
+		//unmatchable rows are only kept if they need to show up
+		int keepNA = packProbe && (forJ->joinType == WHODUN_JOIN_LEFT);
+		packData.resize((toI - fromI) * recBytes);
+		packCount = 0;
+		for(uintptr_t ri = fromI; ri<toI; ri++){
+			DataTableEntry* curRow = packTab->saveData[ri*numCols];
+			char* curRec = packData[packCount*recBytes];
+			memset(curRec, 0, recBytes);
+			//build the key
+				int anyNA = 0;
+				char* curKey = curRec + GROUPBY_REC_KEY;
+				for(uintptr_t k = 0; k<numKey; k++){
+					uintptr_t curC = (*useKeys)[k];
+					DataTableEntry* curE = curRow + curC;
+					char* curKP = curKey + forJ->keyOffsets[k];
+					if(curE->isNA){
+						curKP[0] = 1;
+						anyNA = 1;
+						continue;
+					}
+					switch(useDesc->colTypes[curC]){
+						case WHODUN_DATA_CAT:{
+							uint64_t curV = curE->valC;
+							std::vector<uint64_t>* catMap = &(forJ->probeCatMaps[k]);
+							if(packProbe && catMap->size()){
+								curV = (curV < catMap->size()) ? (*catMap)[curV] : HASHJOIN_MISSING_LEVEL;
+							}
+							memcpy(curKP + 1, &curV, 8);
+						} break;
+						case WHODUN_DATA_INT: memcpy(curKP + 1, &(curE->valI), 8); break;
+						case WHODUN_DATA_REAL:{
+							double curV = curE->valR;
+							if(curV == 0.0){ curV = 0.0; }
+							if(curV != curV){ curV = NAN; }
+							memcpy(curKP + 1, &curV, 8);
+						} break;
+						case WHODUN_DATA_STR:{
+							uintptr_t maxLen = useDesc->strLengths[curC];
+							const char* endS = (const char*)memchr(curE->valS, 0, maxLen);
+							memcpy(curKP + 1, curE->valS, endS ? (endS - curE->valS) : maxLen);
+						} break;
+						default:
+							throw std::runtime_error("Unknown column type.");
+					}
+				}
+				if(anyNA && !keepNA){ continue; }
+				uint64_t curH = dataGroupHashKey(curKey, keyBytes);
+				memcpy(curRec, &curH, 8);
+			//copy the rest
+				for(uintptr_t k = 0; k<numPay; k++){
+					uintptr_t curC = packProbe ? k : forJ->buildOutCols[k];
+					DataTableEntry* curE = curRow + curC;
+					char* curPP = curRec + (*useOffsets)[k];
+					if(curE->isNA){
+						curPP[0] = 1;
+						continue;
+					}
+					switch(useDesc->colTypes[curC]){
+						case WHODUN_DATA_CAT: memcpy(curPP + 1, &(curE->valC), 8); break;
+						case WHODUN_DATA_INT: memcpy(curPP + 1, &(curE->valI), 8); break;
+						case WHODUN_DATA_REAL: memcpy(curPP + 1, &(curE->valR), 8); break;
+						case WHODUN_DATA_STR:{
+							uintptr_t maxLen = useDesc->strLengths[curC];
+							const char* endS = (const char*)memchr(curE->valS, 0, maxLen);
+							memcpy(curPP + 1, curE->valS, endS ? (endS - curE->valS) : maxLen);
+						} break;
+						default:
+							throw std::runtime_error("Unknown column type.");
+					}
+				}
+			packCount++;
+		}
+	}
+	else if(phase == 2){
+		uintptr_t recBytes = srcRecBytes;
+		uintptr_t numR = toI - fromI;
+		uintptr_t partShift = 64 - GROUPBY_SPILL_BITS*(spillLevel + 1);
+		uintptr_t* partCount = spillCounts[0];
+		//count
+			memset(partCount, 0, GROUPBY_SPILL_PARTS*sizeof(uintptr_t));
+			for(uintptr_t i = fromI; i<toI; i++){
+				uint64_t curH; memcpy(&curH, srcData + i*recBytes, 8);
+				partCount[(curH >> partShift) & (GROUPBY_SPILL_PARTS-1)]++;
+			}
+		//and place
+			uintptr_t partNext[GROUPBY_SPILL_PARTS];
+			uintptr_t curTot = 0;
+			for(uintptr_t i = 0; i<GROUPBY_SPILL_PARTS; i++){
+				partNext[i] = curTot;
+				curTot += partCount[i];
+			}
+			spillData.resize(numR * recBytes);
+			for(uintptr_t i = fromI; i<toI; i++){
+				char* curRec = srcData + i*recBytes;
+				uint64_t curH; memcpy(&curH, curRec, 8);
+				uintptr_t curP = (curH >> partShift) & (GROUPBY_SPILL_PARTS-1);
+				memcpy(spillData[partNext[curP]*recBytes], curRec, recBytes);
+				partNext[curP]++;
+			}
+	}
+	else if(phase == 3){
+		uintptr_t numThread = forJ->passUnis.size();
+		uintptr_t recBytes = forJ->buildRecBytes;
+		joinTab.clear();
+		//go backwards, so records with the same key come out in order
+		uintptr_t i = forJ->numBuild;
+		while(i){
+			i--;
+			char* curRec = forJ->buildData[i*recBytes];
+			uint64_t curH; memcpy(&curH, curRec, 8);
+			if((numThread > 1) && (dataGroupMergeTask(curH, numThread) != taskInd)){ continue; }
+			joinTab.add(curH, curRec);
+		}
+	}
+	else{
+		uintptr_t numThread = forJ->passUnis.size();
+		uintptr_t recBytes = srcRecBytes;
+		outTab.saveData.clear();
+		for(uintptr_t ri = fromI; ri<toI; ri++){
+			char* curRec = srcData + ri*recBytes;
+			uint64_t curH; memcpy(&curH, curRec, 8);
+			DataTableJoinHash* lookTab = &(((DataTableJoinTask*)(forJ->passUnis[(numThread > 1) ? dataGroupMergeTask(curH, numThread) : 0]))->joinTab);
+			uintptr_t curEnt = lookTab->find(curH, curRec + GROUPBY_REC_KEY);
+			if(curEnt == 0){
+				if(forJ->joinType == WHODUN_JOIN_LEFT){ addResult(curRec, 0); }
+				continue;
+			}
+			while(curEnt){
+				addResult(curRec, lookTab->getRecord(curEnt));
+				curEnt = lookTab->next(curEnt);
+			}
+		}
+	}
+}
+void DataTableJoinTask::addResult(const char* probeRec, const char* buildRec){
+	DataTableHashJoin* forJ = myJoin;
+	uintptr_t numProbe = forJ->probeOffsets.size();
+	uintptr_t numBuild = forJ->buildOffsets.size();
+	uintptr_t curSize = outTab.saveData.size();
+	outTab.saveData.resize(curSize + numProbe + numBuild);
+	DataTableEntry* curFill = outTab.saveData[curSize];
+	for(uintptr_t i = 0; i<numProbe; i++){
+		dataJoinUnpackColumn(forJ->probeDesc.colTypes[i], probeRec + forJ->probeOffsets[i], curFill);
+		curFill++;
+	}
+	for(uintptr_t i = 0; i<numBuild; i++){
+		uintptr_t curC = forJ->buildOutCols[i];
+		if(buildRec){
+			dataJoinUnpackColumn(forJ->buildDesc.colTypes[curC], buildRec + forJ->buildOffsets[i], curFill);
+		}
+		else{
+			curFill->isNA = 1;
+			curFill->valI = 0;
+			if(forJ->buildDesc.colTypes[curC] == WHODUN_DATA_STR){ curFill->valS = forJ->blankText[0]; }
+		}
+		curFill++;
+	}
+}
+
+TableExternalSort::TableExternalSort(const char* workDirName){
+	maxLoad = 0x20000000;
+	tempName = workDirName;
+	numThread = 1;
+	usePool = 0;
+	keyBytes = 0;
+	entryBytes = 0;
+	sortingText = 0;
+	textFrom = 0;
+	textTo = 0;
+	dataFrom = 0;
+	dataTo = 0;
+	gatherEntries = 0;
+}
+TableExternalSort::TableExternalSort(const char* workDirName, uintptr_t numThread, ThreadPool* mainPool){
+	maxLoad = 0x20000000;
+	tempName = workDirName;
+	this->numThread = numThread;
+	usePool = mainPool;
+	keyBytes = 0;
+	entryBytes = 0;
+	sortingText = 0;
+	textFrom = 0;
+	textTo = 0;
+	dataFrom = 0;
+	dataTo = 0;
+	gatherEntries = 0;
+}
+TableExternalSort::~TableExternalSort(){
+	for(uintptr_t i = 0; i<passUnis.size(); i++){
+		delete(passUnis[i]);
+	}
+}
+void TableExternalSort::addKey(uintptr_t column, int flags, uintptr_t width){
+	if(passUnis.size()){ throw std::runtime_error("Keys must be set before sorting."); }
+	keyCols.push_back(column);
+	keyFlags.push_back(flags);
+	keyWidths.push_back(width);
+}
+void TableExternalSort::sortText(RandacTextTableReader* sortFrom, TextTableWriter* sortTo){
+	sortingText = 1;
+	textFrom = sortFrom;
+	textTo = sortTo;
+	prepare();
+	runSort();
+}
+void TableExternalSort::sortData(RandacDataTableReader* sortFrom, DataTableWriter* sortTo){
+	DataTableDescription* useDesc = &(sortFrom->tabDesc);
+	for(uintptr_t k = 0; k<keyCols.size(); k++){
+		if(keyCols[k] >= useDesc->colTypes.size()){ throw std::runtime_error("Sort column out of range."); }
+	}
+	sortingText = 0;
+	dataFrom = sortFrom;
+	dataTo = sortTo;
+	prepare();
+	runSort();
+}
+void TableExternalSort::prepare(){
+	//lay out the entries: a flag for unknown before anything that can be unknown
+		keyOffsets.clear();
+		keyBytes = 0;
+		for(uintptr_t k = 0; k<keyCols.size(); k++){
+			keyOffsets.push_back(keyBytes);
+			if(sortingText){
+				keyBytes += (keyFlags[k] & WHODUN_TABLESORT_NUMERIC) ? 9 : keyWidths[k];
+			}
+			else{
+				uintptr_t curC = keyCols[k];
+				keyBytes += 1 + ((dataFrom->tabDesc.colTypes[curC] == WHODUN_DATA_STR) ? dataFrom->tabDesc.strLengths[curC] : 8);
+			}
+		}
+		keyOffsets.push_back(keyBytes);
+		entryBytes = keyBytes + 8;
+	//make the tasks
+		if(passUnis.size() == 0){
+			for(uintptr_t i = 0; i<numThread; i++){
+				passUnis.push_back(new TableSortTask(this));
+			}
+		}
+}
+void TableExternalSort::runSort(){
+	uintptr_t loadBudget = std::max(maxLoad, (uintptr_t)0x010000);
+	//set up the sort: the row index breaks ties, and the radix passes keep it in order
+		PODSortOptions sortOpts(entryBytes, &entryBytes, tableSortCompare);
+		if(keyBytes){ sortOpts.addKeyPart(0, keyBytes, WHODUN_SORTKEY_BIGENDIAN); }
+		PODExternalMergeSort* useSort = 0;
+		if(usePool){
+			useSort = new PODExternalMergeSort(tempName.c_str(), &sortOpts, numThread, usePool);
+		}
+		else{
+			useSort = new PODExternalMergeSort(tempName.c_str(), &sortOpts);
+		}
+		//each run needs room for two buffers and the sort's scratch space
+		useSort->maxLoad = loadBudget / 4;
+		uintptr_t runEntries = std::max(loadBudget / (3*entryBytes), (uintptr_t)1);
+	TableSortGatherStream gatherStr(this);
+	try{
+		//make and sort the entries
+			uintmax_t totalRows = 0;
+			uintmax_t totalBytes = 0;
+			uintptr_t numFill = 0;
+			char* fillBuf = useSort->getFillBuffer(runEntries);
+			if(sortingText){ textFrom->seek(0); }else{ dataFrom->seek(0); }
+			while(1){
+				uintptr_t numRead;
+				if(sortingText){
+					numRead = textFrom->read(&textTab, std::min((uintptr_t)TABLESORT_READ_ROWS, runEntries));
+					numRead = std::min(numRead, (uintptr_t)(textTab.saveRows.size()));
+					totalBytes += numRead*sizeof(TextTableRow) + textTab.saveStrs.size()*sizeof(SizePtrString) + textTab.saveText.size();
+				}
+				else{
+					numRead = dataFrom->read(&dataTab, std::min((uintptr_t)TABLESORT_READ_ROWS, runEntries));
+					totalBytes += dataTab.saveData.size()*sizeof(DataTableEntry) + dataTab.saveText.size();
+				}
+				if(numRead == 0){ break; }
+				uintptr_t curRead = 0;
+				while(curRead < numRead){
+					uintptr_t numAdd = std::min(numRead - curRead, runEntries - numFill);
+					runTasks(totalRows, curRead, numAdd, fillBuf + numFill*entryBytes);
+					numFill += numAdd;
+					curRead += numAdd;
+					if(numFill == runEntries){
+						useSort->addFillBuffer(numFill, 1);
+						fillBuf = useSort->getFillBuffer(runEntries);
+						numFill = 0;
+					}
+				}
+				totalRows += numRead;
+			}
+			useSort->addFillBuffer(numFill, 1);
+			textTab.saveRows.clear(); textTab.saveStrs.clear(); textTab.saveText.clear();
+			dataTab.saveData.clear(); dataTab.saveText.clear();
+		//figure out how many rows can be gathered at once
+			uintmax_t rowBytes = totalRows ? ((totalBytes / totalRows) + 1) : 1;
+			gatherEntries = (loadBudget / 2) / (2*rowBytes + entryBytes + 2*sizeof(uintmax_t));
+			gatherEntries = std::max(gatherEntries, (uintptr_t)1);
+			gatherEntries = std::min((uintmax_t)gatherEntries, std::max(totalRows, (uintmax_t)1));
+		//merge and write
+			useSort->mergeData(&gatherStr);
+			gatherStr.close();
+	}
+	catch(std::exception& errE){
+		gatherStr.isClosed = 1;
+		delete(useSort);
+		throw;
+	}
+	delete(useSort);
+	outText.saveRows.clear(); outText.saveStrs.clear(); outText.saveText.clear();
+	outData.saveData.clear(); outData.saveText.clear();
+}
+void TableExternalSort::gatherRows(char* entries, uintptr_t numEntries){
+	//read the rows in file order
+		gatherOrder.clear();
+		for(uintptr_t i = 0; i<numEntries; i++){
+			ByteUnpacker getRow(entries + i*entryBytes + keyBytes);
+			gatherOrder.push_back(std::pair<uintmax_t,uintptr_t>(getRow.unpackBE64(), i));
+		}
+		std::sort(gatherOrder.begin(), gatherOrder.end());
+	//set up the output
+		uintptr_t numCols = sortingText ? 0 : dataFrom->tabDesc.colTypes.size();
+		if(sortingText){
+			outText.saveRows.resize(numEntries);
+			outText.saveStrs.clear();
+			outText.saveText.clear();
+			outStarts.resize(numEntries);
+		}
+		else{
+			outData.saveData.resize(numEntries*numCols);
+			outData.saveText.clear();
+		}
+	//read runs of close rows
+		uintptr_t curO = 0;
+		while(curO < numEntries){
+			uintmax_t runS = gatherOrder[curO].first;
+			uintptr_t endO = curO + 1;
+			while(endO < numEntries){
+				uintmax_t nextR = gatherOrder[endO].first;
+				if((nextR - gatherOrder[endO-1].first) > TABLESORT_GATHER_GAP){ break; }
+				if((nextR - runS) >= gatherEntries){ break; }
+				endO++;
+			}
+			uintmax_t runE = gatherOrder[endO-1].first + 1;
+			if(sortingText){
+				textFrom->readRange(&textTab, runS, runE);
+				if(textTab.saveRows.size() != (runE - runS)){ throw std::runtime_error("Table changed while sorting."); }
+				for(uintptr_t i = curO; i<endO; i++){
+					TextTableRow* srcRow = textTab.saveRows[gatherOrder[i].first - runS];
+					uintptr_t curSlot = gatherOrder[i].second;
+					outText.saveRows[curSlot]->numCols = srcRow->numCols;
+					*(outStarts[curSlot]) = outText.saveStrs.size();
+					uintptr_t textLen = 0;
+					for(uintptr_t j = 0; j<srcRow->numCols; j++){ textLen += srcRow->texts[j].len; }
+					uintptr_t strOff = outText.saveStrs.size();
+					uintptr_t textOff = outText.saveText.size();
+					outText.saveStrs.resize(strOff + srcRow->numCols);
+					outText.saveText.resize(textOff + textLen);
+					for(uintptr_t j = 0; j<srcRow->numCols; j++){
+						SizePtrString curS = srcRow->texts[j];
+						outText.saveStrs[strOff + j]->len = curS.len;
+						memcpy(outText.saveText[textOff], curS.txt, curS.len);
+						textOff += curS.len;
+					}
+				}
+			}
+			else{
+				DataTableDescription* useDesc = &(dataFrom->tabDesc);
+				dataFrom->readRange(&dataTab, runS, runE);
+				if(dataTab.saveData.size() != (runE - runS)*numCols){ throw std::runtime_error("Table changed while sorting."); }
+				for(uintptr_t i = curO; i<endO; i++){
+					DataTableEntry* srcRow = dataTab.saveData[(gatherOrder[i].first - runS)*numCols];
+					DataTableEntry* dstRow = outData.saveData[gatherOrder[i].second*numCols];
+					memcpy(dstRow, srcRow, numCols*sizeof(DataTableEntry));
+					for(uintptr_t j = 0; j<numCols; j++){
+						if(useDesc->colTypes[j] != WHODUN_DATA_STR){ continue; }
+						uintptr_t strLen = useDesc->strLengths[j];
+						uintptr_t textOff = outData.saveText.size();
+						outData.saveText.resize(textOff + strLen);
+						if(srcRow[j].isNA){
+							memset(outData.saveText[textOff], 0, strLen);
+						}
+						else{
+							memcpy(outData.saveText[textOff], srcRow[j].valS, strLen);
+						}
+					}
+				}
+			}
+			curO = endO;
+		}
+	//point at the copied text (it was added in file order) and write
+		if(sortingText){
+			char* curText = outText.saveText[0];
+			for(uintptr_t i = 0; i<outText.saveStrs.size(); i++){
+				SizePtrString* curS = outText.saveStrs[i];
+				curS->txt = curText;
+				curText += curS->len;
+			}
+			for(uintptr_t i = 0; i<numEntries; i++){
+				TextTableRow* curRow = outText.saveRows[i];
+				curRow->texts = outText.saveStrs[*(outStarts[i])];
+			}
+			textTo->write(&outText);
+		}
+		else{
+			DataTableDescription* useDesc = &(dataFrom->tabDesc);
+			char* curText = outData.saveText[0];
+			for(uintptr_t i = 0; i<numEntries; i++){
+				DataTableEntry* dstRow = outData.saveData[gatherOrder[i].second*numCols];
+				for(uintptr_t j = 0; j<numCols; j++){
+					if(useDesc->colTypes[j] != WHODUN_DATA_STR){ continue; }
+					dstRow[j].valS = curText;
+					curText += useDesc->strLengths[j];
+				}
+			}
+			dataTo->write(&outData);
+		}
+}
+void TableExternalSort::runTasks(uintmax_t baseRow, uintptr_t fromRow, uintptr_t numRows, char* fillTo){
+	uintptr_t numPT = numRows / numThread;
+	uintptr_t numET = numRows % numThread;
+	uintptr_t curI = fromRow;
+	for(uintptr_t i = 0; i<numThread; i++){
+		TableSortTask* curT = (TableSortTask*)(passUnis[i]);
+		curT->baseRow = baseRow;
+		curT->fromI = curI;
+		curT->fillTo = fillTo + (curI - fromRow)*entryBytes;
+		curI += (numPT + (i<numET));
+		curT->toI = curI;
+	}
+	if(usePool){
+		usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
+		joinTasks(numThread, &(passUnis[0]));
+	}
+	else{
+		for(uintptr_t i = 0; i<numThread; i++){
+			passUnis[i]->doTask();
+		}
+	}
+}
+
+TableSortTask::TableSortTask(TableExternalSort* forSort){
+	mySort = forSort;
+}
+TableSortTask::~TableSortTask(){}
+void TableSortTask::doTask(){
+	TableExternalSort* forS = mySort;
+	uintptr_t entryBytes = forS->entryBytes;
+	uintptr_t keyBytes = forS->keyBytes;
+	uintptr_t numKey = forS->keyCols.size();
+	uintptr_t numCols = forS->sortingText ? 0 : forS->dataFrom->tabDesc.colTypes.size();
+	for(uintptr_t ri = fromI; ri<toI; ri++){
+		char* curEnt = fillTo + (ri - fromI)*entryBytes;
+		memset(curEnt, 0, keyBytes);
+		for(uintptr_t k = 0; k<numKey; k++){
+			uintptr_t curC = forS->keyCols[k];
+			char* curKP = curEnt + forS->keyOffsets[k];
+			char* curKE = curEnt + forS->keyOffsets[k+1];
+			int hasFlag = 1;
+			if(forS->sortingText){
+				TextTableRow* curRow = forS->textTab.saveRows[ri];
+				SizePtrString curT = {0, 0};
+				if(curC < curRow->numCols){ curT = curRow->texts[curC]; }
+				if(forS->keyFlags[k] & WHODUN_TABLESORT_NUMERIC){
+					double curV; char isBad;
+					parseFloatBatch(1, &curT, &curV, &isBad);
+					if(isBad || (curV != curV)){
+						curKP[0] = 1;
+						continue;
+					}
+					tableSortPackReal(curV, curKP + 1);
+				}
+				else{
+					memcpy(curKP, curT.txt, std::min(curT.len, (uintptr_t)(curKE - curKP)));
+					hasFlag = 0;
+				}
+			}
+			else{
+				DataTableEntry* curE = forS->dataTab.saveData[ri*numCols + curC];
+				if(curE->isNA){
+					curKP[0] = 1;
+					continue;
+				}
+				BytePacker packV(curKP + 1);
+				switch(forS->dataFrom->tabDesc.colTypes[curC]){
+					case WHODUN_DATA_CAT: packV.packBE64(curE->valC); break;
+					case WHODUN_DATA_INT: packV.packBE64(((uint64_t)(curE->valI)) ^ 0x8000000000000000ULL); break;
+					case WHODUN_DATA_REAL:
+						if(curE->valR != curE->valR){
+							curKP[0] = 1;
+							continue;
+						}
+						tableSortPackReal(curE->valR, curKP + 1);
+						break;
+					case WHODUN_DATA_STR:{
+						uintptr_t maxLen = curKE - (curKP + 1);
+						const char* endS = (const char*)memchr(curE->valS, 0, maxLen);
+						memcpy(curKP + 1, curE->valS, endS ? (endS - curE->valS) : maxLen);
+					} break;
+					default:
+						throw std::runtime_error("Unknown column type.");
+				}
+			}
+			//unknown values stay last when reversed
+			if(forS->keyFlags[k] & WHODUN_TABLESORT_REVERSE){
+				for(char* curB = curKP + hasFlag; curB < curKE; curB++){ *curB = ~*curB; }
+			}
+		}
+		BytePacker packR(curEnt + keyBytes);
+		packR.packBE64(baseRow + ri);
+	}
+}
+
+TableSortGatherStream::TableSortGatherStream(TableExternalSort* forSort){
+	mySort = forSort;
+	numBytes = 0;
+}
+TableSortGatherStream::~TableSortGatherStream(){}
+void TableSortGatherStream::write(int toW){
+	char toWC = toW;
+	write(&toWC, 1);
+}
+void TableSortGatherStream::write(const char* toW, uintptr_t numW){
+	uintptr_t entryBytes = mySort->entryBytes;
+	uintptr_t fullBytes = mySort->gatherEntries * entryBytes;
+	if(entryStore.size() < fullBytes){ entryStore.resize(fullBytes); }
+	while(numW){
+		uintptr_t numCopy = std::min(numW, fullBytes - numBytes);
+		memcpy(entryStore[numBytes], toW, numCopy);
+		numBytes += numCopy;
+		toW += numCopy;
+		numW -= numCopy;
+		if(numBytes == fullBytes){
+			mySort->gatherRows(entryStore[0], mySort->gatherEntries);
+			numBytes = 0;
+		}
+	}
+}
+void TableSortGatherStream::close(){
+	isClosed = 1;
+	if(numBytes){
+		mySort->gatherRows(entryStore[0], numBytes / mySort->entryBytes);
+		numBytes = 0;
+	}
+}
+
+TextTableKeyIndexBuilder::TextTableKeyIndexBuilder(const char* workDirName){
+	keyWidth = 32;
+	blockEntries = 0;
+	maxLoad = 0x20000000;
+	tempName = workDirName;
+	numThread = 1;
+	usePool = 0;
+}
+TextTableKeyIndexBuilder::TextTableKeyIndexBuilder(const char* workDirName, uintptr_t numThread, ThreadPool* mainPool){
+	keyWidth = 32;
+	blockEntries = 0;
+	maxLoad = 0x20000000;
+	tempName = workDirName;
+	this->numThread = numThread;
+	usePool = mainPool;
+}
+TextTableKeyIndexBuilder::~TextTableKeyIndexBuilder(){}
+void TextTableKeyIndexBuilder::build(RandacTextTableReader* fromTab, uintptr_t column, OutStream* toDump){
+	if(keyWidth == 0){ throw std::runtime_error("Key index needs at least one byte of key."); }
+	uintptr_t entryBytes = keyWidth + 8;
+	//blocks default to about a page
+		uintptr_t useBlockEnts = blockEntries ? blockEntries : std::max((uintptr_t)(0x01000 / entryBytes), (uintptr_t)1);
+	//set up the sort: the row index breaks ties, and the radix passes keep it in order
+		uintptr_t loadBudget = std::max(maxLoad, (uintptr_t)0x010000);
+		PODSortOptions sortOpts(entryBytes, &entryBytes, tableSortCompare);
+		sortOpts.addKeyPart(0, keyWidth, WHODUN_SORTKEY_BIGENDIAN);
+		PODExternalMergeSort* useSort = 0;
+		if(usePool){
+			useSort = new PODExternalMergeSort(tempName.c_str(), &sortOpts, numThread, usePool);
+		}
+		else{
+			useSort = new PODExternalMergeSort(tempName.c_str(), &sortOpts);
+		}
+		useSort->maxLoad = loadBudget / 4;
+		uintptr_t runEntries = std::max(loadBudget / (3*entryBytes), (uintptr_t)1);
+	TextTableKeyIndexDumpStream dumpStr(toDump, keyWidth, useBlockEnts);
+	try{
+		//make and sort the entries
+			uintmax_t totalRows = 0;
+			uintptr_t numFill = 0;
+			char* fillBuf = useSort->getFillBuffer(runEntries);
+			fromTab->seek(0);
+			while(1){
+				uintptr_t numRead = fromTab->read(&loadTab, TABLESORT_READ_ROWS);
+				numRead = std::min(numRead, (uintptr_t)(loadTab.saveRows.size()));
+				if(numRead == 0){ break; }
+				for(uintptr_t i = 0; i<numRead; i++){
+					char* curEnt = fillBuf + numFill*entryBytes;
+					memset(curEnt, 0, keyWidth);
+					TextTableRow* curRow = loadTab.saveRows[i];
+					if(column < curRow->numCols){
+						SizePtrString curT = curRow->texts[column];
+						memcpy(curEnt, curT.txt, std::min(curT.len, keyWidth));
+					}
+					BytePacker packR(curEnt + keyWidth);
+					packR.packBE64(totalRows + i);
+					numFill++;
+					if(numFill == runEntries){
+						useSort->addFillBuffer(numFill, 1);
+						fillBuf = useSort->getFillBuffer(runEntries);
+						numFill = 0;
+					}
+				}
+				totalRows += numRead;
+			}
+			useSort->addFillBuffer(numFill, 1);
+		//the header, the entries, then the first key of each block
+			char headBuf[KEYINDEX_HEAD_BYTES];
+			BytePacker packH(headBuf);
+			packH.packBE64(column);
+			packH.packBE64(keyWidth);
+			packH.packBE64(totalRows);
+			packH.packBE64(useBlockEnts);
+			toDump->write(headBuf, KEYINDEX_HEAD_BYTES);
+			useSort->mergeData(&dumpStr);
+			dumpStr.close();
+			toDump->write(dumpStr.topKeys[0], dumpStr.topKeys.size());
+	}
+	catch(std::exception& errE){
+		dumpStr.isClosed = 1;
+		delete(useSort);
+		throw;
+	}
+	delete(useSort);
+	loadTab.saveRows.clear(); loadTab.saveStrs.clear(); loadTab.saveText.clear();
+}
+
+TextTableKeyIndex::TextTableKeyIndex(RandaccInStream* indexFile, RandacTextTableReader* forTable){
+	indexStr = indexFile;
+	tableStr = forTable;
+	loadedBlock = 0;
+	//read the header
+		char headBuf[KEYINDEX_HEAD_BYTES];
+		indexStr->seek(0);
+		indexStr->forceRead(headBuf, KEYINDEX_HEAD_BYTES);
+		ByteUnpacker getH(headBuf);
+		column = getH.unpackBE64();
+		keyWidth = getH.unpackBE64();
+		numEntries = getH.unpackBE64();
+		blockEntries = getH.unpackBE64();
+		if((keyWidth == 0) || (blockEntries == 0)){ throw std::runtime_error("Malformed key index."); }
+		entryBytes = keyWidth + 8;
+		numBlocks = (numEntries + blockEntries - 1) / blockEntries;
+		uintmax_t topStart = KEYINDEX_HEAD_BYTES + numEntries*entryBytes;
+		if(indexStr->size() != (topStart + numBlocks*keyWidth)){ throw std::runtime_error("Malformed key index."); }
+		if(numEntries != tableStr->size()){ throw std::runtime_error("Key index is for a different table."); }
+	//and the first key of each block
+		topKeys.resize(numBlocks*keyWidth);
+		indexStr->seek(topStart);
+		indexStr->forceRead(topKeys[0], numBlocks*keyWidth);
+	blockData.resize(blockEntries*entryBytes);
+	padKey.resize(keyWidth);
+}
+TextTableKeyIndex::~TextTableKeyIndex(){}
+void TextTableKeyIndex::lookup(SizePtrString key, TextTable* toFill){
+	lookup(1, &key, toFill, 0);
+}
+void TextTableKeyIndex::lookup(uintptr_t numKeys, SizePtrString* keys, TextTable* toFill, std::vector<uintptr_t>* rowKeys){
+	toFill->saveRows.clear();
+	toFill->saveStrs.clear();
+	toFill->saveText.clear();
+	if(rowKeys){ rowKeys->clear(); }
+	//sort the keys, so blocks are visited in order
+		sortKeys.clear();
+		for(uintptr_t i = 0; i<numKeys; i++){
+			sortKeys.push_back(std::pair<std::string,uintptr_t>(std::string(keys[i].txt, keys[i].len), i));
+		}
+		std::sort(sortKeys.begin(), sortKeys.end());
+	//find the rows that might match
+		candRows.clear();
+		for(uintptr_t si = 0; si<sortKeys.size(); si++){
+			if(si && (sortKeys[si].first == sortKeys[si-1].first)){ continue; }
+			std::string* curK = &(sortKeys[si].first);
+			memset(padKey[0], 0, keyWidth);
+			memcpy(padKey[0], curK->c_str(), std::min(curK->size(), keyWidth));
+			//matches can start in the block before the first block that starts at or after the key
+			uintmax_t lowB = 0;
+			uintmax_t highB = numBlocks;
+			while(lowB < highB){
+				uintmax_t midB = lowB + (highB - lowB)/2;
+				if(memcmp(topKeys[midB*keyWidth], padKey[0], keyWidth) < 0){ lowB = midB + 1; }
+				else{ highB = midB; }
+			}
+			uintmax_t curB = lowB ? (lowB - 1) : 0;
+			int pastKey = 0;
+			while(!pastKey && (curB < numBlocks)){
+				uintptr_t numE = loadBlock(curB);
+				for(uintptr_t ei = 0; ei<numE; ei++){
+					char* curE = blockData[ei*entryBytes];
+					int compV = memcmp(curE, padKey[0], keyWidth);
+					if(compV < 0){ continue; }
+					if(compV > 0){ pastKey = 1; break; }
+					ByteUnpacker getR(curE + keyWidth);
+					candRows.push_back(std::pair<uintmax_t,uintptr_t>(getR.unpackBE64(), si));
+				}
+				curB++;
+			}
+		}
+	//read the rows in table order, and check the full key
+		std::sort(candRows.begin(), candRows.end());
+		uintptr_t curC = 0;
+		while(curC < candRows.size()){
+			uintmax_t runS = candRows[curC].first;
+			uintptr_t endC = curC + 1;
+			while(endC < candRows.size()){
+				uintmax_t nextR = candRows[endC].first;
+				if((nextR - candRows[endC-1].first) > TABLESORT_GATHER_GAP){ break; }
+				if((nextR - runS) >= KEYINDEX_MAX_SPAN){ break; }
+				endC++;
+			}
+			uintmax_t runE = candRows[endC-1].first + 1;
+			tableStr->readRange(&loadTab, runS, runE);
+			if(loadTab.saveRows.size() != (runE - runS)){ throw std::runtime_error("Table does not match its index."); }
+			for(uintptr_t i = curC; i<endC; i++){
+				TextTableRow* srcRow = loadTab.saveRows[candRows[i].first - runS];
+				std::string* wantK = &(sortKeys[candRows[i].second].first);
+				SizePtrString haveK = {0, 0};
+				if(column < srcRow->numCols){ haveK = srcRow->texts[column]; }
+				if(haveK.len != wantK->size()){ continue; }
+				if(haveK.len && memcmp(haveK.txt, wantK->c_str(), haveK.len)){ continue; }
+				uintptr_t textLen = 0;
+				for(uintptr_t j = 0; j<srcRow->numCols; j++){ textLen += srcRow->texts[j].len; }
+				uintptr_t rowOff = toFill->saveRows.size();
+				uintptr_t strOff = toFill->saveStrs.size();
+				uintptr_t textOff = toFill->saveText.size();
+				toFill->saveRows.resize(rowOff + 1);
+				toFill->saveStrs.resize(strOff + srcRow->numCols);
+				toFill->saveText.resize(textOff + textLen);
+				toFill->saveRows[rowOff]->numCols = srcRow->numCols;
+				for(uintptr_t j = 0; j<srcRow->numCols; j++){
+					SizePtrString curS = srcRow->texts[j];
+					toFill->saveStrs[strOff + j]->len = curS.len;
+					memcpy(toFill->saveText[textOff], curS.txt, curS.len);
+					textOff += curS.len;
+				}
+				if(rowKeys){ rowKeys->push_back(sortKeys[candRows[i].second].second); }
+			}
+			curC = endC;
+		}
+	//point at the copied text
+		char* curText = toFill->saveText[0];
+		uintptr_t curStr = 0;
+		for(uintptr_t i = 0; i<toFill->saveRows.size(); i++){
+			TextTableRow* curRow = toFill->saveRows[i];
+			curRow->texts = toFill->saveStrs[curStr];
+			for(uintptr_t j = 0; j<curRow->numCols; j++){
+				curRow->texts[j].txt = curText;
+				curText += curRow->texts[j].len;
+			}
+			curStr += curRow->numCols;
+		}
+}
+uintptr_t TextTableKeyIndex::loadBlock(uintmax_t blockInd){
+	uintptr_t numE = std::min((uintmax_t)blockEntries, numEntries - blockInd*blockEntries);
+	if(loadedBlock == (blockInd + 1)){ return numE; }
+	indexStr->seek(KEYINDEX_HEAD_BYTES + blockInd*blockEntries*entryBytes);
+	indexStr->forceRead(blockData[0], numE*entryBytes);
+	loadedBlock = blockInd + 1;
+	return numE;
+}
+
+TextTableKeyIndexDumpStream::TextTableKeyIndexDumpStream(OutStream* baseStr, uintptr_t keyWidth, uintptr_t blockEntries){
+	this->baseStr = baseStr;
+	this->keyWidth = keyWidth;
+	this->blockEntries = blockEntries;
+	entryBytes = keyWidth + 8;
+	numBytes = 0;
+}
+TextTableKeyIndexDumpStream::~TextTableKeyIndexDumpStream(){}
+void TextTableKeyIndexDumpStream::write(int toW){
+	char toWC = toW;
+	write(&toWC, 1);
+}
+void TextTableKeyIndexDumpStream::write(const char* toW, uintptr_t numW){
+	baseStr->write(toW, numW);
+	while(numW){
+		uintptr_t entOff = numBytes % entryBytes;
+		uintmax_t entInd = numBytes / entryBytes;
+		uintptr_t numHere = std::min(numW, entryBytes - entOff);
+		if(((entInd % blockEntries) == 0) && (entOff < keyWidth)){
+			uintptr_t numKey = std::min(numHere, keyWidth - entOff);
+			uintptr_t topOff = (entInd / blockEntries)*keyWidth + entOff;
+			topKeys.resize(topOff + numKey);
+			memcpy(topKeys[topOff], toW, numKey);
+		}
+		numBytes += numHere;
+		toW += numHere;
+		numW -= numHere;
+	}
+}
+void TextTableKeyIndexDumpStream::close(){
+	isClosed = 1;
+}
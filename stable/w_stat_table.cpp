@@ -26,11 +26,9 @@ public:
 	/**The index after the last row this should work over.*/
 	uintptr_t endRI;
 	/**The number of columns in each row.*/
-	std::vector<uintptr_t> numColsEachRow;
+	StructVector<uintptr_t> numColsEachRow;
 	/**Store the columns for this run.*/
-	std::vector<SizePtrString> colCellTexts;
-	/**Save row splits.*/
-	StructVector<Token> saveColS;
+	StructVector<SizePtrString> colCellTexts;
 	
 	//phase 2 - pack them into the final target
 	/**The table to store in*/
@@ -93,6 +91,8 @@ public:
 	SizePtrString textData;
 	/**The total number of columns in this chunk.*/
 	uintptr_t totalColumns;
+	/**The unpacked row addresses (first is the base address of the loaded text).*/
+	StructVector<uint64_t> rowAddrs;
 	
 	//phase 2 - packing the data
 	/**The table to fill.*/
@@ -122,6 +122,16 @@ public:
 	//phase 1 - figure out how many bytes this eats
 	/**The number of bytes this chunk will use.*/
 	uintptr_t numEatBytes;
+	/**The number of rows in each zone (zero if not recording statistics).*/
+	uintptr_t zoneRows;
+	/**The number of bytes in each bloom filter.*/
+	uintptr_t zoneBloom;
+	/**The overall index of the first row of the table.*/
+	uintmax_t zoneRowBase;
+	/**Statistics on the pieces of zones this chunk covers, in order.*/
+	std::vector<TextTableBlockZone> zoneParts;
+	/**The number of pieces in use.*/
+	uintptr_t numZoneParts;
 	
 	//phase 2 - pack it up
 	/**The file offset this chunk starts at.*/
@@ -130,6 +140,8 @@ public:
 	char* annotData;
 	/**The table data to pack this piece into.*/
 	char* tableData;
+	/**The row addresses to pack.*/
+	StructVector<uint64_t> rowAddrs;
 };
 
 /**Run a filter.*/
@@ -223,8 +235,52 @@ public:
 	
 	/**The mode this is mutating for.*/
 	int mutMode;
+	/**Find escape characters.*/
+	ByteSetSearcher escFind;
+	/**Find characters that need escaping.*/
+	ByteSetSearcher packFind;
 };
 
+/**
+ * Trim spaces, tabs, carriage returns and newlines off both ends of some text.
+ * @param toTrim The text to trim.
+ * @return The trimmed text.
+ */
+SizePtrString tsvTrimSpace(SizePtrString toTrim);
+
+/**
+ * Compare two pieces of text, byte by byte (a prefix comes first).
+ * @param strA The first text.
+ * @param lenA The length of the first text.
+ * @param strB The second text.
+ * @param lenB The length of the second text.
+ * @return Negative if A comes first, positive if B comes first, zero if equal.
+ */
+int textZoneCompare(const char* strA, uintptr_t lenA, const char* strB, uintptr_t lenB);
+
+/**
+ * Hash some text for the zone bloom filters.
+ * @param toHash The text to hash.
+ * @return The hash.
+ */
+uint64_t textZoneHash(SizePtrString toHash);
+
+/**
+ * Pack up the statistics for a block.
+ * @param toPack The statistics to pack.
+ * @param toFill The place to add the packed bytes.
+ */
+void textZoneWrite(TextTableBlockZone* toPack, StructVector<char>* toFill);
+
+/**
+ * Unpack the statistics for a block.
+ * @param toFill The place to put the statistics: bloomBytes should already be set.
+ * @param fromData The packed data.
+ * @param numData The number of bytes of packed data.
+ * @return The number of bytes used.
+ */
+uintptr_t textZoneRead(TextTableBlockZone* toFill, const char* fromData, uintptr_t numData);
+
 /**Filter out empty rows.*/
 class TSVTableFilter : public TextTableFilter{
 public:
@@ -451,7 +507,10 @@ TextTableWriter::~TextTableWriter(){
 DelimitedTableReader::DelimitedTableReader(char rowDelim, char colDelim, InStream* mainFrom){
 	theStr = mainFrom;
 	rowSplitter = new CharacterSplitTokenizer(rowDelim);
-	colSplitter = new CharacterSplitTokenizer(colDelim);
+	char allSpec[2] = {rowDelim, colDelim};
+	structFind.setBytes(allSpec, 2);
+	escapeChar = -1;
+	quoteChar = -1;
 	charMove = new StandardMemoryShuttler();
 	haveDrained = 0;
 	usePool = 0;
@@ -464,7 +523,52 @@ DelimitedTableReader::DelimitedTableReader(char rowDelim, char colDelim, InStrea
 DelimitedTableReader::DelimitedTableReader(char rowDelim, char colDelim, InStream* mainFrom, uintptr_t numThread, ThreadPool* mainPool){
 	theStr = mainFrom;
 	rowSplitter = new MultithreadedCharacterSplitTokenizer(rowDelim, numThread, mainPool);
-	colSplitter = new CharacterSplitTokenizer(colDelim);
+	char allSpec[2] = {rowDelim, colDelim};
+	structFind.setBytes(allSpec, 2);
+	escapeChar = -1;
+	quoteChar = -1;
+	charMove = new ThreadedMemoryShuttler(numThread, mainPool);
+	haveDrained = 0;
+	usePool = mainPool;
+	for(uintptr_t i = 0; i<numThread; i++){
+		DelimitedTableReadTask* curT = new DelimitedTableReadTask();
+		curT->forRead = this;
+		passUnis.push_back(curT);
+	}
+}
+DelimitedTableReader::DelimitedTableReader(char rowDelim, char colDelim, int escChar, int quotChar, InStream* mainFrom){
+	theStr = mainFrom;
+	rowSplitter = new EscapedCharacterSplitTokenizer(rowDelim, escChar, quotChar);
+	escapeChar = escChar;
+	quoteChar = quotChar;
+	char allSpec[4];
+	uintptr_t numSpec = 0;
+	allSpec[numSpec++] = rowDelim;
+	allSpec[numSpec++] = colDelim;
+	if(escChar >= 0){ allSpec[numSpec++] = escChar; }
+	if(quotChar >= 0){ allSpec[numSpec++] = quotChar; }
+	structFind.setBytes(allSpec, numSpec);
+	charMove = new StandardMemoryShuttler();
+	haveDrained = 0;
+	usePool = 0;
+	{
+		DelimitedTableReadTask* curT = new DelimitedTableReadTask();
+		curT->forRead = this;
+		passUnis.push_back(curT);
+	}
+}
+DelimitedTableReader::DelimitedTableReader(char rowDelim, char colDelim, int escChar, int quotChar, InStream* mainFrom, uintptr_t numThread, ThreadPool* mainPool){
+	theStr = mainFrom;
+	rowSplitter = new MultithreadedEscapedCharacterSplitTokenizer(rowDelim, escChar, quotChar, numThread, mainPool);
+	escapeChar = escChar;
+	quoteChar = quotChar;
+	char allSpec[4];
+	uintptr_t numSpec = 0;
+	allSpec[numSpec++] = rowDelim;
+	allSpec[numSpec++] = colDelim;
+	if(escChar >= 0){ allSpec[numSpec++] = escChar; }
+	if(quotChar >= 0){ allSpec[numSpec++] = quotChar; }
+	structFind.setBytes(allSpec, numSpec);
 	charMove = new ThreadedMemoryShuttler(numThread, mainPool);
 	haveDrained = 0;
 	usePool = mainPool;
@@ -476,7 +580,6 @@ DelimitedTableReader::DelimitedTableReader(char rowDelim, char colDelim, InStrea
 }
 DelimitedTableReader::~DelimitedTableReader(){
 	delete(rowSplitter);
-	delete(colSplitter);
 	delete(charMove);
 	for(uintptr_t i = 0; i<passUnis.size(); i++){
 		delete(passUnis[i]);
@@ -519,6 +622,20 @@ uintptr_t DelimitedTableReader::read(TextTable* toStore, uintptr_t numRows){
 			//load more and try again
 				uintptr_t origTS = toStore->saveText.size();
 				uintptr_t newTS = std::max((uintptr_t)80, 2*origTS);
+				uintptr_t numHave = saveRowS.size() / 2;
+				if(numHave){
+					//guess from the rows already had (with some slack): every retry re-splits the whole buffer
+					uintptr_t rowBytes = (origTS / numHave) + 1;
+					uintptr_t needRows = numRows - numHave;
+					uintptr_t maxGrow = 15*origTS;
+					if(needRows < (maxGrow / rowBytes)){
+						uintptr_t needBytes = needRows * rowBytes;
+						newTS = origTS + needBytes + (needBytes >> 3) + 80;
+					}
+					else{
+						newTS = origTS + maxGrow;
+					}
+				}
 				toStore->saveText.resize(newTS);
 				uintptr_t numWantR = newTS - origTS;
 				uintptr_t numGotR = theStr->read(toStore->saveText[origTS], numWantR);
@@ -593,28 +710,79 @@ void DelimitedTableReadTask::doTask(){
 		//cut up each line into columns
 		numColsEachRow.clear();
 		colCellTexts.clear();
-		for(uintptr_t i = firstRI; i<endRI; i++){
-			saveColS.clear();
-			SizePtrString curLine = forRead->saveRowS[2*i]->text;
-			SizePtrString remText = forRead->colSplitter->tokenize(curLine, &saveColS);
-			uintptr_t numCol = saveColS.size() / 2;
-			for(uintptr_t j = 0; j<numCol; j++){
-				colCellTexts.push_back(saveColS[2*j]->text);
-			}
-			colCellTexts.push_back(remText);
-			numColsEachRow.push_back(numCol+1);
-		}
+		if(firstRI == endRI){ return; }
+		//the rows are back to back, so walk the whole run at once
+		const char* runText = forRead->saveRowS[2*firstRI]->text.txt;
+		SizePtrString lastLine = forRead->saveRowS[2*(endRI-1)]->text;
+		uintptr_t runLen = (lastLine.txt + lastLine.len) - runText;
+		//masks come back as row delimiter, column delimiter, then escape and quote if present
+		uintptr_t escSlot = (forRead->escapeChar >= 0) ? 2 : 0;
+		uintptr_t quoteSlot = (forRead->quoteChar >= 0) ? (escSlot ? 3 : 2) : 0;
+		uint64_t allMasks[WHODUN_BYTECLASS_MAX];
+		//rows always start outside quotes and escapes
+		uint64_t prevEscaped = 0;
+		uint64_t prevQuoted = 0;
+		uintptr_t numCell = 0;
+		uintptr_t numRow = 0;
+		uintptr_t numCol = 1;
+		uintptr_t prevStart = 0;
+		uintptr_t curBase = 0;
+		while(curBase < runLen){
+			//stage 1: figure out which bytes split things
+				uintptr_t curNum = std::min((uintptr_t)64, runLen - curBase);
+				forRead->structFind.mask64(runText + curBase, curNum, allMasks);
+				uint64_t rowMask = allMasks[0];
+				uint64_t splitMask = allMasks[0] | allMasks[1];
+				if(escSlot){
+					uint64_t escapedMask = maskEscaped64(allMasks[escSlot], &prevEscaped);
+					splitMask = splitMask & ~escapedMask;
+					if(quoteSlot){ allMasks[quoteSlot] = allMasks[quoteSlot] & ~escapedMask; }
+				}
+				if(quoteSlot){
+					splitMask = splitMask & ~maskQuoted64(allMasks[quoteSlot], &prevQuoted);
+				}
+			//stage 2: cut at the splits (a block has at most 64)
+				colCellTexts.resize(numCell + 64);
+				numColsEachRow.resize(numRow + 64);
+				SizePtrString* cellFill = colCellTexts[numCell];
+				uintptr_t* rowFill = numColsEachRow[numRow];
+				while(splitMask){
+					uintptr_t curBit = __builtin_ctzll(splitMask);
+					uintptr_t curSplitInd = curBase + curBit;
+					splitMask = splitMask & (splitMask - 1);
+					cellFill->txt = (char*)(runText + prevStart);
+					cellFill->len = curSplitInd - prevStart;
+					cellFill++;
+					prevStart = curSplitInd + 1;
+					if((rowMask >> curBit) & 1){
+						*rowFill = numCol;
+						rowFill++;
+						numCol = 1;
+					}
+					else{
+						numCol++;
+					}
+				}
+				numCell = cellFill - colCellTexts[0];
+				numRow = rowFill - numColsEachRow[0];
+			curBase += curNum;
+		}
+		colCellTexts.resize(numCell + 1);
+		colCellTexts[numCell]->txt = (char*)(runText + prevStart);
+		colCellTexts[numCell]->len = runLen - prevStart;
+		numColsEachRow.resize(numRow + 1);
+		*(numColsEachRow[numRow]) = numCol;
 	}
 	else{
 		TextTableRow* curRow = toStore->saveRows[firstRI];
 		SizePtrString* curCol = toStore->saveStrs[colOffset];
 		uintptr_t curStrI = 0;
 		for(uintptr_t i = 0; i<numColsEachRow.size(); i++){
-			uintptr_t curNumC = numColsEachRow[i];
+			uintptr_t curNumC = *(numColsEachRow[i]);
 			curRow->numCols = curNumC;
 			curRow->texts = curCol;
 			if(curNumC){
-				memcpy(curCol, &(colCellTexts[curStrI]), curNumC*sizeof(SizePtrString));
+				memcpy(curCol, colCellTexts[curStrI], curNumC*sizeof(SizePtrString));
 			}
 			curStrI += curNumC;
 			curCol += curNumC;
@@ -728,12 +896,12 @@ void DelimitedTableWriteTask::doTask(){
 }
 
 TSVTableReader::TSVTableReader(InStream* mainFrom, int useEscapes){
-	baseRead = new DelimitedTableReader('\n', '\t', mainFrom);
+	baseRead = useEscapes ? new DelimitedTableReader('\n', '\t', '\\', -1, mainFrom) : new DelimitedTableReader('\n', '\t', mainFrom);
 	trimEscape = new TSVTableMutator(0, useEscapes ? 1 : 0);
 	killEmpties = new TSVTableFilter();
 }
 TSVTableReader::TSVTableReader(InStream* mainFrom, int useEscapes, uintptr_t numThread, ThreadPool* mainPool){
-	baseRead = new DelimitedTableReader('\n', '\t', mainFrom, numThread, mainPool);
+	baseRead = useEscapes ? new DelimitedTableReader('\n', '\t', '\\', -1, mainFrom, numThread, mainPool) : new DelimitedTableReader('\n', '\t', mainFrom, numThread, mainPool);
 	trimEscape = new TSVTableMutator(0, useEscapes ? 1 : 0, numThread, mainPool);
 	killEmpties = new TSVTableFilter(numThread, mainPool);
 }
@@ -784,10 +952,26 @@ void TSVTableWriter::close(){
 	baseRead->close();
 }
 
-TSVTableMutator::TSVTableMutator(int isPack, int wantEscape) : TextTableMutate(){
+SizePtrString whodun::tsvTrimSpace(SizePtrString toTrim){
+	SizePtrString toRet = toTrim;
+	while(toRet.len){
+		char curC = toRet.txt[0];
+		if((curC != ' ') && (curC != '\t') && (curC != '\r') && (curC != '\n')){ break; }
+		toRet.txt++;
+		toRet.len--;
+	}
+	while(toRet.len){
+		char curC = toRet.txt[toRet.len - 1];
+		if((curC != ' ') && (curC != '\t') && (curC != '\r') && (curC != '\n')){ break; }
+		toRet.len--;
+	}
+	return toRet;
+}
+
+TSVTableMutator::TSVTableMutator(int isPack, int wantEscape) : TextTableMutate(), escFind("\\", 1), packFind("\\\t\r\n", 4){
 	mutMode = (isPack << 1) | wantEscape;
 }
-TSVTableMutator::TSVTableMutator(int isPack, int wantEscape, uintptr_t numThread, ThreadPool* mainPool) : TextTableMutate(numThread, mainPool){
+TSVTableMutator::TSVTableMutator(int isPack, int wantEscape, uintptr_t numThread, ThreadPool* mainPool) : TextTableMutate(numThread, mainPool), escFind("\\", 1), packFind("\\\t\r\n", 4){
 	mutMode = (isPack << 1) | wantEscape;
 }
 TSVTableMutator::~TSVTableMutator(){}
@@ -803,7 +987,6 @@ std::pair<uintptr_t,uintptr_t> TSVTableMutator::neededSpace(TextTableRow* row){
 	return std::pair<uintptr_t,uintptr_t>(numCol,numByte);
 }
 void TSVTableMutator::mutate(TextTableRow* rowS, TextTableRow* rowD, SizePtrString* nextCol, char* nextByte){
-	StandardMemorySearcher cutUpS;
 	uintptr_t numCol = rowS->numCols;
 	rowD->numCols = numCol;
 	rowD->texts = nextCol;
@@ -811,7 +994,7 @@ void TSVTableMutator::mutate(TextTableRow* rowS, TextTableRow* rowD, SizePtrStri
 	switch(mutMode){
 		case 0:{ /*trim only*/
 			for(uintptr_t i = 0; i<numCol; i++){
-				SizePtrString curEnt = cutUpS.trim(rowS->texts[i]);
+				SizePtrString curEnt = tsvTrimSpace(rowS->texts[i]);
 				nextCol[i].txt = nextT;
 				nextCol[i].len = curEnt.len;
 				memcpy(nextT, curEnt.txt, curEnt.len);
@@ -820,28 +1003,31 @@ void TSVTableMutator::mutate(TextTableRow* rowS, TextTableRow* rowD, SizePtrStri
 		} break;
 		case 1:{ /*trim and fix up escapes*/
 			for(uintptr_t i = 0; i<numCol; i++){
-				SizePtrString curEnt = cutUpS.trim(rowS->texts[i]);
+				SizePtrString curEnt = tsvTrimSpace(rowS->texts[i]);
 				nextCol[i].txt = nextT;
 				uintptr_t finLen = 0;
 				uintptr_t j = 0;
 				while(j<curEnt.len){
-					if(curEnt.txt[j] == '\\'){
-						j++;
-						char winC;
-						if(j>curEnt.len){ winC = ' '; }
-						else{
-							switch(curEnt.txt[j]){
-								case 'n': winC = '\n'; break;
-								case 'r': winC = '\r'; break;
-								case 't': winC = '\t'; break;
-								default: winC = curEnt.txt[j];
-							}
-						}
-						*nextT = winC;
-					}
+					//copy up to the next escape
+					uintptr_t plainLen = escFind.findFirst(curEnt.txt + j, curEnt.len - j);
+					memcpy(nextT, curEnt.txt + j, plainLen);
+					nextT += plainLen;
+					finLen += plainLen;
+					j += plainLen;
+					if(j >= curEnt.len){ break; }
+					//handle the escape
+					j++;
+					char winC;
+					if(j>=curEnt.len){ winC = ' '; }
 					else{
-						*nextT = curEnt.txt[j];
+						switch(curEnt.txt[j]){
+							case 'n': winC = '\n'; break;
+							case 'r': winC = '\r'; break;
+							case 't': winC = '\t'; break;
+							default: winC = curEnt.txt[j];
+						}
 					}
+					*nextT = winC;
 					j++;
 					nextT++;
 					finLen++;
@@ -890,7 +1076,15 @@ void TSVTableMutator::mutate(TextTableRow* rowS, TextTableRow* rowD, SizePtrStri
 					}
 				//escape the text in the middle
 					while(j < k){
+						//copy up to the next thing needing an escape
+						uintptr_t plainLen = packFind.findFirst(curEnt.txt + j, k - j);
+						memcpy(nextT, curEnt.txt + j, plainLen);
+						nextT += plainLen;
+						j += plainLen;
+						if(j >= k){ break; }
 						switch(curEnt.txt[j]){
+							case '\\':
+								*nextT = '\\'; nextT++; *nextT = '\\'; nextT++; break;
 							case '\t':
 								*nextT = '\\'; nextT++; *nextT = 't'; nextT++; break;
 							case '\r':
@@ -933,6 +1127,401 @@ int TSVTableFilter::test(TextTableRow* row){
 	return row->texts->len > 0;
 }
 
+int whodun::textZoneCompare(const char* strA, uintptr_t lenA, const char* strB, uintptr_t lenB){
+	uintptr_t compLen = std::min(lenA, lenB);
+	int compV = compLen ? memcmp(strA, strB, compLen) : 0;
+	if(compV){ return compV; }
+	if(lenA < lenB){ return -1; }
+	return lenA > lenB;
+}
+
+uint64_t whodun::textZoneHash(SizePtrString toHash){
+	//fnv-1a
+	uint64_t curH = 0xCBF29CE484222325ULL;
+	const unsigned char* curT = (const unsigned char*)(toHash.txt);
+	for(uintptr_t i = 0; i<toHash.len; i++){
+		curH = (curH ^ curT[i]) * 0x100000001B3ULL;
+	}
+	//fnv is weak in the high bits, so mix it up
+	curH ^= (curH >> 33);
+	curH *= 0xFF51AFD7ED558CCDULL;
+	curH ^= (curH >> 33);
+	curH *= 0xC4CEB9FE1A85EC53ULL;
+	curH ^= (curH >> 33);
+	return curH;
+}
+
+/**The number of hashes each entry sets in a zone bloom filter.*/
+#define TEXTZONE_BLOOM_K 3
+
+TextTableColumnZone::TextTableColumnZone(){
+	reset(0);
+}
+TextTableColumnZone::~TextTableColumnZone(){}
+void TextTableColumnZone::reset(uintptr_t bloomBytes){
+	numNull = 0;
+	numNumber = 0;
+	numText = 0;
+	minNumber = 0.0;
+	maxNumber = 0.0;
+	minText.clear();
+	maxText.clear();
+	maxTextCut = 0;
+	bloom.assign(bloomBytes, (char)0);
+}
+void TextTableColumnZone::add(SizePtrString cellText){
+	if(cellText.len == 0){
+		numNull++;
+		return;
+	}
+	//numeric range
+		double curV;
+		char isBad;
+		parseFloatBatch(1, &cellText, &curV, &isBad);
+		if(!isBad && (curV == curV)){
+			if((numNumber == 0) || (curV < minNumber)){ minNumber = curV; }
+			if((numNumber == 0) || (curV > maxNumber)){ maxNumber = curV; }
+			numNumber++;
+		}
+		else{
+			numText++;
+		}
+	//text range (cut to a prefix: still a lower bound for the minimum)
+		uintptr_t cutLen = std::min(cellText.len, (uintptr_t)WHODUN_TEXTZONE_TEXT_MAX);
+		int isCut = cutLen < cellText.len;
+		if((numNumber + numText) == 1){
+			minText.assign(cellText.txt, cutLen);
+			maxText.assign(cellText.txt, cutLen);
+			maxTextCut = isCut;
+		}
+		else{
+			if(textZoneCompare(cellText.txt, cutLen, minText.c_str(), minText.size()) < 0){
+				minText.assign(cellText.txt, cutLen);
+			}
+			int maxComp = textZoneCompare(cellText.txt, cutLen, maxText.c_str(), maxText.size());
+			if(maxComp > 0){
+				maxText.assign(cellText.txt, cutLen);
+				maxTextCut = isCut;
+			}
+			else if(maxComp == 0){
+				maxTextCut = maxTextCut || isCut;
+			}
+		}
+	//bloom filter
+		uint64_t numBits = 8*(uint64_t)(bloom.size());
+		if(numBits){
+			uint64_t curH = textZoneHash(cellText);
+			uint64_t stepH = (curH >> 32) | 1;
+			for(int i = 0; i<TEXTZONE_BLOOM_K; i++){
+				uint64_t curB = curH % numBits;
+				bloom[curB >> 3] |= (char)(1 << (curB & 0x07));
+				curH += stepH;
+			}
+		}
+}
+void TextTableColumnZone::merge(TextTableColumnZone* toMerge){
+	numNull += toMerge->numNull;
+	if(toMerge->numNumber){
+		if((numNumber == 0) || (toMerge->minNumber < minNumber)){ minNumber = toMerge->minNumber; }
+		if((numNumber == 0) || (toMerge->maxNumber > maxNumber)){ maxNumber = toMerge->maxNumber; }
+	}
+	uintmax_t hadFull = numNumber + numText;
+	numNumber += toMerge->numNumber;
+	numText += toMerge->numText;
+	if(toMerge->numNumber + toMerge->numText){
+		if(hadFull == 0){
+			minText = toMerge->minText;
+			maxText = toMerge->maxText;
+			maxTextCut = toMerge->maxTextCut;
+		}
+		else{
+			if(textZoneCompare(toMerge->minText.c_str(), toMerge->minText.size(), minText.c_str(), minText.size()) < 0){
+				minText = toMerge->minText;
+			}
+			int maxComp = textZoneCompare(toMerge->maxText.c_str(), toMerge->maxText.size(), maxText.c_str(), maxText.size());
+			if(maxComp > 0){
+				maxText = toMerge->maxText;
+				maxTextCut = toMerge->maxTextCut;
+			}
+			else if(maxComp == 0){
+				maxTextCut = maxTextCut || toMerge->maxTextCut;
+			}
+		}
+	}
+	if(bloom.size() != toMerge->bloom.size()){ throw std::runtime_error("Bloom filter size mismatch."); }
+	for(uintptr_t i = 0; i<bloom.size(); i++){
+		bloom[i] |= toMerge->bloom[i];
+	}
+}
+int TextTableColumnZone::bloomMaybe(SizePtrString cellText){
+	uint64_t numBits = 8*(uint64_t)(bloom.size());
+	if(numBits == 0){ return 1; }
+	uint64_t curH = textZoneHash(cellText);
+	uint64_t stepH = (curH >> 32) | 1;
+	for(int i = 0; i<TEXTZONE_BLOOM_K; i++){
+		uint64_t curB = curH % numBits;
+		if(!(bloom[curB >> 3] & (char)(1 << (curB & 0x07)))){ return 0; }
+		curH += stepH;
+	}
+	return 1;
+}
+
+TextTableBlockZone::TextTableBlockZone(){
+	numRows = 0;
+	bloomBytes = 0;
+}
+TextTableBlockZone::~TextTableBlockZone(){}
+void TextTableBlockZone::reset(uintptr_t bloomBytes){
+	numRows = 0;
+	this->bloomBytes = bloomBytes;
+	cols.clear();
+}
+void TextTableBlockZone::add(TextTableRow* toAdd){
+	uintptr_t numCols = toAdd->numCols;
+	//new columns were null for everything before
+	while(cols.size() < numCols){
+		cols.push_back(TextTableColumnZone());
+		TextTableColumnZone* newC = &(cols[cols.size()-1]);
+		newC->reset(bloomBytes);
+		newC->numNull = numRows;
+	}
+	for(uintptr_t i = 0; i<numCols; i++){
+		cols[i].add(toAdd->texts[i]);
+	}
+	for(uintptr_t i = numCols; i<cols.size(); i++){
+		cols[i].numNull++;
+	}
+	numRows++;
+}
+void TextTableBlockZone::merge(TextTableBlockZone* toMerge){
+	while(cols.size() < toMerge->cols.size()){
+		cols.push_back(TextTableColumnZone());
+		TextTableColumnZone* newC = &(cols[cols.size()-1]);
+		newC->reset(bloomBytes);
+		newC->numNull = numRows;
+	}
+	for(uintptr_t i = 0; i<toMerge->cols.size(); i++){
+		cols[i].merge(&(toMerge->cols[i]));
+	}
+	for(uintptr_t i = toMerge->cols.size(); i<cols.size(); i++){
+		cols[i].numNull += toMerge->numRows;
+	}
+	numRows += toMerge->numRows;
+}
+
+void whodun::textZoneWrite(TextTableBlockZone* toPack, StructVector<char>* toFill){
+	uintptr_t numCols = toPack->cols.size();
+	//figure the size
+		uintptr_t packSize = 16;
+		for(uintptr_t i = 0; i<numCols; i++){
+			TextTableColumnZone* curC = &(toPack->cols[i]);
+			packSize += (8*8 + curC->minText.size() + curC->maxText.size() + toPack->bloomBytes);
+		}
+		uintptr_t origSize = toFill->size();
+		toFill->resize(origSize + packSize);
+	//and pack
+		BytePacker curPack((*toFill)[origSize]);
+		curPack.packBE64(toPack->numRows);
+		curPack.packBE64(numCols);
+		for(uintptr_t i = 0; i<numCols; i++){
+			TextTableColumnZone* curC = &(toPack->cols[i]);
+			curPack.packBE64(curC->numNull);
+			curPack.packBE64(curC->numNumber);
+			curPack.packBE64(curC->numText);
+			curPack.packBEDbl(curC->minNumber);
+			curPack.packBEDbl(curC->maxNumber);
+			curPack.packBE64(curC->maxTextCut);
+			curPack.packBE64(curC->minText.size());
+			memcpy(curPack.target, curC->minText.c_str(), curC->minText.size());
+			curPack.skip(curC->minText.size());
+			curPack.packBE64(curC->maxText.size());
+			memcpy(curPack.target, curC->maxText.c_str(), curC->maxText.size());
+			curPack.skip(curC->maxText.size());
+			memcpy(curPack.target, curC->bloom.c_str(), toPack->bloomBytes);
+			curPack.skip(toPack->bloomBytes);
+		}
+}
+
+uintptr_t whodun::textZoneRead(TextTableBlockZone* toFill, const char* fromData, uintptr_t numData){
+	#define TEXTZONE_NEED(numNeed) if((numData - numUsed) < (numNeed)){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file truncated.", 0, 0); }
+	uintptr_t numUsed = 0;
+	ByteUnpacker curUnp((char*)fromData);
+	TEXTZONE_NEED(16)
+	uintmax_t numRows = curUnp.unpackBE64();
+	uintmax_t numCols = curUnp.unpackBE64();
+	numUsed += 16;
+	uintptr_t bloomBytes = toFill->bloomBytes;
+	toFill->reset(bloomBytes);
+	toFill->numRows = numRows;
+	for(uintmax_t i = 0; i<numCols; i++){
+		TEXTZONE_NEED(7*8)
+		toFill->cols.push_back(TextTableColumnZone());
+		TextTableColumnZone* curC = &(toFill->cols[toFill->cols.size()-1]);
+		curC->numNull = curUnp.unpackBE64();
+		curC->numNumber = curUnp.unpackBE64();
+		curC->numText = curUnp.unpackBE64();
+		curC->minNumber = curUnp.unpackBEDbl();
+		curC->maxNumber = curUnp.unpackBEDbl();
+		curC->maxTextCut = curUnp.unpackBE64() != 0;
+		uintmax_t minLen = curUnp.unpackBE64();
+		numUsed += 7*8;
+		TEXTZONE_NEED(minLen)
+		curC->minText.assign(curUnp.target, minLen);
+		curUnp.skip(minLen);
+		numUsed += minLen;
+		TEXTZONE_NEED(8)
+		uintmax_t maxLen = curUnp.unpackBE64();
+		numUsed += 8;
+		TEXTZONE_NEED(maxLen)
+		curC->maxText.assign(curUnp.target, maxLen);
+		curUnp.skip(maxLen);
+		numUsed += maxLen;
+		TEXTZONE_NEED(bloomBytes)
+		curC->bloom.assign(curUnp.target, bloomBytes);
+		curUnp.skip(bloomBytes);
+		numUsed += bloomBytes;
+		if((curC->numNull + curC->numNumber + curC->numText) != numRows){
+			throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file counts do not add up.", 0, 0);
+		}
+	}
+	#undef TEXTZONE_NEED
+	return numUsed;
+}
+
+TextTablePredicate::TextTablePredicate() : TextTableFilter(){}
+TextTablePredicate::TextTablePredicate(uintptr_t numThread, ThreadPool* mainPool) : TextTableFilter(numThread,mainPool){}
+TextTablePredicate::~TextTablePredicate(){}
+int TextTablePredicate::test(TextTableRow* row){
+	for(uintptr_t i = 0; i<conds.size(); i++){
+		TextTableCondition* curC = &(conds[i]);
+		SizePtrString curT;
+			curT.len = 0;
+			curT.txt = 0;
+			if(curC->column < row->numCols){ curT = row->texts[curC->column]; }
+		//null tests
+			if(curC->op == WHODUN_TEXTPRED_NULL){
+				if(curT.len){ return 0; }
+				continue;
+			}
+			if(curC->op == WHODUN_TEXTPRED_NOTNULL){
+				if(curT.len == 0){ return 0; }
+				continue;
+			}
+			if(curT.len == 0){ return 0; }
+		//comparisons
+			int compV;
+			if(curC->numeric){
+				double curV;
+				char isBad;
+				parseFloatBatch(1, &curT, &curV, &isBad);
+				if(isBad || (curV != curV)){ return 0; }
+				compV = (curV < curC->numValue) ? -1 : ((curV > curC->numValue) ? 1 : 0);
+			}
+			else{
+				compV = textZoneCompare(curT.txt, curT.len, curC->textValue.c_str(), curC->textValue.size());
+			}
+			int isPass;
+			switch(curC->op){
+				case WHODUN_TEXTPRED_EQ: isPass = compV == 0; break;
+				case WHODUN_TEXTPRED_NE: isPass = compV != 0; break;
+				case WHODUN_TEXTPRED_LT: isPass = compV < 0; break;
+				case WHODUN_TEXTPRED_LE: isPass = compV <= 0; break;
+				case WHODUN_TEXTPRED_GT: isPass = compV > 0; break;
+				case WHODUN_TEXTPRED_GE: isPass = compV >= 0; break;
+				default:
+					throw std::runtime_error("Unknown predicate operation.");
+			}
+			if(!isPass){ return 0; }
+	}
+	return 1;
+}
+void TextTablePredicate::addText(uintptr_t column, int op, SizePtrString value){
+	conds.push_back(TextTableCondition());
+	TextTableCondition* newC = &(conds[conds.size()-1]);
+	newC->column = column;
+	newC->op = op;
+	newC->numeric = 0;
+	newC->textValue.assign(value.txt, value.len);
+	newC->numValue = 0.0;
+}
+void TextTablePredicate::addNumber(uintptr_t column, int op, double value){
+	conds.push_back(TextTableCondition());
+	TextTableCondition* newC = &(conds[conds.size()-1]);
+	newC->column = column;
+	newC->op = op;
+	newC->numeric = 1;
+	newC->numValue = value;
+}
+int TextTablePredicate::mightMatch(TextTableBlockZone* block){
+	for(uintptr_t i = 0; i<conds.size(); i++){
+		TextTableCondition* curC = &(conds[i]);
+		//columns past the end are all null
+			TextTableColumnZone allNull;
+			TextTableColumnZone* curZ;
+			if(curC->column < block->cols.size()){
+				curZ = &(block->cols[curC->column]);
+			}
+			else{
+				allNull.numNull = block->numRows;
+				curZ = &allNull;
+			}
+		//null tests
+			if(curC->op == WHODUN_TEXTPRED_NULL){
+				if(curZ->numNull == 0){ return 0; }
+				continue;
+			}
+			uintmax_t numFull = curZ->numNumber + curZ->numText;
+			if(numFull == 0){ return 0; }
+			if(curC->op == WHODUN_TEXTPRED_NOTNULL){ continue; }
+		//numeric ranges
+			if(curC->numeric){
+				if(curZ->numNumber == 0){ return 0; }
+				double testV = curC->numValue;
+				int isPass;
+				switch(curC->op){
+					case WHODUN_TEXTPRED_EQ: isPass = (curZ->minNumber <= testV) && (curZ->maxNumber >= testV); break;
+					case WHODUN_TEXTPRED_NE: isPass = !((curZ->minNumber == testV) && (curZ->maxNumber == testV)); break;
+					case WHODUN_TEXTPRED_LT: isPass = curZ->minNumber < testV; break;
+					case WHODUN_TEXTPRED_LE: isPass = curZ->minNumber <= testV; break;
+					case WHODUN_TEXTPRED_GT: isPass = curZ->maxNumber > testV; break;
+					case WHODUN_TEXTPRED_GE: isPass = curZ->maxNumber >= testV; break;
+					default:
+						throw std::runtime_error("Unknown predicate operation.");
+				}
+				if(!isPass){ return 0; }
+				continue;
+			}
+		//text ranges
+			const char* testT = curC->textValue.c_str();
+			uintptr_t testL = curC->textValue.size();
+			int minComp = textZoneCompare(curZ->minText.c_str(), curZ->minText.size(), testT, testL);
+			int maxComp = textZoneCompare(curZ->maxText.c_str(), curZ->maxText.size(), testT, testL);
+			//a cut maximum is a prefix of the real one: anything starting with it might be passed
+			int maxPrefix = curZ->maxTextCut && (testL >= curZ->maxText.size()) && (memcmp(testT, curZ->maxText.c_str(), curZ->maxText.size()) == 0);
+			int isPass;
+			switch(curC->op){
+				case WHODUN_TEXTPRED_EQ:
+					isPass = (minComp <= 0) && ((maxComp >= 0) || maxPrefix);
+					if(isPass){
+						SizePtrString testS;
+							testS.len = testL;
+							testS.txt = (char*)testT;
+						isPass = curZ->bloomMaybe(testS);
+					}
+					break;
+				case WHODUN_TEXTPRED_NE: isPass = !((minComp == 0) && (maxComp == 0) && !(curZ->maxTextCut)); break;
+				case WHODUN_TEXTPRED_LT: isPass = minComp < 0; break;
+				case WHODUN_TEXTPRED_LE: isPass = minComp <= 0; break;
+				case WHODUN_TEXTPRED_GT: isPass = (maxComp > 0) || maxPrefix; break;
+				case WHODUN_TEXTPRED_GE: isPass = (maxComp >= 0) || maxPrefix; break;
+				default:
+					throw std::runtime_error("Unknown predicate operation.");
+			}
+			if(!isPass){ return 0; }
+	}
+	return 1;
+}
+
 //annotation for block-compressed table is just the address of the entry
 //entries are stored N_cell {len text[]}[]
 #define BLOCKCOMPTAB_ANNOT_ENTLEN 8
@@ -943,6 +1532,10 @@ ChunkyTextTableReader::ChunkyTextTableReader(RandaccInStream* annotationFile, Ra
 	usePool = 0;
 	needSeek = 1;
 	focusInd = 0;
+	nextInd = 0;
+	nextAddr = 0;
+	zoneRows = 0;
+	usePred = 0;
 	totalNInd = indStr->size();
 		if(totalNInd % BLOCKCOMPTAB_ANNOT_ENTLEN){
 			throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file not even.", 0, 0);
@@ -956,9 +1549,13 @@ ChunkyTextTableReader::ChunkyTextTableReader(RandaccInStream* annotationFile, Ra
 ChunkyTextTableReader::ChunkyTextTableReader(RandaccInStream* annotationFile, RandaccInStream* dataFile, uintptr_t numThread, ThreadPool* mainPool){
 	indStr = annotationFile;
 	tsvStr = dataFile;
-	usePool = 0;
+	usePool = mainPool;
 	needSeek = 1;
 	focusInd = 0;
+	nextInd = 0;
+	nextAddr = 0;
+	zoneRows = 0;
+	usePred = 0;
 	totalNInd = indStr->size();
 		if(totalNInd % BLOCKCOMPTAB_ANNOT_ENTLEN){
 			throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file not even.", 0, 0);
@@ -976,46 +1573,128 @@ ChunkyTextTableReader::~ChunkyTextTableReader(){
 }
 uintptr_t ChunkyTextTableReader::read(TextTable* toStore, uintptr_t numRows){
 	if(numRows == 0){ return 0; }
-	//seek if necessary
-		if(needSeek){
-			if(focusInd < totalNInd){
-				indStr->seek(BLOCKCOMPTAB_ANNOT_ENTLEN*focusInd);
-				saveARB.resize(BLOCKCOMPTAB_ANNOT_ENTLEN);
-				indStr->forceRead(saveARB[0], BLOCKCOMPTAB_ANNOT_ENTLEN);
-				ByteUnpacker getOffV(saveARB[0]);
-				tsvStr->seek(getOffV.unpackBE64());
-			}
-			needSeek = 0;
-		}
-	//figure out how many rows will actually be read
+	//figure out how many rows will actually be passed over
 		uintmax_t endFocInd = focusInd + numRows;
 			endFocInd = std::min(endFocInd, totalNInd);
 		uintptr_t numRealRead = endFocInd - focusInd;
-		int willHitEOF = endFocInd == totalNInd;
 		if(numRealRead == 0){ return 0; }
-	//load the annotation
-		saveARB.resize(BLOCKCOMPTAB_ANNOT_ENTLEN*(numRealRead + 1));
-		indStr->forceRead(saveARB[BLOCKCOMPTAB_ANNOT_ENTLEN], BLOCKCOMPTAB_ANNOT_ENTLEN*(numRealRead - willHitEOF));
-		if(willHitEOF){
-			BytePacker packOffV(saveARB[BLOCKCOMPTAB_ANNOT_ENTLEN*numRealRead]);
-			packOffV.packBE64(totalNByte);
+	//figure out which runs of rows need loading
+		loadRuns.clear();
+		if(usePred && zoneRows){
+			uintmax_t curInd = focusInd;
+			while(curInd < endFocInd){
+				uintmax_t curZone = curInd / zoneRows;
+				uintmax_t zoneEnd = std::min((curZone + 1) * zoneRows, endFocInd);
+				if(usePred->mightMatch(&(zones[curZone]))){
+					if(loadRuns.size() && (loadRuns[loadRuns.size()-1] == curInd)){
+						loadRuns[loadRuns.size()-1] = zoneEnd;
+					}
+					else{
+						loadRuns.push_back(curInd);
+						loadRuns.push_back(zoneEnd);
+					}
+				}
+				curInd = zoneEnd;
+			}
+		}
+		else{
+			loadRuns.push_back(focusInd);
+			loadRuns.push_back(endFocInd);
+		}
+		uintptr_t numLoad = 0;
+		for(uintptr_t ri = 0; ri<loadRuns.size(); ri += 2){
+			numLoad += (loadRuns[ri+1] - loadRuns[ri]);
+		}
+		if(numLoad == 0){
+			toStore->saveText.clear();
+			toStore->saveStrs.clear();
+			toStore->saveRows.clear();
+			focusInd = endFocInd;
+			return numRealRead;
+		}
+	//load the annotations (later runs are shifted to follow right after the earlier ones)
+		saveARB.resize(BLOCKCOMPTAB_ANNOT_ENTLEN*(numLoad + 1));
+		int textAtStart = !needSeek;
+		uintmax_t textAtAddr = nextAddr;
+		StructVector<uint64_t> runTextAddr;
+		runTextAddr.resize(loadRuns.size());
+		uintptr_t curLoadI = 0;
+		uintmax_t curVirtAddr = 0;
+		for(uintptr_t ri = 0; ri<loadRuns.size(); ri += 2){
+			uintmax_t runS = loadRuns[ri];
+			uintmax_t runE = loadRuns[ri+1];
+			uintptr_t runN = runE - runS;
+			int willHitEOF = runE == totalNInd;
+			//find where the run starts
+				uintmax_t runStartA;
+				if(needSeek || (runS != nextInd)){
+					char startARB[BLOCKCOMPTAB_ANNOT_ENTLEN];
+					indStr->seek(BLOCKCOMPTAB_ANNOT_ENTLEN*runS);
+					indStr->forceRead(startARB, BLOCKCOMPTAB_ANNOT_ENTLEN);
+					ByteUnpacker getOffV(startARB);
+					runStartA = getOffV.unpackBE64();
+				}
+				else{
+					runStartA = nextAddr;
+				}
+				needSeek = 0;
+				if(ri == 0){
+					curVirtAddr = runStartA;
+					BytePacker packOffV(saveARB[0]);
+					packOffV.packBE64(runStartA);
+				}
+			//get the addresses of the following rows
+				char* runARB = saveARB[BLOCKCOMPTAB_ANNOT_ENTLEN*(curLoadI + 1)];
+				indStr->forceRead(runARB, BLOCKCOMPTAB_ANNOT_ENTLEN*(runN - willHitEOF));
+				if(willHitEOF){
+					BytePacker packOffV(runARB + BLOCKCOMPTAB_ANNOT_ENTLEN*(runN - 1));
+					packOffV.packBE64(totalNByte);
+				}
+				uintmax_t runEndA;
+				{
+					ByteUnpacker getOffV(runARB + BLOCKCOMPTAB_ANNOT_ENTLEN*(runN - 1));
+					runEndA = getOffV.unpackBE64();
+				}
+				if(runEndA < runStartA){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file not monotonic.", 0, 0); }
+				nextInd = runE;
+				nextAddr = runEndA;
+			//shift to follow the previous run
+				if(curVirtAddr != runStartA){
+					uint64_t addrShift = curVirtAddr - runStartA;
+					ByteUnpacker getOffV(runARB);
+					BytePacker packOffV(runARB);
+					for(uintptr_t i = 0; i<runN; i++){
+						packOffV.packBE64(getOffV.unpackBE64() + addrShift);
+					}
+				}
+				*(runTextAddr[ri]) = runStartA;
+				*(runTextAddr[ri+1]) = runEndA;
+				curVirtAddr += (runEndA - runStartA);
+				curLoadI += runN;
 		}
 	//load the text
 		uintmax_t startTAddr;
-		uintmax_t endTAddr;
 		{
 			ByteUnpacker getOffV(saveARB[0]);
 			startTAddr = getOffV.unpackBE64();
-			getOffV.retarget(saveARB[BLOCKCOMPTAB_ANNOT_ENTLEN*numRealRead]);
-			endTAddr = getOffV.unpackBE64();
 		}
 		toStore->saveText.clear();
-		toStore->saveText.resize(endTAddr - startTAddr);
-		tsvStr->forceRead(toStore->saveText[0], endTAddr - startTAddr);
+		toStore->saveText.resize(curVirtAddr - startTAddr);
+		uintptr_t curTextOff = 0;
+		for(uintptr_t ri = 0; ri<loadRuns.size(); ri += 2){
+			uintmax_t runStartA = *(runTextAddr[ri]);
+			uintmax_t runEndA = *(runTextAddr[ri+1]);
+			uintmax_t prevEndA = (ri == 0) ? textAtAddr : *(runTextAddr[ri-1]);
+			if(((ri == 0) && !textAtStart) || (runStartA != prevEndA)){
+				tsvStr->seek(runStartA);
+			}
+			tsvStr->forceRead(toStore->saveText[curTextOff], runEndA - runStartA);
+			curTextOff += (runEndA - runStartA);
+		}
 	//figure out how many columns there are
 		uintptr_t numThread = passUnis.size();
-		uintptr_t numPT = numRealRead / numThread;
-		uintptr_t numET = numRealRead % numThread;
+		uintptr_t numPT = numLoad / numThread;
+		uintptr_t numET = numLoad % numThread;
 		uintptr_t curRN = 0;
 		for(uintptr_t i = 0; i<numThread; i++){
 			ChunkyTableReadTask* curT = (ChunkyTableReadTask*)(passUnis[i]);
@@ -1045,7 +1724,7 @@ uintptr_t ChunkyTextTableReader::read(TextTable* toStore, uintptr_t numRows){
 		toStore->saveStrs.clear();
 		toStore->saveRows.clear();
 		toStore->saveStrs.resize(totalNC);
-		toStore->saveRows.resize(numRealRead);
+		toStore->saveRows.resize(numLoad);
 		if(usePool){
 			usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
 			joinTasks(numThread, &(passUnis[0]));
@@ -1053,8 +1732,10 @@ uintptr_t ChunkyTextTableReader::read(TextTable* toStore, uintptr_t numRows){
 		else{
 			passUnis[0]->doTask();
 		}
-	//and prepare for the next round
-		memcpy(saveARB[0], saveARB[BLOCKCOMPTAB_ANNOT_ENTLEN*numRealRead], BLOCKCOMPTAB_ANNOT_ENTLEN);
+	//drop anything that does not pass
+		if(usePred){
+			usePred->filter(toStore, toStore);
+		}
 		focusInd = endFocInd;
 	return numRealRead;
 }
@@ -1070,20 +1751,52 @@ void ChunkyTextTableReader::seek(uintmax_t index){
 		needSeek = 1;
 	}
 }
+void ChunkyTextTableReader::loadZones(InStream* zoneFile){
+	std::vector<char> allZone;
+	zoneFile->readAll(&allZone);
+	if(allZone.size() < 16){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file missing header.", 0, 0); }
+	ByteUnpacker getHead(&(allZone[0]));
+	uintmax_t blockRows = getHead.unpackBE64();
+	uintmax_t bloomBytes = getHead.unpackBE64();
+	if(blockRows == 0){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file has empty blocks.", 0, 0); }
+	std::vector<TextTableBlockZone> newZones;
+	uintptr_t curOff = 16;
+	uintmax_t totalRows = 0;
+	while(curOff < allZone.size()){
+		if(totalRows % blockRows){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file has short block before end.", 0, 0); }
+		newZones.push_back(TextTableBlockZone());
+		TextTableBlockZone* curZ = &(newZones[newZones.size()-1]);
+		curZ->bloomBytes = bloomBytes;
+		curOff += textZoneRead(curZ, &(allZone[curOff]), allZone.size() - curOff);
+		if((curZ->numRows == 0) || (curZ->numRows > blockRows)){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file block has a bad size.", 0, 0); }
+		totalRows += curZ->numRows;
+	}
+	if(totalRows != totalNInd){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Zone file does not match table.", 0, 0); }
+	zones.swap(newZones);
+	zoneRows = blockRows;
+}
+void ChunkyTextTableReader::setPredicate(TextTablePredicate* toUse){
+	usePred = toUse;
+}
 
 ChunkyTableReadTask::ChunkyTableReadTask(){}
 ChunkyTableReadTask::~ChunkyTableReadTask(){}
 void ChunkyTableReadTask::doTask(){
+	if(phase == 1){ totalColumns = 0; }
 	if(fromRI == toRI){ return; }
 	if(phase == 1){
-		totalColumns = 0;
+		uintptr_t numRows = toRI - fromRI;
+		rowAddrs.resize(numRows + 2);
 		ByteUnpacker getOffV(annotData);
-		uintmax_t baseAddr = getOffV.unpackBE64();
+		getOffV.unpackBE64Array(rowAddrs[0], 1);
 		getOffV.retarget(annotData + BLOCKCOMPTAB_ANNOT_ENTLEN*fromRI);
-		uintmax_t curAddr = getOffV.unpackBE64();
+		getOffV.unpackBE64Array(rowAddrs[1], numRows + 1);
+		uint64_t* curAddrs = rowAddrs[1];
+		uintmax_t baseAddr = *rowAddrs[0];
+		uintmax_t curAddr = curAddrs[0];
 		if(curAddr < baseAddr){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file not monotonic.", 0, 0); }
-		for(uintptr_t i = fromRI; i<toRI; i++){
-			uintmax_t nextAddr = getOffV.unpackBE64();
+		for(uintptr_t i = 1; i<=numRows; i++){
+			uintmax_t nextAddr = curAddrs[i];
 			if(nextAddr < curAddr){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file not monotonic.", 0, 0); }
 			if((nextAddr - curAddr) < 8){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file entry too short.", 0, 0); }
 			if((nextAddr - baseAddr) > textData.len){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index file out of order.", 0, 0); }
@@ -1095,12 +1808,12 @@ void ChunkyTableReadTask::doTask(){
 	else{
 		TextTableRow* fillRow = toStore->saveRows[fromRI];
 		SizePtrString* fillCol = toStore->saveStrs[columnOffset];
-		ByteUnpacker getOffV(annotData);
-		uintmax_t baseAddr = getOffV.unpackBE64();
-		getOffV.retarget(annotData + BLOCKCOMPTAB_ANNOT_ENTLEN*fromRI);
-		uintmax_t curAddr = getOffV.unpackBE64();
-		for(uintptr_t i = fromRI; i<toRI; i++){
-			uintmax_t nextAddr = getOffV.unpackBE64();
+		uintptr_t numRows = toRI - fromRI;
+		uint64_t* curAddrs = rowAddrs[1];
+		uintmax_t baseAddr = *rowAddrs[0];
+		uintmax_t curAddr = curAddrs[0];
+		for(uintptr_t i = 1; i<=numRows; i++){
+			uintmax_t nextAddr = curAddrs[i];
 			uintptr_t totalRowS = nextAddr - curAddr;
 			uintptr_t totalEatS = 0;
 			ByteUnpacker getCCnt(textData.txt + (curAddr - baseAddr));
@@ -1130,6 +1843,11 @@ ChunkyTextTableWriter::ChunkyTextTableWriter(OutStream* annotationFile, OutStrea
 	tsvStr = dataFile;
 	usePool = 0;
 	totalOutData = 0;
+	zoneStr = 0;
+	zoneRows = 0;
+	zoneBloom = 0;
+	zoneRowsSeen = 0;
+	curZoneInd = 0;
 	{
 		passUnis.push_back(new ChunkyTableWriteTask());
 	}
@@ -1139,6 +1857,11 @@ ChunkyTextTableWriter::ChunkyTextTableWriter(OutStream* annotationFile, OutStrea
 	tsvStr = dataFile;
 	usePool = mainPool;
 	totalOutData = 0;
+	zoneStr = 0;
+	zoneRows = 0;
+	zoneBloom = 0;
+	zoneRowsSeen = 0;
+	curZoneInd = 0;
 	for(uintptr_t i = 0; i<numThread; i++){
 		passUnis.push_back(new ChunkyTableWriteTask());
 	}
@@ -1163,6 +1886,9 @@ void ChunkyTextTableWriter::write(TextTableView* toStore){
 			curRN += (numPT + (i<numET));
 			curT->toRI = curRN;
 			curT->toStore = toStore;
+			curT->zoneRows = zoneRows;
+			curT->zoneBloom = zoneBloom;
+			curT->zoneRowBase = zoneRowsSeen;
 		}
 		if(usePool){
 			usePool->addTasks(numThread, (JoinableThreadTask**)&(passUnis[0]));
@@ -1176,6 +1902,23 @@ void ChunkyTextTableWriter::write(TextTableView* toStore){
 			ChunkyTableWriteTask* curT = (ChunkyTableWriteTask*)(passUnis[i]);
 			totalNB += curT->numEatBytes;
 		}
+	//gather up any statistics
+		if(zoneRows){
+			packZone.clear();
+			for(uintptr_t i = 0; i<numThread; i++){
+				ChunkyTableWriteTask* curT = (ChunkyTableWriteTask*)(passUnis[i]);
+				for(uintptr_t j = 0; j<curT->numZoneParts; j++){
+					curZone.merge(&(curT->zoneParts[j]));
+					if(curZone.numRows >= zoneRows){
+						textZoneWrite(&curZone, &packZone);
+						curZone.reset(zoneBloom);
+						curZoneInd++;
+					}
+				}
+			}
+			if(packZone.size()){ zoneStr->write(packZone[0], packZone.size()); }
+			zoneRowsSeen += numRows;
+		}
 	//pack for the output
 		packARB.resize(BLOCKCOMPTAB_ANNOT_ENTLEN*numRows);
 		packDatums.resize(totalNB);
@@ -1202,9 +1945,32 @@ void ChunkyTextTableWriter::write(TextTableView* toStore){
 	//and dump
 		indStr->write(packARB[0], BLOCKCOMPTAB_ANNOT_ENTLEN*numRows);
 		tsvStr->write(packDatums[0], totalNB);
+		totalOutData += totalNB;
 }
 void ChunkyTextTableWriter::close(){
 	isClosed = 1;
+	if(zoneRows && curZone.numRows){
+		packZone.clear();
+		textZoneWrite(&curZone, &packZone);
+		zoneStr->write(packZone[0], packZone.size());
+		curZone.reset(zoneBloom);
+		curZoneInd++;
+	}
+}
+void ChunkyTextTableWriter::recordZones(OutStream* zoneFile, uintptr_t blockRows, uintptr_t bloomBytes){
+	if(totalOutData){ throw std::runtime_error("Zones must be set up before writing."); }
+	if(blockRows == 0){ throw std::runtime_error("Zones need at least one row."); }
+	zoneStr = zoneFile;
+	zoneRows = blockRows;
+	zoneBloom = bloomBytes;
+	zoneRowsSeen = 0;
+	curZoneInd = 0;
+	curZone.reset(zoneBloom);
+	packZone.resize(16);
+	BytePacker curPack(packZone[0]);
+	curPack.packBE64(blockRows);
+	curPack.packBE64(bloomBytes);
+	zoneStr->write(packZone[0], 16);
 }
 
 ChunkyTableWriteTask::ChunkyTableWriteTask(){}
@@ -1222,14 +1988,33 @@ void ChunkyTableWriteTask::doTask(){
 			}
 			curFocR++;
 		}
+		//statistics for each piece of a zone
+		numZoneParts = 0;
+		if(zoneRows){
+			uintmax_t lastZone = 0;
+			curFocR = toStore->saveRows[fromRI];
+			for(uintptr_t i = fromRI; i<toRI; i++){
+				uintmax_t curZone = (zoneRowBase + i) / zoneRows;
+				if((numZoneParts == 0) || (curZone != lastZone)){
+					if(numZoneParts >= zoneParts.size()){ zoneParts.push_back(TextTableBlockZone()); }
+					zoneParts[numZoneParts].reset(zoneBloom);
+					numZoneParts++;
+					lastZone = curZone;
+				}
+				zoneParts[numZoneParts-1].add(curFocR);
+				curFocR++;
+			}
+		}
 	}
 	else{
-		BytePacker curPackA(annotData);
 		uintmax_t curByteI = startByteI;
 		BytePacker curPackD(tableData);
 		TextTableRow* curFocR = toStore->saveRows[fromRI];
+		rowAddrs.resize(toRI - fromRI);
+		uint64_t* curRowA = rowAddrs[0];
 		for(uintptr_t i = fromRI; i<toRI; i++){
-			curPackA.packBE64(curByteI);
+			*curRowA = curByteI;
+			curRowA++;
 			curPackD.packBE64(curFocR->numCols); curByteI += 8;
 			SizePtrString* curFocC = curFocR->texts;
 			for(uintptr_t j = 0; j<curFocR->numCols; j++){
@@ -1240,6 +2025,10 @@ void ChunkyTableWriteTask::doTask(){
 			}
 			curFocR++;
 		}
+		if(toRI != fromRI){
+			BytePacker curPackA(annotData);
+			curPackA.packBE64Array(rowAddrs[0], toRI - fromRI);
+		}
 	}
 }
 
@@ -1,8 +1,9 @@
 #include "whodun_string.h"
 
-#include <math.h>
+#include <algorithm>
 #include <string.h>
 #include <exception>
+#include <stdexcept>
 
 using namespace whodun;
 
@@ -30,73 +31,6 @@ SizePtrString whodun::toSizePtr(uintptr_t packLen, char* toPackage){
 		toRet.txt = toPackage;
 	return toRet;
 }
-intptr_t whodun::parseInt(SizePtrString toParse){
-	int needFlip = 0;
-	intptr_t toRet = 0;
-	SizePtrString curParse = toParse;
-	if(curParse.len == 0){ throw std::runtime_error("Empty string passed to parse int."); }
-	char leadChar = curParse.txt[0];
-	if(leadChar == '+'){ curParse.len--; curParse.txt++; }
-	else if(leadChar == '-'){ needFlip = 1; curParse.len--; curParse.txt++; }
-	if(curParse.len == 0){ throw std::runtime_error("No digits passed to parse int."); }
-	while(curParse.len){
-		int curV = curParse.txt[0];
-		if((curV < '0') || (curV > '9')){ throw std::runtime_error("Invalid digit passed to parse int."); }
-		toRet = (10*toRet) + (curV - '0');
-		curParse.txt++;
-		curParse.len--;
-	}
-	if(needFlip){ toRet = -toRet; }
-	return toRet;
-}
-double whodun::parseFloat(SizePtrString toParse){
-	int needFlip = 0;
-	double manval = 0;
-	intptr_t expVal = 0;
-	SizePtrString curParse = toParse;
-	if(curParse.len == 0){ throw std::runtime_error("Empty string passed to parse float."); }
-	//get the sign out of the way
-		char leadChar = curParse.txt[0];
-		if(leadChar == '+'){ curParse.len--; curParse.txt++; }
-		else if(leadChar == '-'){ needFlip = 1; curParse.len--; curParse.txt++; }
-		if(curParse.len == 0){ throw std::runtime_error("No digits passed to parse float."); }
-	//handle special values
-		if(curParse == toSizePtr("nan")){
-			return (needFlip ? -0.0 : 0.0) / 0.0;
-		}
-		if(curParse == toSizePtr("inf")){
-			return (needFlip ? -1.0 : 1.0) / 0.0;
-		}
-	//read to the decimal
-		while(curParse.len){
-			int curV = curParse.txt[0];
-			if((curV == '.') || (curV == 'e') || (curV == 'E')){ break; }
-			if((curV < '0') || (curV > '9')){ throw std::runtime_error("Invalid digit passed to parse float."); }
-			manval = (10*manval) + curV;
-		}
-	//read off the fractional part
-		if(curParse.len && (curParse.txt[0] == '.')){
-			curParse.len--;
-			curParse.txt++;
-			double curMulV = 0.1;
-			while(curParse.len){
-				int curV = curParse.txt[0];
-				if((curV == 'e') || (curV == 'E')){ break; }
-				if((curV < '0') || (curV > '9')){ throw std::runtime_error("Invalid digit passed to parse float."); }
-				manval = manval + (curMulV * curV);
-				curMulV = 0.1 * curMulV;
-			}
-		}
-	//read the exponent
-		if(curParse.len){
-			curParse.len--;
-			curParse.txt++;
-			expVal = parseInt(curParse);
-		}
-	//return the result
-		return (needFlip ? -1.0 : 1.0) * manval * pow(10.0,expVal);
-}
-
 bool whodun::operator < (const SizePtrString& strA, const SizePtrString& strB){
 	uintptr_t compTo = std::min(strA.len, strB.len);
 	int compV = memcmp(strA.txt, strB.txt, compTo);
@@ -227,6 +161,96 @@ char* StandardMemorySearcher::memmem(const char* str1, size_t numB1, const char*
 	return (char*)::memmem(str1, numB1, str2, numB2);
 }
 
+ByteSetSearcher::ByteSetSearcher(){
+	setBytes(0, 0);
+}
+ByteSetSearcher::ByteSetSearcher(const char* useChars, size_t numChars){
+	setBytes(useChars, numChars);
+}
+ByteSetSearcher::~ByteSetSearcher(){}
+void ByteSetSearcher::setBytes(const char* useChars, size_t numChars){
+	memset(lowRow, 0, 16);
+	memset(highRow, 0, 16);
+	for(size_t i = 0; i<numChars; i++){
+		int curB = 0x00FF & useChars[i];
+		int highN = curB >> 4;
+		if(highN < 8){
+			lowRow[curB & 0x0F] |= (1 << highN);
+		}
+		else{
+			highRow[curB & 0x0F] |= (1 << (highN - 8));
+		}
+	}
+}
+int ByteSetSearcher::contains(char toTest){
+	int curB = 0x00FF & toTest;
+	int highN = curB >> 4;
+	unsigned char useRow = (highN < 8) ? lowRow[curB & 0x0F] : highRow[curB & 0x0F];
+	return (useRow >> (highN & 0x07)) & 1;
+}
+size_t ByteSetSearcher::findFirst(const char* str, size_t numB){
+	size_t curBase = 0;
+	while(curBase < numB){
+		size_t curNum = std::min((size_t)64, numB - curBase);
+		uint64_t curMask = mask64(str + curBase, curNum);
+		if(curMask){ return curBase + __builtin_ctzll(curMask); }
+		curBase += curNum;
+	}
+	return numB;
+}
+size_t ByteSetSearcher::findFirstNot(const char* str, size_t numB){
+	size_t curBase = 0;
+	while(curBase < numB){
+		size_t curNum = std::min((size_t)64, numB - curBase);
+		uint64_t curMask = ~mask64(str + curBase, curNum);
+		if(curNum < 64){ curMask = curMask & ((((uint64_t)1) << curNum) - 1); }
+		if(curMask){ return curBase + __builtin_ctzll(curMask); }
+		curBase += curNum;
+	}
+	return numB;
+}
+
+ByteClassSearcher::ByteClassSearcher(){
+	setBytes(0, 0);
+}
+ByteClassSearcher::ByteClassSearcher(const char* useChars, size_t numChars){
+	setBytes(useChars, numChars);
+}
+ByteClassSearcher::~ByteClassSearcher(){}
+void ByteClassSearcher::setBytes(const char* useChars, size_t numChars){
+	if(numChars > WHODUN_BYTECLASS_MAX){ throw std::runtime_error("Too many bytes for a byte class search."); }
+	this->numChars = numChars;
+	memset(theChars, 0, WHODUN_BYTECLASS_MAX);
+	if(numChars){ memcpy(theChars, useChars, numChars); }
+}
+
+uint64_t whodun::maskEscaped64(uint64_t escMask, uint64_t* prevEscaped){
+	//an escape that was itself escaped starts nothing
+	escMask = escMask & ~(*prevEscaped);
+	uint64_t followsEscape = (escMask << 1) | *prevEscaped;
+	//a run of escapes escapes the next character if it is odd: odd runs starting on even bits end on even bits
+	uint64_t evenBits = 0x5555555555555555ULL;
+	uint64_t oddStarts = escMask & ~evenBits & ~followsEscape;
+	uint64_t evenStartRuns = oddStarts + escMask;
+	*prevEscaped = (evenStartRuns < oddStarts) ? 1 : 0;
+	uint64_t invertMask = evenStartRuns << 1;
+	return (evenBits ^ invertMask) & followsEscape;
+}
+
+uint64_t whodun::maskQuoted64(uint64_t quoteMask, uint64_t* prevQuoted){
+	//prefix xor: each bit is the parity of the quotes at or before it
+	uint64_t toRet = quoteMask;
+	toRet = toRet ^ (toRet << 1);
+	toRet = toRet ^ (toRet << 2);
+	toRet = toRet ^ (toRet << 4);
+	toRet = toRet ^ (toRet << 8);
+	toRet = toRet ^ (toRet << 16);
+	toRet = toRet ^ (toRet << 32);
+	toRet = toRet ^ *prevQuoted;
+	*prevQuoted = (uint64_t)(((int64_t)toRet) >> 63);
+	return toRet;
+}
+
 BytePacker::BytePacker(){}
 BytePacker::BytePacker(char* toFill){
 	target = toFill;
@@ -239,6 +263,40 @@ void BytePacker::skip(uintptr_t numSkip){
 	target += numSkip;
 }
 
+/**The number of values to convert at a time when widening or narrowing.*/
+#define WHODUN_PACK_CONVERT_CHUNK 256
+
+void BytePacker::packBE64Array(const uint32_t* toPack, uintptr_t numPack){
+	uint64_t tmpConv[WHODUN_PACK_CONVERT_CHUNK];
+	while(numPack){
+		uintptr_t curNum = std::min(numPack, (uintptr_t)WHODUN_PACK_CONVERT_CHUNK);
+		for(uintptr_t i = 0; i<curNum; i++){ tmpConv[i] = toPack[i]; }
+		packBE64Array(tmpConv, curNum);
+		toPack += curNum;
+		numPack -= curNum;
+	}
+}
+void BytePacker::packBE32Array(const uint64_t* toPack, uintptr_t numPack){
+	uint32_t tmpConv[WHODUN_PACK_CONVERT_CHUNK];
+	while(numPack){
+		uintptr_t curNum = std::min(numPack, (uintptr_t)WHODUN_PACK_CONVERT_CHUNK);
+		for(uintptr_t i = 0; i<curNum; i++){ tmpConv[i] = toPack[i]; }
+		packBE32Array(tmpConv, curNum);
+		toPack += curNum;
+		numPack -= curNum;
+	}
+}
+void BytePacker::packBEFltArray(const double* toPack, uintptr_t numPack){
+	float tmpConv[WHODUN_PACK_CONVERT_CHUNK];
+	while(numPack){
+		uintptr_t curNum = std::min(numPack, (uintptr_t)WHODUN_PACK_CONVERT_CHUNK);
+		for(uintptr_t i = 0; i<curNum; i++){ tmpConv[i] = toPack[i]; }
+		packBEFltArray(tmpConv, curNum);
+		toPack += curNum;
+		numPack -= curNum;
+	}
+}
+
 ByteUnpacker::ByteUnpacker(){}
 ByteUnpacker::ByteUnpacker(char* toFill){
 	target = toFill;
@@ -251,5 +309,33 @@ void ByteUnpacker::skip(uintptr_t numSkip){
 	target += numSkip;
 }
 
-
-
+void ByteUnpacker::unpackBE64Array(uint32_t* toFill, uintptr_t numUnpack){
+	uint64_t tmpConv[WHODUN_PACK_CONVERT_CHUNK];
+	while(numUnpack){
+		uintptr_t curNum = std::min(numUnpack, (uintptr_t)WHODUN_PACK_CONVERT_CHUNK);
+		unpackBE64Array(tmpConv, curNum);
+		for(uintptr_t i = 0; i<curNum; i++){ toFill[i] = tmpConv[i]; }
+		toFill += curNum;
+		numUnpack -= curNum;
+	}
+}
+void ByteUnpacker::unpackBE32Array(uint64_t* toFill, uintptr_t numUnpack){
+	uint32_t tmpConv[WHODUN_PACK_CONVERT_CHUNK];
+	while(numUnpack){
+		uintptr_t curNum = std::min(numUnpack, (uintptr_t)WHODUN_PACK_CONVERT_CHUNK);
+		unpackBE32Array(tmpConv, curNum);
+		for(uintptr_t i = 0; i<curNum; i++){ toFill[i] = tmpConv[i]; }
+		toFill += curNum;
+		numUnpack -= curNum;
+	}
+}
+void ByteUnpacker::unpackBEFltArray(double* toFill, uintptr_t numUnpack){
+	float tmpConv[WHODUN_PACK_CONVERT_CHUNK];
+	while(numUnpack){
+		uintptr_t curNum = std::min(numUnpack, (uintptr_t)WHODUN_PACK_CONVERT_CHUNK);
+		unpackBEFltArray(tmpConv, curNum);
+		for(uintptr_t i = 0; i<curNum; i++){ toFill[i] = tmpConv[i]; }
+		toFill += curNum;
+		numUnpack -= curNum;
+	}
+}
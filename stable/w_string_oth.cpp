@@ -1,5 +1,7 @@
 #include "whodun_string.h"
 
+#include <string.h>
+
 using namespace whodun;
 
 size_t whodun::memcspn(const char* str1, size_t numB1, const char* str2, size_t numB2){
@@ -22,6 +24,7 @@ size_t whodun::memspn(const char* str1, size_t numB1, const char* str2, size_t n
 		}
 		return curCS;
 		wasGut:
+		;
 	}
 	return numB1;
 }
@@ -33,7 +36,7 @@ char* whodun::memmem(const char* str1, size_t numB1, const char* str2, size_t nu
 	size_t maxCheck = (numB1 - numB2) + 1;
 	for(size_t curCS = 0; curCS < maxCheck; curCS++){
 		if(memcmp(str1+curCS, str2, numB2) == 0){
-			return str1+curCS;
+			return (char*)(str1+curCS);
 		}
 	}
 	return 0;
@@ -47,6 +50,30 @@ void whodun::memswap(char* arrA, char* arrB, size_t numBts){
 	}
 }
 
+int whodun::memVectorLevel(){
+	return WHODUN_VECTOR_NONE;
+}
+int whodun::memVectorLimit(int maxLevel){
+	return WHODUN_VECTOR_NONE;
+}
+
+uint64_t ByteSetSearcher::mask64(const char* str, size_t numB){
+	uint64_t toRet = 0;
+	for(size_t i = 0; i<numB; i++){
+		toRet |= (((uint64_t)contains(str[i])) << i);
+	}
+	return toRet;
+}
+void ByteClassSearcher::mask64(const char* str, size_t numB, uint64_t* toFill){
+	for(size_t j = 0; j<numChars; j++){
+		uint64_t curMask = 0;
+		for(size_t i = 0; i<numB; i++){
+			curMask |= (((uint64_t)(str[i] == theChars[j])) << i);
+		}
+		toFill[j] = curMask;
+	}
+}
+
 void BytePacker::packBE64(uint64_t toPack){
 	target[7] = toPack & 0x00FF;
 	target[6] = (toPack>>8) & 0x00FF;
@@ -217,3 +244,34 @@ float ByteUnpacker::unpackLEFlt(){
 	return tmpSave.saveF;
 }
 
+void BytePacker::packBE64Array(const uint64_t* toPack, uintptr_t numPack){
+	for(uintptr_t i = 0; i<numPack; i++){ packBE64(toPack[i]); }
+}
+void BytePacker::packBE32Array(const uint32_t* toPack, uintptr_t numPack){
+	for(uintptr_t i = 0; i<numPack; i++){ packBE32(toPack[i]); }
+}
+void BytePacker::packBE16Array(const uint16_t* toPack, uintptr_t numPack){
+	for(uintptr_t i = 0; i<numPack; i++){ packBE16(toPack[i]); }
+}
+void BytePacker::packBEDblArray(const double* toPack, uintptr_t numPack){
+	for(uintptr_t i = 0; i<numPack; i++){ packBEDbl(toPack[i]); }
+}
+void BytePacker::packBEFltArray(const float* toPack, uintptr_t numPack){
+	for(uintptr_t i = 0; i<numPack; i++){ packBEFlt(toPack[i]); }
+}
+
+void ByteUnpacker::unpackBE64Array(uint64_t* toFill, uintptr_t numUnpack){
+	for(uintptr_t i = 0; i<numUnpack; i++){ toFill[i] = unpackBE64(); }
+}
+void ByteUnpacker::unpackBE32Array(uint32_t* toFill, uintptr_t numUnpack){
+	for(uintptr_t i = 0; i<numUnpack; i++){ toFill[i] = unpackBE32(); }
+}
+void ByteUnpacker::unpackBE16Array(uint16_t* toFill, uintptr_t numUnpack){
+	for(uintptr_t i = 0; i<numUnpack; i++){ toFill[i] = unpackBE16(); }
+}
+void ByteUnpacker::unpackBEDblArray(double* toFill, uintptr_t numUnpack){
+	for(uintptr_t i = 0; i<numUnpack; i++){ toFill[i] = unpackBEDbl(); }
+}
+void ByteUnpacker::unpackBEFltArray(float* toFill, uintptr_t numUnpack){
+	for(uintptr_t i = 0; i<numUnpack; i++){ toFill[i] = unpackBEFlt(); }
+}
@@ -1,10 +1,19 @@
 #include "whodun_string.h"
 
 #include <string.h>
+#include <immintrin.h>
 
 using namespace whodun;
 
-size_t whodun::memcspn(const char* str1, size_t numB1, const char* str2, size_t numB2){
+/**
+ * Scalar memcspn: used when no vector instructions are available.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The characters to look for.
+ * @param numB2 The number of characters to look for.
+ * @return The number of characters at the start of str1 that are not in str2.
+ */
+size_t memcspn_scalar(const char* str1, size_t numB1, const char* str2, size_t numB2){
 	if(numB1 == 0){ return numB1; }
 	if(numB2 == 0){ return numB1; }
 	if(numB2 < 8){
@@ -20,6 +29,7 @@ size_t whodun::memcspn(const char* str1, size_t numB1, const char* str2, size_t
 		//str1[i] in bvecSearch = anyByteZero(((0x0101010101010101 * str1[i])^bvecSearch)|bvecMask)
 		//anyByteZero(v) = (v-0x0101010101010101) & ~v & 0x8080808080808080
 		const char* endPt;
+		size_t numLeft = numB1;
 		asm volatile (
 			"movq $0x0101010101010101, %%r8\n"
 			"movq $0x8080808080808080, %%r9\n"
@@ -40,8 +50,8 @@ size_t whodun::memcspn(const char* str1, size_t numB1, const char* str2, size_t
 			"jnz memcspn_rep%=\n"
 			"memcspn_done%=:\n"
 			"xorq %%r10, %%r10\n"
-		: "=a" (endPt)
-		: "a" (str1), "b" (numB1), "c" (bvecSearch), "d" (bvecMask)
+		: "=a" (endPt), "+b" (numLeft)
+		: "a" (str1), "c" (bvecSearch), "d" (bvecMask)
 		: "cc", "r8", "r9", "r10", "r11"
 		);
 		return endPt - str1;
@@ -58,7 +68,15 @@ size_t whodun::memcspn(const char* str1, size_t numB1, const char* str2, size_t
 	}
 }
 
-size_t whodun::memspn(const char* str1, size_t numB1, const char* str2, size_t numB2){
+/**
+ * Scalar memspn: used when no vector instructions are available.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The characters to look for.
+ * @param numB2 The number of characters to look for.
+ * @return The number of characters at the start of str1 that are in str2.
+ */
+size_t memspn_scalar(const char* str1, size_t numB1, const char* str2, size_t numB2){
 	for(size_t curCS = 0; curCS < numB1; curCS++){
 		for(size_t i = 0; i<numB2; i++){
 			if(str1[curCS] == str2[i]){
@@ -72,7 +90,15 @@ size_t whodun::memspn(const char* str1, size_t numB1, const char* str2, size_t n
 	return numB1;
 }
 
-char* whodun::memmem(const char* str1, size_t numB1, const char* str2, size_t numB2){
+/**
+ * Scalar memmem: used when no vector instructions are available.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The string to look for.
+ * @param numB2 The length of the string to look for.
+ * @return The first location of str2 in str1, or null if not present.
+ */
+char* memmem_scalar(const char* str1, size_t numB1, const char* str2, size_t numB2){
 	if(numB2 > numB1){
 		return 0;
 	}
@@ -103,8 +129,8 @@ void memswap_direct_byte(char* arrA, char* arrB, size_t numBts){
 		"addq $1, %%rbx\n"
 		"addq $-1, %%rcx\n"
 		"jnz memswap_byte_rep%=\n"
+	: "+a" (arrA), "+b" (arrB), "+c" (numBts)
 	:
-	: "a" (arrA), "b" (arrB), "c" (numBts)
 	: "cc", "memory", "r8", "r9"
 	);
 }
@@ -127,13 +153,19 @@ void memswap_direct_word(char* arrA, char* arrB, size_t numWord){
 		"addq $8, %%rbx\n"
 		"addq $-1, %%rcx\n"
 		"jnz memswap_word_rep%=\n"
+	: "+a" (arrA), "+b" (arrB), "+c" (numWord)
 	:
-	: "a" (arrA), "b" (arrB), "c" (numWord)
 	: "cc", "memory", "r8", "r9"
 	);
 }
 
-void whodun::memswap(char* arrA, char* arrB, size_t numBts){
+/**
+ * Word-wise memswap: used when no vector instructions are available.
+ * @param arrA The first array.
+ * @param arrB The second array.
+ * @param numBts The number of bytes to swap.
+ */
+void memswap_scalar(char* arrA, char* arrB, size_t numBts){
 	if(numBts == 0){
 		return;
 	}
@@ -173,6 +205,769 @@ void whodun::memswap(char* arrA, char* arrB, size_t numBts){
 	}
 }
 
+//vector versions: picked at startup from cpuid
+
+/**Sets at most this big get compared byte by byte, larger sets use nibble tables.*/
+#define WHODUN_MEMSEARCH_SMALLSET 4
+
+/**The bit to test for each high nibble.*/
+static const unsigned char memByteSetHighBits[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+
+/**
+ * Scan the end of a string with nibble tables.
+ * @param str1 The string to look through.
+ * @param fromI The index to start at.
+ * @param numB1 The length of said string.
+ * @param useSet The tables.
+ * @param wantIn Whether to stop at bytes in the set (memcspn) or out of the set (memspn).
+ * @return The index of the first stop byte, or numB1.
+ */
+size_t memByteSetTail(const char* str1, size_t fromI, size_t numB1, ByteSetSearcher* useSet, int wantIn){
+	for(size_t i = fromI; i<numB1; i++){
+		if(useSet->contains(str1[i]) == wantIn){
+			return i;
+		}
+	}
+	return numB1;
+}
+
+/**
+ * memcspn/memspn with SSE4.2: pcmpestri for sets of up to 16, SSSE3 nibble tables above that.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The characters to look for.
+ * @param numB2 The number of characters to look for.
+ * @param wantIn Whether to stop at bytes in the set (memcspn) or out of the set (memspn).
+ * @return The index of the first stop byte, or numB1.
+ */
+__attribute__((target("sse4.2"))) size_t memspanning_sse42(const char* str1, size_t numB1, const char* str2, size_t numB2, int wantIn){
+	ByteSetSearcher useSet(str2, numB2);
+	size_t i = 0;
+	if(numB2 <= 16){
+		char setBuff[16];
+		memset(setBuff, 0, 16);
+		memcpy(setBuff, str2, numB2);
+		__m128i setV = _mm_loadu_si128((const __m128i*)setBuff);
+		int setLen = numB2;
+		if(wantIn){
+			for(; (i + 16) <= numB1; i += 16){
+				__m128i curV = _mm_loadu_si128((const __m128i*)(str1 + i));
+				int firstI = _mm_cmpestri(setV, setLen, curV, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+				if(firstI < 16){ return i + firstI; }
+			}
+		}
+		else{
+			for(; (i + 16) <= numB1; i += 16){
+				__m128i curV = _mm_loadu_si128((const __m128i*)(str1 + i));
+				int firstI = _mm_cmpestri(setV, setLen, curV, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
+				if(firstI < 16){ return i + firstI; }
+			}
+		}
+	}
+	else{
+		__m128i lowRow = _mm_loadu_si128((const __m128i*)useSet.lowRow);
+		__m128i highRow = _mm_loadu_si128((const __m128i*)useSet.highRow);
+		__m128i highBits = _mm_loadu_si128((const __m128i*)memByteSetHighBits);
+		__m128i nibMask = _mm_set1_epi8(0x0F);
+		__m128i seven = _mm_set1_epi8(7);
+		int flipMask = wantIn ? 0 : 0x0FFFF;
+		for(; (i + 16) <= numB1; i += 16){
+			__m128i curV = _mm_loadu_si128((const __m128i*)(str1 + i));
+			__m128i lowN = _mm_and_si128(curV, nibMask);
+			__m128i highN = _mm_and_si128(_mm_srli_epi16(curV, 4), nibMask);
+			__m128i rowV = _mm_blendv_epi8(_mm_shuffle_epi8(lowRow, lowN), _mm_shuffle_epi8(highRow, lowN), _mm_cmpgt_epi8(highN, seven));
+			__m128i bitV = _mm_shuffle_epi8(highBits, highN);
+			int hitMask = flipMask ^ _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(rowV, bitV), bitV));
+			if(hitMask){ return i + __builtin_ctz(hitMask); }
+		}
+	}
+	return memByteSetTail(str1, i, numB1, &useSet, wantIn);
+}
+
+/**
+ * memcspn/memspn with AVX2: direct compares for small sets, nibble tables for large.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The characters to look for.
+ * @param numB2 The number of characters to look for.
+ * @param wantIn Whether to stop at bytes in the set (memcspn) or out of the set (memspn).
+ * @return The index of the first stop byte, or numB1.
+ */
+__attribute__((target("avx2"))) size_t memspanning_avx2(const char* str1, size_t numB1, const char* str2, size_t numB2, int wantIn){
+	ByteSetSearcher useSet(str2, numB2);
+	uint32_t flipMask = wantIn ? 0 : 0x0FFFFFFFF;
+	size_t i = 0;
+	if(numB2 <= WHODUN_MEMSEARCH_SMALLSET){
+		__m256i setV[WHODUN_MEMSEARCH_SMALLSET];
+		for(size_t j = 0; j<numB2; j++){ setV[j] = _mm256_set1_epi8(str2[j]); }
+		for(; (i + 32) <= numB1; i += 32){
+			__m256i curV = _mm256_loadu_si256((const __m256i*)(str1 + i));
+			__m256i hitV = _mm256_setzero_si256();
+			for(size_t j = 0; j<numB2; j++){ hitV = _mm256_or_si256(hitV, _mm256_cmpeq_epi8(curV, setV[j])); }
+			uint32_t hitMask = flipMask ^ (uint32_t)_mm256_movemask_epi8(hitV);
+			if(hitMask){ return i + __builtin_ctz(hitMask); }
+		}
+	}
+	else{
+		__m256i lowRow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)useSet.lowRow));
+		__m256i highRow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)useSet.highRow));
+		__m256i highBits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)memByteSetHighBits));
+		__m256i nibMask = _mm256_set1_epi8(0x0F);
+		__m256i seven = _mm256_set1_epi8(7);
+		for(; (i + 32) <= numB1; i += 32){
+			__m256i curV = _mm256_loadu_si256((const __m256i*)(str1 + i));
+			__m256i lowN = _mm256_and_si256(curV, nibMask);
+			__m256i highN = _mm256_and_si256(_mm256_srli_epi16(curV, 4), nibMask);
+			__m256i rowV = _mm256_blendv_epi8(_mm256_shuffle_epi8(lowRow, lowN), _mm256_shuffle_epi8(highRow, lowN), _mm256_cmpgt_epi8(highN, seven));
+			__m256i bitV = _mm256_shuffle_epi8(highBits, highN);
+			uint32_t hitMask = flipMask ^ (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(rowV, bitV), bitV));
+			if(hitMask){ return i + __builtin_ctz(hitMask); }
+		}
+	}
+	return memByteSetTail(str1, i, numB1, &useSet, wantIn);
+}
+
+/**
+ * memcspn/memspn with AVX-512: direct compares for small sets, nibble tables for large, masked loads for the tail.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The characters to look for.
+ * @param numB2 The number of characters to look for.
+ * @param wantIn Whether to stop at bytes in the set (memcspn) or out of the set (memspn).
+ * @return The index of the first stop byte, or numB1.
+ */
+__attribute__((target("avx512f,avx512bw"))) size_t memspanning_avx512(const char* str1, size_t numB1, const char* str2, size_t numB2, int wantIn){
+	ByteSetSearcher useSet(str2, numB2);
+	uint64_t flipMask = wantIn ? 0 : (uint64_t)-1;
+	__m512i lowRow = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)useSet.lowRow));
+	__m512i highRow = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)useSet.highRow));
+	__m512i highBits = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)memByteSetHighBits));
+	__m512i nibMask = _mm512_set1_epi8(0x0F);
+	__m512i seven = _mm512_set1_epi8(7);
+	__m512i setV[WHODUN_MEMSEARCH_SMALLSET];
+	int smallSet = numB2 <= WHODUN_MEMSEARCH_SMALLSET;
+	if(smallSet){
+		for(size_t j = 0; j<numB2; j++){ setV[j] = _mm512_set1_epi8(str2[j]); }
+	}
+	size_t i = 0;
+	while(i < numB1){
+		size_t numLeft = numB1 - i;
+		uint64_t loadMask = (numLeft >= 64) ? (uint64_t)-1 : ((((uint64_t)1) << numLeft) - 1);
+		__m512i curV = _mm512_maskz_loadu_epi8(loadMask, str1 + i);
+		uint64_t inMask;
+		if(smallSet){
+			inMask = 0;
+			for(size_t j = 0; j<numB2; j++){ inMask |= _mm512_cmpeq_epi8_mask(curV, setV[j]); }
+		}
+		else{
+			__m512i lowN = _mm512_and_si512(curV, nibMask);
+			__m512i highN = _mm512_and_si512(_mm512_srli_epi16(curV, 4), nibMask);
+			__m512i rowV = _mm512_mask_blend_epi8(_mm512_cmpgt_epi8_mask(highN, seven), _mm512_shuffle_epi8(lowRow, lowN), _mm512_shuffle_epi8(highRow, lowN));
+			__m512i bitV = _mm512_shuffle_epi8(highBits, highN);
+			inMask = _mm512_test_epi8_mask(rowV, bitV);
+		}
+		uint64_t hitMask = (flipMask ^ inMask) & loadMask;
+		if(hitMask){ return i + __builtin_ctzll(hitMask); }
+		i += 64;
+	}
+	return numB1;
+}
+
+/**
+ * memmem with SSE: compare the first and last byte of the needle at 16 offsets at once, then check candidates.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The string to look for.
+ * @param numB2 The length of the string to look for.
+ * @return The first location of str2 in str1, or null if not present.
+ */
+__attribute__((target("sse4.2"))) char* memmem_sse42(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	if(numB2 > numB1){ return 0; }
+	if(numB2 == 0){ return (char*)str1; }
+	if(numB2 == 1){ return (char*)memchr(str1, str2[0], numB1); }
+	size_t maxCheck = (numB1 - numB2) + 1;
+	__m128i firstV = _mm_set1_epi8(str2[0]);
+	__m128i lastV = _mm_set1_epi8(str2[numB2-1]);
+	size_t i = 0;
+	for(; (i + 16) <= maxCheck; i += 16){
+		__m128i headV = _mm_loadu_si128((const __m128i*)(str1 + i));
+		__m128i tailV = _mm_loadu_si128((const __m128i*)(str1 + i + numB2 - 1));
+		uint32_t candMask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(headV, firstV), _mm_cmpeq_epi8(tailV, lastV)));
+		while(candMask){
+			size_t candI = i + __builtin_ctz(candMask);
+			if(memcmp(str1 + candI + 1, str2 + 1, numB2 - 2) == 0){ return (char*)(str1 + candI); }
+			candMask = candMask & (candMask - 1);
+		}
+	}
+	char* tailFind = memmem_scalar(str1 + i, numB1 - i, str2, numB2);
+	return tailFind;
+}
+
+/**
+ * memmem with AVX2: compare the first and last byte of the needle at 32 offsets at once, then check candidates.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The string to look for.
+ * @param numB2 The length of the string to look for.
+ * @return The first location of str2 in str1, or null if not present.
+ */
+__attribute__((target("avx2"))) char* memmem_avx2(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	if(numB2 > numB1){ return 0; }
+	if(numB2 == 0){ return (char*)str1; }
+	if(numB2 == 1){ return (char*)memchr(str1, str2[0], numB1); }
+	size_t maxCheck = (numB1 - numB2) + 1;
+	__m256i firstV = _mm256_set1_epi8(str2[0]);
+	__m256i lastV = _mm256_set1_epi8(str2[numB2-1]);
+	size_t i = 0;
+	for(; (i + 32) <= maxCheck; i += 32){
+		__m256i headV = _mm256_loadu_si256((const __m256i*)(str1 + i));
+		__m256i tailV = _mm256_loadu_si256((const __m256i*)(str1 + i + numB2 - 1));
+		uint32_t candMask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(headV, firstV), _mm256_cmpeq_epi8(tailV, lastV)));
+		while(candMask){
+			size_t candI = i + __builtin_ctz(candMask);
+			if(memcmp(str1 + candI + 1, str2 + 1, numB2 - 2) == 0){ return (char*)(str1 + candI); }
+			candMask = candMask & (candMask - 1);
+		}
+	}
+	return memmem_sse42(str1 + i, numB1 - i, str2, numB2);
+}
+
+/**
+ * memmem with AVX-512: compare the first and last byte of the needle at 64 offsets at once, then check candidates.
+ * @param str1 The string to look through.
+ * @param numB1 The length of said string.
+ * @param str2 The string to look for.
+ * @param numB2 The length of the string to look for.
+ * @return The first location of str2 in str1, or null if not present.
+ */
+__attribute__((target("avx512f,avx512bw"))) char* memmem_avx512(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	if(numB2 > numB1){ return 0; }
+	if(numB2 == 0){ return (char*)str1; }
+	if(numB2 == 1){ return (char*)memchr(str1, str2[0], numB1); }
+	size_t maxCheck = (numB1 - numB2) + 1;
+	__m512i firstV = _mm512_set1_epi8(str2[0]);
+	__m512i lastV = _mm512_set1_epi8(str2[numB2-1]);
+	size_t i = 0;
+	while(i < maxCheck){
+		size_t numLeft = maxCheck - i;
+		uint64_t loadMask = (numLeft >= 64) ? (uint64_t)-1 : ((((uint64_t)1) << numLeft) - 1);
+		__m512i headV = _mm512_maskz_loadu_epi8(loadMask, str1 + i);
+		__m512i tailV = _mm512_maskz_loadu_epi8(loadMask, str1 + i + numB2 - 1);
+		uint64_t candMask = _mm512_mask_cmpeq_epi8_mask(_mm512_cmpeq_epi8_mask(headV, firstV) & loadMask, tailV, lastV);
+		while(candMask){
+			size_t candI = i + __builtin_ctzll(candMask);
+			if(memcmp(str1 + candI + 1, str2 + 1, numB2 - 2) == 0){ return (char*)(str1 + candI); }
+			candMask = candMask & (candMask - 1);
+		}
+		i += 64;
+	}
+	return 0;
+}
+
+/**
+ * memswap with SSE registers.
+ * @param arrA The first array.
+ * @param arrB The second array.
+ * @param numBts The number of bytes to swap.
+ */
+__attribute__((target("sse4.2"))) void memswap_sse42(char* arrA, char* arrB, size_t numBts){
+	size_t i = 0;
+	for(; (i + 16) <= numBts; i += 16){
+		__m128i valA = _mm_loadu_si128((const __m128i*)(arrA + i));
+		__m128i valB = _mm_loadu_si128((const __m128i*)(arrB + i));
+		_mm_storeu_si128((__m128i*)(arrA + i), valB);
+		_mm_storeu_si128((__m128i*)(arrB + i), valA);
+	}
+	memswap_scalar(arrA + i, arrB + i, numBts - i);
+}
+
+/**
+ * memswap with AVX registers.
+ * @param arrA The first array.
+ * @param arrB The second array.
+ * @param numBts The number of bytes to swap.
+ */
+__attribute__((target("avx2"))) void memswap_avx2(char* arrA, char* arrB, size_t numBts){
+	size_t i = 0;
+	for(; (i + 64) <= numBts; i += 64){
+		__m256i valA0 = _mm256_loadu_si256((const __m256i*)(arrA + i));
+		__m256i valA1 = _mm256_loadu_si256((const __m256i*)(arrA + i + 32));
+		__m256i valB0 = _mm256_loadu_si256((const __m256i*)(arrB + i));
+		__m256i valB1 = _mm256_loadu_si256((const __m256i*)(arrB + i + 32));
+		_mm256_storeu_si256((__m256i*)(arrA + i), valB0);
+		_mm256_storeu_si256((__m256i*)(arrA + i + 32), valB1);
+		_mm256_storeu_si256((__m256i*)(arrB + i), valA0);
+		_mm256_storeu_si256((__m256i*)(arrB + i + 32), valA1);
+	}
+	memswap_sse42(arrA + i, arrB + i, numBts - i);
+}
+
+/**
+ * memswap with AVX-512 registers: masked moves for the tail.
+ * @param arrA The first array.
+ * @param arrB The second array.
+ * @param numBts The number of bytes to swap.
+ */
+__attribute__((target("avx512f,avx512bw"))) void memswap_avx512(char* arrA, char* arrB, size_t numBts){
+	size_t i = 0;
+	for(; (i + 64) <= numBts; i += 64){
+		__m512i valA = _mm512_loadu_si512((const void*)(arrA + i));
+		__m512i valB = _mm512_loadu_si512((const void*)(arrB + i));
+		_mm512_storeu_si512((void*)(arrA + i), valB);
+		_mm512_storeu_si512((void*)(arrB + i), valA);
+	}
+	if(i < numBts){
+		uint64_t loadMask = ((((uint64_t)1) << (numBts - i)) - 1);
+		__m512i valA = _mm512_maskz_loadu_epi8(loadMask, arrA + i);
+		__m512i valB = _mm512_maskz_loadu_epi8(loadMask, arrB + i);
+		_mm512_mask_storeu_epi8(arrA + i, loadMask, valB);
+		_mm512_mask_storeu_epi8(arrB + i, loadMask, valA);
+	}
+}
+
+/**
+ * Byte set mask without vectors.
+ * @param useSet The set to test against.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @return A mask with bit i set if str[i] is in the set.
+ */
+uint64_t memByteMask_scalar(ByteSetSearcher* useSet, const char* str, size_t numB){
+	uint64_t toRet = 0;
+	for(size_t i = 0; i<numB; i++){
+		toRet |= (((uint64_t)(useSet->contains(str[i]))) << i);
+	}
+	return toRet;
+}
+
+/**
+ * Byte set mask with SSSE3 nibble lookups.
+ * @param useSet The set to test against.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @return A mask with bit i set if str[i] is in the set.
+ */
+__attribute__((target("sse4.2"))) uint64_t memByteMask_sse42(ByteSetSearcher* useSet, const char* str, size_t numB){
+	char tmpBuff[64];
+	const char* useStr = str;
+	if(numB < 64){
+		memcpy(tmpBuff, str, numB);
+		useStr = tmpBuff;
+	}
+	__m128i lowRow = _mm_loadu_si128((const __m128i*)(useSet->lowRow));
+	__m128i highRow = _mm_loadu_si128((const __m128i*)(useSet->highRow));
+	__m128i highBits = _mm_loadu_si128((const __m128i*)memByteSetHighBits);
+	__m128i nibMask = _mm_set1_epi8(0x0F);
+	__m128i seven = _mm_set1_epi8(7);
+	uint64_t toRet = 0;
+	for(int i = 0; i<4; i++){
+		__m128i curV = _mm_loadu_si128((const __m128i*)(useStr + 16*i));
+		__m128i lowN = _mm_and_si128(curV, nibMask);
+		__m128i highN = _mm_and_si128(_mm_srli_epi16(curV, 4), nibMask);
+		__m128i rowV = _mm_blendv_epi8(_mm_shuffle_epi8(lowRow, lowN), _mm_shuffle_epi8(highRow, lowN), _mm_cmpgt_epi8(highN, seven));
+		__m128i bitV = _mm_shuffle_epi8(highBits, highN);
+		uint64_t curMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(rowV, bitV), bitV));
+		toRet |= (curMask << (16*i));
+	}
+	if(numB < 64){ toRet = toRet & ((((uint64_t)1) << numB) - 1); }
+	return toRet;
+}
+
+/**
+ * Byte set mask with AVX2 nibble lookups.
+ * @param useSet The set to test against.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @return A mask with bit i set if str[i] is in the set.
+ */
+__attribute__((target("avx2"))) uint64_t memByteMask_avx2(ByteSetSearcher* useSet, const char* str, size_t numB){
+	char tmpBuff[64];
+	const char* useStr = str;
+	if(numB < 64){
+		memcpy(tmpBuff, str, numB);
+		useStr = tmpBuff;
+	}
+	__m256i lowRow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(useSet->lowRow)));
+	__m256i highRow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(useSet->highRow)));
+	__m256i highBits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)memByteSetHighBits));
+	__m256i nibMask = _mm256_set1_epi8(0x0F);
+	__m256i seven = _mm256_set1_epi8(7);
+	uint64_t toRet = 0;
+	for(int i = 0; i<2; i++){
+		__m256i curV = _mm256_loadu_si256((const __m256i*)(useStr + 32*i));
+		__m256i lowN = _mm256_and_si256(curV, nibMask);
+		__m256i highN = _mm256_and_si256(_mm256_srli_epi16(curV, 4), nibMask);
+		__m256i rowV = _mm256_blendv_epi8(_mm256_shuffle_epi8(lowRow, lowN), _mm256_shuffle_epi8(highRow, lowN), _mm256_cmpgt_epi8(highN, seven));
+		__m256i bitV = _mm256_shuffle_epi8(highBits, highN);
+		uint64_t curMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(rowV, bitV), bitV));
+		toRet |= (curMask << (32*i));
+	}
+	if(numB < 64){ toRet = toRet & ((((uint64_t)1) << numB) - 1); }
+	return toRet;
+}
+
+/**
+ * Byte set mask with AVX-512 nibble lookups.
+ * @param useSet The set to test against.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @return A mask with bit i set if str[i] is in the set.
+ */
+__attribute__((target("avx512f,avx512bw"))) uint64_t memByteMask_avx512(ByteSetSearcher* useSet, const char* str, size_t numB){
+	uint64_t loadMask = (numB >= 64) ? (uint64_t)-1 : ((((uint64_t)1) << numB) - 1);
+	__m512i lowRow = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)(useSet->lowRow)));
+	__m512i highRow = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)(useSet->highRow)));
+	__m512i highBits = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)memByteSetHighBits));
+	__m512i nibMask = _mm512_set1_epi8(0x0F);
+	__m512i curV = _mm512_maskz_loadu_epi8(loadMask, str);
+	__m512i lowN = _mm512_and_si512(curV, nibMask);
+	__m512i highN = _mm512_and_si512(_mm512_srli_epi16(curV, 4), nibMask);
+	__m512i rowV = _mm512_mask_blend_epi8(_mm512_cmpgt_epi8_mask(highN, _mm512_set1_epi8(7)), _mm512_shuffle_epi8(lowRow, lowN), _mm512_shuffle_epi8(highRow, lowN));
+	__m512i bitV = _mm512_shuffle_epi8(highBits, highN);
+	return _mm512_test_epi8_mask(rowV, bitV) & loadMask;
+}
+
+/**
+ * Byte class masks without vectors.
+ * @param useSet The bytes to look for.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @param toFill The place to put the masks, one for each byte looked for.
+ */
+void memByteClass_scalar(ByteClassSearcher* useSet, const char* str, size_t numB, uint64_t* toFill){
+	for(size_t j = 0; j<useSet->numChars; j++){
+		char curC = useSet->theChars[j];
+		uint64_t curMask = 0;
+		for(size_t i = 0; i<numB; i++){
+			curMask |= (((uint64_t)(str[i] == curC)) << i);
+		}
+		toFill[j] = curMask;
+	}
+}
+
+/**
+ * Byte class masks with SSE compares.
+ * @param useSet The bytes to look for.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @param toFill The place to put the masks, one for each byte looked for.
+ */
+__attribute__((target("sse4.2"))) void memByteClass_sse42(ByteClassSearcher* useSet, const char* str, size_t numB, uint64_t* toFill){
+	char tmpBuff[64];
+	const char* useStr = str;
+	if(numB < 64){
+		memcpy(tmpBuff, str, numB);
+		useStr = tmpBuff;
+	}
+	__m128i curV[4];
+	for(int i = 0; i<4; i++){
+		curV[i] = _mm_loadu_si128((const __m128i*)(useStr + 16*i));
+	}
+	uint64_t endMask = (numB < 64) ? ((((uint64_t)1) << numB) - 1) : (uint64_t)-1;
+	for(size_t j = 0; j<useSet->numChars; j++){
+		__m128i testV = _mm_set1_epi8(useSet->theChars[j]);
+		uint64_t curMask = 0;
+		for(int i = 0; i<4; i++){
+			uint64_t subMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(curV[i], testV));
+			curMask |= (subMask << (16*i));
+		}
+		toFill[j] = curMask & endMask;
+	}
+}
+
+/**
+ * Byte class masks with AVX2 compares.
+ * @param useSet The bytes to look for.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @param toFill The place to put the masks, one for each byte looked for.
+ */
+__attribute__((target("avx2"))) void memByteClass_avx2(ByteClassSearcher* useSet, const char* str, size_t numB, uint64_t* toFill){
+	char tmpBuff[64];
+	const char* useStr = str;
+	if(numB < 64){
+		memcpy(tmpBuff, str, numB);
+		useStr = tmpBuff;
+	}
+	__m256i lowV = _mm256_loadu_si256((const __m256i*)useStr);
+	__m256i highV = _mm256_loadu_si256((const __m256i*)(useStr + 32));
+	uint64_t endMask = (numB < 64) ? ((((uint64_t)1) << numB) - 1) : (uint64_t)-1;
+	for(size_t j = 0; j<useSet->numChars; j++){
+		__m256i testV = _mm256_set1_epi8(useSet->theChars[j]);
+		uint64_t lowMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lowV, testV));
+		uint64_t highMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(highV, testV));
+		toFill[j] = (lowMask | (highMask << 32)) & endMask;
+	}
+}
+
+/**
+ * Byte class masks with AVX-512 compares.
+ * @param useSet The bytes to look for.
+ * @param str The bytes to look through.
+ * @param numB The number of bytes: at most 64.
+ * @param toFill The place to put the masks, one for each byte looked for.
+ */
+__attribute__((target("avx512f,avx512bw"))) void memByteClass_avx512(ByteClassSearcher* useSet, const char* str, size_t numB, uint64_t* toFill){
+	uint64_t loadMask = (numB >= 64) ? (uint64_t)-1 : ((((uint64_t)1) << numB) - 1);
+	__m512i curV = _mm512_maskz_loadu_epi8(loadMask, str);
+	for(size_t j = 0; j<useSet->numChars; j++){
+		toFill[j] = _mm512_cmpeq_epi8_mask(curV, _mm512_set1_epi8(useSet->theChars[j])) & loadMask;
+	}
+}
+
+/**Shuffles to reverse bytes in 2, 4 and 8 byte groups.*/
+static const unsigned char memByteRevShuffles[3][16] = {
+	{1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14},
+	{3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12},
+	{7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8}
+};
+
+/**
+ * Get the shuffle for a width.
+ * @param width The number of bytes in each value (2, 4 or 8).
+ * @return The shuffle.
+ */
+const unsigned char* memByteRevShuffle(int width){
+	return memByteRevShuffles[(width == 2) ? 0 : ((width == 4) ? 1 : 2)];
+}
+
+/**
+ * Reverse the bytes of each value in an array, without vectors.
+ * @param dst The place to put the results.
+ * @param src The values to reverse.
+ * @param numBytes The number of bytes (a multiple of width).
+ * @param width The number of bytes in each value (2, 4 or 8).
+ */
+void memByteRev_scalar(char* dst, const char* src, uintptr_t numBytes, int width){
+	switch(width){
+		case 8:
+			for(uintptr_t i = 0; i<numBytes; i+=8){
+				uint64_t curV;
+				memcpy(&curV, src + i, 8);
+				curV = __builtin_bswap64(curV);
+				memcpy(dst + i, &curV, 8);
+			}
+			break;
+		case 4:
+			for(uintptr_t i = 0; i<numBytes; i+=4){
+				uint32_t curV;
+				memcpy(&curV, src + i, 4);
+				curV = __builtin_bswap32(curV);
+				memcpy(dst + i, &curV, 4);
+			}
+			break;
+		default:
+			for(uintptr_t i = 0; i<numBytes; i+=width){
+				for(int j = 0; j<width; j++){
+					dst[i + j] = src[i + width - (j+1)];
+				}
+			}
+	}
+}
+
+/**
+ * Reverse the bytes of each value in an array, with SSSE3.
+ * @param dst The place to put the results.
+ * @param src The values to reverse.
+ * @param numBytes The number of bytes (a multiple of width).
+ * @param width The number of bytes in each value (2, 4 or 8).
+ */
+__attribute__((target("sse4.2"))) void memByteRev_sse42(char* dst, const char* src, uintptr_t numBytes, int width){
+	__m128i revV = _mm_loadu_si128((const __m128i*)memByteRevShuffle(width));
+	uintptr_t i = 0;
+	for(; (i + 16) <= numBytes; i += 16){
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i)), revV));
+	}
+	memByteRev_scalar(dst + i, src + i, numBytes - i, width);
+}
+
+/**
+ * Reverse the bytes of each value in an array, with AVX2.
+ * @param dst The place to put the results.
+ * @param src The values to reverse.
+ * @param numBytes The number of bytes (a multiple of width).
+ * @param width The number of bytes in each value (2, 4 or 8).
+ */
+__attribute__((target("avx2"))) void memByteRev_avx2(char* dst, const char* src, uintptr_t numBytes, int width){
+	__m256i revV = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)memByteRevShuffle(width)));
+	uintptr_t i = 0;
+	for(; (i + 64) <= numBytes; i += 64){
+		__m256i valA = _mm256_loadu_si256((const __m256i*)(src + i));
+		__m256i valB = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_shuffle_epi8(valA, revV));
+		_mm256_storeu_si256((__m256i*)(dst + i + 32), _mm256_shuffle_epi8(valB, revV));
+	}
+	memByteRev_sse42(dst + i, src + i, numBytes - i, width);
+}
+
+/**
+ * Reverse the bytes of each value in an array, with AVX-512: masked moves for the tail.
+ * @param dst The place to put the results.
+ * @param src The values to reverse.
+ * @param numBytes The number of bytes (a multiple of width).
+ * @param width The number of bytes in each value (2, 4 or 8).
+ */
+__attribute__((target("avx512f,avx512bw"))) void memByteRev_avx512(char* dst, const char* src, uintptr_t numBytes, int width){
+	__m512i revV = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)memByteRevShuffle(width)));
+	uintptr_t i = 0;
+	for(; (i + 64) <= numBytes; i += 64){
+		_mm512_storeu_si512((void*)(dst + i), _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(src + i)), revV));
+	}
+	if(i < numBytes){
+		uint64_t loadMask = ((((uint64_t)1) << (numBytes - i)) - 1);
+		_mm512_mask_storeu_epi8(dst + i, loadMask, _mm512_shuffle_epi8(_mm512_maskz_loadu_epi8(loadMask, src + i), revV));
+	}
+}
+
+//the dispatch
+
+size_t memcspn_sse42(const char* str1, size_t numB1, const char* str2, size_t numB2){ return memspanning_sse42(str1, numB1, str2, numB2, 1); }
+size_t memspn_sse42(const char* str1, size_t numB1, const char* str2, size_t numB2){ return memspanning_sse42(str1, numB1, str2, numB2, 0); }
+size_t memcspn_avx2(const char* str1, size_t numB1, const char* str2, size_t numB2){ return memspanning_avx2(str1, numB1, str2, numB2, 1); }
+size_t memspn_avx2(const char* str1, size_t numB1, const char* str2, size_t numB2){ return memspanning_avx2(str1, numB1, str2, numB2, 0); }
+size_t memcspn_avx512(const char* str1, size_t numB1, const char* str2, size_t numB2){ return memspanning_avx512(str1, numB1, str2, numB2, 1); }
+size_t memspn_avx512(const char* str1, size_t numB1, const char* str2, size_t numB2){ return memspanning_avx512(str1, numB1, str2, numB2, 0); }
+
+size_t memcspn_first(const char* str1, size_t numB1, const char* str2, size_t numB2);
+size_t memspn_first(const char* str1, size_t numB1, const char* str2, size_t numB2);
+char* memmem_first(const char* str1, size_t numB1, const char* str2, size_t numB2);
+void memswap_first(char* arrA, char* arrB, size_t numBts);
+uint64_t memByteMask_first(ByteSetSearcher* useSet, const char* str, size_t numB);
+void memByteClass_first(ByteClassSearcher* useSet, const char* str, size_t numB, uint64_t* toFill);
+void memByteRev_first(char* dst, const char* src, uintptr_t numBytes, int width);
+
+/**The memcspn in use.*/
+size_t (*memcspn_use)(const char*,size_t,const char*,size_t) = memcspn_first;
+/**The memspn in use.*/
+size_t (*memspn_use)(const char*,size_t,const char*,size_t) = memspn_first;
+/**The memmem in use.*/
+char* (*memmem_use)(const char*,size_t,const char*,size_t) = memmem_first;
+/**The memswap in use.*/
+void (*memswap_use)(char*,char*,size_t) = memswap_first;
+/**The byte set mask in use.*/
+uint64_t (*memByteMask_use)(ByteSetSearcher*,const char*,size_t) = memByteMask_first;
+/**The byte class masks in use.*/
+void (*memByteClass_use)(ByteClassSearcher*,const char*,size_t,uint64_t*) = memByteClass_first;
+/**The byte reversal in use.*/
+void (*memByteRev_use)(char*,const char*,uintptr_t,int) = memByteRev_first;
+/**The level in use.*/
+int memVectorCur = WHODUN_VECTOR_NONE;
+
+/**
+ * Figure out what the processor (and os) can do.
+ * @return The highest level supported.
+ */
+int memVectorCPU(){
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512f")){ return WHODUN_VECTOR_AVX512; }
+	if(__builtin_cpu_supports("avx2")){ return WHODUN_VECTOR_AVX2; }
+	if(__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("ssse3")){ return WHODUN_VECTOR_SSE42; }
+	return WHODUN_VECTOR_NONE;
+}
+
+int whodun::memVectorLevel(){
+	if(memcspn_use == memcspn_first){
+		memVectorLimit(WHODUN_VECTOR_AVX512);
+	}
+	return memVectorCur;
+}
+
+int whodun::memVectorLimit(int maxLevel){
+	int useLevel = memVectorCPU();
+	useLevel = (maxLevel < useLevel) ? maxLevel : useLevel;
+	switch(useLevel){
+		case WHODUN_VECTOR_AVX512:
+			memcspn_use = memcspn_avx512;
+			memspn_use = memspn_avx512;
+			memmem_use = memmem_avx512;
+			memswap_use = memswap_avx512;
+			memByteMask_use = memByteMask_avx512;
+			memByteClass_use = memByteClass_avx512;
+			memByteRev_use = memByteRev_avx512;
+			break;
+		case WHODUN_VECTOR_AVX2:
+			memcspn_use = memcspn_avx2;
+			memspn_use = memspn_avx2;
+			memmem_use = memmem_avx2;
+			memswap_use = memswap_avx2;
+			memByteMask_use = memByteMask_avx2;
+			memByteClass_use = memByteClass_avx2;
+			memByteRev_use = memByteRev_avx2;
+			break;
+		case WHODUN_VECTOR_SSE42:
+			memcspn_use = memcspn_sse42;
+			memspn_use = memspn_sse42;
+			memmem_use = memmem_sse42;
+			memswap_use = memswap_sse42;
+			memByteMask_use = memByteMask_sse42;
+			memByteClass_use = memByteClass_sse42;
+			memByteRev_use = memByteRev_sse42;
+			break;
+		default:
+			useLevel = WHODUN_VECTOR_NONE;
+			memcspn_use = memcspn_scalar;
+			memspn_use = memspn_scalar;
+			memmem_use = memmem_scalar;
+			memswap_use = memswap_scalar;
+			memByteMask_use = memByteMask_scalar;
+			memByteClass_use = memByteClass_scalar;
+			memByteRev_use = memByteRev_scalar;
+	}
+	memVectorCur = useLevel;
+	return useLevel;
+}
+
+/**Pick the vector level at startup.*/
+int memVectorStartup = memVectorLevel();
+
+size_t memcspn_first(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	memVectorLevel();
+	return memcspn_use(str1, numB1, str2, numB2);
+}
+size_t memspn_first(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	memVectorLevel();
+	return memspn_use(str1, numB1, str2, numB2);
+}
+char* memmem_first(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	memVectorLevel();
+	return memmem_use(str1, numB1, str2, numB2);
+}
+void memswap_first(char* arrA, char* arrB, size_t numBts){
+	memVectorLevel();
+	memswap_use(arrA, arrB, numBts);
+}
+
+size_t whodun::memcspn(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	return memcspn_use(str1, numB1, str2, numB2);
+}
+size_t whodun::memspn(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	return memspn_use(str1, numB1, str2, numB2);
+}
+char* whodun::memmem(const char* str1, size_t numB1, const char* str2, size_t numB2){
+	return memmem_use(str1, numB1, str2, numB2);
+}
+void whodun::memswap(char* arrA, char* arrB, size_t numBts){
+	memswap_use(arrA, arrB, numBts);
+}
+uint64_t memByteMask_first(ByteSetSearcher* useSet, const char* str, size_t numB){
+	memVectorLevel();
+	return memByteMask_use(useSet, str, numB);
+}
+uint64_t ByteSetSearcher::mask64(const char* str, size_t numB){
+	return memByteMask_use(this, str, numB);
+}
+void memByteClass_first(ByteClassSearcher* useSet, const char* str, size_t numB, uint64_t* toFill){
+	memVectorLevel();
+	memByteClass_use(useSet, str, numB, toFill);
+}
+void ByteClassSearcher::mask64(const char* str, size_t numB, uint64_t* toFill){
+	memByteClass_use(this, str, numB, toFill);
+}
+void memByteRev_first(char* dst, const char* src, uintptr_t numBytes, int width){
+	memVectorLevel();
+	memByteRev_use(dst, src, numBytes, width);
+}
+
 void BytePacker::packBE64(uint64_t toPack){
 	asm volatile (
 		"bswapq %%rcx\n"
@@ -334,4 +1129,44 @@ float ByteUnpacker::unpackLEFlt(){
 	return tmpSave.saveF;
 }
 
+void BytePacker::packBE64Array(const uint64_t* toPack, uintptr_t numPack){
+	memByteRev_use(target, (const char*)toPack, 8*numPack, 8);
+	target += 8*numPack;
+}
+void BytePacker::packBE32Array(const uint32_t* toPack, uintptr_t numPack){
+	memByteRev_use(target, (const char*)toPack, 4*numPack, 4);
+	target += 4*numPack;
+}
+void BytePacker::packBE16Array(const uint16_t* toPack, uintptr_t numPack){
+	memByteRev_use(target, (const char*)toPack, 2*numPack, 2);
+	target += 2*numPack;
+}
+void BytePacker::packBEDblArray(const double* toPack, uintptr_t numPack){
+	memByteRev_use(target, (const char*)toPack, 8*numPack, 8);
+	target += 8*numPack;
+}
+void BytePacker::packBEFltArray(const float* toPack, uintptr_t numPack){
+	memByteRev_use(target, (const char*)toPack, 4*numPack, 4);
+	target += 4*numPack;
+}
 
+void ByteUnpacker::unpackBE64Array(uint64_t* toFill, uintptr_t numUnpack){
+	memByteRev_use((char*)toFill, target, 8*numUnpack, 8);
+	target += 8*numUnpack;
+}
+void ByteUnpacker::unpackBE32Array(uint32_t* toFill, uintptr_t numUnpack){
+	memByteRev_use((char*)toFill, target, 4*numUnpack, 4);
+	target += 4*numUnpack;
+}
+void ByteUnpacker::unpackBE16Array(uint16_t* toFill, uintptr_t numUnpack){
+	memByteRev_use((char*)toFill, target, 2*numUnpack, 2);
+	target += 2*numUnpack;
+}
+void ByteUnpacker::unpackBEDblArray(double* toFill, uintptr_t numUnpack){
+	memByteRev_use((char*)toFill, target, 8*numUnpack, 8);
+	target += 8*numUnpack;
+}
+void ByteUnpacker::unpackBEFltArray(float* toFill, uintptr_t numUnpack){
+	memByteRev_use((char*)toFill, target, 4*numUnpack, 4);
+	target += 4*numUnpack;
+}
@@ -86,8 +86,17 @@ public:
 /**Compress with the deflate algorithm.*/
 class DeflateCompressionFactory : public CompressionFactory{
 public:
+	/**Set up with the default compression level.*/
+	DeflateCompressionFactory();
+	/**
+	 * Set up with a specific compression level.
+	 * @param useLevel The zlib compression level (Z_BEST_SPEED for fast, Z_BEST_COMPRESSION for small).
+	 */
+	DeflateCompressionFactory(int useLevel);
 	CompressionMethod* makeZip();
 	DecompressionMethod* makeUnzip();
+	/**The compression level to use.*/
+	int compLevel;
 };
 
 /**Compress with gzip (optionally with block compression info).*/
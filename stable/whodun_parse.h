@@ -7,6 +7,7 @@
  */
 
 #include "whodun_regex.h"
+#include "whodun_oshook.h"
 #include "whodun_string.h"
 #include "whodun_thread.h"
 #include "whodun_container.h"
@@ -54,12 +55,22 @@ public:
 	 * @param onChar The character to split on.
 	 */
 	CharacterSplitTokenizer(char onChar);
+	/**
+	 * Set up a tokenizer that splits on any of a set of characters.
+	 * @param onChars The characters to split on.
+	 * @param numChars The number of characters to split on.
+	 */
+	CharacterSplitTokenizer(const char* onChars, uintptr_t numChars);
 	/**Clean up*/
 	~CharacterSplitTokenizer();
 	uintptr_t numTokenTypes();
 	SizePtrString tokenize(SizePtrString toCut, StructVector<Token>* fillTokens);
 	/**The character to split on.*/
 	char splitOn;
+	/**Whether this splits on a set of characters (splitSet) rather than one (splitOn).*/
+	int splitMulti;
+	/**The characters to split on, if more than one.*/
+	ByteSetSearcher splitSet;
 	/**The string method.*/
 	StandardMemorySearcher doMem;
 	/**The marker for the delimiter.*/
@@ -78,6 +89,14 @@ public:
 	 * @param mainPool The threads to use.
 	 */
 	MultithreadedCharacterSplitTokenizer(char onChar, uintptr_t numThread, ThreadPool* mainPool);
+	/**
+	 * Set up a tokenizer that splits on any of a set of characters.
+	 * @param onChars The characters to split on.
+	 * @param numChars The number of characters to split on.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	MultithreadedCharacterSplitTokenizer(const char* onChars, uintptr_t numChars, uintptr_t numThread, ThreadPool* mainPool);
 	/**Clean up*/
 	~MultithreadedCharacterSplitTokenizer();
 	SizePtrString tokenize(SizePtrString toCut, StructVector<Token>* fillTokens);
@@ -87,6 +106,55 @@ public:
 	void* useForUA;
 	/**The actual set of things to run.*/
 	void* useForUB;
+	/**
+	 * Build the tasks.
+	 * @param numThread The number of threads to use.
+	 */
+	void makeTasks(uintptr_t numThread);
+};
+
+/**Split into tokens based on a character, skipping delimiters that are escaped or quoted: token type 0 is the delimiter, token type 1 is the text.*/
+class EscapedCharacterSplitTokenizer : public CharacterSplitTokenizer{
+public:
+	/**
+	 * Set up a tokenizer.
+	 * @param onChar The character to split on.
+	 * @param escChar The escape character (the character after it is taken literally), or -1 for none.
+	 * @param quoteChar The quote character (delimiters between quotes do not split), or -1 for none.
+	 */
+	EscapedCharacterSplitTokenizer(char onChar, int escChar, int quoteChar);
+	/**Clean up*/
+	~EscapedCharacterSplitTokenizer();
+	SizePtrString tokenize(SizePtrString toCut, StructVector<Token>* fillTokens);
+	/**The escape character, or -1.*/
+	int escapeChar;
+	/**The quote character, or -1.*/
+	int quoteChar;
+	/**Find delimiters, escapes and quotes (in that order, skipping any not in use).*/
+	ByteClassSearcher specialSet;
+};
+
+/**Split tokens based on character, skipping escaped and quoted delimiters, using multiple threads.*/
+class MultithreadedEscapedCharacterSplitTokenizer : public EscapedCharacterSplitTokenizer{
+public:
+	/**
+	 * Set up a tokenizer.
+	 * @param onChar The character to split on.
+	 * @param escChar The escape character (the character after it is taken literally), or -1 for none.
+	 * @param quoteChar The quote character (delimiters between quotes do not split), or -1 for none.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	MultithreadedEscapedCharacterSplitTokenizer(char onChar, int escChar, int quoteChar, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up*/
+	~MultithreadedEscapedCharacterSplitTokenizer();
+	SizePtrString tokenize(SizePtrString toCut, StructVector<Token>* fillTokens);
+	/**The thread pool to use.*/
+	ThreadPool* usePool;
+	/**The actual set of things to run.*/
+	void* useForUA;
+	/**The actual set of things to run.*/
+	void* useForUB;
 };
 
 /**Cut into tokens based on a set of regular expressions.*/
@@ -106,6 +174,100 @@ public:
 	RegexSet* useRgx;
 };
 
+/**The default number of bytes a stream tokenizer reads at a time.*/
+#define WHODUN_STREAMTOKEN_CHUNK 0x010000
+
+/**Cut text into tokens as it comes in, a piece at a time: matching picks up where it left off, so only text past the end of a finished token is looked at again.*/
+class RegexStreamTokenizer : public RegexTokenizer{
+public:
+	/**
+	 * Make a tokenizer for a set of regexes.
+	 * @param useRegex The regex set to use.
+	 */
+	RegexStreamTokenizer(RegexSet* useRegex);
+	/**
+	 * Make a tokenizer for a set of regexes.
+	 * @param useRegex The regex set to use.
+	 * @param chunkSize The number of bytes to read from a stream at a time.
+	 */
+	RegexStreamTokenizer(RegexSet* useRegex, uintptr_t chunkSize);
+	/**Clean up*/
+	~RegexStreamTokenizer();
+	SizePtrString tokenize(SizePtrString toCut, StructVector<Token>* fillTokens);
+	
+	/**Forget any text in progress and start over.*/
+	void reset();
+	/**
+	 * Cut up the next piece of text.
+	 * @param toCut The text. This only needs to stick around until the next call.
+	 * @param fillTokens The place to put finished tokens. Their text is good until the next call.
+	 * @return Whether cutting can continue (zero if text that is not a token was hit).
+	 */
+	int feed(SizePtrString toCut, StructVector<Token>* fillTokens);
+	/**
+	 * Read the next piece of a stream and cut it.
+	 * @param fromStr The stream to read from.
+	 * @param fillTokens The place to put finished tokens. Their text is good until the next call.
+	 * @return Whether there is more to cut: at the end of the stream, it calls finish.
+	 */
+	int feed(InStream* fromStr, StructVector<Token>* fillTokens);
+	/**
+	 * Note that there is no more text, and finish any last tokens.
+	 * @param fillTokens The place to put finished tokens. Their text is good until the next call.
+	 * @return Any text at the end that did not fit into a token. If text that is not a token was hit, this is from there to the end of the piece it was in.
+	 */
+	SizePtrString finish(StructVector<Token>* fillTokens);
+	
+	/**The number of bytes to read from a stream at a time.*/
+	uintptr_t readSize;
+	/**Whether text that is not a token has been hit.*/
+	int hitBad;
+	/**The total number of bytes fed in.*/
+	uintmax_t totalFed;
+	/**Where the current token starts.*/
+	uintmax_t tokStart;
+	/**The progress of matching the current token.*/
+	RegexSetMatchProgress curProg;
+	/**Text from the start of the current token to the end of the last piece.*/
+	std::vector<char> pendText;
+	/**Space to build the next pendText.*/
+	std::vector<char> nextPend;
+	/**Space for a token that spans pendText and the current piece.*/
+	std::vector<char> joinText;
+	/**Space to read into.*/
+	std::vector<char> readText;
+	/**Any text left at the end.*/
+	SizePtrString leftText;
+	/**
+	 * Utility: cut up as much as possible.
+	 * @param toCut The next piece.
+	 * @param fillTokens The place to put finished tokens.
+	 * @param atEnd Whether this is the end of the text.
+	 */
+	void cutPiece(SizePtrString toCut, StructVector<Token>* fillTokens, int atEnd);
+};
+
+/**Cut into tokens based on a set of regular expressions, using multiple threads: each thread cuts a chunk starting from a guess, and the pieces are stitched back in sync. Lazily compiled sets are run on one thread.*/
+class MultithreadedRegexTokenizer : public RegexTokenizer{
+public:
+	/**
+	 * Make a tokenizer for a set of regexes.
+	 * @param useRegex The regex set to use.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	MultithreadedRegexTokenizer(RegexSet* useRegex, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up*/
+	~MultithreadedRegexTokenizer();
+	SizePtrString tokenize(SizePtrString toCut, StructVector<Token>* fillTokens);
+	/**The thread pool to use.*/
+	ThreadPool* usePool;
+	/**The actual set of things to run.*/
+	void* useForUA;
+	/**The number of bytes that had to be recut on one thread to get the pieces in sync.*/
+	uintmax_t numResync;
+};
+
 };
 
 #endif
@@ -6,6 +6,8 @@
  * @brief (Basic) regular expressions.
  */
 
+#include <map>
+#include <string>
 #include <vector>
 #include <stdint.h>
 
@@ -110,8 +112,147 @@ public:
 	/**Clean up.*/
 	~DeterministicFiniteAutomata();
 	
+	/**Merge equivalent states (Hopcroft): states with different stateStatus are never merged, and the start stays at 0.*/
+	void minimize();
+	/**Figure out which bytes always go to the same place and build the (much smaller) class table.*/
+	void compress();
+	
 	/**The states in this thing: state 0 is the start.*/
 	std::vector<DeterministicFiniteAutomataState> states;
+	/**The class of each byte (filled in by compress).*/
+	unsigned char charClass[256];
+	/**The number of byte classes (zero until compress).*/
+	uintptr_t numClasses;
+	/**Rows of numClasses+1 entries, one row per state: the stateStatus, then the offset of the row to go to for each class. The start row is at offset 0.*/
+	std::vector<uintptr_t> classTable;
+};
+
+/**Marks a transition in a lazy dfa that has not been worked out yet.*/
+#define WHODUN_LAZYDFA_UNKNOWN (~(uintptr_t)0)
+/**A reasonable default size for a lazy dfa cache.*/
+#define WHODUN_LAZYDFA_DEFAULT_CACHE 0x0100000
+
+/**Walk one or more nfas side by side, working out (and caching) dfa states only as input asks for them. Not safe to use from multiple threads at once.*/
+class LazyDeterministicFiniteAutomata{
+public:
+	/**
+	 * Set up.
+	 * @param numNFA The number of nfas to run side by side.
+	 * @param toCrank The nfas (these are copied).
+	 * @param maxBytes The (rough) number of bytes the state cache can use before it is flushed.
+	 */
+	LazyDeterministicFiniteAutomata(uintptr_t numNFA, NondeterministicFiniteAutomata** toCrank, uintptr_t maxBytes);
+	/**Clean up.*/
+	~LazyDeterministicFiniteAutomata();
+	
+	/**
+	 * Get the length of the match starting at the first character.
+	 * @param toLook The string to look at.
+	 * @param storeTC The place to store the number of nfas that accept.
+	 * @param storeTypes The place to store the nfas that accept.
+	 * @return The number of characters in the match: -1 for no match.
+	 */
+	intptr_t longMatchLength(SizePtrString toLook, uintptr_t* storeTC, uintptr_t** storeTypes);
+	/**
+	 * Get the length of the shortest match starting at the first character.
+	 * @param toLook The string to look at.
+	 * @return The number of characters in the match: -1 for no match.
+	 */
+	intptr_t firstMatchLength(SizePtrString toLook);
+	/**
+	 * Work out where a row goes on a byte class, and remember it.
+	 * @param fromRow The row to start from.
+	 * @param onClass The class of the byte.
+	 * @return The row to go to. If the cache was flushed, any other row offsets are now junk.
+	 */
+	uintptr_t buildNext(uintptr_t fromRow, uintptr_t onClass);
+	/**Forget all cached states (other than the start).*/
+	void flush();
+	
+	/**The combined states of all the nfas.*/
+	std::vector<NondeterministicFiniteAutomataState> nfaStates;
+	/**The nfa each of the combined states came from.*/
+	std::vector<uintptr_t> nfaOwner;
+	/**Whether each of the combined states is a dead end (left out of state sets).*/
+	std::vector<char> nfaDead;
+	/**The class of each byte.*/
+	unsigned char charClass[256];
+	/**A byte from each class.*/
+	unsigned char classRep[256];
+	/**The number of byte classes.*/
+	uintptr_t numClasses;
+	/**Rows of numClasses+2 entries: the status, the index of the accept list, then the offset of the row to go to for each class (or WHODUN_LAZYDFA_UNKNOWN).*/
+	std::vector<uintptr_t> classTable;
+	/**The (sorted) nfa states each row stands for.*/
+	std::vector< std::vector<uintptr_t> > rowStates;
+	/**Find rows by their nfa states.*/
+	std::map< std::vector<uintptr_t>, uintptr_t > rowMap;
+	/**The nfa states of the start.*/
+	std::vector<uintptr_t> startStates;
+	/**The offset of the start row.*/
+	uintptr_t startRow;
+	/**Lists of accepting nfas: count, then the indices. These survive flushes.*/
+	std::vector<uintptr_t*> acceptLists;
+	/**Find accept lists by their contents.*/
+	std::map< std::vector<uintptr_t>, uintptr_t > acceptMap;
+	/**The rough number of bytes the cache may use.*/
+	uintptr_t maxCache;
+	/**The rough number of bytes the cache is using.*/
+	uintptr_t usedCache;
+	
+	/**The number of bytes stepped over: the number of cache hits is this less numMiss.*/
+	uintmax_t numStep;
+	/**The number of steps that had to be worked out.*/
+	uintmax_t numMiss;
+	/**The number of times the cache filled up and was flushed.*/
+	uintmax_t numFlush;
+	/**The number of states that have been built.*/
+	uintmax_t numBuilt;
+	
+	/**Utility: mark nfa states already seen.*/
+	std::vector<uintptr_t> nfaMark;
+	/**The current marker value.*/
+	uintptr_t curMark;
+	/**Utility: states left to expand.*/
+	std::vector<uintptr_t> openStack;
+	/**Utility: the states being worked on.*/
+	std::vector<uintptr_t> workStates;
+	/**Utility: the accept list being worked on.*/
+	std::vector<uintptr_t> workAccept;
+	/**
+	 * Utility: add a state and follow its epsilon jumps.
+	 * @param toAdd The state to add.
+	 * @param toFill The place to add the states.
+	 */
+	void addClosure(uintptr_t toAdd, std::vector<uintptr_t>* toFill);
+	/**
+	 * Utility: find (or make) the row for a set of nfa states.
+	 * @param forStates The (sorted) states.
+	 * @return The offset of the row.
+	 */
+	uintptr_t findRow(std::vector<uintptr_t>* forStates);
+};
+
+/**What can be said about the matches of a regex without running it: used to skip ahead when searching.*/
+class RegexPrefilter{
+public:
+	/**Set up knowing nothing.*/
+	RegexPrefilter();
+	/**Clean up.*/
+	~RegexPrefilter();
+	
+	/**Whether the empty string might match.*/
+	int canEmpty;
+	/**Whether each byte might start a (non-empty) match.*/
+	char firstBytes[256];
+	/**Whether the only thing that matches is exactText.*/
+	int isExact;
+	/**The only thing that matches, if isExact.*/
+	std::string exactText;
+	/**Text every match starts with.*/
+	std::string prefixText;
+	/**Text every match contains somewhere.*/
+	std::string requireText;
 };
 
 /**A basic regular expression.*/
@@ -134,6 +275,12 @@ public:
 	 * @param state0 The offset of the first state.
 	 */
 	virtual void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0) = 0;
+	
+	/**
+	 * Figure out what can be said about matches without running. The default knows nothing.
+	 * @param toFill The place to put the information.
+	 */
+	virtual void prefilter(RegexPrefilter* toFill);
 };
 
 /**The empty string.*/
@@ -144,6 +291,7 @@ public:
 	
 	uintptr_t neededStates();
 	void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0);
+	void prefilter(RegexPrefilter* toFill);
 };
 
 /**A sequence of characters.*/
@@ -172,6 +320,7 @@ public:
 	
 	uintptr_t neededStates();
 	void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0);
+	void prefilter(RegexPrefilter* toFill);
 };
 
 /**Match one of a set of characters.*/
@@ -193,6 +342,7 @@ public:
 	
 	uintptr_t neededStates();
 	void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0);
+	void prefilter(RegexPrefilter* toFill);
 };
 
 /**A concatenation of zero or more items.*/
@@ -206,6 +356,7 @@ public:
 	
 	uintptr_t neededStates();
 	void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0);
+	void prefilter(RegexPrefilter* toFill);
 };
 
 /**One of several items.*/
@@ -219,6 +370,7 @@ public:
 	
 	uintptr_t neededStates();
 	void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0);
+	void prefilter(RegexPrefilter* toFill);
 };
 
 /**An item repeated.*/
@@ -235,10 +387,14 @@ public:
 	
 	uintptr_t neededStates();
 	void packStates(NondeterministicFiniteAutomata* toPack, uintptr_t state0);
+	void prefilter(RegexPrefilter* toFill);
 };
 
 //+ ? {N}
 
+/**Marks text that has not been looked for (or found).*/
+#define WHODUN_REGEX_NOTFOUND (~(uintptr_t)0)
+
 /**Compile and use a regular expression.*/
 class Regex{
 public:
@@ -247,6 +403,12 @@ public:
 	 * @param toFind The regular expression to hunt for.
 	 */
 	Regex(RegexSpecification* toFind);
+	/**
+	 * Set up a regex that works out its dfa as it goes.
+	 * @param toFind The regular expression to hunt for.
+	 * @param lazyCache The (rough) number of bytes to use for cached states.
+	 */
+	Regex(RegexSpecification* toFind, uintptr_t lazyCache);
 	/**Clena up*/
 	~Regex();
 	
@@ -285,10 +447,52 @@ public:
 	 */
 	int matches(SizePtrString toLook);
 	
-	/**The compiled expression.*/
+	/**The compiled expression (null if lazy).*/
 	DeterministicFiniteAutomata* compRegex;
+	/**The nfa, if lazy.*/
+	NondeterministicFiniteAutomata* baseNFA;
+	/**The lazily compiled expression, if lazy.*/
+	LazyDeterministicFiniteAutomata* lazyRegex;
+	
+	/**What is known about matches, for skipping ahead in find.*/
+	RegexPrefilter preInfo;
+	/**The bytes that can start a match.*/
+	ByteSetSearcher firstSet;
+	/**The number of bytes that can start a match.*/
+	uintptr_t numFirst;
+	/**The string method.*/
+	StandardMemorySearcher doMem;
+	/**
+	 * Utility: fill in the skip ahead information.
+	 * @param toFind The regular expression to hunt for.
+	 */
+	void setupPrefilter(RegexSpecification* toFind);
+	/**
+	 * Utility: skip to the next place a match might start.
+	 * @param toLook The string being searched.
+	 * @param fromI The first place to look: updated to the next candidate.
+	 * @param reqAt The location of the last found required text (WHODUN_REGEX_NOTFOUND if not looked for yet): updated as needed.
+	 * @return Whether there are any candidates left.
+	 */
+	int nextCandidate(SizePtrString toLook, uintptr_t* fromI, uintptr_t* reqAt);
 };
 
+/**How far along a (longest) match through a RegexSet is, for matching a piece at a time.*/
+typedef struct{
+	/**The current state.*/
+	uintptr_t curState;
+	/**Whether the match has hit a dead end.*/
+	int isDead;
+	/**The number of bytes eaten so far.*/
+	uintptr_t numSeen;
+	/**The length of the longest match so far: -1 for none.*/
+	intptr_t winLen;
+	/**The number of token types of the longest match.*/
+	uintptr_t winTC;
+	/**The token types of the longest match.*/
+	uintptr_t* winTypes;
+} RegexSetMatchProgress;
+
 /**A collection of regular expressions.*/
 class RegexSet{
 public:
@@ -299,6 +503,11 @@ public:
 	
 	/**Once all the regexes have been added, compile any acceleration structures.*/
 	void compile();
+	/**
+	 * Once all the regexes have been added, set up to work out states as they are needed.
+	 * @param lazyCache The (rough) number of bytes to use for cached states.
+	 */
+	void compileLazy(uintptr_t lazyCache);
 	
 	/**
 	 * Get the length of the match starting at the first character.
@@ -308,6 +517,18 @@ public:
 	 * @return The number of characters in the match: -1 for no match.
 	 */
 	intptr_t longMatchLength(SizePtrString toLook, uintptr_t* storeTC, uintptr_t** storeTypes);
+	/**
+	 * Start a match to be fed a piece at a time.
+	 * @param toFill The progress to set up.
+	 */
+	void startMatch(RegexSetMatchProgress* toFill);
+	/**
+	 * Continue a match over more text.
+	 * @param toUpd The progress to update.
+	 * @param toLook The next piece of text.
+	 * @return The number of bytes eaten: stops early (after the byte responsible) if it hits a dead end.
+	 */
+	uintptr_t continueMatch(RegexSetMatchProgress* toUpd, SizePtrString toLook);
 	
 	/**The regular expressions.*/
 	std::vector<Regex*> theReg;
@@ -315,6 +536,8 @@ public:
 	DeterministicFiniteAutomata compiledRegs;
 	/**Collected information on the structures: status, numStates, states[]*/
 	std::vector<uintptr_t> compiledStatus;
+	/**The lazy version, if compiled that way.*/
+	LazyDeterministicFiniteAutomata* lazyRegs;
 };
 
 };
@@ -8,7 +8,11 @@
 
 #include <deque>
 #include <vector>
+#include <string.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
 
 #include "whodun_ermac.h"
 #include "whodun_thread.h"
@@ -60,6 +64,29 @@ public:
 	}
 };
 
+/**The bytes of a key part are stored most significant first (little endian otherwise).*/
+#define WHODUN_SORTKEY_BIGENDIAN 1
+/**The key part is a two's complement signed integer.*/
+#define WHODUN_SORTKEY_SIGNED 2
+/**The key part is an IEEE floating point number: negative zero sorts with zero, and all NaN sort together after infinity.*/
+#define WHODUN_SORTKEY_FLOAT 4
+/**The byte order flag for native integers.*/
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	#define WHODUN_SORTKEY_NATIVE WHODUN_SORTKEY_BIGENDIAN
+#else
+	#define WHODUN_SORTKEY_NATIVE 0
+#endif
+
+/**A fixed width piece of a sort key.*/
+typedef struct{
+	/**The offset of the key bytes in each item.*/
+	uintptr_t offset;
+	/**The number of bytes in the key.*/
+	uintptr_t size;
+	/**How the key is stored (WHODUN_SORTKEY_*).*/
+	int flags;
+} PODSortKeyPart;
+
 /**Options for sorting data.*/
 class PODSortOptions{
 public:
@@ -89,6 +116,38 @@ public:
 	void* useUni;
 	/**The size of each item.*/
 	uintptr_t itemSize;
+	
+	/**
+	 * Note a fixed width key for each item: radix passes will be used where it pays.
+	 * Parts should be added most significant first, and must order items the same as compMeth (including how floating point parts treat negative zero and NaN).
+	 * @param offset The offset of the key bytes in each item.
+	 * @param size The number of bytes in the key.
+	 * @param flags How the key is stored (WHODUN_SORTKEY_*).
+	 */
+	void addKeyPart(uintptr_t offset, uintptr_t size, int flags);
+	/**The pieces of the key, most significant first. If empty, only compMeth is available.*/
+	std::vector<PODSortKeyPart> keyParts;
+	
+	/**
+	 * A method to get an order preserving prefix of an item's key, if any. Setting this lets in memory sorts of wide items sort prefixes instead of items.
+	 * @param unif A uniform for the comparison.
+	 * @param item The item.
+	 * @return The prefix: if the prefix of A is less than the prefix of B, A must come before B.
+	 */
+	uint64_t (*prefixMeth)(void* unif, void* item);
+	/**
+	 * Get the key prefix of an item, from prefixMeth or the key parts.
+	 * @param item The item.
+	 * @return The prefix: equal prefixes say nothing.
+	 */
+	uint64_t getPrefix(void* item);
+	/**
+	 * Get whether key prefixes are available.
+	 * @return Whether there is a prefix method or key parts.
+	 */
+	int hasPrefix();
+	/**Whether in memory sorts of wide items should sort prefixes built from the key parts instead of the items: this only pays if prefixes rarely tie.*/
+	int useIndirect;
 };
 
 /**A view of a sorted chunk of data.*/
@@ -174,6 +233,444 @@ public:
 	PODSortOptions opts;
 };
 
+/**Merge a piece of two sorted lists, with the comparison known at compile time.*/
+template<typename T, typename Cmp>
+class PODMergeQuantTaskT : public JoinableThreadTask{
+public:
+	/**
+	 * Basic setup
+	 * @param useComp The comparison to use.
+	 */
+	PODMergeQuantTaskT(const Cmp& useComp) : compMeth(useComp){}
+	/**Tear down*/
+	~PODMergeQuantTaskT(){}
+	void doTask(){
+		//figure the quantiles
+			uintptr_t quantALow = chunkyPairedQuantile(quantileStart);
+			uintptr_t quantAHigh = chunkyPairedQuantile(quantileEnd);
+		//turn into arrays
+			T* curTgt = dataE + quantileStart;
+			T* curElemA = dataA + quantALow;
+			T* endElemA = dataA + quantAHigh;
+			T* curElemB = dataB + (quantileStart - quantALow);
+			T* endElemB = curElemB + ((quantileEnd - quantileStart) - (quantAHigh - quantALow));
+		//merge
+			while((curElemA != endElemA) && (curElemB != endElemB)){
+				//in case of tie, A should go first (to keep it stable)
+				if(!compMeth(*curElemB, *curElemA)){
+					*curTgt = *curElemA;
+					curElemA++;
+				}
+				else{
+					*curTgt = *curElemB;
+					curElemB++;
+				}
+				curTgt++;
+			}
+			if(curElemA != endElemA){ memcpy(curTgt, curElemA, (endElemA - curElemA)*sizeof(T)); }
+			if(curElemB != endElemB){ memcpy(curTgt, curElemB, (endElemB - curElemB)*sizeof(T)); }
+	}
+	
+	/**
+	 * Figure out how many things to get from list A to hit the requested quantile.
+	 * @param forQuant The desired quantile.
+	 * @return The number of things to get from list A.
+	 */
+	uintptr_t chunkyPairedQuantile(uintptr_t forQuant){
+		uintptr_t fromALow = 0;
+		uintptr_t fromAHig = numEA;
+		while(fromAHig - fromALow){
+			uintptr_t fromAMid = fromALow + ((fromAHig - fromALow) >> 1);
+			uintptr_t fromBMid = std::lower_bound(dataB, dataB + numEB, dataA[fromAMid], compMeth) - dataB;
+			if((fromAMid + fromBMid) < forQuant){
+				fromALow = fromAMid + 1;
+			}
+			else{
+				fromAHig = fromAMid;
+			}
+		}
+		return fromALow;
+	}
+	
+	/**The number of things in the full first list.*/
+	uintptr_t numEA;
+	/**The full first list.*/
+	T* dataA;
+	/**The number of things in the full second list.*/
+	uintptr_t numEB;
+	/**The full second list.*/
+	T* dataB;
+	/**The full target list.*/
+	T* dataE;
+	/**The start quantile.*/
+	uintptr_t quantileStart;
+	/**The end quantile.*/
+	uintptr_t quantileEnd;
+	/**The comparison to use.*/
+	Cmp compMeth;
+};
+
+/**Merge sorted data, with the comparison known at compile time.*/
+template<typename T, typename Cmp = std::less<T> >
+class PODSortedDataMergerT{
+public:
+	/**
+	 * Set up data merging.
+	 * @param useComp The comparison to use.
+	 */
+	PODSortedDataMergerT(const Cmp& useComp = Cmp()){
+		usePool = 0;
+		passUnis.push_back(new PODMergeQuantTaskT<T,Cmp>(useComp));
+	}
+	/**
+	 * Set up data merging.
+	 * @param numThr The number of threads to use.
+	 * @param mainPool The threads to use.
+	 * @param useComp The comparison to use.
+	 */
+	PODSortedDataMergerT(uintptr_t numThr, ThreadPool* mainPool, const Cmp& useComp = Cmp()){
+		usePool = mainPool;
+		for(uintptr_t i = 0; i<numThr; i++){
+			passUnis.push_back(new PODMergeQuantTaskT<T,Cmp>(useComp));
+		}
+	}
+	/**Clean up*/
+	~PODSortedDataMergerT(){
+		for(uintptr_t i = 0; i<passUnis.size(); i++){
+			delete(passUnis[i]);
+		}
+	}
+	
+	/**
+	 * Perform the merge.
+	 * @param numEA The number of elements in A.
+	 * @param dataA The data in A.
+	 * @param numEB The number of elements in B.
+	 * @param dataB The data in B.
+	 * @param dataE The place to put the merged data.
+	 */
+	void merge(uintptr_t numEA, T* dataA, uintptr_t numEB, T* dataB, T* dataE){
+		startMerge(numEA, dataA, numEB, dataB, dataE);
+		joinMerge();
+	}
+	
+	/**
+	 * Start a merge, without blocking for finish.
+	 * @param numEA The number of elements in A.
+	 * @param dataA The data in A.
+	 * @param numEB The number of elements in B.
+	 * @param dataB The data in B.
+	 * @param dataE The place to put the merged data.
+	 */
+	void startMerge(uintptr_t numEA, T* dataA, uintptr_t numEB, T* dataB, T* dataE){
+		uintptr_t numThread = passUnis.size();
+		uintptr_t totalNumE = numEA + numEB;
+		uintptr_t numPT = totalNumE / numThread;
+		uintptr_t numET = totalNumE % numThread;
+		uintptr_t curQuant = 0;
+		for(uintptr_t i = 0; i<numThread; i++){
+			PODMergeQuantTaskT<T,Cmp>* curTask = (PODMergeQuantTaskT<T,Cmp>*)(passUnis[i]);
+			curTask->numEA = numEA;
+			curTask->dataA = dataA;
+			curTask->numEB = numEB;
+			curTask->dataB = dataB;
+			curTask->dataE = dataE;
+			curTask->quantileStart = curQuant;
+			curQuant += (numPT + (i < numET));
+			curTask->quantileEnd = curQuant;
+		}
+		if(usePool){
+			usePool->addTasks(passUnis.size(), (JoinableThreadTask**)(&(passUnis[0])));
+		}
+	}
+	
+	/**Join a previously started merge.*/
+	void joinMerge(){
+		if(usePool){
+			joinTasks(passUnis.size(), (JoinableThreadTask**)(&(passUnis[0])));
+		}
+		else{
+			passUnis[0]->doTask();
+		}
+	}
+	
+	/**The thread pool to use, if any.*/
+	ThreadPool* usePool;
+	/**Storage for things to do.*/
+	std::vector<JoinableThreadTask*> passUnis;
+};
+
+/**The size of runs to insertion sort before merging, for templated sorts.*/
+#define WHODUN_SORT_TEMPLATE_RUN 16
+
+/**
+ * Performs a small mergesort in memory in a single thread, with the comparison known at compile time.
+ * @param numEnts The entries to merge.
+ * @param inMem The data to sort.
+ * @param compMeth The comparison to use.
+ * @param tmpStore Temporary storage (same size as inMem).
+ * @return Whether the end result is in tmpStore.
+ */
+template<typename T, typename Cmp>
+int whodun_inMemoryMergesortSmallT(uintptr_t numEnts, T* inMem, const Cmp& compMeth, T* tmpStore){
+	//insertion sort small runs
+		for(uintptr_t curBase = 0; curBase < numEnts; curBase += WHODUN_SORT_TEMPLATE_RUN){
+			uintptr_t finBase = std::min(curBase + WHODUN_SORT_TEMPLATE_RUN, numEnts);
+			for(uintptr_t i = curBase + 1; i < finBase; i++){
+				T curVal = inMem[i];
+				uintptr_t j = i;
+				while((j > curBase) && compMeth(curVal, inMem[j-1])){
+					inMem[j] = inMem[j-1];
+					j--;
+				}
+				inMem[j] = curVal;
+			}
+		}
+	//and merge them
+		T* curStore = inMem;
+		T* nxtStore = tmpStore;
+		uintptr_t size = WHODUN_SORT_TEMPLATE_RUN;
+		while(size < numEnts){
+			uintptr_t curBase = 0;
+			while(curBase < numEnts){
+				T* curFromA = curStore + curBase;
+				T* curTo = nxtStore + curBase;
+				uintptr_t nxtBase = curBase + size;
+				if(nxtBase > numEnts){
+					memcpy(curTo, curFromA, (numEnts - curBase)*sizeof(T));
+					break;
+				}
+				T* endFromA = curStore + nxtBase;
+				T* curFromB = endFromA;
+				uintptr_t finBase = std::min(nxtBase + size, numEnts);
+				T* endFromB = curStore + finBase;
+				while((curFromA != endFromA) && (curFromB != endFromB)){
+					if(compMeth(*curFromB, *curFromA)){
+						*curTo = *curFromB;
+						curFromB++;
+					}
+					else{
+						*curTo = *curFromA;
+						curFromA++;
+					}
+					curTo++;
+				}
+				if(curFromA != endFromA){ memcpy(curTo, curFromA, (endFromA - curFromA)*sizeof(T)); }
+				if(curFromB != endFromB){ memcpy(curTo, curFromB, (endFromB - curFromB)*sizeof(T)); }
+				curBase = finBase;
+			}
+			size = (size << 1);
+			T* swapSave = curStore;
+			curStore = nxtStore;
+			nxtStore = swapSave;
+		}
+	return curStore != inMem;
+}
+
+/**Sort a chunk, with the comparison known at compile time.*/
+template<typename T, typename Cmp>
+class PODSortChunkTaskT : public JoinableThreadTask{
+public:
+	/**
+	 * Basic setup
+	 * @param useComp The comparison to use.
+	 */
+	PODSortChunkTaskT(const Cmp& useComp) : compMeth(useComp){}
+	/**Tear down*/
+	~PODSortChunkTaskT(){}
+	void doTask(){
+		int isInTemp = whodun_inMemoryMergesortSmallT(numElem, dataStart, compMeth, dataTemp);
+		if(wantInTemp){
+			if(!isInTemp){
+				memcpy(dataTemp, dataStart, numElem * sizeof(T));
+			}
+		}
+		else{
+			if(isInTemp){
+				memcpy(dataStart, dataTemp, numElem * sizeof(T));
+			}
+		}
+	}
+	
+	/**The number of things in the list.*/
+	uintptr_t numElem;
+	/**The array the data start in.*/
+	T* dataStart;
+	/**A temporary array.*/
+	T* dataTemp;
+	/**Whether the final thing should wind up in dataTemp.*/
+	int wantInTemp;
+	/**The comparison to use.*/
+	Cmp compMeth;
+};
+
+/**Do merge sorts in memory, with the item type and comparison known at compile time.*/
+template<typename T, typename Cmp = std::less<T> >
+class PODInMemoryMergesortT{
+public:
+	/**
+	 * Set up in memory mergesorting.
+	 * @param useComp The comparison to use.
+	 */
+	PODInMemoryMergesortT(const Cmp& useComp = Cmp()){
+		allocSize = 1024;
+		allocTmp = (T*)malloc(allocSize * sizeof(T));
+		usePool = 0;
+		wantInTemp = 0;
+		PODSortChunkTaskT<T,Cmp>* curSTask = new PODSortChunkTaskT<T,Cmp>(useComp);
+			curSTask->wantInTemp = wantInTemp;
+			passUnis.push_back(curSTask);
+		mergeMeths.push_back(new PODSortedDataMergerT<T,Cmp>(useComp));
+	}
+	/**
+	 * Set up in memory mergesorting.
+	 * @param numThr The number of threads to use.
+	 * @param mainPool The threads to use.
+	 * @param useComp The comparison to use.
+	 */
+	PODInMemoryMergesortT(uintptr_t numThr, ThreadPool* mainPool, const Cmp& useComp = Cmp()){
+		allocSize = 1024*numThr;
+		allocTmp = (T*)malloc(allocSize * sizeof(T));
+		usePool = mainPool;
+		//figure out whether the initial sorts should wind up in start or finish
+			wantInTemp = 0;
+			uintptr_t tmpNumThr = numThr;
+			while(tmpNumThr > 1){
+				wantInTemp = !wantInTemp;
+				tmpNumThr = (tmpNumThr >> 1) + (tmpNumThr & 0x01);
+			}
+		//make the thread stuff
+		for(uintptr_t i = 0; i<numThr; i++){
+			PODSortChunkTaskT<T,Cmp>* curSTask = new PODSortChunkTaskT<T,Cmp>(useComp);
+				curSTask->wantInTemp = wantInTemp;
+				passUnis.push_back(curSTask);
+			mergeMeths.push_back(new PODSortedDataMergerT<T,Cmp>(numThr, mainPool, useComp));
+		}
+	}
+	/**Clean up.*/
+	~PODInMemoryMergesortT(){
+		for(uintptr_t i = 0; i<passUnis.size(); i++){
+			delete(passUnis[i]);
+			delete(mergeMeths[i]);
+		}
+		free(allocTmp);
+	}
+	
+	/**
+	 * Actually sort some stuff.
+	 * @param numEntries The number of entries.
+	 * @param entryStore The entries.
+	 */
+	void sort(uintptr_t numEntries, T* entryStore){
+		//test storage allocation
+			if(numEntries > allocSize){
+				if(allocTmp){ free(allocTmp); }
+				allocSize = numEntries;
+				allocTmp = (T*)malloc(allocSize * sizeof(T));
+			}
+		//do the initial sort
+			uintptr_t numThread = passUnis.size();
+			uintptr_t numPT = numEntries / numThread;
+			uintptr_t numET = numEntries % numThread;
+			uintptr_t curI0 = 0;
+			threadPieceSizes.clear();
+			for(uintptr_t i = 0; i<numThread; i++){
+				PODSortChunkTaskT<T,Cmp>* curSortT = (PODSortChunkTaskT<T,Cmp>*)(passUnis[i]);
+				uintptr_t curNum = numPT + (i < numET);
+				curSortT->numElem = curNum;
+				curSortT->dataStart = entryStore + curI0;
+				curSortT->dataTemp = allocTmp + curI0;
+				threadPieceSizes.push_back(curNum);
+				curI0 += curNum;
+			}
+			if(usePool){
+				usePool->addTasks(passUnis.size(), (JoinableThreadTask**)(&(passUnis[0])));
+				joinTasks(passUnis.size(), (JoinableThreadTask**)(&(passUnis[0])));
+			}
+			else{
+				passUnis[0]->doTask();
+			}
+		//do the merges
+			T* curMergeFrom = wantInTemp ? allocTmp : entryStore;
+			T* curMergeTo = wantInTemp ? entryStore : allocTmp;
+			while(threadPieceSizes.size() > 1){
+				//start the merges
+					uintptr_t curI0 = 0;
+					uintptr_t startNumP = threadPieceSizes.size();
+					uintptr_t curPI = 0;
+					uintptr_t curMI = 0;
+					while(curPI < startNumP){
+						T* curElemE = curMergeTo + curI0;
+						uintptr_t curNumA = threadPieceSizes[curPI];
+						T* curElemA = curMergeFrom + curI0;
+						curI0 += curNumA;
+						curPI++;
+						T* curElemB = curMergeFrom + curI0;
+						uintptr_t curNumB = (curPI < startNumP) ? threadPieceSizes[curPI] : 0;
+						curI0 += curNumB;
+						curPI++;
+						mergeMeths[curMI]->startMerge(curNumA, curElemA, curNumB, curElemB, curElemE);
+						threadPieceSizes.push_back(curNumA + curNumB);
+						curMI++;
+					}
+				//wait for them to finish
+					for(uintptr_t i = 0; i<curMI; i++){
+						mergeMeths[i]->joinMerge();
+					}
+				//prepare for the next round
+					T* tmpMerge = curMergeFrom;
+					curMergeFrom = curMergeTo;
+					curMergeTo = tmpMerge;
+					threadPieceSizes.erase(threadPieceSizes.begin(), threadPieceSizes.begin() + startNumP);
+			}
+	}
+	
+	/**Whether this wants the original sort to put things in temporary storage.*/
+	int wantInTemp;
+	/**The amount of space allocated for temporaries.*/
+	uintptr_t allocSize;
+	/**The temporary space.*/
+	T* allocTmp;
+	/**The thread pool to use, if any.*/
+	ThreadPool* usePool;
+	/**Sort the pieces independently.*/
+	std::vector<JoinableThreadTask*> passUnis;
+	/**The ways to merge things.*/
+	std::vector<PODSortedDataMergerT<T,Cmp>*> mergeMeths;
+	/**The pieces waiting to merge.*/
+	std::vector< uintptr_t > threadPieceSizes;
+};
+
+/**An item key prefix and the index of the item, for indirect sorting.*/
+typedef struct{
+	/**The key prefix.*/
+	uint64_t prefix;
+	/**The index of the item.*/
+	uintptr_t index;
+} PODSortPrefixEntry;
+
+/**Compare prefix entries, falling back to the items themselves on prefix ties.*/
+class PODSortPrefixLess{
+public:
+	/**
+	 * Set up a comparison.
+	 * @param theOpts The options for the full items.
+	 * @param theBase The place the start of the item array will be stored.
+	 */
+	PODSortPrefixLess(PODSortOptions* theOpts, char** theBase);
+	/**
+	 * Compare two entries.
+	 * @param itemA The first entry.
+	 * @param itemB The second entry.
+	 * @return Whether itemA should come before itemB (ties go by index).
+	 */
+	bool operator()(const PODSortPrefixEntry& itemA, const PODSortPrefixEntry& itemB) const;
+	/**The options for the full items.*/
+	PODSortOptions* opts;
+	/**The place the start of the item array will be stored.*/
+	char** baseData;
+};
+
 /**Do merge sorts in memory.*/
 class PODInMemoryMergesort{
 public:
@@ -198,6 +695,24 @@ public:
 	 * @param entryStore The entries.
 	 */
 	void sort(uintptr_t numEntries, char* entryStore);
+	/**
+	 * Sort some stuff by radix passes over the key parts.
+	 * @param numEntries The number of entries.
+	 * @param entryStore The entries.
+	 */
+	void radixSort(uintptr_t numEntries, char* entryStore);
+	/**
+	 * Sort (key prefix, index) pairs, then gather the items into temporary storage and copy them back.
+	 * @param numEntries The number of entries.
+	 * @param entryStore The entries.
+	 */
+	void indirectSort(uintptr_t numEntries, char* entryStore);
+	/**
+	 * Merge all the sorted thread pieces in one pass, using splitters to divide the output between threads.
+	 * @param mergeFrom The sorted pieces, one after another.
+	 * @param mergeTo The place to put the merged data.
+	 */
+	void multiwayMerge(char* mergeFrom, char* mergeTo);
 	
 	/**Whether this wants the original sort to put things in temporary storage.*/
 	int wantInTemp;
@@ -209,6 +724,26 @@ public:
 	ThreadPool* usePool;
 	/**Sort the pieces independently.*/
 	std::vector<JoinableThreadTask*> passUnis;
+	/**Count and scatter bytes for radix passes.*/
+	std::vector<JoinableThreadTask*> radixUnis;
+	/**Whether to merge the thread pieces in one multiway pass instead of pairwise.*/
+	int useMultiway;
+	/**Find cuts and merge ranges for multiway merges.*/
+	std::vector<JoinableThreadTask*> multiUnis;
+	/**Where each piece gets cut for each output range, for multiway merges.*/
+	std::vector<uintptr_t> multiCuts;
+	/**Storage for samples, for multiway merges.*/
+	std::vector<char> multiSamples;
+	/**Storage for splitters, for multiway merges.*/
+	std::vector<char> multiSplitters;
+	/**Build prefixes and gather items for indirect sorts.*/
+	std::vector<JoinableThreadTask*> indirectUnis;
+	/**Sort prefixes for indirect sorts, if prefixes are available.*/
+	PODInMemoryMergesortT<PODSortPrefixEntry,PODSortPrefixLess>* prefixSort;
+	/**Storage for prefixes.*/
+	std::vector<PODSortPrefixEntry> prefixStore;
+	/**The items currently being sorted indirectly.*/
+	char* indirectBase;
 	/**The ways to merge things.*/
 	std::vector<PODSortedDataMerger*> mergeMeths;
 	/**The pieces waiting to merge.*/
@@ -237,11 +772,37 @@ public:
 	/**Clean up.*/
 	~PODExternalMergeSort();
 	/**
-	 * Add some (sorted) data.
+	 * Add some (sorted) data: it is spilled in the background.
 	 * @param numEntries The number of entries.
 	 * @param entryStore The entries. Memory can be reused after this call.
 	 */
 	void addData(uintptr_t numEntries, char* entryStore);
+	/**
+	 * Add some unsorted data: it is sorted and spilled in the background.
+	 * @param numEntries The number of entries.
+	 * @param entryStore The entries. Memory can be reused after this call.
+	 */
+	void addUnsortedData(uintptr_t numEntries, char* entryStore);
+	/**
+	 * Get a buffer to fill with a run, while the previous run spills.
+	 * @param numEntries The number of entries that will be added.
+	 * @return The place to put them.
+	 */
+	char* getFillBuffer(uintptr_t numEntries);
+	/**
+	 * Hand off the buffer from getFillBuffer to be spilled in the background.
+	 * @param numEntries The number of entries actually in the buffer.
+	 * @param needSort Whether the entries need to be sorted first.
+	 */
+	void addFillBuffer(uintptr_t numEntries, int needSort);
+	/**Wait for any background spill to finish.*/
+	void waitSpill();
+	/**
+	 * Write a sorted run to a new temporary file.
+	 * @param numEntries The number of entries.
+	 * @param entryStore The entries.
+	 */
+	void spillRun(uintptr_t numEntries, char* entryStore);
 	/**
 	 * Merge all the data.
 	 * @param toDump The place to write it.
@@ -251,7 +812,7 @@ public:
 	ErrorLog* statusDump;
 	/**The maximum number of bytes to load.*/
 	uintptr_t maxLoad;
-	/**The maximum number of files to have open at one time while merging.*/
+	/**The maximum number of files to have open at one time while merging (the budget in maxLoad may lower this).*/
 	uintptr_t maxMergeFiles;
 	/**The minimum number of entities to have loaded per file while merging.*/
 	uintptr_t minMergeEnts;
@@ -271,13 +832,30 @@ public:
 	std::deque<std::string> allTempBase;
 	/**Storage for information on temporary files.*/
 	std::deque<std::string> allTempBlock;
+	/**The default compression for temporary files.*/
+	DeflateCompressionFactory defaultSpillComp;
+	/**The compression to use for temporary files: change before adding data. Defaults to defaultSpillComp.*/
+	CompressionFactory* spillComp;
+	/**The buffers runs are filled in and spilled from.*/
+	char* runBuffers[2];
+	/**The number of entries each buffer has room for.*/
+	uintptr_t runBufferSize[2];
+	/**The buffer getFillBuffer hands out.*/
+	int runFillIndex;
+	/**Sort runs that come in unsorted.*/
+	PODInMemoryMergesort* runSort;
+	/**The background spill.*/
+	JoinableThreadTask* spillTask;
+	/**The thread running the background spill, if any.*/
+	OSThread* spillThread;
 	/**
-	 * Do a single merge.
+	 * Do a single k-way merge of neighboring temporary files, and remove them.
+	 * @param fromFile The index of the first file to merge.
 	 * @param numFileOpen The number of files to merge in one go.
-	 * @param loadEnts The number of entries to load.
+	 * @param loadEnts The number of entries to buffer for each file (and the output).
 	 * @param toDump The place to write.
 	 */
-	void mergeSingle(uintptr_t numFileOpen, uintptr_t loadEnts, OutStream* toDump);
+	void mergeSingle(uintptr_t fromFile, uintptr_t numFileOpen, uintptr_t loadEnts, OutStream* toDump);
 };
 
 //TODO serialize external
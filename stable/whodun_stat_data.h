@@ -13,6 +13,7 @@
 
 #include "whodun_args.h"
 #include "whodun_thread.h"
+#include "whodun_compress.h"
 #include "whodun_container.h"
 
 namespace whodun {
@@ -61,6 +62,83 @@ public:
 	std::vector<uintptr_t> strLengths;
 };
 
+/**A flat hash from the names of the levels of a categorical column to their values.*/
+class DataTableFactorDictionary{
+public:
+	/**Set up an empty dictionary.*/
+	DataTableFactorDictionary();
+	/**Clean up.*/
+	~DataTableFactorDictionary();
+	/**
+	 * Hash the name of a level.
+	 * @param levName The name.
+	 * @return The hash.
+	 */
+	uint64_t hashName(SizePtrString levName);
+	/**
+	 * Add a level.
+	 * @param levName The name of the level.
+	 * @param levVal The value of the level.
+	 * @return Whether the level was added (zero if the name was already present).
+	 */
+	int add(SizePtrString levName, uintptr_t levVal);
+	/**
+	 * Replace the levels with those of a column.
+	 * @param fromMap The levels to use.
+	 */
+	void setLevels(std::map<std::string,uintptr_t>* fromMap);
+	/**
+	 * Look up a level.
+	 * @param levName The name to look for.
+	 * @param toFill The place to put its value.
+	 * @return Whether it was found.
+	 */
+	int find(SizePtrString levName, uintptr_t* toFill);
+	/**
+	 * Look up a level.
+	 * @param levName The name to look for.
+	 * @param hashV The hash of the name.
+	 * @param toFill The place to put its value.
+	 * @return Whether it was found.
+	 */
+	int find(SizePtrString levName, uint64_t hashV, uintptr_t* toFill);
+	/**Rearrange the slots so that every level lands in its slot on the first try (a perfect hash). Adding a level undoes this.*/
+	void freeze();
+	/**Remove all levels.*/
+	void clear();
+
+	/**The number of levels.*/
+	uintptr_t numLevels;
+	/**Whether the slots are a perfect hash.*/
+	int isFrozen;
+	/**The names of the levels, back to back.*/
+	StructVector<char> nameText;
+	/**The offset of each name in nameText, with an extra entry at the end.*/
+	StructVector<uintptr_t> nameOffsets;
+	/**The hash of each name.*/
+	StructVector<uint64_t> nameHashes;
+	/**The value of each level.*/
+	StructVector<uintptr_t> levelValues;
+	/**The hash of the level in each slot.*/
+	StructVector<uint64_t> slotHash;
+	/**The level (plus one) in each slot, or zero if empty.*/
+	StructVector<uintptr_t> slotLevel;
+	/**For a frozen dictionary, how to place the levels of each bucket: zero for empty, negative for a fixed slot, positive for a seed.*/
+	StructVector<intptr_t> bucketPlace;
+
+	/**
+	 * Rebuild the slots for linear probing.
+	 * @param numSlots The number of slots to use (a power of two).
+	 */
+	void rehashProbe(uintptr_t numSlots);
+	/**
+	 * Try to lay out the slots as a perfect hash.
+	 * @param numSlots The number of slots to use (a power of two).
+	 * @return Whether it worked.
+	 */
+	int tryFreeze(uintptr_t numSlots);
+};
+
 /**A collection of rows from a data table.*/
 class DataTable{
 public:
@@ -75,6 +153,67 @@ public:
 	StructVector<char> saveText;
 };
 
+/**One column of a collection of rows.*/
+class DataTableColumn{
+public:
+	/**Set up an empty column.*/
+	DataTableColumn();
+	/**Clean up.*/
+	~DataTableColumn();
+	
+	/**The type of data in this column.*/
+	uintptr_t colType;
+	/**For string data, the (padded) length of each entry.*/
+	uintptr_t strLength;
+	/**Which entries are known: bit (i%64) of word (i/64) is set if entry i is known.*/
+	StructVector<uint64_t> valid;
+	/**The values, for categorical columns.*/
+	StructVector<uint64_t> valC;
+	/**The values, for integer columns.*/
+	StructVector<int64_t> valI;
+	/**The values, for real columns.*/
+	StructVector<double> valR;
+	/**For string columns, where each entry starts in strText (with an extra entry for the end). Trailing padding is not stored.*/
+	StructVector<uintptr_t> strOffs;
+	/**For string columns, the text of the entries.*/
+	StructVector<char> strText;
+};
+
+/**A collection of rows from a data table, stored a column at a time.*/
+class DataTableColumns{
+public:
+	/**Set up an empty table.*/
+	DataTableColumns();
+	/**Clean up*/
+	~DataTableColumns();
+	
+	/**
+	 * Set up the columns for a type of table and empty them.
+	 * @param forData The type of table.
+	 */
+	void setColumns(DataTableDescription* forData);
+	/**
+	 * Make room for some number of rows (values and known flags, not string text).
+	 * @param newRows The number of rows.
+	 */
+	void resize(uintptr_t newRows);
+	/**
+	 * Convert from a collection of rows (the columns must already be set up).
+	 * @param fromRows The rows to convert.
+	 */
+	void fromRows(DataTable* fromRows);
+	/**
+	 * Convert to a collection of rows.
+	 * @param toRows The place to put the rows.
+	 */
+	void toRows(DataTable* toRows);
+	
+	/**The number of rows.*/
+	uintptr_t numRows;
+	/**The columns.*/
+	std::vector<DataTableColumn*> cols;
+};
+
 /**Read from a data table.*/
 class DataTableReader{
 public:
@@ -94,6 +233,13 @@ public:
 	 * @return The number of rows actually read: if less than numRows, have hit eof.
 	 */
 	virtual uintptr_t read(DataTable* toStore, uintptr_t numRows) = 0;
+	/**
+	 * Read some rows from the table, a column at a time.
+	 * @param toStore The place to put them: will be set up for this table.
+	 * @param numRows The number of rows to read.
+	 * @return The number of rows actually read: if less than numRows, have hit eof.
+	 */
+	virtual uintptr_t readColumns(DataTableColumns* toStore, uintptr_t numRows);
 	/** Close anything this thing opened. */
 	virtual void close() = 0;
 	
@@ -101,6 +247,8 @@ public:
 	int isClosed;
 	/**The description of the table.*/
 	DataTableDescription tabDesc;
+	/**Storage for rows when reading columns.*/
+	DataTable convRows;
 };
 
 /**Random access to data tables.*/
@@ -140,6 +288,11 @@ public:
 	 * @param toStore The rows to write.
 	 */
 	virtual void write(DataTable* toStore) = 0;
+	/**
+	 * Write some rows, stored a column at a time, to the table.
+	 * @param toStore The rows to write.
+	 */
+	virtual void writeColumns(DataTableColumns* toStore);
 	/** Close anything this thing opened. */
 	virtual void close() = 0;
 	
@@ -147,6 +300,8 @@ public:
 	int isClosed;
 	/**The description of the table.*/
 	DataTableDescription tabDesc;
+	/**Storage for rows when writing columns.*/
+	DataTable convRows;
 };
 
 /**Read from a binary data table file.*/
@@ -259,6 +414,133 @@ public:
 	uintptr_t rowBytes;
 };
 
+/**The default number of (uncompressed) bytes to gather into a row group of a columnar table.*/
+#define WHODUN_COLUMNAR_GROUP_BYTES 0x01000000
+
+/**Read from a columnar data table file: rows are stored in groups, with each column of a group compressed separately.*/
+class ColumnarDataTableReader : public RandacDataTableReader{
+public:
+	/**
+	 * Open a data table file.
+	 * @param dataFile The file with the actual data.
+	 * @param compMeth The compression method used for the column chunks.
+	 */
+	ColumnarDataTableReader(RandaccInStream* dataFile, CompressionFactory* compMeth);
+	/**
+	 * Open a data table file.
+	 * @param dataFile The file with the actual data.
+	 * @param compMeth The compression method used for the column chunks.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	ColumnarDataTableReader(RandaccInStream* dataFile, CompressionFactory* compMeth, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up*/
+	~ColumnarDataTableReader();
+	uintptr_t read(DataTable* toStore, uintptr_t numRows);
+	uintptr_t readColumns(DataTableColumns* toStore, uintptr_t numRows);
+	void close();
+	uintmax_t size();
+	void seek(uintmax_t index);
+	
+	/**
+	 * Only read some of the columns: the description (and the rows read) will only have those columns.
+	 * @param numSel The number of columns to read.
+	 * @param selCols The indices of the columns to read, in the order they should appear.
+	 */
+	void selectColumns(uintptr_t numSel, const uintptr_t* selCols);
+	/**
+	 * Read the description of this table and the footer (the row groups and the locations of their column chunks).
+	 * @param compMeth The compression method used for the column chunks.
+	 */
+	void readHeader(CompressionFactory* compMeth);
+	/**
+	 * Load and decompress the selected columns of a row group.
+	 * @param groupInd The group to load.
+	 */
+	void loadGroup(uintptr_t groupInd);
+	
+	/**The main data.*/
+	RandaccInStream* tsvStr;
+	/**The things to run in threads.*/
+	std::vector<JoinableThreadTask*> passUnis;
+	/**The pool to use, if any.*/
+	ThreadPool* usePool;
+	/**The description of every column in the file.*/
+	DataTableDescription fullDesc;
+	/**The columns being read.*/
+	std::vector<uintptr_t> useCols;
+	/**The first row of each group, with the total number of rows at the end.*/
+	std::vector<uintmax_t> groupStarts;
+	/**For each group, for each column, the location and compressed size of its chunk.*/
+	std::vector<uintmax_t> chunkLocs;
+	/**Decompression for each column of the file.*/
+	std::vector<DecompressionMethod*> colUnzip;
+	/**Storage for compressed chunks.*/
+	StructVector<char> compLoad;
+	/**The group currently loaded, if any.*/
+	uintptr_t loadedGroup;
+	/**The next index to report.*/
+	uintmax_t focusInd;
+};
+
+/**Write to a columnar data table file.*/
+class ColumnarDataTableWriter : public DataTableWriter{
+public:
+	/**
+	 * Prepare to write a data table file.
+	 * @param forData The type of data this will be writing.
+	 * @param dataFile The file to write to.
+	 * @param compMeth The compression method to use for the column chunks.
+	 */
+	ColumnarDataTableWriter(DataTableDescription* forData, OutStream* dataFile, CompressionFactory* compMeth);
+	/**
+	 * Prepare to write a data table file.
+	 * @param forData The type of data this will be writing.
+	 * @param dataFile The file to write to.
+	 * @param compMeth The compression method to use for the column chunks.
+	 * @param groupRows The number of rows in each row group (zero for a default).
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	ColumnarDataTableWriter(DataTableDescription* forData, OutStream* dataFile, CompressionFactory* compMeth, uintptr_t groupRows, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up*/
+	~ColumnarDataTableWriter();
+	void write(DataTable* toStore);
+	void close();
+	
+	/**
+	 * Set up the storage for a group.
+	 * @param compMeth The compression method to use for the column chunks.
+	 * @param groupRows The number of rows in each row group (zero for a default).
+	 */
+	void prepareGroups(CompressionFactory* compMeth, uintptr_t groupRows);
+	/**
+	 * Compress and write out the pending group.
+	 */
+	void dumpGroup();
+	
+	/**The main data.*/
+	OutStream* tsvStr;
+	/**The things to run in threads.*/
+	std::vector<JoinableThreadTask*> passUnis;
+	/**The pool to use, if any.*/
+	ThreadPool* usePool;
+	/**The number of rows in a full group.*/
+	uintptr_t maxGroupRows;
+	/**The number of rows waiting in the current group.*/
+	uintptr_t numPending;
+	/**Packed data for each column of the current group: missing flags for every row, then the values.*/
+	std::vector<char*> colPack;
+	/**Compression for each column.*/
+	std::vector<CompressionMethod*> colZip;
+	/**The number of rows in each group written so far.*/
+	std::vector<uintmax_t> groupRowCounts;
+	/**For each group written, for each column, the location and compressed size of its chunk.*/
+	std::vector<uintmax_t> chunkLocs;
+	/**The number of bytes written so far.*/
+	uintmax_t totalWrite;
+};
+
 /**Choose how to open a thing based on its extension.*/
 class ExtensionDataTableReader : public DataTableReader{
 public:
@@ -279,6 +561,7 @@ public:
 	/**Clean up.*/
 	~ExtensionDataTableReader();
 	uintptr_t read(DataTable* toStore, uintptr_t numRows);
+	uintptr_t readColumns(DataTableColumns* toStore, uintptr_t numRows);
 	void close();
 	
 	/**
@@ -314,6 +597,7 @@ public:
 	/**Clean up.*/
 	~ExtensionRandacDataTableReader();
 	uintptr_t read(DataTable* toStore, uintptr_t numRows);
+	uintptr_t readColumns(DataTableColumns* toStore, uintptr_t numRows);
 	void close();
 	uintmax_t size();
 	void seek(uintmax_t index);
@@ -354,6 +638,7 @@ public:
 	/**Clean up.*/
 	~ExtensionDataTableWriter();
 	void write(DataTable* toStore);
+	void writeColumns(DataTableColumns* toStore);
 	void close();
 	
 	/**
@@ -0,0 +1,693 @@
+#ifndef WHODUN_STAT_QUERY_H
+#define WHODUN_STAT_QUERY_H 1
+
+/**
+ * @file
+ * @brief Queries over tables.
+ */
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "whodun_sort.h"
+#include "whodun_thread.h"
+#include "whodun_compress.h"
+#include "whodun_container.h"
+#include "whodun_stat_data.h"
+#include "whodun_stat_table.h"
+
+namespace whodun {
+
+/**Count the rows in each group (the column is ignored).*/
+#define WHODUN_AGGREGATE_ROWS 0
+/**Count the known values of a column.*/
+#define WHODUN_AGGREGATE_COUNT 1
+/**Sum the known values of a column.*/
+#define WHODUN_AGGREGATE_SUM 2
+/**Average the known values of a column.*/
+#define WHODUN_AGGREGATE_MEAN 3
+/**Find the smallest known value of a column.*/
+#define WHODUN_AGGREGATE_MIN 4
+/**Find the largest known value of a column.*/
+#define WHODUN_AGGREGATE_MAX 5
+/**Find the (sample) variance of the known values of a column.*/
+#define WHODUN_AGGREGATE_VAR 6
+
+/**Running statistics on one column for one group.*/
+typedef struct{
+	/**The number of known values.*/
+	uintmax_t numKnown;
+	/**The running mean.*/
+	double mean;
+	/**The running sum of squared deviations from the mean.*/
+	double sumSqDev;
+	/**The sum.*/
+	union{
+		/**For integer columns.*/
+		int64_t sumI;
+		/**For real columns.*/
+		double sumR;
+	};
+	/**The smallest value.*/
+	union{
+		/**For integer columns.*/
+		int64_t minI;
+		/**For real columns.*/
+		double minR;
+	};
+	/**The largest value.*/
+	union{
+		/**For integer columns.*/
+		int64_t maxI;
+		/**For real columns.*/
+		double maxR;
+	};
+} DataTableAggregateAccum;
+
+/**A hash table of groups and their running statistics.*/
+class DataTableGroupHash{
+public:
+	/**
+	 * Set up an empty table.
+	 * @param keyBytes The number of bytes in each key (must be a multiple of 8).
+	 * @param numAccum The number of running statistics for each group.
+	 */
+	DataTableGroupHash(uintptr_t keyBytes, uintptr_t numAccum);
+	/**Clean up.*/
+	~DataTableGroupHash();
+	/**
+	 * Find a group, adding it if not present.
+	 * @param hashV The hash of the key.
+	 * @param keyData The key.
+	 * @param wasNew The place to note whether the group was just added: its statistics are not set up.
+	 * @return The record for the group.
+	 */
+	char* findOrAdd(uint64_t hashV, const char* keyData, int* wasNew);
+	/**Remove all groups.*/
+	void clear();
+	/**
+	 * Get the record for a group.
+	 * @param groupInd The index of the group.
+	 * @return The record: hash, key, row count, then statistics.
+	 */
+	char* getRecord(uintptr_t groupInd);
+
+	/**The number of bytes in each key.*/
+	uintptr_t keyBytes;
+	/**The number of running statistics for each group.*/
+	uintptr_t numAccum;
+	/**The number of bytes in each record.*/
+	uintptr_t recordBytes;
+	/**The number of groups.*/
+	uintptr_t numGroups;
+	/**The records for the groups.*/
+	StructVector<char> groupData;
+	/**The hash of the group in each slot.*/
+	StructVector<uint64_t> slotHash;
+	/**The group (plus one) in each slot, or zero if empty.*/
+	StructVector<uintptr_t> slotGroup;
+};
+
+/**Partition files that records spill to.*/
+class DataTableGroupSpill{
+public:
+	/**Set up an empty spill.*/
+	DataTableGroupSpill();
+	/**Clean up, removing any files.*/
+	~DataTableGroupSpill();
+	/**Close any open files.*/
+	void close();
+
+	/**The names of the partition files.*/
+	std::vector<std::string> baseNames;
+	/**The names of the block annotation files.*/
+	std::vector<std::string> blockNames;
+	/**The open files, if still writing.*/
+	std::vector<OutStream*> outStrs;
+	/**The number of records in each file.*/
+	std::vector<uintmax_t> numRecords;
+};
+
+/**Group the rows of a data table by some key columns and summarize other columns.*/
+class DataTableGroupBy{
+public:
+	/**
+	 * Set up a single threaded grouping.
+	 * @param forData The type of table to group.
+	 * @param workDirName The working directory for temporary files, if groups do not fit in memory.
+	 */
+	DataTableGroupBy(DataTableDescription* forData, const char* workDirName);
+	/**
+	 * Set up a multi-threaded grouping.
+	 * @param forData The type of table to group.
+	 * @param workDirName The working directory for temporary files, if groups do not fit in memory.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	DataTableGroupBy(DataTableDescription* forData, const char* workDirName, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up.*/
+	~DataTableGroupBy();
+	/**
+	 * Add a column to group by (call before adding data).
+	 * @param column The index of the column.
+	 */
+	void addKey(uintptr_t column);
+	/**
+	 * Add a summary to produce (call before adding data).
+	 * @param aggType The summary to produce (WHODUN_AGGREGATE_*).
+	 * @param column The index of the column to summarize.
+	 */
+	void addAggregate(int aggType, uintptr_t column);
+	/**
+	 * Get the layout of the result: the key columns, then the summaries.
+	 * @param toFill The place to put the layout.
+	 */
+	void getResultDescription(DataTableDescription* toFill);
+	/**
+	 * Add some rows.
+	 * @param toAdd The rows to add.
+	 */
+	void add(DataTable* toAdd);
+	/**
+	 * Finish up and write out the groups (in no particular order).
+	 * @param toDump The place to write: should have the layout from getResultDescription.
+	 */
+	void finish(DataTableWriter* toDump);
+
+	/**The maximum number of bytes of groups to keep in memory before spilling to disk.*/
+	uintptr_t maxLoad;
+	/**The compression to use for temporary files: change before adding data.*/
+	CompressionFactory* spillComp;
+	/**The default compression for temporary files (fast deflate).*/
+	DeflateCompressionFactory defaultSpillComp;
+	/**The layout of the input.*/
+	DataTableDescription tabDesc;
+	/**The key columns.*/
+	std::vector<uintptr_t> keyCols;
+	/**The summaries to produce.*/
+	std::vector<int> aggTypes;
+	/**The columns the summaries are of.*/
+	std::vector<uintptr_t> aggCols;
+	/**The columns that need running statistics.*/
+	std::vector<uintptr_t> accumCols;
+	/**The running statistic each summary uses.*/
+	std::vector<uintptr_t> aggAccums;
+	/**The offset of each key column in the key.*/
+	std::vector<uintptr_t> keyOffsets;
+	/**The number of bytes in a key.*/
+	uintptr_t keyBytes;
+	/**The name of the temporary directory.*/
+	std::string tempName;
+	/**Whether this made the temporary directory.*/
+	int madeTemp;
+	/**The number of created temporary files.*/
+	uintptr_t numTemps;
+	/**The number of threads to make use of.*/
+	uintptr_t numThread;
+	/**The thread pool to use, if any.*/
+	ThreadPool* usePool;
+	/**The things to run in threads.*/
+	std::vector<JoinableThreadTask*> passUnis;
+	/**The files spilled to from the added data.*/
+	DataTableGroupSpill* topSpill;
+	/**Storage for records read back in.*/
+	StructVector<char> loadRecords;
+	/**Storage for output.*/
+	DataTable outTab;
+
+	/**Set up the key layout and tasks, if not done yet.*/
+	void prepare();
+	/**
+	 * Note whether the groups in memory are over budget.
+	 * @return Whether they need to spill.
+	 */
+	int overBudget();
+	/**
+	 * Spill the groups in memory to partition files.
+	 * @param spillTo The files to spill to.
+	 * @param level The level of partitioning.
+	 */
+	void spillGroups(DataTableGroupSpill* spillTo, uintptr_t level);
+	/**
+	 * Merge and write out the groups in memory.
+	 * @param toDump The place to write.
+	 */
+	void dumpGroups(DataTableWriter* toDump);
+	/**
+	 * Group the records in a spilled partition.
+	 * @param fileInd The index of the file in the spill.
+	 * @param spillFrom The spill.
+	 * @param level The level of partitioning of the spill.
+	 * @param toDump The place to write.
+	 */
+	void groupSpilled(uintptr_t fileInd, DataTableGroupSpill* spillFrom, uintptr_t level, DataTableWriter* toDump);
+	/**
+	 * Run the tasks over some stuff.
+	 * @param phase The phase to run.
+	 * @param numItems The number of things to divide among the tasks.
+	 */
+	void runTasks(uintptr_t phase, uintptr_t numItems);
+};
+
+/**Only keep rows that match.*/
+#define WHODUN_JOIN_INNER 0
+/**Keep every probe row, even without a match.*/
+#define WHODUN_JOIN_LEFT 1
+
+/**A hash table of keyed records, where several records can share a key.*/
+class DataTableJoinHash{
+public:
+	/**
+	 * Set up an empty table.
+	 * @param keyBytes The number of bytes in each key (must be a multiple of 8).
+	 */
+	DataTableJoinHash(uintptr_t keyBytes);
+	/**Clean up.*/
+	~DataTableJoinHash();
+	/**
+	 * Add a record.
+	 * @param hashV The hash of the key.
+	 * @param record The record: hash, then key, then anything. Must stay put while in the table.
+	 */
+	void add(uint64_t hashV, char* record);
+	/**
+	 * Find the records with a key.
+	 * @param hashV The hash of the key.
+	 * @param keyData The key.
+	 * @return The first entry (plus one) with that key, or zero if none.
+	 */
+	uintptr_t find(uint64_t hashV, const char* keyData);
+	/**
+	 * Get the next entry with the same key.
+	 * @param entryInd The entry (plus one) to go from.
+	 * @return The next entry (plus one), or zero if none.
+	 */
+	uintptr_t next(uintptr_t entryInd);
+	/**
+	 * Get the record of an entry.
+	 * @param entryInd The entry (plus one).
+	 * @return The record.
+	 */
+	char* getRecord(uintptr_t entryInd);
+	/**Remove all records.*/
+	void clear();
+
+	/**The number of bytes in each key.*/
+	uintptr_t keyBytes;
+	/**The number of distinct keys.*/
+	uintptr_t numKeys;
+	/**The number of records.*/
+	uintptr_t numEntries;
+	/**The record of each entry.*/
+	StructVector<char*> entryRecs;
+	/**The next entry (plus one) with the same key, or zero.*/
+	StructVector<uintptr_t> entryNext;
+	/**The hash of the key in each slot.*/
+	StructVector<uint64_t> slotHash;
+	/**The first entry (plus one) in each slot, or zero if empty.*/
+	StructVector<uintptr_t> slotEntry;
+};
+
+/**Join the rows of one data table (the probe) to matching rows of another (the build) by key columns.*/
+class DataTableHashJoin{
+public:
+	/**
+	 * Set up a single threaded join.
+	 * @param buildData The type of table to hash.
+	 * @param probeData The type of table to look up.
+	 * @param joinType The type of join (WHODUN_JOIN_*).
+	 * @param workDirName The working directory for temporary files, if the build table does not fit in memory.
+	 */
+	DataTableHashJoin(DataTableDescription* buildData, DataTableDescription* probeData, int joinType, const char* workDirName);
+	/**
+	 * Set up a multi-threaded join.
+	 * @param buildData The type of table to hash.
+	 * @param probeData The type of table to look up.
+	 * @param joinType The type of join (WHODUN_JOIN_*).
+	 * @param workDirName The working directory for temporary files, if the build table does not fit in memory.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	DataTableHashJoin(DataTableDescription* buildData, DataTableDescription* probeData, int joinType, const char* workDirName, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up.*/
+	~DataTableHashJoin();
+	/**
+	 * Add a pair of columns to join on (call before adding data).
+	 * @param buildCol The index of the column in the build table.
+	 * @param probeCol The index of the column in the probe table.
+	 */
+	void addKey(uintptr_t buildCol, uintptr_t probeCol);
+	/**
+	 * Get the layout of the result: the probe columns, then the non-key build columns.
+	 * @param toFill The place to put the layout.
+	 */
+	void getResultDescription(DataTableDescription* toFill);
+	/**
+	 * Add some rows of the build table (all of them must be added before probing).
+	 * @param toAdd The rows to add.
+	 */
+	void addBuild(DataTable* toAdd);
+	/**
+	 * Look up some rows of the probe table.
+	 * @param toAdd The rows to look up.
+	 * @param toDump The place to write any results that are ready: should have the layout from getResultDescription.
+	 */
+	void addProbe(DataTable* toAdd, DataTableWriter* toDump);
+	/**
+	 * Finish up and write out any remaining results.
+	 * @param toDump The place to write.
+	 */
+	void finish(DataTableWriter* toDump);
+
+	/**The maximum number of bytes of build rows to keep in memory before spilling to disk.*/
+	uintptr_t maxLoad;
+	/**The compression to use for temporary files: change before adding data.*/
+	CompressionFactory* spillComp;
+	/**The default compression for temporary files (fast deflate).*/
+	DeflateCompressionFactory defaultSpillComp;
+	/**The type of join.*/
+	int joinType;
+	/**The layout of the build table.*/
+	DataTableDescription buildDesc;
+	/**The layout of the probe table.*/
+	DataTableDescription probeDesc;
+	/**The key columns in the build table.*/
+	std::vector<uintptr_t> buildKeys;
+	/**The key columns in the probe table.*/
+	std::vector<uintptr_t> probeKeys;
+	/**For categorical keys, the build level of each probe level (or all ones if missing).*/
+	std::vector< std::vector<uint64_t> > probeCatMaps;
+	/**The offset of each key column in the key.*/
+	std::vector<uintptr_t> keyOffsets;
+	/**The width of each key column in the key.*/
+	std::vector<uintptr_t> keyWidths;
+	/**The number of bytes in a key.*/
+	uintptr_t keyBytes;
+	/**The build columns that get copied out.*/
+	std::vector<uintptr_t> buildOutCols;
+	/**The offset of each copied build column in a build record.*/
+	std::vector<uintptr_t> buildOffsets;
+	/**The number of bytes in a build record.*/
+	uintptr_t buildRecBytes;
+	/**The offset of each probe column in a probe record.*/
+	std::vector<uintptr_t> probeOffsets;
+	/**The number of bytes in a probe record.*/
+	uintptr_t probeRecBytes;
+	/**The name of the temporary directory.*/
+	std::string tempName;
+	/**Whether this made the temporary directory.*/
+	int madeTemp;
+	/**The number of created temporary files.*/
+	uintptr_t numTemps;
+	/**The number of threads to make use of.*/
+	uintptr_t numThread;
+	/**The thread pool to use, if any.*/
+	ThreadPool* usePool;
+	/**The things to run in threads.*/
+	std::vector<JoinableThreadTask*> passUnis;
+	/**Whether the build table has been hashed (or spilled).*/
+	int buildDone;
+	/**The build records in memory.*/
+	StructVector<char> buildData;
+	/**The number of build records in memory.*/
+	uintptr_t numBuild;
+	/**The files the build table spilled to.*/
+	DataTableGroupSpill* topBuildSpill;
+	/**The files the probe table spilled to.*/
+	DataTableGroupSpill* topProbeSpill;
+	/**Storage for packed or loaded records.*/
+	StructVector<char> stageData;
+	/**Blank text for unknown build strings.*/
+	StructVector<char> blankText;
+
+	/**Set up the record layouts and tasks, if not done yet.*/
+	void prepare();
+	/**
+	 * Note whether the build records in memory are over budget.
+	 * @return Whether they need to spill.
+	 */
+	int overBudget();
+	/**
+	 * Pack rows into records, in stageData.
+	 * @param toPack The rows to pack.
+	 * @param isProbe Whether the rows are from the probe table.
+	 * @return The number of records.
+	 */
+	uintptr_t packRows(DataTable* toPack, int isProbe);
+	/**
+	 * Spill records to partition files.
+	 * @param records The records.
+	 * @param numRecords The number of records.
+	 * @param recBytes The number of bytes in each record.
+	 * @param spillTo The files to spill to.
+	 * @param level The level of partitioning.
+	 */
+	void spillRecords(char* records, uintptr_t numRecords, uintptr_t recBytes, DataTableGroupSpill* spillTo, uintptr_t level);
+	/**Hash the build records in memory.*/
+	void hashBuild();
+	/**
+	 * Look up probe records against the hashed build records.
+	 * @param records The probe records.
+	 * @param numRecords The number of records.
+	 * @param toDump The place to write the results.
+	 */
+	void probeRecords(char* records, uintptr_t numRecords, DataTableWriter* toDump);
+	/**Finish with the build table.*/
+	void finishBuild();
+	/**
+	 * Join a pair of spilled partitions.
+	 * @param fileInd The index of the file in the spills.
+	 * @param buildFrom The build spill.
+	 * @param probeFrom The probe spill.
+	 * @param level The level of partitioning of the spills.
+	 * @param toDump The place to write.
+	 */
+	void joinSpilled(uintptr_t fileInd, DataTableGroupSpill* buildFrom, DataTableGroupSpill* probeFrom, uintptr_t level, DataTableWriter* toDump);
+	/**
+	 * Run the tasks over some stuff.
+	 * @param phase The phase to run.
+	 * @param numItems The number of things to divide among the tasks.
+	 */
+	void runTasks(uintptr_t phase, uintptr_t numItems);
+};
+
+/**Sort a text column by its value as a number (data columns sort by their type).*/
+#define WHODUN_TABLESORT_NUMERIC 1
+/**Sort a column largest first.*/
+#define WHODUN_TABLESORT_REVERSE 2
+
+/**Sort the rows of a text or data table by key columns, without loading the table.*/
+class TableExternalSort{
+public:
+	/**
+	 * Set up a single threaded sort.
+	 * @param workDirName The working directory for temporary files.
+	 */
+	TableExternalSort(const char* workDirName);
+	/**
+	 * Set up a multi-threaded sort.
+	 * @param workDirName The working directory for temporary files.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	TableExternalSort(const char* workDirName, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up.*/
+	~TableExternalSort();
+	/**
+	 * Add a column to sort by, most important first. Unknown (or, for text, non-numeric) values go last, and ties keep their original order.
+	 * @param column The index of the column.
+	 * @param flags How to sort the column (WHODUN_TABLESORT_*).
+	 * @param width For text columns not sorted as numbers, the number of leading bytes to compare.
+	 */
+	void addKey(uintptr_t column, int flags, uintptr_t width);
+	/**
+	 * Sort a text table.
+	 * @param sortFrom The table to sort.
+	 * @param sortTo The place to write the sorted rows.
+	 */
+	void sortText(RandacTextTableReader* sortFrom, TextTableWriter* sortTo);
+	/**
+	 * Sort a data table.
+	 * @param sortFrom The table to sort.
+	 * @param sortTo The place to write the sorted rows.
+	 */
+	void sortData(RandacDataTableReader* sortFrom, DataTableWriter* sortTo);
+
+	/**The maximum number of bytes to use for keys and gathered rows.*/
+	uintptr_t maxLoad;
+	/**The name of the temporary directory.*/
+	std::string tempName;
+	/**The number of threads to make use of.*/
+	uintptr_t numThread;
+	/**The thread pool to use, if any.*/
+	ThreadPool* usePool;
+	/**The things to run in threads.*/
+	std::vector<JoinableThreadTask*> passUnis;
+	/**The key columns.*/
+	std::vector<uintptr_t> keyCols;
+	/**How to sort each key column.*/
+	std::vector<int> keyFlags;
+	/**The requested width of each key column.*/
+	std::vector<uintptr_t> keyWidths;
+	/**The offset of each key column in a sort entry (with an extra entry for the end).*/
+	std::vector<uintptr_t> keyOffsets;
+	/**The number of bytes of key in a sort entry (the row index follows).*/
+	uintptr_t keyBytes;
+	/**The number of bytes in a sort entry.*/
+	uintptr_t entryBytes;
+	/**Whether a text table is being sorted.*/
+	int sortingText;
+	/**The text table being sorted.*/
+	RandacTextTableReader* textFrom;
+	/**The place sorted text goes.*/
+	TextTableWriter* textTo;
+	/**The data table being sorted.*/
+	RandacDataTableReader* dataFrom;
+	/**The place sorted data goes.*/
+	DataTableWriter* dataTo;
+	/**Storage for text rows.*/
+	TextTable textTab;
+	/**Storage for data rows.*/
+	DataTable dataTab;
+	/**Storage for gathered text rows.*/
+	TextTable outText;
+	/**Storage for gathered data rows.*/
+	DataTable outData;
+	/**Where the text of each gathered row starts.*/
+	StructVector<uintptr_t> outStarts;
+	/**The row each sorted entry came from, and where it goes.*/
+	std::vector< std::pair<uintmax_t,uintptr_t> > gatherOrder;
+	/**The number of sort entries to gather at once.*/
+	uintptr_t gatherEntries;
+
+	/**Lay out the sort entries and make the tasks.*/
+	void prepare();
+	/**Read the table, make the sort entries and sort them.*/
+	void runSort();
+	/**
+	 * Read and write out the rows for some sorted entries.
+	 * @param entries The sorted entries.
+	 * @param numEntries The number of entries.
+	 */
+	void gatherRows(char* entries, uintptr_t numEntries);
+	/**
+	 * Make the sort entries for some loaded rows.
+	 * @param baseRow The index of the first loaded row in the table.
+	 * @param fromRow The first loaded row to make an entry for.
+	 * @param numRows The number of rows to make entries for.
+	 * @param fillTo The place to put the entries.
+	 */
+	void runTasks(uintmax_t baseRow, uintptr_t fromRow, uintptr_t numRows, char* fillTo);
+};
+
+/**Build an index of the keys in a column of a text table, for finding rows by key.*/
+class TextTableKeyIndexBuilder{
+public:
+	/**
+	 * Set up a single threaded build.
+	 * @param workDirName The working directory for temporary files.
+	 */
+	TextTableKeyIndexBuilder(const char* workDirName);
+	/**
+	 * Set up a multi-threaded build.
+	 * @param workDirName The working directory for temporary files.
+	 * @param numThread The number of threads to use.
+	 * @param mainPool The threads to use.
+	 */
+	TextTableKeyIndexBuilder(const char* workDirName, uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up.*/
+	~TextTableKeyIndexBuilder();
+	/**
+	 * Build an index.
+	 * @param fromTab The table to index.
+	 * @param column The column to index.
+	 * @param toDump The place to write the index.
+	 */
+	void build(RandacTextTableReader* fromTab, uintptr_t column, OutStream* toDump);
+
+	/**The number of leading bytes of each key to store: longer keys are checked against the table.*/
+	uintptr_t keyWidth;
+	/**The number of entries in each block of the index.*/
+	uintptr_t blockEntries;
+	/**The maximum number of bytes of keys to hold in memory.*/
+	uintptr_t maxLoad;
+	/**The name of the temporary directory.*/
+	std::string tempName;
+	/**The number of threads to make use of.*/
+	uintptr_t numThread;
+	/**The thread pool to use, if any.*/
+	ThreadPool* usePool;
+	/**Storage for rows.*/
+	TextTable loadTab;
+};
+
+/**Find the rows of a text table using a key index.*/
+class TextTableKeyIndex{
+public:
+	/**
+	 * Open an index.
+	 * @param indexFile The index, from TextTableKeyIndexBuilder.
+	 * @param forTable The table it indexes.
+	 */
+	TextTableKeyIndex(RandaccInStream* indexFile, RandacTextTableReader* forTable);
+	/**Clean up.*/
+	~TextTableKeyIndex();
+	/**
+	 * Find the rows with a key.
+	 * @param key The key to look for.
+	 * @param toFill The place to put the rows, in table order.
+	 */
+	void lookup(SizePtrString key, TextTable* toFill);
+	/**
+	 * Find the rows with any of some keys. The keys are sorted first, so each index block and table row is read once.
+	 * @param numKeys The number of keys to look for.
+	 * @param keys The keys to look for.
+	 * @param toFill The place to put the rows, in table order.
+	 * @param rowKeys If not null, the place to put which key each row matched.
+	 */
+	void lookup(uintptr_t numKeys, SizePtrString* keys, TextTable* toFill, std::vector<uintptr_t>* rowKeys);
+
+	/**The index.*/
+	RandaccInStream* indexStr;
+	/**The table.*/
+	RandacTextTableReader* tableStr;
+	/**The indexed column.*/
+	uintptr_t column;
+	/**The number of leading bytes of each key that are stored.*/
+	uintptr_t keyWidth;
+	/**The number of bytes in an entry.*/
+	uintptr_t entryBytes;
+	/**The number of entries in the index.*/
+	uintmax_t numEntries;
+	/**The number of entries in each block.*/
+	uintptr_t blockEntries;
+	/**The number of blocks.*/
+	uintmax_t numBlocks;
+	/**The first key of each block.*/
+	StructVector<char> topKeys;
+	/**The loaded block.*/
+	StructVector<char> blockData;
+	/**The index of the loaded block, plus one (zero for none).*/
+	uintmax_t loadedBlock;
+	/**Storage for a padded key.*/
+	StructVector<char> padKey;
+	/**The keys to look for, in order, with their original index.*/
+	std::vector< std::pair<std::string,uintptr_t> > sortKeys;
+	/**The rows that might match, and the key they might match.*/
+	std::vector< std::pair<uintmax_t,uintptr_t> > candRows;
+	/**Storage for loaded rows.*/
+	TextTable loadTab;
+
+	/**
+	 * Load a block of the index.
+	 * @param blockInd The block to load.
+	 * @return The number of entries in the block.
+	 */
+	uintptr_t loadBlock(uintmax_t blockInd);
+};
+
+};
+
+#endif
+
@@ -6,6 +6,7 @@
  * @brief Text tables.
  */
 
+#include <string>
 #include <vector>
 #include <stdint.h>
 
@@ -212,6 +213,26 @@ public:
 	 * @param mainPool The threads to use.
 	 */
 	DelimitedTableReader(char rowDelim, char colDelim, InStream* mainFrom, uintptr_t numThread, ThreadPool* mainPool);
+	/**
+	 * Set up a delimited input that respects escapes and/or quotes (these are left in the text).
+	 * @param rowDelim The delimiter for rows.
+	 * @param colDelim The delimiter for columns.
+	 * @param escChar The escape character (the character after it is not a delimiter), or -1 for none.
+	 * @param quoteChar The quote character (delimiters between quotes are not delimiters), or -1 for none.
+	 * @param mainFrom The stream to delimit.
+	 */
+	DelimitedTableReader(char rowDelim, char colDelim, int escChar, int quoteChar, InStream* mainFrom);
+	/**
+	 * Set up a delimited input that respects escapes and/or quotes (these are left in the text).
+	 * @param rowDelim The delimiter for rows.
+	 * @param colDelim The delimiter for columns.
+	 * @param escChar The escape character (the character after it is not a delimiter), or -1 for none.
+	 * @param quoteChar The quote character (delimiters between quotes are not delimiters), or -1 for none.
+	 * @param mainFrom The stream to delimit.
+	 * @param numThread The number of tasks to spawn.
+	 * @param mainPool The threads to use.
+	 */
+	DelimitedTableReader(char rowDelim, char colDelim, int escChar, int quoteChar, InStream* mainFrom, uintptr_t numThread, ThreadPool* mainPool);
 	/**Clean up.*/
 	~DelimitedTableReader();
 	uintptr_t read(TextTable* toStore, uintptr_t numRows);
@@ -221,8 +242,12 @@ public:
 	InStream* theStr;
 	/**Split up rows.*/
 	Tokenizer* rowSplitter;
-	/**Split up columns.*/
-	Tokenizer* colSplitter;
+	/**Find row delimiters, column delimiters, escapes and quotes (in that order, skipping any not in use).*/
+	ByteClassSearcher structFind;
+	/**The escape character, or -1.*/
+	int escapeChar;
+	/**The quote character, or -1.*/
+	int quoteChar;
 	/**Move overflow text.*/
 	MemoryShuttler* charMove;
 	/**Save row splits.*/
@@ -333,6 +358,163 @@ public:
 	TextTable baseStage;
 };
 
+/**The most bytes of text a zone keeps for the smallest and largest text in a column.*/
+#define WHODUN_TEXTZONE_TEXT_MAX 64
+/**A reasonable number of rows in each zone.*/
+#define WHODUN_TEXTZONE_DEFAULT_ROWS 4096
+/**A reasonable number of bytes for the bloom filter of each column in a zone.*/
+#define WHODUN_TEXTZONE_DEFAULT_BLOOM 256
+
+/**Statistics on one column over a block of rows (a zone).*/
+class TextTableColumnZone{
+public:
+	/**Set up empty statistics.*/
+	TextTableColumnZone();
+	/**Clean up.*/
+	~TextTableColumnZone();
+	/**
+	 * Clear out the statistics.
+	 * @param bloomBytes The number of bytes in the bloom filter (zero for none).
+	 */
+	void reset(uintptr_t bloomBytes);
+	/**
+	 * Add a cell.
+	 * @param cellText The text of the cell: empty cells are null.
+	 */
+	void add(SizePtrString cellText);
+	/**
+	 * Fold in the statistics for some other rows.
+	 * @param toMerge The statistics to fold in: must have the same size bloom filter.
+	 */
+	void merge(TextTableColumnZone* toMerge);
+	/**
+	 * Test whether some text might show up, according to the bloom filter.
+	 * @param cellText The text to test.
+	 * @return Whether it might be in this column.
+	 */
+	int bloomMaybe(SizePtrString cellText);
+
+	/**The number of null (empty or missing) cells.*/
+	uintmax_t numNull;
+	/**The number of cells that are numbers.*/
+	uintmax_t numNumber;
+	/**The number of non-empty cells that are not numbers.*/
+	uintmax_t numText;
+	/**The smallest number.*/
+	double minNumber;
+	/**The largest number.*/
+	double maxNumber;
+	/**The smallest text (of all non-empty cells). This may be cut short, which still leaves it a lower bound.*/
+	std::string minText;
+	/**The largest text (of all non-empty cells).*/
+	std::string maxText;
+	/**Whether maxText was cut short (and so is a prefix of the real largest text).*/
+	int maxTextCut;
+	/**The bloom filter over the non-empty cells.*/
+	std::string bloom;
+};
+
+/**Statistics on the columns in a block of rows.*/
+class TextTableBlockZone{
+public:
+	/**Set up empty statistics.*/
+	TextTableBlockZone();
+	/**Clean up.*/
+	~TextTableBlockZone();
+	/**
+	 * Clear out the statistics.
+	 * @param bloomBytes The number of bytes in the bloom filter of each column.
+	 */
+	void reset(uintptr_t bloomBytes);
+	/**
+	 * Add a row.
+	 * @param toAdd The row to add.
+	 */
+	void add(TextTableRow* toAdd);
+	/**
+	 * Fold in the statistics for the rows right after these.
+	 * @param toMerge The statistics to fold in: must have the same size bloom filter.
+	 */
+	void merge(TextTableBlockZone* toMerge);
+
+	/**The number of rows in the block.*/
+	uintmax_t numRows;
+	/**The number of bytes in the bloom filter of each column.*/
+	uintptr_t bloomBytes;
+	/**The statistics for each column (columns past the end are all null).*/
+	std::vector<TextTableColumnZone> cols;
+};
+
+/**Test that a column equals a value.*/
+#define WHODUN_TEXTPRED_EQ 0
+/**Test that a column does not equal a value.*/
+#define WHODUN_TEXTPRED_NE 1
+/**Test that a column is less than a value.*/
+#define WHODUN_TEXTPRED_LT 2
+/**Test that a column is at most a value.*/
+#define WHODUN_TEXTPRED_LE 3
+/**Test that a column is greater than a value.*/
+#define WHODUN_TEXTPRED_GT 4
+/**Test that a column is at least a value.*/
+#define WHODUN_TEXTPRED_GE 5
+/**Test that a column is null (empty or missing).*/
+#define WHODUN_TEXTPRED_NULL 6
+/**Test that a column is not null.*/
+#define WHODUN_TEXTPRED_NOTNULL 7
+
+/**A test on one column.*/
+typedef struct{
+	/**The column to test.*/
+	uintptr_t column;
+	/**The test to run (WHODUN_TEXTPRED_*).*/
+	int op;
+	/**Whether to compare as numbers (cells that are not numbers fail).*/
+	int numeric;
+	/**The text to compare against.*/
+	std::string textValue;
+	/**The number to compare against.*/
+	double numValue;
+} TextTableCondition;
+
+/**Keep the rows that pass all of a set of column tests. Comparisons against null cells fail.*/
+class TextTablePredicate : public TextTableFilter{
+public:
+	/**Set up a single-threaded predicate.*/
+	TextTablePredicate();
+	/**
+	 * Set up a multi-threaded predicate.
+	 * @param numThread The number of tasks to spawn.
+	 * @param mainPool The threads to use.
+	 */
+	TextTablePredicate(uintptr_t numThread, ThreadPool* mainPool);
+	/**Clean up.*/
+	~TextTablePredicate();
+	int test(TextTableRow* row);
+	/**
+	 * Add a test comparing text (or a null test).
+	 * @param column The column to test.
+	 * @param op The test to run (WHODUN_TEXTPRED_*).
+	 * @param value The value to compare against.
+	 */
+	void addText(uintptr_t column, int op, SizePtrString value);
+	/**
+	 * Add a test comparing numbers.
+	 * @param column The column to test.
+	 * @param op The test to run (WHODUN_TEXTPRED_*).
+	 * @param value The value to compare against.
+	 */
+	void addNumber(uintptr_t column, int op, double value);
+	/**
+	 * Figure out whether any row in a block might pass.
+	 * @param block The statistics for the block.
+	 * @return Whether any row might pass: if zero, the block can be skipped.
+	 */
+	int mightMatch(TextTableBlockZone* block);
+
+	/**The tests to run.*/
+	std::vector<TextTableCondition> conds;
+};
+
 /**Quick sequential access to a bctsv file.*/
 class ChunkyTextTableReader : public RandacTextTableReader{
 public:
@@ -352,10 +534,26 @@ public:
 	ChunkyTextTableReader(RandaccInStream* annotationFile, RandaccInStream* dataFile, uintptr_t numThread, ThreadPool* mainPool);
 	/**Clean up*/
 	~ChunkyTextTableReader();
+	/**
+	 * Read some rows from the table. If there is a predicate, only passing rows are stored, and blocks it rules out are never loaded.
+	 * @param toStore The place to put them.
+	 * @param numRows The number of rows to read.
+	 * @return The number of rows passed over (stored or not): if less than numRows, have hit eof.
+	 */
 	uintptr_t read(TextTable* toStore, uintptr_t numRows);
 	void close();
 	uintmax_t size();
 	void seek(uintmax_t index);
+	/**
+	 * Load statistics on the blocks of the table (as written by ChunkyTextTableWriter::recordZones).
+	 * @param zoneFile The file with the statistics.
+	 */
+	void loadZones(InStream* zoneFile);
+	/**
+	 * Only report rows passing a predicate.
+	 * @param toUse The predicate to use, or null to report everything.
+	 */
+	void setPredicate(TextTablePredicate* toUse);
 	
 	/**The index data.*/
 	RandaccInStream* indStr;
@@ -375,6 +573,18 @@ public:
 	uintmax_t totalNInd;
 	/**The total number of bytes in the data.*/
 	uintmax_t totalNByte;
+	/**The next row the streams are set up to read (if no seek is needed).*/
+	uintmax_t nextInd;
+	/**The address of the next row the streams are set up to read.*/
+	uintmax_t nextAddr;
+	/**The runs of rows to load in the current read (start and end).*/
+	std::vector<uintmax_t> loadRuns;
+	/**The number of rows in each zone, or zero if none loaded.*/
+	uintmax_t zoneRows;
+	/**Statistics on each block of rows.*/
+	std::vector<TextTableBlockZone> zones;
+	/**The predicate to filter with, if any.*/
+	TextTablePredicate* usePred;
 };
 
 /**Write to a bctsv file.*/
@@ -398,6 +608,13 @@ public:
 	~ChunkyTextTableWriter();
 	void write(TextTableView* toStore);
 	void close();
+	/**
+	 * Record statistics on blocks of rows to a side file, so readers can skip blocks. Call before writing anything.
+	 * @param zoneFile The place to write the statistics.
+	 * @param blockRows The number of rows in each block.
+	 * @param bloomBytes The number of bytes in the bloom filter of each column in each block.
+	 */
+	void recordZones(OutStream* zoneFile, uintptr_t blockRows, uintptr_t bloomBytes);
 	
 	/**The index data.*/
 	OutStream* indStr;
@@ -413,6 +630,20 @@ public:
 	StructVector<char> packARB;
 	/**Staging ground for sending data to output.*/
 	StructVector<char> packDatums;
+	/**The place to write block statistics, if any.*/
+	OutStream* zoneStr;
+	/**The number of rows in each block of statistics.*/
+	uintptr_t zoneRows;
+	/**The number of bytes in each bloom filter.*/
+	uintptr_t zoneBloom;
+	/**The number of rows written so far.*/
+	uintmax_t zoneRowsSeen;
+	/**The index of the block being built.*/
+	uintmax_t curZoneInd;
+	/**The statistics for the block being built.*/
+	TextTableBlockZone curZone;
+	/**Staging ground for block statistics.*/
+	StructVector<char> packZone;
 };
 
 /**Choose how to open a thing based on its extension.*/
@@ -64,6 +64,63 @@ intptr_t parseInt(SizePtrString toParse);
  */
 double parseFloat(SizePtrString toParse);
 
+/**
+ * Parse a bunch of integers, noting malformed entries instead of throwing.
+ * @param numParse The number of strings to parse.
+ * @param toParse The strings to parse.
+ * @param toFill The place to put the values (malformed entries get zero).
+ * @param isBad The place to note whether each string was malformed (empty, not a number, or out of range).
+ * @return The number of malformed strings.
+ */
+uintptr_t parseIntBatch(uintptr_t numParse, const SizePtrString* toParse, int64_t* toFill, char* isBad);
+
+/**
+ * Parse a bunch of floats, noting malformed entries instead of throwing.
+ * @param numParse The number of strings to parse.
+ * @param toParse The strings to parse.
+ * @param toFill The place to put the values (malformed entries get zero).
+ * @param isBad The place to note whether each string was malformed.
+ * @return The number of malformed strings.
+ */
+uintptr_t parseFloatBatch(uintptr_t numParse, const SizePtrString* toParse, double* toFill, char* isBad);
+
+/**The most characters formatInt will produce.*/
+#define WHODUN_FORMAT_INT_MAXLEN 24
+/**The most characters formatFloat will produce.*/
+#define WHODUN_FORMAT_FLOAT_MAXLEN 32
+
+/**
+ * Write out an integer.
+ * @param toFormat The value to write.
+ * @param toFill The place to write (at least WHODUN_FORMAT_INT_MAXLEN bytes, not null terminated).
+ * @return The number of characters written.
+ */
+uintptr_t formatInt(int64_t toFormat, char* toFill);
+
+/**
+ * Write out a float using the fewest digits that parse back to the same value.
+ * @param toFormat The value to write.
+ * @param toFill The place to write (at least WHODUN_FORMAT_FLOAT_MAXLEN bytes, not null terminated).
+ * @return The number of characters written.
+ */
+uintptr_t formatFloat(double toFormat, char* toFill);
+
+/**
+ * Write out a bunch of integers.
+ * @param numFormat The number of values to write.
+ * @param toFormat The values to write.
+ * @param toFill The places to write: the text pointers should have room for WHODUN_FORMAT_INT_MAXLEN bytes, lengths will be set.
+ */
+void formatIntBatch(uintptr_t numFormat, const int64_t* toFormat, SizePtrString* toFill);
+
+/**
+ * Write out a bunch of floats (shortest round trip).
+ * @param numFormat The number of values to write.
+ * @param toFormat The values to write.
+ * @param toFill The places to write: the text pointers should have room for WHODUN_FORMAT_FLOAT_MAXLEN bytes, lengths will be set.
+ */
+void formatFloatBatch(uintptr_t numFormat, const double* toFormat, SizePtrString* toFill);
+
 /**
  * Compare two strings in lexicographic order.
  * @param strA The first "string": length and characters.
@@ -292,6 +349,113 @@ public:
 	char* memmem(const char* str1, size_t numB1, const char* str2, size_t numB2);
 };
 
+/**Look for any of a set of bytes: tables are built once, and scans report masks of matching positions.*/
+class ByteSetSearcher{
+public:
+	/**Set up an empty set.*/
+	ByteSetSearcher();
+	/**
+	 * Set up a set.
+	 * @param useChars The bytes in the set.
+	 * @param numChars The number of bytes in the set.
+	 */
+	ByteSetSearcher(const char* useChars, size_t numChars);
+	/**Tear down.*/
+	~ByteSetSearcher();
+	
+	/**
+	 * Change the bytes in the set.
+	 * @param useChars The bytes in the set.
+	 * @param numChars The number of bytes in the set.
+	 */
+	void setBytes(const char* useChars, size_t numChars);
+	/**
+	 * Test whether a byte is in the set.
+	 * @param toTest The byte to test.
+	 * @return Whether it is in the set.
+	 */
+	int contains(char toTest);
+	/**
+	 * Find which of (up to) 64 bytes are in the set.
+	 * @param str The bytes to look through.
+	 * @param numB The number of bytes: at most 64.
+	 * @return A mask with bit i set if str[i] is in the set.
+	 */
+	uint64_t mask64(const char* str, size_t numB);
+	/**
+	 * Find the first byte in the set.
+	 * @param str The bytes to look through.
+	 * @param numB The number of bytes.
+	 * @return The index of the first byte in the set, or numB if none.
+	 */
+	size_t findFirst(const char* str, size_t numB);
+	/**
+	 * Find the first byte not in the set.
+	 * @param str The bytes to look through.
+	 * @param numB The number of bytes.
+	 * @return The index of the first byte not in the set, or numB if none.
+	 */
+	size_t findFirstNot(const char* str, size_t numB);
+	
+	/**For each low nibble, a bit for each high nibble (0-7) in the set.*/
+	unsigned char lowRow[16];
+	/**For each low nibble, a bit for each high nibble (8-15) in the set.*/
+	unsigned char highRow[16];
+};
+
+/**The most bytes a ByteClassSearcher can look for.*/
+#define WHODUN_BYTECLASS_MAX 4
+
+/**Look for a few bytes at once, reporting a separate mask of positions for each.*/
+class ByteClassSearcher{
+public:
+	/**Set up an empty search.*/
+	ByteClassSearcher();
+	/**
+	 * Set up a search.
+	 * @param useChars The bytes to look for.
+	 * @param numChars The number of bytes to look for: at most WHODUN_BYTECLASS_MAX.
+	 */
+	ByteClassSearcher(const char* useChars, size_t numChars);
+	/**Tear down.*/
+	~ByteClassSearcher();
+
+	/**
+	 * Change the bytes to look for.
+	 * @param useChars The bytes to look for.
+	 * @param numChars The number of bytes to look for: at most WHODUN_BYTECLASS_MAX.
+	 */
+	void setBytes(const char* useChars, size_t numChars);
+	/**
+	 * Find where each byte shows up in (up to) 64 bytes.
+	 * @param str The bytes to look through.
+	 * @param numB The number of bytes: at most 64.
+	 * @param toFill The place to put the masks: one for each byte looked for, with bit i set if str[i] is that byte.
+	 */
+	void mask64(const char* str, size_t numB, uint64_t* toFill);
+
+	/**The number of bytes to look for.*/
+	size_t numChars;
+	/**The bytes to look for.*/
+	char theChars[WHODUN_BYTECLASS_MAX];
+};
+
+/**
+ * Figure out which characters in a 64 byte block are escaped (follow an odd run of escape characters).
+ * @param escMask The locations of the escape characters.
+ * @param prevEscaped Whether the first character is escaped by the end of the previous block (0 or 1). Set to whether the first character of the next block is.
+ * @return A mask of the escaped characters.
+ */
+uint64_t maskEscaped64(uint64_t escMask, uint64_t* prevEscaped);
+
+/**
+ * Figure out which characters in a 64 byte block are between quotes.
+ * @param quoteMask The locations of the (unescaped) quote characters.
+ * @param prevQuoted All ones if the block starts inside quotes, zero if not. Set to the same for the next block.
+ * @return A mask of the quoted characters: opening quotes count as inside, closing quotes do not.
+ */
+uint64_t maskQuoted64(uint64_t quoteMask, uint64_t* prevQuoted);
+
 /**Pack things into bytes.*/
 class BytePacker{
 public:
@@ -373,6 +537,55 @@ public:
 	 * @param toPack The float to pack.
 	 */
 	void packLEFlt(float toPack);
+	
+	/**
+	 * Pack an array of 64-bit integers big endian.
+	 * @param toPack The integers to pack.
+	 * @param numPack The number of integers.
+	 */
+	void packBE64Array(const uint64_t* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 32-bit integers as 64-bit big endian.
+	 * @param toPack The integers to pack.
+	 * @param numPack The number of integers.
+	 */
+	void packBE64Array(const uint32_t* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 32-bit integers big endian.
+	 * @param toPack The integers to pack.
+	 * @param numPack The number of integers.
+	 */
+	void packBE32Array(const uint32_t* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 64-bit integers as 32-bit big endian (high bits are dropped).
+	 * @param toPack The integers to pack.
+	 * @param numPack The number of integers.
+	 */
+	void packBE32Array(const uint64_t* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 16-bit integers big endian.
+	 * @param toPack The integers to pack.
+	 * @param numPack The number of integers.
+	 */
+	void packBE16Array(const uint16_t* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 64-bit floats big endian.
+	 * @param toPack The floats to pack.
+	 * @param numPack The number of floats.
+	 */
+	void packBEDblArray(const double* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 32-bit floats big endian.
+	 * @param toPack The floats to pack.
+	 * @param numPack The number of floats.
+	 */
+	void packBEFltArray(const float* toPack, uintptr_t numPack);
+	/**
+	 * Pack an array of 64-bit floats as 32-bit big endian.
+	 * @param toPack The floats to pack.
+	 * @param numPack The number of floats.
+	 */
+	void packBEFltArray(const double* toPack, uintptr_t numPack);
 };
 
 /**Unpack things from bytes.*/
@@ -455,6 +668,55 @@ public:
 	 * @return The float
 	 */
 	float unpackLEFlt();
+	
+	/**
+	 * Unpack an array of 64-bit integers big endian.
+	 * @param toFill The place to put the integers.
+	 * @param numUnpack The number of integers.
+	 */
+	void unpackBE64Array(uint64_t* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 64-bit big endian integers into 32-bit integers (high bits are dropped).
+	 * @param toFill The place to put the integers.
+	 * @param numUnpack The number of integers.
+	 */
+	void unpackBE64Array(uint32_t* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 32-bit integers big endian.
+	 * @param toFill The place to put the integers.
+	 * @param numUnpack The number of integers.
+	 */
+	void unpackBE32Array(uint32_t* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 32-bit big endian integers into 64-bit integers.
+	 * @param toFill The place to put the integers.
+	 * @param numUnpack The number of integers.
+	 */
+	void unpackBE32Array(uint64_t* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 16-bit integers big endian.
+	 * @param toFill The place to put the integers.
+	 * @param numUnpack The number of integers.
+	 */
+	void unpackBE16Array(uint16_t* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 64-bit floats big endian.
+	 * @param toFill The place to put the floats.
+	 * @param numUnpack The number of floats.
+	 */
+	void unpackBEDblArray(double* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 32-bit floats big endian.
+	 * @param toFill The place to put the floats.
+	 * @param numUnpack The number of floats.
+	 */
+	void unpackBEFltArray(float* toFill, uintptr_t numUnpack);
+	/**
+	 * Unpack an array of 32-bit big endian floats into 64-bit floats.
+	 * @param toFill The place to put the floats.
+	 * @param numUnpack The number of floats.
+	 */
+	void unpackBEFltArray(double* toFill, uintptr_t numUnpack);
 };
 
 //odd things missing from string.h
@@ -495,6 +757,27 @@ char* memmem(const char* str1, size_t numB1, const char* str2, size_t numB2);
  */
 void memswap(char* arrA, char* arrB, size_t numBts);
 
+/**No vector instructions for the above.*/
+#define WHODUN_VECTOR_NONE 0
+/**SSE4.2 (and SSSE3) for the above.*/
+#define WHODUN_VECTOR_SSE42 1
+/**AVX2 for the above.*/
+#define WHODUN_VECTOR_AVX2 2
+/**AVX-512 (BW) for the above.*/
+#define WHODUN_VECTOR_AVX512 3
+
+/**
+ * Get the vector instructions the above are using (picked from the processor on first use).
+ * @return The level in use (WHODUN_VECTOR_*).
+ */
+int memVectorLevel();
+/**
+ * Limit the vector instructions the above use (for testing and benchmarking).
+ * @param maxLevel The highest level to use: the processor still caps it.
+ * @return The level now in use.
+ */
+int memVectorLimit(int maxLevel);
+
 };
 
 #endif
@@ -269,9 +269,7 @@ void ChunkySeqGraphIntConvertLoop::doRange(uintptr_t threadInd, uintptr_t fromI,
 	doRangeStart(threadInd, fromI, toI);
 	
 	ByteUnpacker curUP(convFrom + 8*fromI);
-	for(uintptr_t i = fromI; i<toI; i++){
-		convTo[i] = curUP.unpackBE64();
-	}
+	curUP.unpackBE64Array(convTo + fromI, toI - fromI);
 	
 	doRangeEnd(threadInd, fromI, toI);
 }
@@ -303,9 +301,7 @@ void ChunkySeqGraphFloatConvertLoop::doRange(uintptr_t threadInd, uintptr_t from
 	doRangeStart(threadInd, fromI, toI);
 	
 	ByteUnpacker curUP(convFrom + 4*fromI);
-	for(uintptr_t i = fromI; i<toI; i++){
-		convTo[i] = curUP.unpackBEFlt();
-	}
+	curUP.unpackBEFltArray(convTo + fromI, toI - fromI);
 	
 	doRangeEnd(threadInd, fromI, toI);
 }
@@ -337,9 +333,7 @@ void ChunkySeqGraphIntPackLoop::doRange(uintptr_t threadInd, uintptr_t fromI, ui
 	doRangeStart(threadInd, fromI, toI);
 	
 	BytePacker curP(convFrom + 8*fromI);
-	for(uintptr_t i = fromI; i<toI; i++){
-		curP.packBE64(convTo[i]);
-	}
+	curP.packBE64Array(convTo + fromI, toI - fromI);
 	
 	doRangeEnd(threadInd, fromI, toI);
 }
@@ -368,9 +362,7 @@ void ChunkySeqGraphFloatPackLoop::doRange(uintptr_t threadInd, uintptr_t fromI,
 	doRangeStart(threadInd, fromI, toI);
 	
 	BytePacker curP(convFrom + 4*fromI);
-	for(uintptr_t i = fromI; i<toI; i++){
-		curP.packBEFlt(convTo[i]);
-	}
+	curP.packBEFltArray(convTo + fromI, toI - fromI);
 	
 	doRangeEnd(threadInd, fromI, toI);
 }
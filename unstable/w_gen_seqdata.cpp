@@ -91,6 +91,10 @@ public:
 	SizePtrString seqData;
 	/**The thing to fix up.*/
 	SequenceSet* toStore;
+	/**The unpacked name addresses (first is the base address of the loaded names).*/
+	StructVector<uint64_t> nameAddrs;
+	/**The unpacked sequence addresses (first is the base address of the loaded sequence).*/
+	StructVector<uint64_t> seqAddrs;
 };
 
 /**Pack things up for a chunky write.*/
@@ -128,6 +132,8 @@ public:
 	//phase 3 - pack up sequence
 	/**The file offset this chunk of sequence starts at.*/
 	uintmax_t startByteIS;
+	/**The addresses to pack.*/
+	StructVector<uint64_t> rowAddrs;
 };
 
 };
@@ -641,17 +647,26 @@ void ChunkySequenceReadTask::doTask(){
 	if(fromRI == toRI){ return; }
 	SizePtrString* fillName = toStore->saveNames[fromRI];
 	SizePtrString* fillSeq = toStore->saveStrs[fromRI];
+	uintptr_t numRows = toRI - fromRI;
+	nameAddrs.resize(numRows + 2);
+	seqAddrs.resize(numRows + 2);
 	ByteUnpacker getOffVN(annotNData);
 	ByteUnpacker getOffVS(annotSData);
-	uintmax_t baseAddrN = getOffVN.unpackBE64();
-	uintmax_t baseAddrS = getOffVS.unpackBE64();
+	getOffVN.unpackBE64Array(nameAddrs[0], 1);
+	getOffVS.unpackBE64Array(seqAddrs[0], 1);
 	getOffVN.retarget(annotNData + BLOCKCOMP_ANNOT_ENTLEN*fromRI);
 	getOffVS.retarget(annotSData + BLOCKCOMP_ANNOT_ENTLEN*fromRI);
-	uintmax_t curAddrN = getOffVN.unpackBE64();
-	uintmax_t curAddrS = getOffVS.unpackBE64();
-	for(uintptr_t i = fromRI; i<toRI; i++){
-		uintmax_t nextAddrN = getOffVN.unpackBE64();
-		uintmax_t nextAddrS = getOffVS.unpackBE64();
+	getOffVN.unpackBE64Array(nameAddrs[1], numRows + 1);
+	getOffVS.unpackBE64Array(seqAddrs[1], numRows + 1);
+	uintmax_t baseAddrN = *nameAddrs[0];
+	uintmax_t baseAddrS = *seqAddrs[0];
+	uint64_t* curAddrsN = nameAddrs[1];
+	uint64_t* curAddrsS = seqAddrs[1];
+	uintmax_t curAddrN = curAddrsN[0];
+	uintmax_t curAddrS = curAddrsS[0];
+	for(uintptr_t i = 1; i<=numRows; i++){
+		uintmax_t nextAddrN = curAddrsN[i];
+		uintmax_t nextAddrS = curAddrsS[i];
 		if(nextAddrN < curAddrN){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Name index file not monotonic.", 0, 0); }
 		if(nextAddrS < curAddrS){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Sequence index file not monotonic.", 0, 0); }
 		if((nextAddrN - baseAddrN) > nameData.len){ throw WhodunError(WHODUN_ERROR_LEVEL_WARNING, WHODUN_ERROR_SDESC_FILEMANG, __FILE__, __LINE__, "Index name file out of order.", 0, 0); }
@@ -794,7 +809,6 @@ void ChunkySequenceWriteTask::doTask(){
 		}
 	}
 	else{
-		BytePacker curPackA(annotData);
 		char* curFillD = tableData;
 		uintmax_t curByteI;
 		SizePtrString* curDumpS;
@@ -806,14 +820,21 @@ void ChunkySequenceWriteTask::doTask(){
 			curByteI = startByteIS;
 			curDumpS = toStore->saveStrs[fromRI];
 		}
+		rowAddrs.resize(toRI - fromRI);
+		uint64_t* curRowA = rowAddrs[0];
 		for(uintptr_t i = fromRI; i<toRI; i++){
-			curPackA.packBE64(curByteI);
+			*curRowA = curByteI;
+			curRowA++;
 			uintptr_t curL = curDumpS->len;
 			curByteI += curL;
 			memcpy(curFillD, curDumpS->txt, curL);
 			curFillD += curL;
 			curDumpS++;
 		}
+		if(toRI != fromRI){
+			BytePacker curPackA(annotData);
+			curPackA.packBE64Array(rowAddrs[0], toRI - fromRI);
+		}
 	}
 }
 
@@ -25,6 +25,8 @@ public:
 	Token* theToken;
 	/**The indices of the tokens that actually have something (not purely whitespace)*/
 	std::vector<uintptr_t> nameTokenIs;
+	/**Find non-whitespace.*/
+	ByteSetSearcher spaceFind;
 	
 	//phase 2 - collect the tokens into one list
 	/**The place to put token indices.*/
@@ -256,16 +258,14 @@ void AsciiFastqReader::close(){
 	isClosed = 1;
 }
 
-FastqReadTask::FastqReadTask(){}
+FastqReadTask::FastqReadTask() : spaceFind(" \t\r\n", 4){}
 FastqReadTask::~FastqReadTask(){}
 void FastqReadTask::doTask(){
 	if(phase == 1){
-		StandardMemorySearcher doTrim;
 		nameTokenIs.clear();
 		for(uintptr_t i = tokenSI; i<tokenEI; i++){
-			Token* curLTok = theToken + i;
-			SizePtrString trimS = doTrim.trim(curLTok->text);
-			if(trimS.len == 0){ continue; }
+			SizePtrString curLine = theToken[i].text;
+			if(spaceFind.findFirstNot(curLine.txt, curLine.len) == curLine.len){ continue; }
 			nameTokenIs.push_back(i);
 		}
 	}
@@ -194,6 +194,8 @@ void suffixArrayBuilderSetup(SuffixArrayBuilder* toFill){
 	uintptr_t numThread = toFill->numThread;
 	ThreadPool* usePool = toFill->usePool;
 	PODSortOptions rankOpts(3*sizeof(Itp), 0, compareSuffixEntryRank<Itp>);
+		rankOpts.addKeyPart(sizeof(Itp), sizeof(Itp), WHODUN_SORTKEY_NATIVE);
+		rankOpts.addKeyPart(2*sizeof(Itp), sizeof(Itp), WHODUN_SORTKEY_NATIVE);
 	toFill->rankSort = usePool ? new PODInMemoryMergesort(&rankOpts, numThread, usePool) : new PODInMemoryMergesort(&rankOpts);
 	toFill->initRank = new SuffixArrayBuildInitRank<Itp>(numThread);
 	for(uintptr_t i = 0; i<numThread; i++){